@@ -69,6 +69,19 @@ std::optional<DesyncMonitor::HistoryEntry> DesyncMonitor::findHistoryEntry(const
     return std::nullopt;
 }
 
+uint32_t DesyncMonitor::mismatchedComponents(const HistoryEntry& local, const HistoryEntry& remote)
+{
+    const std::vector<uint32_t>& a = local.componentDigests;
+    const std::vector<uint32_t>& b = remote.componentDigests;
+    if(a.empty() || a.size() != b.size()) return 0;
+
+    uint32_t mask = 0;
+    for(size_t i = 0; i < a.size() && i < 32; ++i) {
+        if(a[i] != b[i]) mask |= 1u << i;
+    }
+    return mask;
+}
+
 DesyncMonitor::Update DesyncMonitor::evaluateFrame(FrameNumber frame)
 {
     Update update;
@@ -90,6 +103,7 @@ DesyncMonitor::Update DesyncMonitor::evaluateFrame(FrameNumber frame)
     update.compared = true;
     if(localEntry->crc32 != remoteEntry->crc32) {
         update.mismatchDetected = true;
+        update.mismatchedComponentMask = mismatchedComponents(*localEntry, *remoteEntry);
         if(m_lastMismatchFrame != 0 && frame >= m_lastMismatchFrame) {
             m_consecutiveMismatchCount = static_cast<uint8_t>(
                 std::min<unsigned>(255u, static_cast<unsigned>(m_consecutiveMismatchCount) + 1u)
@@ -5,6 +5,7 @@
 #include <deque>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "NetplayTypes.h"
 
@@ -20,6 +21,8 @@ public:
         CrcSubmissionSource submissionSource = CrcSubmissionSource::Unknown;
         FrameNumber localSimulationFrame = 0;
         FrameNumber confirmedFrame = 0;
+        // Per-component digests behind crc32, when the sender hashes its state as a tree.
+        std::vector<uint32_t> componentDigests = {};
     };
 
     struct Update
@@ -29,6 +32,8 @@ public:
         bool mismatchResolved = false;
         FrameNumber frame = 0;
         uint8_t consecutiveMismatchCount = 0;
+        // Bit i set when component i differs. Zero when either side sent no components.
+        uint32_t mismatchedComponentMask = 0;
         std::optional<uint32_t> localCrc32;
         std::optional<uint32_t> remoteCrc32;
         std::optional<HistoryEntry> localEntry;
@@ -59,6 +64,7 @@ private:
 
     static void storeHistoryEntry(std::deque<HistoryEntry>& history, const HistoryEntry& entry);
     static std::optional<HistoryEntry> findHistoryEntry(const std::deque<HistoryEntry>& history, FrameNumber frame);
+    static uint32_t mismatchedComponents(const HistoryEntry& local, const HistoryEntry& remote);
     Update evaluateFrame(FrameNumber frame);
 };
 
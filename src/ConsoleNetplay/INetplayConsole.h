@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <optional>
 #include <vector>
 
@@ -31,6 +32,34 @@ public:
     virtual void queueStandaloneBootstrapInputFrame() = 0;
     virtual bool queuePlaybackInputFrame(const NetplayCoordinator::ConfirmedFrameInputs& confirmed) = 0;
     virtual void discardQueuedInputFramesAfter(FrameNumber frame) = 0;
+
+    // Rollback mode needs an in-memory state that can be restored at once and a way to run
+    // one frame from explicit inputs with audio and video output suppressed. Consoles that
+    // do not provide them keep the default and are never rolled back.
+    virtual bool saveRollbackState(std::vector<uint8_t>& outState)
+    {
+        (void)outState;
+        return false;
+    }
+    virtual bool loadRollbackState(const std::vector<uint8_t>& state)
+    {
+        (void)state;
+        return false;
+    }
+    virtual bool resimulateFrame(const NetplayCoordinator::ConfirmedFrameInputs& inputs, uint32_t frameDtMs)
+    {
+        (void)inputs;
+        (void)frameDtMs;
+        return false;
+    }
+
+    // Tree hash of the current state, cheap enough to take every frame. Consoles without
+    // one are checked with the CRC of their serialized state instead.
+    virtual bool stateDigest(NetplayStateDigest& outDigest)
+    {
+        (void)outDigest;
+        return false;
+    }
 };
 
 } // namespace ConsoleNetplay
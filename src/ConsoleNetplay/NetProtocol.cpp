@@ -155,30 +155,18 @@ size_t InputTopologyData::serializedSize() const
     return size;
 }
 
-void InputFrameData::serialize(PacketWriter& writer) const
+void InputFrameBatchData::serialize(PacketWriter& writer) const
 {
     writer.writePod(timelineEpoch);
-    writer.writePod(frame);
-    writer.writePod(authoritativeFrameStartClockMicros);
     writer.writePod(participantId);
     writer.writePod(playerSlot);
-    writer.writePod(buttonMaskLo);
-    writer.writePod(buttonMaskHi);
-    writer.writePod(sequence);
-    writer.writePod(payloadSize);
 }
 
-bool InputFrameData::deserialize(PacketReader& reader, InputFrameData& data)
+bool InputFrameBatchData::deserialize(PacketReader& reader, InputFrameBatchData& data)
 {
     return reader.readPod(data.timelineEpoch) &&
-           reader.readPod(data.frame) &&
-           reader.readPod(data.authoritativeFrameStartClockMicros) &&
            reader.readPod(data.participantId) &&
-           reader.readPod(data.playerSlot) &&
-           reader.readPod(data.buttonMaskLo) &&
-           reader.readPod(data.buttonMaskHi) &&
-           reader.readPod(data.sequence) &&
-           reader.readPod(data.payloadSize);
+           reader.readPod(data.playerSlot);
 }
 
 void ConfirmedInputFramesData::serialize(PacketWriter& writer) const
@@ -195,54 +183,6 @@ bool ConfirmedInputFramesData::deserialize(PacketReader& reader, ConfirmedInputF
            reader.readPod(data.frameCount);
 }
 
-void ConfirmedInputFrameEntry::SlotMask::serialize(PacketWriter& writer) const
-{
-    writer.writePod(slot);
-    writer.writePod(buttonMaskLo);
-    writer.writePod(buttonMaskHi);
-}
-
-bool ConfirmedInputFrameEntry::SlotMask::deserialize(PacketReader& reader, SlotMask& slotMask)
-{
-    return reader.readPod(slotMask.slot) &&
-           reader.readPod(slotMask.buttonMaskLo) &&
-           reader.readPod(slotMask.buttonMaskHi);
-}
-
-void ConfirmedInputFrameEntry::serialize(PacketWriter& writer) const
-{
-    writer.writePod(authoritativeFrameStartClockMicros);
-    const uint8_t slotMaskCount = static_cast<uint8_t>(std::min<size_t>(slotMasks.size(), std::numeric_limits<uint8_t>::max()));
-    writer.writePod(slotMaskCount);
-    for(uint8_t index = 0; index < slotMaskCount; ++index) {
-        slotMasks[index].serialize(writer);
-    }
-    writer.writePod(payloadSize);
-}
-
-bool ConfirmedInputFrameEntry::deserialize(PacketReader& reader, ConfirmedInputFrameEntry& entry)
-{
-    if(!reader.readPod(entry.authoritativeFrameStartClockMicros)) return false;
-    uint8_t slotMaskCount = 0;
-    if(!reader.readPod(slotMaskCount)) return false;
-    entry.slotMasks.clear();
-    entry.slotMasks.reserve(slotMaskCount);
-    for(uint8_t index = 0; index < slotMaskCount; ++index) {
-        SlotMask slotMask;
-        if(!SlotMask::deserialize(reader, slotMask)) return false;
-        entry.slotMasks.push_back(slotMask);
-    }
-    return reader.readPod(entry.payloadSize);
-}
-
-size_t ConfirmedInputFrameEntry::serializedSize() const
-{
-    return sizeof(authoritativeFrameStartClockMicros) +
-           sizeof(uint8_t) +
-           (sizeof(PlayerSlot) + sizeof(uint64_t) + sizeof(uint64_t)) * slotMasks.size() +
-           sizeof(payloadSize);
-}
-
 void InputAckData::serialize(PacketWriter& writer) const
 {
     writer.writePod(timelineEpoch);
@@ -267,6 +207,7 @@ void FrameStatusData::serialize(PacketWriter& writer) const
     writer.writePod(currentFrame);
     writer.writePod(lastConfirmedFrame);
     writer.writePod(inputDelayFrames);
+    writer.writePod(rollbackEnabled);
     topology.serialize(writer);
 }
 
@@ -276,6 +217,7 @@ bool FrameStatusData::deserialize(PacketReader& reader, FrameStatusData& data)
            reader.readPod(data.currentFrame) &&
            reader.readPod(data.lastConfirmedFrame) &&
            reader.readPod(data.inputDelayFrames) &&
+           reader.readPod(data.rollbackEnabled) &&
            InputTopologyData::deserialize(reader, data.topology);
 }
 
@@ -285,6 +227,7 @@ size_t FrameStatusData::serializedSize() const
            sizeof(currentFrame) +
            sizeof(lastConfirmedFrame) +
            sizeof(inputDelayFrames) +
+           sizeof(rollbackEnabled) +
            topology.serializedSize();
 }
 
@@ -368,6 +311,7 @@ void StartSessionData::serialize(PacketWriter& writer) const
 {
     writer.writePod(state);
     writer.writePod(inputDelayFrames);
+    writer.writePod(rollbackEnabled);
     topology.serialize(writer);
 }
 
@@ -375,12 +319,13 @@ bool StartSessionData::deserialize(PacketReader& reader, StartSessionData& data)
 {
     return reader.readPod(data.state) &&
            reader.readPod(data.inputDelayFrames) &&
+           reader.readPod(data.rollbackEnabled) &&
            InputTopologyData::deserialize(reader, data.topology);
 }
 
 size_t StartSessionData::serializedSize() const
 {
-    return sizeof(state) + sizeof(inputDelayFrames) + topology.serializedSize();
+    return sizeof(state) + sizeof(inputDelayFrames) + sizeof(rollbackEnabled) + topology.serializedSize();
 }
 
 void PeerHealthData::serialize(PacketWriter& writer) const
@@ -456,17 +401,32 @@ void CrcReportData::serialize(PacketWriter& writer) const
     writer.writePod(submissionSource);
     writer.writePod(senderLocalSimulationFrame);
     writer.writePod(senderConfirmedFrame);
+    const uint8_t count = static_cast<uint8_t>(std::min(componentDigests.size(), kMaxStateComponentDigests));
+    writer.writePod(count);
+    for(uint8_t index = 0; index < count; ++index) {
+        writer.writePod(componentDigests[index]);
+    }
 }
 
 bool CrcReportData::deserialize(PacketReader& reader, CrcReportData& data)
 {
-    return reader.readPod(data.timelineEpoch) &&
-           reader.readPod(data.frame) &&
-           reader.readPod(data.crc32) &&
-           reader.readPod(data.severity) &&
-           reader.readPod(data.submissionSource) &&
-           reader.readPod(data.senderLocalSimulationFrame) &&
-           reader.readPod(data.senderConfirmedFrame);
+    uint8_t count = 0;
+    if(!reader.readPod(data.timelineEpoch) ||
+       !reader.readPod(data.frame) ||
+       !reader.readPod(data.crc32) ||
+       !reader.readPod(data.severity) ||
+       !reader.readPod(data.submissionSource) ||
+       !reader.readPod(data.senderLocalSimulationFrame) ||
+       !reader.readPod(data.senderConfirmedFrame) ||
+       !reader.readPod(count) ||
+       count > kMaxStateComponentDigests) {
+        return false;
+    }
+    data.componentDigests.resize(count);
+    for(uint8_t index = 0; index < count; ++index) {
+        if(!reader.readPod(data.componentDigests[index])) return false;
+    }
+    return true;
 }
 
 void ResyncBeginData::serialize(PacketWriter& writer) const
@@ -482,21 +442,37 @@ void ResyncBeginData::serialize(PacketWriter& writer) const
     writer.writePod(frameReadyCrc32);
     writer.writePod(inputSequenceBase);
     writer.writePod(reason);
+    const uint16_t count = static_cast<uint16_t>(std::min(segments.size(), kMaxResyncSegments));
+    writer.writePod(count);
+    for(uint16_t index = 0; index < count; ++index) {
+        writer.writePod(segments[index].size);
+        writer.writePod(segments[index].crc32);
+    }
 }
 
 bool ResyncBeginData::deserialize(PacketReader& reader, ResyncBeginData& data)
 {
-    return reader.readPod(data.resyncId) &&
-           reader.readPod(data.timelineEpoch) &&
-           reader.readPod(data.targetFrame) &&
-           reader.readPod(data.confirmedFrame) &&
-           reader.readPod(data.frameReadyFrame) &&
-           reader.readPod(data.payloadSize) &&
-           reader.readPod(data.payloadCrc32) &&
-           reader.readPod(data.stateCrc32) &&
-           reader.readPod(data.frameReadyCrc32) &&
-           reader.readPod(data.inputSequenceBase) &&
-           reader.readPod(data.reason);
+    uint16_t count = 0;
+    if(!reader.readPod(data.resyncId) ||
+       !reader.readPod(data.timelineEpoch) ||
+       !reader.readPod(data.targetFrame) ||
+       !reader.readPod(data.confirmedFrame) ||
+       !reader.readPod(data.frameReadyFrame) ||
+       !reader.readPod(data.payloadSize) ||
+       !reader.readPod(data.payloadCrc32) ||
+       !reader.readPod(data.stateCrc32) ||
+       !reader.readPod(data.frameReadyCrc32) ||
+       !reader.readPod(data.inputSequenceBase) ||
+       !reader.readPod(data.reason) ||
+       !reader.readPod(count) ||
+       count > kMaxResyncSegments) {
+        return false;
+    }
+    data.segments.resize(count);
+    for(ResyncSegment& segment : data.segments) {
+        if(!reader.readPod(segment.size) || !reader.readPod(segment.crc32)) return false;
+    }
+    return true;
 }
 
 void ResyncChunkData::serialize(PacketWriter& writer) const
@@ -589,4 +565,53 @@ bool ResyncRequestData::deserialize(PacketReader& reader, ResyncRequestData& dat
     return true;
 }
 
+namespace {
+void writeSegmentMask(PacketWriter& writer, const std::vector<uint8_t>& mask)
+{
+    const uint16_t size = static_cast<uint16_t>(std::min(mask.size(), kMaxResyncSegments / 8u));
+    writer.writePod(size);
+    writer.writeBytes(std::span<const uint8_t>(mask.data(), size));
+}
+
+bool readSegmentMask(PacketReader& reader, std::vector<uint8_t>& mask)
+{
+    uint16_t size = 0;
+    return reader.readPod(size) &&
+           size <= kMaxResyncSegments / 8u &&
+           reader.readBytes(mask, size);
+}
+} // namespace
+
+void ResyncSegmentRequestData::serialize(PacketWriter& writer) const
+{
+    writer.writePod(resyncId);
+    writer.writePod(participantId);
+    writeSegmentMask(writer, segmentMask);
+}
+
+bool ResyncSegmentRequestData::deserialize(PacketReader& reader, ResyncSegmentRequestData& data)
+{
+    return reader.readPod(data.resyncId) &&
+           reader.readPod(data.participantId) &&
+           readSegmentMask(reader, data.segmentMask);
+}
+
+void ResyncSegmentsData::serialize(PacketWriter& writer) const
+{
+    writer.writePod(resyncId);
+    writeSegmentMask(writer, segmentMask);
+    writer.writePod(rawSize);
+    writer.writePod(transferSize);
+    writer.writePod(encoding);
+}
+
+bool ResyncSegmentsData::deserialize(PacketReader& reader, ResyncSegmentsData& data)
+{
+    return reader.readPod(data.resyncId) &&
+           readSegmentMask(reader, data.segmentMask) &&
+           reader.readPod(data.rawSize) &&
+           reader.readPod(data.transferSize) &&
+           reader.readPod(data.encoding);
+}
+
 } // namespace ConsoleNetplay
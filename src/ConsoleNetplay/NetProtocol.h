@@ -14,10 +14,12 @@ namespace ConsoleNetplay {
 class PacketWriter;
 class PacketReader;
 
-constexpr uint8_t kProtocolVersion = 19;
+constexpr uint8_t kProtocolVersion = 23;
 constexpr size_t kMaxRomHashBytes = 32;
 constexpr size_t kMaxDisplayNameBytes = 32;
 constexpr size_t kMaxChatMessageBytes = 256;
+constexpr size_t kMaxStateComponentDigests = 32;
+constexpr size_t kMaxResyncSegments = 4096;
 
 enum class Channel : uint8_t
 {
@@ -57,7 +59,9 @@ enum class MessageType : uint16_t
     ResyncComplete,
     ResyncAck,
     ResyncAbort,
-    ResyncRequest
+    ResyncRequest,
+    ResyncSegmentRequest,
+    ResyncSegments
 };
 
 enum class ParticipantRole : uint8_t
@@ -88,6 +92,12 @@ enum class ResyncReason : uint8_t
     ObserverVisibilityRestore
 };
 
+enum class ResyncEncoding : uint8_t
+{
+    Raw = 0,
+    Deflate = 1
+};
+
 struct PacketHeader
 {
     uint8_t protocolVersion = kProtocolVersion;
@@ -170,6 +180,7 @@ struct InputTopologyData
     size_t serializedSize() const;
 };
 
+// One decoded InputFrame entry.
 struct InputFrameData
 {
     uint32_t timelineEpoch = 0;
@@ -180,12 +191,23 @@ struct InputFrameData
     uint64_t buttonMaskLo = 0;
     uint64_t buttonMaskHi = 0;
     uint32_t sequence = 0;
-    uint16_t payloadSize = 0;
+};
+
+// InputFrame body: this header, then the sender's latest inputs for the slot as packed
+// entries (writePackedInputFrames()), oldest first. Every packet repeats the frames the
+// host has not confirmed yet, so a lost one is filled in by the next.
+struct InputFrameBatchData
+{
+    uint32_t timelineEpoch = 0;
+    ParticipantId participantId = kInvalidParticipantId;
+    PlayerSlot playerSlot = kObserverPlayerSlot;
 
     void serialize(PacketWriter& writer) const;
-    static bool deserialize(PacketReader& reader, InputFrameData& data);
+    static bool deserialize(PacketReader& reader, InputFrameBatchData& data);
 };
 
+// ConfirmedInputFrames body: this header, then frameCount packed entries starting at
+// startFrame.
 struct ConfirmedInputFramesData
 {
     uint32_t timelineEpoch = 0;
@@ -196,27 +218,6 @@ struct ConfirmedInputFramesData
     static bool deserialize(PacketReader& reader, ConfirmedInputFramesData& data);
 };
 
-struct ConfirmedInputFrameEntry
-{
-    struct SlotMask
-    {
-        PlayerSlot slot = kObserverPlayerSlot;
-        uint64_t buttonMaskLo = 0;
-        uint64_t buttonMaskHi = 0;
-
-        void serialize(PacketWriter& writer) const;
-        static bool deserialize(PacketReader& reader, SlotMask& slotMask);
-    };
-
-    uint64_t authoritativeFrameStartClockMicros = 0;
-    std::vector<SlotMask> slotMasks;
-    uint16_t payloadSize = 0;
-
-    void serialize(PacketWriter& writer) const;
-    static bool deserialize(PacketReader& reader, ConfirmedInputFrameEntry& entry);
-    size_t serializedSize() const;
-};
-
 struct InputAckData
 {
     uint32_t timelineEpoch = 0;
@@ -235,6 +236,7 @@ struct FrameStatusData
     FrameNumber currentFrame = 0;
     FrameNumber lastConfirmedFrame = 0;
     uint8_t inputDelayFrames = 0;
+    uint8_t rollbackEnabled = 0;
     InputTopologyData topology = {};
 
     void serialize(PacketWriter& writer) const;
@@ -283,6 +285,7 @@ struct StartSessionData
 {
     SessionState state = SessionState::Lobby;
     uint8_t inputDelayFrames = 0;
+    uint8_t rollbackEnabled = 0;
     InputTopologyData topology = {};
 
     void serialize(PacketWriter& writer) const;
@@ -340,11 +343,19 @@ struct CrcReportData
     CrcSubmissionSource submissionSource = CrcSubmissionSource::Unknown;
     FrameNumber senderLocalSimulationFrame = 0;
     FrameNumber senderConfirmedFrame = 0;
+    // Component digests crc32 is the root of; empty when the sender hashes the state whole.
+    std::vector<uint32_t> componentDigests;
 
     void serialize(PacketWriter& writer) const;
     static bool deserialize(PacketReader& reader, CrcReportData& data);
 };
 
+struct ResyncSegment
+{
+    uint32_t size = 0;
+    uint32_t crc32 = 0;
+};
+
 struct ResyncBeginData
 {
     uint32_t resyncId = 0;
@@ -358,6 +369,10 @@ struct ResyncBeginData
     uint32_t frameReadyCrc32 = 0;
     uint32_t inputSequenceBase = 0;
     ResyncReason reason = ResyncReason::Unspecified;
+    // Consecutive pieces of the payload. Receivers keep the ones their own state already
+    // has and ask for the rest with ResyncSegmentRequest; no segments means the chunks
+    // follow right away and carry the payload itself.
+    std::vector<ResyncSegment> segments;
 
     void serialize(PacketWriter& writer) const;
     static bool deserialize(PacketReader& reader, ResyncBeginData& data);
@@ -420,4 +435,29 @@ struct ResyncRequestData
     static bool deserialize(PacketReader& reader, ResyncRequestData& data);
 };
 
+// One bit per ResyncBeginData segment, lowest bit first.
+struct ResyncSegmentRequestData
+{
+    uint32_t resyncId = 0;
+    ParticipantId participantId = kInvalidParticipantId;
+    std::vector<uint8_t> segmentMask;
+
+    void serialize(PacketWriter& writer) const;
+    static bool deserialize(PacketReader& reader, ResyncSegmentRequestData& data);
+};
+
+// Answers a segment request. The chunks that follow fill transferSize bytes: the requested
+// segments back to back (rawSize bytes), deflated when that came out smaller.
+struct ResyncSegmentsData
+{
+    uint32_t resyncId = 0;
+    std::vector<uint8_t> segmentMask;
+    uint32_t rawSize = 0;
+    uint32_t transferSize = 0;
+    ResyncEncoding encoding = ResyncEncoding::Raw;
+
+    void serialize(PacketWriter& writer) const;
+    static bool deserialize(PacketReader& reader, ResyncSegmentsData& data);
+};
+
 } // namespace ConsoleNetplay
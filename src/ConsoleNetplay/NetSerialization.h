@@ -1,6 +1,8 @@
 #pragma once
 
+#include <cstdint>
 #include <cstring>
+#include <limits>
 #include <span>
 #include <string>
 #include <type_traits>
@@ -37,6 +39,16 @@ public:
         }
     }
 
+    // LEB128: seven bits per byte, low bits first, so small values take one byte.
+    void writeVarint(uint64_t value)
+    {
+        while(value >= 0x80u) {
+            writePod(static_cast<uint8_t>(value | 0x80u));
+            value >>= 7;
+        }
+        writePod(static_cast<uint8_t>(value));
+    }
+
     void writeString(const std::string& value)
     {
         const uint16_t size = static_cast<uint16_t>(value.size());
@@ -74,6 +86,24 @@ public:
         return true;
     }
 
+    template<typename T>
+    bool readVarint(T& value)
+    {
+        static_assert(std::is_unsigned_v<T>);
+        uint64_t result = 0;
+        for(unsigned shift = 0; shift < 64u; shift += 7u) {
+            uint8_t byte = 0;
+            if(!readPod(byte)) return false;
+            result |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+            if((byte & 0x80u) == 0) {
+                if(result > std::numeric_limits<T>::max()) return false;
+                value = static_cast<T>(result);
+                return true;
+            }
+        }
+        return false;
+    }
+
     bool readString(std::string& value)
     {
         uint16_t size = 0;
@@ -79,6 +79,8 @@ struct RoomState
     SessionState state = SessionState::Lobby;
     uint32_t timelineEpoch = 0;
     uint8_t inputDelayFrames = 2;
+    // Set by the host for the whole room, so every peer predicts when the delay is capped.
+    bool rollbackEnabled = false;
     // `currentFrame`: latest frame the host has reported as locally simulated.
     FrameNumber currentFrame = 0;
     // `lastConfirmedFrame`: highest frame the authoritative input timeline has
@@ -89,6 +91,9 @@ struct RoomState
     CrcSubmissionSource lastRemoteCrcSubmissionSource = CrcSubmissionSource::Unknown;
     FrameNumber lastRemoteCrcSenderLocalSimulationFrame = 0;
     FrameNumber lastRemoteCrcSenderConfirmedFrame = 0;
+    FrameNumber lastCrcMismatchFrame = 0;
+    // Components that differed on lastCrcMismatchFrame, bit per component digest.
+    uint32_t lastCrcMismatchComponentMask = 0;
     uint32_t lastAcceptedRemoteEpoch = 0;
     uint32_t lastIgnoredStaleInputEpoch = 0;
     uint32_t lastIgnoredStaleFrameStatusEpoch = 0;
@@ -55,6 +55,11 @@ void NetplayAppRuntime::FramePacingDiagnostics::record(uint32_t dtMs,
     presenterCadenceMatched = cadenceMatched;
 }
 
+NetplayAppRuntime::NetplayAppRuntime()
+{
+    m_coordinator.setPartialResyncEnabled(true);
+}
+
 void NetplayAppRuntime::enqueueRuntimeCommand(RuntimeCommand command)
 {
     std::scoped_lock stateLock(m_stateMutex);
@@ -453,7 +458,7 @@ bool NetplayAppRuntime::tryBuildPlaybackFrame(FrameNumber frame,
                                               NetplayCoordinator::ConfirmedFrameInputs& outFrame)
 {
     m_coordinator.recordLocalAuthoritativeFrameStart(frame);
-    return runtimeTryBuildPlaybackConfirmedFrame(m_coordinator, m_inputDriver, frame, outFrame);
+    return runtimeTryBuildRollbackPlaybackFrame(m_coordinator, m_inputDriver, m_rollback, frame, outFrame);
 }
 
 NetplayAppRuntime::UpdateResult NetplayAppRuntime::update(UpdateContext context)
@@ -705,6 +710,7 @@ void NetplayAppRuntime::resetInactiveRuntimeState()
     m_runtimeRunning.store(false, std::memory_order_release);
     m_inputDriver.reset();
     m_selfStallDetector.reset();
+    m_rollback.reset();
     m_runtimeLastTickTime = {};
     m_romValidationState.lastSelectedRomKey.clear();
     m_romValidationState.lastSubmittedValidationKey.clear();
@@ -725,6 +731,7 @@ void NetplayAppRuntime::resetInactiveRuntimeState()
 void NetplayAppRuntime::reanchorInputDriver(FrameNumber anchorFrame)
 {
     m_inputDriver.reanchor(anchorFrame);
+    m_rollback.reset();
     m_recoveryProcessState.lastRecoveryReanchorFrame = anchorFrame;
 }
 
@@ -796,7 +803,10 @@ void NetplayAppRuntime::syncRomValidation(const std::optional<RomSelection>& loc
 
 RuntimeInputDelayResult NetplayAppRuntime::syncInputDelayFromSettings(const RuntimeInputDelaySettings& settings)
 {
-    return runtimeSyncInputDelaySettings(m_coordinator, m_inputDriver, m_autoSettings, settings);
+    const RuntimeInputDelayResult result =
+        runtimeSyncInputDelaySettings(m_coordinator, m_inputDriver, m_autoSettings, settings);
+    m_rollback.setEnabled(result.rollbackEnabled);
+    return result;
 }
 
 bool NetplayAppRuntime::processAutoStartIfNeeded(INetplayStateBridge& stateBridge,
@@ -850,7 +860,8 @@ void NetplayAppRuntime::processPeriodicLocalCrcIfNeeded(INetplayStateBridge& sta
         m_coordinator,
         stateBridge,
         hostBridge,
-        m_periodicCrcState
+        m_periodicCrcState,
+        &m_rollback
     );
 }
 
@@ -948,6 +959,7 @@ RuntimePendingResyncApplyResult NetplayAppRuntime::processResyncIfNeededOnWorker
     INetplayStateBridge& stateBridge,
     INetplayStateHostBridge& hostBridge)
 {
+    runtimeProvideResyncBaseIfNeeded(m_coordinator, stateBridge, hostBridge);
     const RuntimePendingResyncApplyResult result =
         runtimeProcessPendingResyncApplyIfNeeded(
             m_coordinator,
@@ -1010,6 +1022,9 @@ NetplayAppRuntime::RuntimeFrameResult NetplayAppRuntime::runActiveConsoleFrame(
 
     const RuntimePendingResyncApplyResult resyncResult =
         processResyncIfNeededOnWorker(stateBridge, hostBridge);
+    if(resyncResult.consumed) {
+        m_rollback.reset();
+    }
     if(resyncResult.loadedExpectedFrame &&
        m_coordinator.isActive() &&
        m_coordinator.session().roomState().state == SessionState::Running &&
@@ -1057,6 +1072,7 @@ NetplayAppRuntime::RuntimeFrameResult NetplayAppRuntime::runActiveConsoleFrame(
         result.running
     );
     if(assignmentLayout.layoutChanged || assignmentLayout.localSlotsChanged) {
+        m_rollback.reset();
         console.discardQueuedInputFramesAfter(console.frameCount());
         if(settings.discardQueuedNetplayInputsAfter) {
             settings.discardQueuedNetplayInputsAfter(console.frameCount());
@@ -1075,6 +1091,37 @@ NetplayAppRuntime::RuntimeFrameResult NetplayAppRuntime::runActiveConsoleFrame(
         workerDtMs
     );
 
+    // Observers only follow confirmed input, so there is nothing for them to predict.
+    // Without snapshots no prediction can start, which keeps rollback off everywhere else.
+    const bool rollbackActive =
+        m_rollback.enabled() && result.running && !assignmentLayout.localSlots.empty();
+    if(rollbackActive) {
+        const RuntimeRollbackResult rollbackResult =
+            runtimeRollbackMispredictedFrames(
+                m_coordinator,
+                m_rollback,
+                console,
+                hostBridge,
+                m_periodicCrcState
+            );
+        if(rollbackResult.failed) {
+            m_coordinator.appendNetplayLog(
+                "Netplay rollback to frame " +
+                std::to_string(rollbackResult.fromFrame) +
+                " failed; waiting for the desync check to resync"
+            );
+        } else if(rollbackResult.rolledBack && settings.showDebugLog) {
+            m_coordinator.appendNetplayLog(
+                "Netplay rollback replayed " +
+                std::to_string(rollbackResult.resimulatedFrames) +
+                " frame(s) from " +
+                std::to_string(rollbackResult.fromFrame)
+            );
+        }
+    } else {
+        m_rollback.reset();
+    }
+
     if(result.running) {
         constexpr uint32_t kMaxObserverPeerCatchupFrames = 120u;
         (void)runtimeAdvanceObserverPeerIfNeeded(
@@ -1088,6 +1135,9 @@ NetplayAppRuntime::RuntimeFrameResult NetplayAppRuntime::runActiveConsoleFrame(
         constexpr uint32_t kMaxContinuousClockCatchupFrames = 120u;
         (void)advanceToSharedClockIfNeededOnWorker(console, kMaxContinuousClockCatchupFrames);
 
+        if(rollbackActive) {
+            runtimeCaptureRollbackSnapshot(m_rollback, console, m_periodicCrcState);
+        }
         runtimePreparePlaybackFrames(m_coordinator, m_inputDriver, console);
         (void)tryQueuePlaybackFrameToConsole(console, console.frameCount());
     }
@@ -1114,6 +1164,8 @@ void NetplayAppRuntime::updateUiSnapshot(const std::optional<RomSelection>& loca
         computeSessionBlockedReason(localRom),
         netplayDebugLogEnabled()
     );
+    snapshot.rollbackEnabled = m_rollback.enabled();
+    snapshot.rollbackStats = m_rollback.stats();
 
     std::scoped_lock stateLock(m_stateMutex);
     if(m_coordinator.localReconnectToken() != 0) {
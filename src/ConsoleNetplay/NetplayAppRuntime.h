@@ -15,6 +15,7 @@
 #include "ConsoleNetplay/NetplayRuntimeTypes.h"
 #include "ConsoleNetplay/NetplayAutoTune.h"
 #include "ConsoleNetplay/NetplayCoordinator.h"
+#include "ConsoleNetplay/NetplayRollback.h"
 #include "ConsoleNetplay/NetplayRuntimeSupport.h"
 #include "ConsoleNetplay/SelfStallDetector.h"
 
@@ -74,6 +75,8 @@ public:
         FrameNumber lastLoadedAuthoritativeFrame = 0;
         FrameNumber lastRecoveryReanchorFrame = 0;
         NetplayAutoTune::Snapshot autoSettings;
+        bool rollbackEnabled = false;
+        NetplayRollback::Stats rollbackStats;
         FramePacingDiagnostics framePacingDiagnostics;
         NetplayRuntimeDiagnostics runtimeDiagnostics;
         std::string sessionBlockedReason;
@@ -126,6 +129,7 @@ public:
         uint32_t inputDelayFrames = 0;
     };
 
+    NetplayAppRuntime();
     virtual ~NetplayAppRuntime() = default;
 
     UpdateResult update(UpdateContext context);
@@ -268,6 +272,7 @@ private:
     ConfirmedInputBufferDriver m_inputDriver;
     SelfStallDetector m_selfStallDetector;
     NetplayAutoTune m_autoSettings;
+    NetplayRollback m_rollback;
     FramePacingDiagnostics m_framePacingDiagnostics;
 
     mutable std::mutex m_stateMutex;
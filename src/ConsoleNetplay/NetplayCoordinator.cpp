@@ -16,11 +16,13 @@
 #include "ConsoleNetplay/NetplayConfig.h"
 #include "ConsoleNetplay/NetplayCrc32.h"
 #include "ConsoleNetplay/NetplayLog.h"
+#include "ConsoleNetplay/ResyncPayload.h"
 
 namespace {
 
 constexpr size_t kResyncChunkPayloadBytes = 1024;
 constexpr size_t kMaxIncomingResyncPayloadBytes = 64u * 1024u * 1024u;
+constexpr size_t kMaxOutgoingResyncTransfers = 4;
 constexpr size_t kConfirmedFrameHistoryCapacity = 16384;
 constexpr uint16_t kMaxConfirmedFramesPerPacket = 64;
 constexpr auto kReconnectRetryDelay = std::chrono::milliseconds(750);
@@ -38,7 +40,10 @@ constexpr size_t kMaxChatHistoryEntries = 128;
 constexpr uint8_t kLocalInputRejectNone = 0u;
 constexpr uint8_t kLocalInputRejectExistingFrame = 1u;
 constexpr uint8_t kLocalInputRejectNonSequential = 2u;
-constexpr uint8_t kInputFrameRedundancyCount = 8u;
+// Inputs repeated in every InputFrame packet: always the latest few, and back to the
+// oldest one the host has not confirmed yet up to the maximum.
+constexpr size_t kMinInputFrameRedundancy = 8u;
+constexpr size_t kMaxInputFrameRedundancy = 32u;
 
 const char* localInputRejectReasonLabel(uint8_t reason)
 {
@@ -346,6 +351,27 @@ ConsoleNetplay::AssignControllerData makeAssignControllerData(const ConsoleNetpl
     return data;
 }
 
+std::vector<ConsoleNetplay::PackedInputFrameEntry> packConfirmedFrames(
+    std::span<const ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs> frames)
+{
+    std::vector<ConsoleNetplay::PackedInputFrameEntry> entries;
+    entries.reserve(frames.size());
+    for(const auto& frame : frames) {
+        ConsoleNetplay::PackedInputFrameEntry entry;
+        entry.frame = frame.frame;
+        // Confirmed frames have no sequence; following the frame number keeps it free on the wire.
+        entry.sequence = frame.frame;
+        entry.clockMicros = frame.authoritativeFrameStartClockMicros;
+        for(ConsoleNetplay::PlayerSlot slot : frame.netplayFrame.activeSlots()) {
+            entry.buttonMaskLo[slot] = frame.buttonMaskLo[slot];
+            entry.buttonMaskHi[slot] = frame.buttonMaskHi[slot];
+        }
+        entry.netplayFrame = frame.netplayFrame;
+        entries.push_back(std::move(entry));
+    }
+    return entries;
+}
+
 }
 
 namespace ConsoleNetplay {
@@ -450,6 +476,8 @@ std::string NetplayCoordinator::messageTypeLabel(MessageType type)
         case MessageType::ResyncAck: return "ResyncAck";
         case MessageType::ResyncAbort: return "ResyncAbort";
         case MessageType::ResyncRequest: return "ResyncRequest";
+        case MessageType::ResyncSegmentRequest: return "ResyncSegmentRequest";
+        case MessageType::ResyncSegments: return "ResyncSegments";
         default: return "Unknown";
     }
 }
@@ -513,6 +541,7 @@ void NetplayCoordinator::resetSessionState()
     m_confirmedDesyncRequestSuppressedUntilFrame = 0;
     m_nextResyncId = 1;
     m_incomingResync.reset();
+    m_outgoingResyncs.clear();
     m_pendingResyncApply.reset();
     m_pendingHostLateJoinResyncParticipant.reset();
     m_remoteInputStallMonitor.reset();
@@ -730,6 +759,7 @@ bool NetplayCoordinator::sendCurrentSessionStateToPeer(NetTransport::PeerHandle
         StartSessionData startData;
         startData.state = SessionState::Paused;
         startData.inputDelayFrames = m_session.roomState().inputDelayFrames;
+        startData.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
         startData.topology = makeTopologyData(m_session.roomState());
         startData.serialize(writer);
         return m_transport.sendReliable(peer, Channel::Control, writer.data());
@@ -744,6 +774,7 @@ bool NetplayCoordinator::sendCurrentSessionStateToPeer(NetTransport::PeerHandle
         StartSessionData startData;
         startData.state = SessionState::Running;
         startData.inputDelayFrames = m_session.roomState().inputDelayFrames;
+        startData.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
         startData.topology = makeTopologyData(m_session.roomState());
         startData.serialize(writer);
         return m_transport.sendReliable(peer, Channel::Control, writer.data());
@@ -768,22 +799,8 @@ bool NetplayCoordinator::sendConfirmedFramesToPeer(NetTransport::PeerHandle peer
         data.startFrame = frames.front().frame;
         data.frameCount = static_cast<uint16_t>(frames.size());
         data.serialize(writer);
-
-        for(const auto& frame : frames) {
-            ConfirmedInputFrameEntry entry;
-            entry.authoritativeFrameStartClockMicros = frame.authoritativeFrameStartClockMicros;
-            for(PlayerSlot slot : frame.netplayFrame.activeSlots()) {
-                entry.slotMasks.push_back(ConfirmedInputFrameEntry::SlotMask{
-                    slot,
-                    frame.buttonMaskLo[slot],
-                    frame.buttonMaskHi[slot]
-                });
-            }
-            const std::vector<uint8_t> payload = serializeNetplayInputFrame(frame.netplayFrame);
-            entry.payloadSize = static_cast<uint16_t>(payload.size());
-            entry.serialize(writer);
-            writer.writeBytes(std::span<const uint8_t>(payload.data(), payload.size()));
-        }
+        const std::vector<PackedInputFrameEntry> entries = packConfirmedFrames(frames);
+        writePackedInputFrames(writer, data.timelineEpoch, entries);
 
         return writer.data();
     };
@@ -898,6 +915,7 @@ void NetplayCoordinator::finalizeActiveResyncIfReady()
     StartSessionData startData;
     startData.state = SessionState::Running;
     startData.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    startData.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     startData.topology = makeTopologyData(m_session.roomState());
     startData.serialize(writer);
     m_transport.broadcastReliable(Channel::Control, writer.data());
@@ -1325,6 +1343,77 @@ std::vector<uint8_t> NetplayCoordinator::buildResyncRequestPacket(const ResyncRe
     return writer.data();
 }
 
+std::vector<uint8_t> NetplayCoordinator::buildResyncSegmentRequestPacket(const ResyncSegmentRequestData& data) const
+{
+    PacketWriter writer;
+
+    PacketHeader header;
+    header.type = MessageType::ResyncSegmentRequest;
+    header.sessionId = m_session.roomState().sessionId;
+    header.serialize(writer);
+    data.serialize(writer);
+
+    return writer.data();
+}
+
+std::vector<uint8_t> NetplayCoordinator::buildResyncSegmentsPacket(const ResyncSegmentsData& data) const
+{
+    PacketWriter writer;
+
+    PacketHeader header;
+    header.type = MessageType::ResyncSegments;
+    header.sessionId = m_session.roomState().sessionId;
+    header.serialize(writer);
+    data.serialize(writer);
+
+    return writer.data();
+}
+
+void NetplayCoordinator::sendResyncChunks(NetTransport::PeerHandle peer, uint32_t resyncId, std::span<const uint8_t> data)
+{
+    for(size_t offset = 0; offset < data.size(); offset += kResyncChunkPayloadBytes) {
+        const size_t chunkSize = std::min(kResyncChunkPayloadBytes, data.size() - offset);
+        ResyncChunkData chunkData;
+        chunkData.resyncId = resyncId;
+        chunkData.offset = static_cast<uint32_t>(offset);
+        chunkData.size = static_cast<uint16_t>(chunkSize);
+        const std::vector<uint8_t> chunkPacket =
+            buildResyncChunkPacket(chunkData, data.subspan(offset, chunkSize));
+        if(peer != NetTransport::kInvalidPeerHandle) {
+            m_transport.sendReliable(peer, Channel::Control, chunkPacket);
+        } else {
+            m_transport.broadcastReliable(Channel::Control, chunkPacket);
+        }
+    }
+
+    ResyncCompleteData completeData;
+    completeData.resyncId = resyncId;
+    const std::vector<uint8_t> completePacket = buildResyncCompletePacket(completeData);
+    if(peer != NetTransport::kInvalidPeerHandle) {
+        m_transport.sendReliable(peer, Channel::Control, completePacket);
+    } else {
+        m_transport.broadcastReliable(Channel::Control, completePacket);
+    }
+}
+
+void NetplayCoordinator::requestResyncSegments(const std::vector<uint8_t>& segmentMask)
+{
+    if(!m_incomingResync.has_value()) return;
+
+    m_incomingResync->requestedMask = segmentMask;
+    m_incomingResync->transferInfo.reset();
+    m_incomingResync->transfer.clear();
+    m_incomingResync->transferReceivedMask.clear();
+    m_incomingResync->lastActivityAt = std::chrono::steady_clock::now();
+    if(m_hosting || m_serverPeer == NetTransport::kInvalidPeerHandle) return;
+
+    ResyncSegmentRequestData request;
+    request.resyncId = m_incomingResync->resyncId;
+    request.participantId = m_localParticipantId;
+    request.segmentMask = segmentMask;
+    m_transport.sendReliable(m_serverPeer, Channel::Control, buildResyncSegmentRequestPacket(request));
+}
+
 namespace {
 std::string resyncRequestFlagsLabel(uint16_t flags)
 {
@@ -1375,40 +1464,41 @@ std::vector<uint8_t> NetplayCoordinator::buildPeerHealthPacket(const PeerHealthD
     return writer.data();
 }
 
-struct SerializedInputFrameEntry
-{
-    InputFrameData input;
-    std::span<const uint8_t> serializedInputFrame;
-};
-
-static std::vector<uint8_t> buildInputFramePacket(std::span<const SerializedInputFrameEntry> entries)
+static std::vector<uint8_t> buildInputFramePacket(const InputFrameBatchData& batch,
+                                                  std::span<const PackedInputFrameEntry> entries)
 {
     PacketWriter writer;
-    size_t estimatedPayloadSize = sizeof(PacketHeader) + sizeof(uint8_t);
-    for(const SerializedInputFrameEntry& entry : entries) {
-        estimatedPayloadSize += sizeof(InputFrameData) + entry.serializedInputFrame.size();
-    }
-    writer.reserve(estimatedPayloadSize);
 
     PacketHeader header;
     header.type = MessageType::InputFrame;
     header.sessionId = 0;
     header.serialize(writer);
-    const uint8_t entryCount = static_cast<uint8_t>(std::min<size_t>(entries.size(), std::numeric_limits<uint8_t>::max()));
-    writer.writePod(entryCount);
-    for(uint8_t index = 0; index < entryCount; ++index) {
-        entries[index].input.serialize(writer);
-        writer.writeBytes(entries[index].serializedInputFrame);
-    }
+    batch.serialize(writer);
+    writePackedInputFrames(writer, batch.timelineEpoch, entries);
 
     return writer.data();
 }
 
-static std::vector<uint8_t> buildInputFramePacket(const InputFrameData& input,
-                                                  std::span<const uint8_t> serializedInputFrame)
+static PackedInputFrameEntry packInputFrame(const InputFrameData& input, const NetplayInputFrame& netplayFrame)
+{
+    PackedInputFrameEntry entry;
+    entry.frame = input.frame;
+    entry.sequence = input.sequence;
+    entry.clockMicros = input.authoritativeFrameStartClockMicros;
+    entry.buttonMaskLo[input.playerSlot] = input.buttonMaskLo;
+    entry.buttonMaskHi[input.playerSlot] = input.buttonMaskHi;
+    entry.netplayFrame = netplayFrame;
+    return entry;
+}
+
+static std::vector<uint8_t> buildInputFramePacket(const InputFrameData& input, const NetplayInputFrame& netplayFrame)
 {
-    const SerializedInputFrameEntry entry{input, serializedInputFrame};
-    return buildInputFramePacket(std::span<const SerializedInputFrameEntry>(&entry, 1));
+    InputFrameBatchData batch;
+    batch.timelineEpoch = input.timelineEpoch;
+    batch.participantId = input.participantId;
+    batch.playerSlot = input.playerSlot;
+    const PackedInputFrameEntry entry = packInputFrame(input, netplayFrame);
+    return buildInputFramePacket(batch, std::span<const PackedInputFrameEntry>(&entry, 1));
 }
 
 static std::vector<uint8_t> buildConfirmedInputFramesPacket(const ConfirmedInputFramesData& data,
@@ -1416,35 +1506,14 @@ static std::vector<uint8_t> buildConfirmedInputFramesPacket(const ConfirmedInput
                                                             uint32_t sessionId)
 {
     PacketWriter writer;
-    size_t estimatedPayloadSize = sizeof(PacketHeader) + sizeof(ConfirmedInputFramesData);
-    for(const auto& frame : frames) {
-        estimatedPayloadSize += sizeof(uint64_t) + sizeof(uint8_t) + sizeof(uint16_t) +
-                                (frame.netplayFrame.activeSlots().size() * sizeof(ConfirmedInputFrameEntry::SlotMask)) +
-                                ConsoleNetplay::serializedNetplayInputFrameSize(frame.netplayFrame);
-    }
-    writer.reserve(estimatedPayloadSize);
 
     PacketHeader header;
     header.type = MessageType::ConfirmedInputFrames;
     header.sessionId = sessionId;
     header.serialize(writer);
     data.serialize(writer);
-    for(const auto& frame : frames) {
-        const std::vector<uint8_t> payload = serializeNetplayInputFrame(frame.netplayFrame);
-
-        ConfirmedInputFrameEntry entry;
-        entry.authoritativeFrameStartClockMicros = frame.authoritativeFrameStartClockMicros;
-        for(PlayerSlot slot : frame.netplayFrame.activeSlots()) {
-            entry.slotMasks.push_back(ConfirmedInputFrameEntry::SlotMask{
-                slot,
-                frame.buttonMaskLo[slot],
-                frame.buttonMaskHi[slot]
-            });
-        }
-        entry.payloadSize = static_cast<uint16_t>(payload.size());
-        entry.serialize(writer);
-        writer.writeBytes(std::span<const uint8_t>(payload.data(), payload.size()));
-    }
+    const std::vector<PackedInputFrameEntry> entries = packConfirmedFrames(frames);
+    writePackedInputFrames(writer, data.timelineEpoch, entries);
 
     return writer.data();
 }
@@ -1537,26 +1606,30 @@ static std::vector<uint8_t> buildSessionStatePacket(MessageType type, SessionSta
 
 bool NetplayCoordinator::handleInputFrame(NetTransport::PeerHandle peer, PacketReader& reader)
 {
-    uint8_t entryCount = 0;
-    if(!reader.readPod(entryCount)) return false;
-    if(entryCount == 0 || entryCount > kInputFrameRedundancyCount) return false;
+    InputFrameBatchData batch;
+    if(!InputFrameBatchData::deserialize(reader, batch)) return false;
+    std::vector<PackedInputFrameEntry> entries;
+    if(!readPackedInputFrames(reader, batch.timelineEpoch, kMaxInputFrameRedundancy, entries)) return false;
+    if(entries.empty()) return false;
 
     bool accepted = true;
-    for(uint8_t index = 0; index < entryCount; ++index) {
+    for(PackedInputFrameEntry& entry : entries) {
         InputFrameData input;
-        if(!InputFrameData::deserialize(reader, input)) return false;
-        std::vector<uint8_t> payload;
-        if(!reader.readBytes(payload, input.payloadSize)) return false;
-        NetplayInputFrame netplayFrame;
-        if(!deserializeNetplayInputFrame(payload.data(), payload.size(), netplayFrame)) return false;
-        accepted = handleInputFrameEntry(peer, input, payload, std::move(netplayFrame)) && accepted;
+        input.timelineEpoch = batch.timelineEpoch;
+        input.frame = entry.frame;
+        input.authoritativeFrameStartClockMicros = entry.clockMicros;
+        input.participantId = batch.participantId;
+        input.playerSlot = batch.playerSlot;
+        input.buttonMaskLo = entry.buttonMaskLo[batch.playerSlot];
+        input.buttonMaskHi = entry.buttonMaskHi[batch.playerSlot];
+        input.sequence = entry.sequence;
+        accepted = handleInputFrameEntry(peer, input, std::move(entry.netplayFrame)) && accepted;
     }
     return accepted;
 }
 
 bool NetplayCoordinator::handleInputFrameEntry(NetTransport::PeerHandle peer,
                                                const InputFrameData& input,
-                                               const std::vector<uint8_t>& payload,
                                                NetplayInputFrame netplayFrame)
 {
     ParticipantInfo* participant = m_session.findParticipant(input.participantId);
@@ -1854,7 +1927,7 @@ bool NetplayCoordinator::handleInputFrameEntry(NetTransport::PeerHandle peer,
             authoritativeFrameStartClockMicros(input.frame);
         m_transport.broadcastUnreliable(
             Channel::Gameplay,
-            buildInputFramePacket(relayedInput, std::span<const uint8_t>(payload.data(), payload.size())),
+            buildInputFramePacket(relayedInput, entry.netplayFrame),
             peer
         );
         publishConfirmedFramesIfReady();
@@ -1884,20 +1957,23 @@ bool NetplayCoordinator::handleConfirmedInputFrames(PacketReader& reader)
         return true;
     }
 
+    std::vector<PackedInputFrameEntry> entries;
+    if(data.frameCount > 0 &&
+       (!readPackedInputFrames(reader, data.timelineEpoch, data.frameCount, entries) ||
+        entries.size() != data.frameCount)) {
+        return false;
+    }
+
     for(uint16_t i = 0; i < data.frameCount; ++i) {
-        ConfirmedInputFrameEntry entry;
-        if(!ConfirmedInputFrameEntry::deserialize(reader, entry)) return false;
-        std::vector<uint8_t> payload;
-        if(!reader.readBytes(payload, entry.payloadSize)) return false;
+        PackedInputFrameEntry& entry = entries[i];
+        if(entry.frame != data.startFrame + static_cast<FrameNumber>(i)) return false;
 
         ConfirmedFrameInputs frame;
-        frame.frame = data.startFrame + static_cast<FrameNumber>(i);
-        frame.authoritativeFrameStartClockMicros = entry.authoritativeFrameStartClockMicros;
-        for(const auto& slotMask : entry.slotMasks) {
-            frame.buttonMaskLo[slotMask.slot] = slotMask.buttonMaskLo;
-            frame.buttonMaskHi[slotMask.slot] = slotMask.buttonMaskHi;
-        }
-        if(!deserializeNetplayInputFrame(payload.data(), payload.size(), frame.netplayFrame)) return false;
+        frame.frame = entry.frame;
+        frame.authoritativeFrameStartClockMicros = entry.clockMicros;
+        frame.buttonMaskLo = std::move(entry.buttonMaskLo);
+        frame.buttonMaskHi = std::move(entry.buttonMaskHi);
+        frame.netplayFrame = std::move(entry.netplayFrame);
         storeConfirmedFrame(frame);
         if(frame.authoritativeFrameStartClockMicros != 0u) {
             m_session.roomState().lastAuthoritativeClockFrame = frame.frame;
@@ -2445,6 +2521,7 @@ bool NetplayCoordinator::handleFrameStatus(PacketReader& reader)
     m_session.roomState().currentFrame = status.currentFrame;
     m_session.roomState().lastConfirmedFrame = status.lastConfirmedFrame;
     m_session.roomState().inputDelayFrames = status.inputDelayFrames;
+    m_session.roomState().rollbackEnabled = status.rollbackEnabled != 0;
     applyTopologyData(m_session.roomState(), status.topology);
     renormalizeParticipantsForCurrentTopology(m_session.roomState());
     advanceRecoveryStabilization(status.currentFrame);
@@ -2481,7 +2558,8 @@ bool NetplayCoordinator::handleCrcReport(PacketReader& reader)
         report.crc32,
         report.submissionSource,
         report.senderLocalSimulationFrame,
-        report.senderConfirmedFrame
+        report.senderConfirmedFrame,
+        std::move(report.componentDigests)
     };
     if(!isTrustedConfirmedCanonicalCrc(remoteEntry)) {
         if(m_debugMode) {
@@ -2547,6 +2625,11 @@ void NetplayCoordinator::applyDesyncMonitorUpdate(const DesyncMonitor::Update& u
             << "}";
     };
 
+    const auto appendMismatchedComponents = [&](std::ostringstream& oss) {
+        if(update.mismatchedComponentMask == 0u) return;
+        oss << " components=0x" << std::hex << update.mismatchedComponentMask << std::dec;
+    };
+
     if(update.compared && !update.mismatchDetected &&
        m_session.roomState().recoveryInputMode == RecoveryInputMode::PostResyncStabilizing &&
        update.frame >= m_session.roomState().recoveryModeEnteredAtFrame) {
@@ -2555,6 +2638,9 @@ void NetplayCoordinator::applyDesyncMonitorUpdate(const DesyncMonitor::Update& u
 
     if(!update.mismatchDetected) return;
 
+    m_session.roomState().lastCrcMismatchFrame = update.frame;
+    m_session.roomState().lastCrcMismatchComponentMask = update.mismatchedComponentMask;
+
     if(m_session.roomState().recoveryInputMode == RecoveryInputMode::PostResyncStabilizing &&
        update.frame >= m_session.roomState().recoveryModeEnteredAtFrame) {
         ++m_session.roomState().stabilizationCrcMismatchCount;
@@ -2566,6 +2652,7 @@ void NetplayCoordinator::applyDesyncMonitorUpdate(const DesyncMonitor::Update& u
         oss << " consecutive=" << static_cast<uint32_t>(update.consecutiveMismatchCount)
             << " classification=post_resync_stabilizing_crc_mismatch"
             << " action=ignored_for_resync_pressure";
+        appendMismatchedComponents(oss);
         appendFirstMismatchDebugDetail(oss);
         pushLog(oss.str());
         return;
@@ -2578,6 +2665,7 @@ void NetplayCoordinator::applyDesyncMonitorUpdate(const DesyncMonitor::Update& u
     }
     oss << " consecutive=" << static_cast<uint32_t>(update.consecutiveMismatchCount)
         << " classification=confirmed_crc_mismatch";
+    appendMismatchedComponents(oss);
     appendFirstMismatchDebugDetail(oss);
     pushLog(oss.str());
 
@@ -3290,6 +3378,10 @@ bool NetplayCoordinator::handleResyncBegin(PacketReader& reader)
         pushLog("Rejected resync begin: payload exceeds safety limit");
         return false;
     }
+    if(!data.segments.empty() && !resyncSegmentsCover(data.segments, data.payloadSize)) {
+        pushLog("Rejected resync begin: segments do not cover the payload");
+        return false;
+    }
     if(m_pendingResyncApply.has_value() &&
        m_pendingResyncApply->resyncId != data.resyncId) {
         std::ostringstream oss;
@@ -3320,6 +3412,7 @@ bool NetplayCoordinator::handleResyncBegin(PacketReader& reader)
     m_incomingResync->payload.resize(data.payloadSize);
     m_incomingResync->receivedMask.assign(data.payloadSize, 0);
     m_incomingResync->lastActivityAt = std::chrono::steady_clock::now();
+    m_incomingResync->segments = std::move(data.segments);
 
     m_session.roomState().activeResyncId = data.resyncId;
     m_session.roomState().timelineEpoch = data.timelineEpoch;
@@ -3349,6 +3442,15 @@ bool NetplayCoordinator::handleResyncBegin(PacketReader& reader)
         pushToast(toast);
     }
 
+    if(!m_incomingResync->segments.empty()) {
+        if(m_partialResyncEnabled) {
+            m_incomingResync->awaitingBase = true;
+        } else {
+            m_incomingResync->fullPayloadRequested = true;
+            requestResyncSegments(fullResyncSegmentMask(m_incomingResync->segments.size()));
+        }
+    }
+
     return true;
 }
 
@@ -3357,28 +3459,107 @@ bool NetplayCoordinator::handleResyncChunk(PacketReader& reader)
     ResyncChunkData data;
     if(!ResyncChunkData::deserialize(reader, data)) return false;
     if(!m_incomingResync.has_value() || m_incomingResync->resyncId != data.resyncId) return false;
-    const size_t payloadSize = m_incomingResync->payload.size();
+
+    // Segmented resyncs fill the transfer announced by ResyncSegments instead.
+    const bool segmented = !m_incomingResync->segments.empty();
+    if(segmented && !m_incomingResync->transferInfo.has_value()) return false;
+    std::vector<uint8_t>& target = segmented ? m_incomingResync->transfer : m_incomingResync->payload;
+    std::vector<uint8_t>& targetMask =
+        segmented ? m_incomingResync->transferReceivedMask : m_incomingResync->receivedMask;
+    const size_t targetSize = target.size();
     const size_t offset = static_cast<size_t>(data.offset);
     const size_t chunkSize = static_cast<size_t>(data.size);
-    if(offset > payloadSize || chunkSize > (payloadSize - offset)) return false;
+    if(offset > targetSize || chunkSize > (targetSize - offset)) return false;
 
     std::vector<uint8_t> chunk;
     if(!reader.readBytes(chunk, data.size)) return false;
     m_incomingResync->lastActivityAt = std::chrono::steady_clock::now();
 
     if(data.size > 0) {
-        std::memcpy(m_incomingResync->payload.data() + offset, chunk.data(), chunkSize);
-        std::fill_n(m_incomingResync->receivedMask.begin() + offset, chunkSize, uint8_t{1});
+        std::memcpy(target.data() + offset, chunk.data(), chunkSize);
+        std::fill_n(targetMask.begin() + offset, chunkSize, uint8_t{1});
     }
     return true;
 }
 
+bool NetplayCoordinator::handleResyncSegments(PacketReader& reader)
+{
+    ResyncSegmentsData data;
+    if(!ResyncSegmentsData::deserialize(reader, data)) return false;
+    if(!m_incomingResync.has_value() ||
+       m_incomingResync->resyncId != data.resyncId ||
+       m_incomingResync->segments.empty()) {
+        return false;
+    }
+    // An answer to an earlier request of this resync; the current one is still coming.
+    if(data.segmentMask != m_incomingResync->requestedMask) return true;
+
+    size_t rawSize = 0;
+    for(size_t index = 0; index < m_incomingResync->segments.size(); ++index) {
+        if(resyncSegmentMasked(data.segmentMask, index)) {
+            rawSize += m_incomingResync->segments[index].size;
+        }
+    }
+    if(data.rawSize != rawSize || data.transferSize > kMaxIncomingResyncPayloadBytes) {
+        pushLog("Rejected resync segments: sizes do not match the request");
+        return false;
+    }
+
+    m_incomingResync->transfer.assign(data.transferSize, 0);
+    m_incomingResync->transferReceivedMask.assign(data.transferSize, 0);
+    m_incomingResync->transferInfo = std::move(data);
+    m_incomingResync->lastActivityAt = std::chrono::steady_clock::now();
+    return true;
+}
+
+void NetplayCoordinator::applySegmentedResyncTransfer()
+{
+    IncomingResyncTransfer& incoming = *m_incomingResync;
+    if(!incoming.transferInfo.has_value() ||
+       std::find(incoming.transferReceivedMask.begin(), incoming.transferReceivedMask.end(), uint8_t{0}) !=
+           incoming.transferReceivedMask.end()) {
+        return;
+    }
+
+    const ResyncSegmentsData& info = *incoming.transferInfo;
+    std::vector<uint8_t> inflated;
+    std::span<const uint8_t> data(incoming.transfer);
+    if(info.encoding == ResyncEncoding::Deflate) {
+        if(!inflateResyncData(incoming.transfer, info.rawSize, inflated)) {
+            pushLog("Resync segments could not be inflated");
+            return;
+        }
+        data = inflated;
+    } else if(info.encoding != ResyncEncoding::Raw) {
+        pushLog("Resync segments use an unknown encoding");
+        return;
+    }
+    if(!scatterResyncSegments(incoming.segments, info.segmentMask, data, incoming.payload)) {
+        pushLog("Resync segments do not match the request");
+        return;
+    }
+
+    size_t offset = 0;
+    for(size_t index = 0; index < incoming.segments.size(); ++index) {
+        const size_t size = incoming.segments[index].size;
+        if(resyncSegmentMasked(info.segmentMask, index)) {
+            std::fill_n(incoming.receivedMask.begin() + offset, size, uint8_t{1});
+        }
+        offset += size;
+    }
+}
+
 bool NetplayCoordinator::handleResyncComplete(PacketReader& reader)
 {
     ResyncCompleteData data;
     if(!ResyncCompleteData::deserialize(reader, data)) return false;
     if(!m_incomingResync.has_value() || m_incomingResync->resyncId != data.resyncId) return false;
 
+    const bool segmented = !m_incomingResync->segments.empty();
+    if(segmented) {
+        applySegmentedResyncTransfer();
+    }
+
     if(std::find(m_incomingResync->receivedMask.begin(), m_incomingResync->receivedMask.end(), uint8_t{0}) != m_incomingResync->receivedMask.end()) {
         pushLog("Resync payload incomplete");
         if(!m_hosting && m_serverPeer != NetTransport::kInvalidPeerHandle) {
@@ -3393,6 +3574,16 @@ bool NetplayCoordinator::handleResyncComplete(PacketReader& reader)
     }
 
     const uint32_t payloadCrc32 = crc32(m_incomingResync->payload.data(), m_incomingResync->payload.size());
+    if(payloadCrc32 != m_incomingResync->expectedPayloadCrc32 &&
+       segmented &&
+       !m_incomingResync->fullPayloadRequested) {
+        // A kept segment only matched by CRC; fall back to the whole payload once.
+        pushLog("Partial resync payload CRC mismatch; requesting the full payload");
+        std::fill(m_incomingResync->receivedMask.begin(), m_incomingResync->receivedMask.end(), uint8_t{0});
+        m_incomingResync->fullPayloadRequested = true;
+        requestResyncSegments(fullResyncSegmentMask(m_incomingResync->segments.size()));
+        return true;
+    }
     if(payloadCrc32 != m_incomingResync->expectedPayloadCrc32) {
         pushLog("Resync payload CRC mismatch");
         if(!m_hosting && m_serverPeer != NetTransport::kInvalidPeerHandle) {
@@ -3611,6 +3802,62 @@ bool NetplayCoordinator::handleResyncAbort(PacketReader& reader)
     return true;
 }
 
+bool NetplayCoordinator::handleResyncSegmentRequest(NetTransport::PeerHandle peer, PacketReader& reader)
+{
+    ResyncSegmentRequestData data;
+    if(!ResyncSegmentRequestData::deserialize(reader, data)) return false;
+    if(!m_hosting) return true;
+
+    if(m_session.findParticipant(data.participantId) == nullptr ||
+       participantIdFromPeer(peer) != data.participantId) {
+        pushLog("Ignored resync segment request from unknown participant");
+        return true;
+    }
+    const auto outgoingIt = std::find_if(
+        m_outgoingResyncs.begin(),
+        m_outgoingResyncs.end(),
+        [&data](const OutgoingResyncTransfer& outgoing) { return outgoing.resyncId == data.resyncId; }
+    );
+    if(outgoingIt == m_outgoingResyncs.end()) {
+        return true;
+    }
+    OutgoingResyncTransfer& outgoing = *outgoingIt;
+    if(outgoing.targetPeer != NetTransport::kInvalidPeerHandle && outgoing.targetPeer != peer) {
+        return true;
+    }
+    if(data.segmentMask.size() != (outgoing.segments.size() + 7u) / 8u) return false;
+
+    if(outgoing.encodedMask.empty() || outgoing.encodedMask != data.segmentMask) {
+        const std::vector<uint8_t> raw = gatherResyncSegments(outgoing.segments, data.segmentMask, outgoing.payload);
+        std::vector<uint8_t> deflated;
+        const bool deflate = !raw.empty() && deflateResyncData(raw, deflated) && deflated.size() < raw.size();
+        outgoing.encodedMask = data.segmentMask;
+        outgoing.encodedInfo.resyncId = outgoing.resyncId;
+        outgoing.encodedInfo.segmentMask = data.segmentMask;
+        outgoing.encodedInfo.rawSize = static_cast<uint32_t>(raw.size());
+        outgoing.encodedInfo.encoding = deflate ? ResyncEncoding::Deflate : ResyncEncoding::Raw;
+        outgoing.encoded = deflate ? std::move(deflated) : raw;
+        outgoing.encodedInfo.transferSize = static_cast<uint32_t>(outgoing.encoded.size());
+    }
+
+    m_transport.sendReliable(peer, Channel::Control, buildResyncSegmentsPacket(outgoing.encodedInfo));
+    sendResyncChunks(peer, outgoing.resyncId, outgoing.encoded);
+
+    {
+        std::ostringstream oss;
+        oss << "Sent resync segments"
+            << " resyncId " << outgoing.resyncId
+            << " participantId " << static_cast<int>(data.participantId)
+            << " segments " << resyncSegmentMaskCount(data.segmentMask, outgoing.segments.size())
+            << "/" << outgoing.segments.size()
+            << " bytes " << outgoing.encodedInfo.rawSize
+            << "->" << outgoing.encodedInfo.transferSize
+            << "/" << outgoing.payload.size();
+        pushLog(oss.str());
+    }
+    return true;
+}
+
 bool NetplayCoordinator::handleResyncRequest(NetTransport::PeerHandle peer, PacketReader& reader)
 {
     ResyncRequestData data;
@@ -3846,6 +4093,7 @@ bool NetplayCoordinator::handleStartSession(PacketReader& reader)
         resetRuntimeTimelineStateForSessionStart();
     }
     m_session.roomState().inputDelayFrames = data.inputDelayFrames;
+    m_session.roomState().rollbackEnabled = data.rollbackEnabled != 0;
     applyTopologyData(m_session.roomState(), data.topology);
     renormalizeParticipantsForCurrentTopology(m_session.roomState());
     if(!m_hosting &&
@@ -4088,6 +4336,7 @@ void NetplayCoordinator::broadcastFrameStatusIfNeeded()
     const FrameNumber inputConfirmedFrame = std::max(m_session.roomState().lastConfirmedFrame, computeHostInputConfirmedFrame());
     status.lastConfirmedFrame = inputConfirmedFrame;
     status.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    status.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     status.topology = makeTopologyData(m_session.roomState());
 
     const FrameNumber previousCurrentFrame = m_session.roomState().currentFrame;
@@ -4223,6 +4472,7 @@ void NetplayCoordinator::setRoomInputTopology(std::vector<InputSlotDescriptor> i
     topologyStatus.currentFrame = room.currentFrame;
     topologyStatus.lastConfirmedFrame = room.lastConfirmedFrame;
     topologyStatus.inputDelayFrames = room.inputDelayFrames;
+    topologyStatus.rollbackEnabled = room.rollbackEnabled ? 1u : 0u;
     topologyStatus.topology = makeTopologyData(room);
     m_transport.broadcastReliable(Channel::Control, buildFrameStatusPacket(topologyStatus, room.sessionId));
 
@@ -4413,6 +4663,7 @@ bool NetplayCoordinator::handleJoinRoom(NetTransport::PeerHandle peer, PacketRea
     status.currentFrame = m_session.roomState().currentFrame;
     status.lastConfirmedFrame = m_session.roomState().lastConfirmedFrame;
     status.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    status.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     status.topology = makeTopologyData(m_session.roomState());
     if(!m_transport.sendReliable(peer, Channel::Diagnostics, buildFrameStatusPacket(status, m_session.roomState().sessionId))) {
         m_lastError = "Failed to sync frame status";
@@ -4426,6 +4677,7 @@ bool NetplayCoordinator::handleJoinRoom(NetTransport::PeerHandle peer, PacketRea
         StartSessionData sessionData;
         sessionData.state = m_session.roomState().state;
         sessionData.inputDelayFrames = m_session.roomState().inputDelayFrames;
+        sessionData.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
         sessionData.topology = makeTopologyData(m_session.roomState());
         m_transport.sendReliable(peer, Channel::Control, buildStartSessionPacket(sessionData, m_session.roomState().sessionId));
     }
@@ -4672,6 +4924,12 @@ bool NetplayCoordinator::handleControlPacket(NetTransport::PeerHandle peer, cons
         case MessageType::ResyncRequest:
             return handleResyncRequest(peer, reader);
 
+        case MessageType::ResyncSegmentRequest:
+            return handleResyncSegmentRequest(peer, reader);
+
+        case MessageType::ResyncSegments:
+            return handleResyncSegments(reader);
+
         case MessageType::ClockSyncRequest:
             return handleClockSyncRequest(peer, reader);
 
@@ -5035,17 +5293,20 @@ void NetplayCoordinator::update(uint32_t timeoutMs)
                                 << " protocol " << static_cast<unsigned>(diagnosticHeader.protocolVersion)
                                 << "/" << static_cast<unsigned>(kProtocolVersion);
                             if(diagnosticHeader.type == MessageType::InputFrame) {
-                                uint8_t inputEntryCount = 0;
-                                InputFrameData input{};
-                                if(diagnosticReader.readPod(inputEntryCount) &&
-                                   InputFrameData::deserialize(diagnosticReader, input)) {
-                                    oss << " entries " << static_cast<unsigned>(inputEntryCount)
-                                        << " epoch " << input.timelineEpoch
+                                InputFrameBatchData batch{};
+                                std::vector<PackedInputFrameEntry> entries;
+                                if(InputFrameBatchData::deserialize(diagnosticReader, batch)) {
+                                    oss << " epoch " << batch.timelineEpoch
                                         << " currentEpoch " << m_session.roomState().timelineEpoch
-                                        << " frame " << input.frame
-                                        << " seq " << input.sequence
-                                        << " participant " << static_cast<int>(input.participantId)
-                                        << " slot " << static_cast<unsigned>(input.playerSlot) + 1u;
+                                        << " participant " << static_cast<int>(batch.participantId)
+                                        << " slot " << static_cast<unsigned>(batch.playerSlot) + 1u;
+                                    if(readPackedInputFrames(diagnosticReader, batch.timelineEpoch,
+                                                             kMaxInputFrameRedundancy, entries) &&
+                                       !entries.empty()) {
+                                        oss << " entries " << entries.size()
+                                            << " frame " << entries.front().frame
+                                            << " seq " << entries.front().sequence;
+                                    }
                                 }
                             } else if(diagnosticHeader.type == MessageType::ConfirmedInputFrames) {
                                 ConfirmedInputFramesData confirmed{};
@@ -5425,19 +5686,16 @@ bool NetplayCoordinator::injectPeerHealthForTests(const PeerHealthData& health)
 
 bool NetplayCoordinator::injectInputFrameForTests(const InputFrameData& input, const NetplayInputFrame& contribution)
 {
-    PacketWriter writer;
     NetplayInputFrame netplayFrame = contribution;
     netplayFrame.frame = input.frame;
     netplayFrame.timelineEpoch = input.timelineEpoch;
-    const std::vector<uint8_t> payload = serializeNetplayInputFrame(netplayFrame);
-    InputFrameData inputWithPayload = input;
-    inputWithPayload.buttonMaskLo = assignedContributionPrimaryMask(input.playerSlot, netplayFrame);
-    inputWithPayload.buttonMaskHi = netplayFrame.buttonMaskHi[input.playerSlot];
-    inputWithPayload.payloadSize = static_cast<uint16_t>(payload.size());
-    writer.writePod(static_cast<uint8_t>(1u));
-    inputWithPayload.serialize(writer);
-    writer.writeBytes(std::span<const uint8_t>(payload.data(), payload.size()));
-    PacketReader reader(writer.data().data(), writer.data().size());
+    InputFrameData packedInput = input;
+    packedInput.buttonMaskLo = assignedContributionPrimaryMask(input.playerSlot, netplayFrame);
+    packedInput.buttonMaskHi = netplayFrame.buttonMaskHi[input.playerSlot];
+    const std::vector<uint8_t> packet = buildInputFramePacket(packedInput, netplayFrame);
+    PacketReader reader(packet.data(), packet.size());
+    PacketHeader header;
+    if(!PacketHeader::deserialize(reader, header)) return false;
     return handleInputFrame(NetTransport::kInvalidPeerHandle, reader);
 }
 
@@ -5853,13 +6111,18 @@ bool NetplayCoordinator::tryAssembleConfirmedFrame(FrameNumber frame, ConfirmedF
     );
 }
 
-bool NetplayCoordinator::tryBuildPlaybackFrameInternal(FrameNumber frame, ConfirmedFrameInputs& outFrame)
+bool NetplayCoordinator::tryBuildPlaybackFrameInternal(FrameNumber frame,
+                                                       ConfirmedFrameInputs& outFrame,
+                                                       bool* predicted)
 {
     if(const ConfirmedFrameInputs* confirmed = findConfirmedFrame(frame)) {
         outFrame = *confirmed;
         return true;
     }
 
+    const ConfirmedFrameInputs* latestConfirmed =
+        predicted != nullptr ? findConfirmedFrame(latestConfirmedFrame()) : nullptr;
+
     outFrame = {};
     outFrame.frame = frame;
     outFrame.authoritativeFrameStartClockMicros = authoritativeFrameStartClockMicros(frame);
@@ -5874,6 +6137,24 @@ bool NetplayCoordinator::tryBuildPlaybackFrameInternal(FrameNumber frame, Confir
             const bool isLocalParticipant = participant.id == m_localParticipantId;
             const InputTimeline& timeline = isLocalParticipant ? m_localInputs : m_remoteInputs;
             const TimelineInputEntry* entry = timeline.find(frame, participant.id, slot);
+            if(entry == nullptr && predicted != nullptr && !isLocalParticipant) {
+                // Predict the participant keeps their newest known input: their own timeline
+                // entry, or the last confirmed frame when that is more recent. With neither
+                // the slot stays neutral.
+                *predicted = true;
+                haveAssignedParticipant = true;
+                const TimelineInputEntry* latest = timeline.latestFor(participant.id, slot);
+                if(latest != nullptr && (latestConfirmed == nullptr || latest->frame >= latestConfirmed->frame)) {
+                    outFrame.buttonMaskLo[slot] = latest->buttonMaskLo;
+                    outFrame.buttonMaskHi[slot] = latest->buttonMaskHi;
+                    applyAssignedContribution(assembledInputFrame, slot, timelineContributionForSlot(*latest));
+                } else if(latestConfirmed != nullptr) {
+                    outFrame.buttonMaskLo[slot] = latestConfirmed->buttonMaskLo[slot];
+                    outFrame.buttonMaskHi[slot] = latestConfirmed->buttonMaskHi[slot];
+                    applyAssignedContribution(assembledInputFrame, slot, latestConfirmed->netplayFrame);
+                }
+                continue;
+            }
             if(entry == nullptr) {
                 if(!isLocalParticipant) {
                     noteImplicitRemoteInputStall(participant.id, slot, frame);
@@ -5901,7 +6182,15 @@ bool NetplayCoordinator::tryBuildPlaybackFrameInternal(FrameNumber frame, Confir
 
 bool NetplayCoordinator::tryBuildPlaybackFrame(FrameNumber frame, ConfirmedFrameInputs& outFrame)
 {
-    return tryBuildPlaybackFrameInternal(frame, outFrame);
+    return tryBuildPlaybackFrameInternal(frame, outFrame, nullptr);
+}
+
+bool NetplayCoordinator::tryBuildPredictedPlaybackFrame(FrameNumber frame,
+                                                        ConfirmedFrameInputs& outFrame,
+                                                        bool& predicted)
+{
+    predicted = false;
+    return tryBuildPlaybackFrameInternal(frame, outFrame, &predicted);
 }
 
 void NetplayCoordinator::publishConfirmedFramesIfReady()
@@ -6091,43 +6380,40 @@ void NetplayCoordinator::recordLocalInputFrame(FrameNumber frame, PlayerSlot slo
     m_localInputs.push(entry);
     updateLocalRejectState(kLocalInputRejectNone, 0u, 0u);
 
-    std::vector<TimelineInputEntry> redundantInputs;
-    redundantInputs.reserve(kInputFrameRedundancyCount);
+    std::vector<const TimelineInputEntry*> redundantInputs;
+    redundantInputs.reserve(kMaxInputFrameRedundancy);
     for(auto it = m_localInputs.entries().rbegin();
-        it != m_localInputs.entries().rend() && redundantInputs.size() < kInputFrameRedundancyCount;
+        it != m_localInputs.entries().rend() && redundantInputs.size() < kMaxInputFrameRedundancy;
         ++it) {
         if(it->participantId != m_localParticipantId || it->playerSlot != slot) continue;
         if(it->netplayFrame.timelineEpoch != m_session.roomState().timelineEpoch) continue;
-        redundantInputs.push_back(*it);
+        if(redundantInputs.size() >= kMinInputFrameRedundancy && it->confirmed) break;
+        redundantInputs.push_back(&*it);
     }
     std::reverse(redundantInputs.begin(), redundantInputs.end());
 
-    std::vector<std::vector<uint8_t>> payloadFrames;
-    std::vector<SerializedInputFrameEntry> packetEntries;
-    payloadFrames.reserve(redundantInputs.size());
+    InputFrameBatchData batch;
+    batch.timelineEpoch = m_session.roomState().timelineEpoch;
+    batch.participantId = m_localParticipantId;
+    batch.playerSlot = slot;
+    std::vector<PackedInputFrameEntry> packetEntries;
     packetEntries.reserve(redundantInputs.size());
-    for(const TimelineInputEntry& redundantInput : redundantInputs) {
-        payloadFrames.push_back(serializeNetplayInputFrame(redundantInput.netplayFrame));
-
+    for(const TimelineInputEntry* redundantInput : redundantInputs) {
         InputFrameData packetData;
-        packetData.timelineEpoch = m_session.roomState().timelineEpoch;
-        packetData.frame = redundantInput.frame;
+        packetData.timelineEpoch = batch.timelineEpoch;
+        packetData.frame = redundantInput->frame;
         packetData.authoritativeFrameStartClockMicros =
-            authoritativeFrameStartClockMicros(redundantInput.frame);
+            authoritativeFrameStartClockMicros(redundantInput->frame);
         packetData.participantId = m_localParticipantId;
         packetData.playerSlot = slot;
-        packetData.buttonMaskLo = redundantInput.buttonMaskLo;
-        packetData.buttonMaskHi = redundantInput.buttonMaskHi;
-        packetData.sequence = redundantInput.sequence;
-        packetData.payloadSize = static_cast<uint16_t>(payloadFrames.back().size());
-        packetEntries.push_back(SerializedInputFrameEntry{
-            packetData,
-            std::span<const uint8_t>(payloadFrames.back().data(), payloadFrames.back().size())
-        });
+        packetData.buttonMaskLo = redundantInput->buttonMaskLo;
+        packetData.buttonMaskHi = redundantInput->buttonMaskHi;
+        packetData.sequence = redundantInput->sequence;
+        packetEntries.push_back(packInputFrame(packetData, redundantInput->netplayFrame));
     }
 
     const std::vector<uint8_t> payload =
-        buildInputFramePacket(std::span<const SerializedInputFrameEntry>(packetEntries.data(), packetEntries.size()));
+        buildInputFramePacket(batch, std::span<const PackedInputFrameEntry>(packetEntries.data(), packetEntries.size()));
 
     if(m_hosting) {
         synthesizeSuspendedRemoteInputsUpTo(frame);
@@ -6155,7 +6441,8 @@ void NetplayCoordinator::submitLocalCrc(FrameNumber frame,
                                         const char* source,
                                         CrcSubmissionSource submissionSource,
                                         FrameNumber senderLocalSimulationFrame,
-                                        FrameNumber senderConfirmedFrame)
+                                        FrameNumber senderConfirmedFrame,
+                                        std::vector<uint32_t> componentDigests)
 {
     if(!kDesyncMonitorEnabled) return;
     if(m_session.roomState().state != SessionState::Running) return;
@@ -6169,7 +6456,8 @@ void NetplayCoordinator::submitLocalCrc(FrameNumber frame,
         crc32,
         submissionSource,
         submitLocalSimulationFrame,
-        submitConfirmedFrame
+        submitConfirmedFrame,
+        std::move(componentDigests)
     };
     if(!isTrustedConfirmedCanonicalCrc(localEntry)) {
         if(m_debugMode) {
@@ -6199,6 +6487,7 @@ void NetplayCoordinator::submitLocalCrc(FrameNumber frame,
     report.submissionSource = submissionSource;
     report.senderLocalSimulationFrame = submitLocalSimulationFrame;
     report.senderConfirmedFrame = submitConfirmedFrame;
+    report.componentDigests = localEntry.componentDigests;
 
     const std::vector<uint8_t> payload = buildCrcReportPacket(report, m_session.roomState().sessionId);
 
@@ -6228,7 +6517,8 @@ bool NetplayCoordinator::beginResync(FrameNumber targetFrame,
                                      uint32_t payloadCrc32,
                                      uint32_t stateCrc32,
                                      ResyncReason reason,
-                                     ParticipantId targetParticipantId)
+                                     ParticipantId targetParticipantId,
+                                     std::span<const uint32_t> layoutSpans)
 {
     if(!m_hosting || payload.empty()) return false;
 
@@ -6353,6 +6643,12 @@ bool NetplayCoordinator::beginResync(FrameNumber targetFrame,
     beginData.frameReadyCrc32 = m_session.roomState().resyncFrameReadyCrc32;
     beginData.inputSequenceBase = m_session.roomState().resyncInputSequenceBase;
     beginData.reason = reason;
+    // Past one segment the payload is only offered: each receiver asks for the segments its
+    // own state lacks and gets those alone, deflated (handleResyncSegmentRequest()).
+    const bool segmented = payload.size() > kResyncSegmentBytes;
+    if(segmented) {
+        beginData.segments = buildResyncSegments(payload, layoutSpans);
+    }
     const std::vector<uint8_t> beginPacket = buildResyncBeginPacket(beginData);
     if(targetedResync) {
         m_transport.sendReliable(targetPeer, Channel::Control, beginPacket);
@@ -6360,28 +6656,18 @@ bool NetplayCoordinator::beginResync(FrameNumber targetFrame,
         m_transport.broadcastReliable(Channel::Control, beginPacket);
     }
 
-    for(size_t offset = 0; offset < payload.size(); offset += kResyncChunkPayloadBytes) {
-        const size_t chunkSize = std::min(kResyncChunkPayloadBytes, payload.size() - offset);
-        ResyncChunkData chunkData;
-        chunkData.resyncId = resyncId;
-        chunkData.offset = static_cast<uint32_t>(offset);
-        chunkData.size = static_cast<uint16_t>(chunkSize);
-        const std::vector<uint8_t> chunkPacket =
-            buildResyncChunkPacket(chunkData, std::span<const uint8_t>(payload.data() + offset, chunkSize));
-        if(targetedResync) {
-            m_transport.sendReliable(targetPeer, Channel::Control, chunkPacket);
-        } else {
-            m_transport.broadcastReliable(Channel::Control, chunkPacket);
+    if(segmented) {
+        OutgoingResyncTransfer outgoing;
+        outgoing.resyncId = resyncId;
+        outgoing.payload = payload;
+        outgoing.segments = std::move(beginData.segments);
+        outgoing.targetPeer = targetPeer;
+        m_outgoingResyncs.push_back(std::move(outgoing));
+        while(m_outgoingResyncs.size() > kMaxOutgoingResyncTransfers) {
+            m_outgoingResyncs.pop_front();
         }
-    }
-
-    ResyncCompleteData completeData;
-    completeData.resyncId = resyncId;
-    const std::vector<uint8_t> completePacket = buildResyncCompletePacket(completeData);
-    if(targetedResync) {
-        m_transport.sendReliable(targetPeer, Channel::Control, completePacket);
     } else {
-        m_transport.broadcastReliable(Channel::Control, completePacket);
+        sendResyncChunks(targetPeer, resyncId, payload);
     }
     {
         std::ostringstream oss;
@@ -6397,6 +6683,53 @@ bool NetplayCoordinator::beginResync(FrameNumber targetFrame,
     return true;
 }
 
+void NetplayCoordinator::setPartialResyncEnabled(bool enabled)
+{
+    m_partialResyncEnabled = enabled;
+}
+
+std::optional<NetplayCoordinator::PendingResyncBase> NetplayCoordinator::pendingResyncBase() const
+{
+    if(!m_incomingResync.has_value() || !m_incomingResync->awaitingBase) return std::nullopt;
+    return PendingResyncBase{m_incomingResync->resyncId, m_incomingResync->targetFrame};
+}
+
+bool NetplayCoordinator::provideResyncBase(uint32_t resyncId, std::span<const uint8_t> base)
+{
+    if(!m_incomingResync.has_value() ||
+       m_incomingResync->resyncId != resyncId ||
+       !m_incomingResync->awaitingBase) {
+        return false;
+    }
+
+    IncomingResyncTransfer& incoming = *m_incomingResync;
+    incoming.awaitingBase = false;
+    const std::vector<uint8_t> missing = reuseResyncSegments(incoming.segments, base, incoming.payload);
+    size_t offset = 0;
+    size_t reusedBytes = 0;
+    for(size_t index = 0; index < incoming.segments.size(); ++index) {
+        const size_t size = incoming.segments[index].size;
+        if(!resyncSegmentMasked(missing, index)) {
+            std::fill_n(incoming.receivedMask.begin() + offset, size, uint8_t{1});
+            reusedBytes += size;
+        }
+        offset += size;
+    }
+    const size_t missingCount = resyncSegmentMaskCount(missing, incoming.segments.size());
+    incoming.fullPayloadRequested = missingCount == incoming.segments.size();
+
+    {
+        std::ostringstream oss;
+        oss << "Resync reusing local state"
+            << " resyncId " << resyncId
+            << " segments " << (incoming.segments.size() - missingCount) << "/" << incoming.segments.size()
+            << " bytes " << reusedBytes << "/" << incoming.payload.size();
+        pushLog(oss.str());
+    }
+    requestResyncSegments(missing);
+    return true;
+}
+
 std::optional<NetplayCoordinator::PendingResyncApply> NetplayCoordinator::consumePendingResyncApply()
 {
     if(m_pendingResyncApply.has_value() &&
@@ -6736,12 +7069,32 @@ bool NetplayCoordinator::setInputDelayFrames(uint8_t frames)
     status.currentFrame = m_session.roomState().currentFrame;
     status.lastConfirmedFrame = m_session.roomState().lastConfirmedFrame;
     status.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    status.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     status.topology = makeTopologyData(m_session.roomState());
     m_lastBroadcastInputDelayFrames = status.inputDelayFrames;
     m_transport.broadcastReliable(Channel::Diagnostics, buildFrameStatusPacket(status, m_session.roomState().sessionId));
     return true;
 }
 
+bool NetplayCoordinator::setRollbackEnabled(bool enabled)
+{
+    if(!m_hosting) return false;
+    if(m_session.roomState().rollbackEnabled == enabled) return true;
+
+    m_session.roomState().rollbackEnabled = enabled;
+    pushLog(std::string("Rollback ") + (enabled ? "enabled" : "disabled") + " for the room");
+
+    FrameStatusData status;
+    status.timelineEpoch = m_session.roomState().timelineEpoch;
+    status.currentFrame = m_session.roomState().currentFrame;
+    status.lastConfirmedFrame = m_session.roomState().lastConfirmedFrame;
+    status.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    status.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
+    status.topology = makeTopologyData(m_session.roomState());
+    m_transport.broadcastReliable(Channel::Diagnostics, buildFrameStatusPacket(status, m_session.roomState().sessionId));
+    return true;
+}
+
 bool NetplayCoordinator::kickParticipant(ParticipantId participantId)
 {
     if(!m_hosting || participantId == m_localParticipantId) return false;
@@ -6865,6 +7218,7 @@ bool NetplayCoordinator::startSession()
     StartSessionData data;
     data.state = m_session.roomState().state;
     data.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    data.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     data.topology = makeTopologyData(m_session.roomState());
     m_transport.broadcastReliable(Channel::Control, buildStartSessionPacket(data, m_session.roomState().sessionId));
     pushLog(requiresInitialSync
@@ -6886,6 +7240,7 @@ bool NetplayCoordinator::pauseSession()
     StartSessionData data;
     data.state = SessionState::Paused;
     data.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    data.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     data.topology = makeTopologyData(m_session.roomState());
     data.serialize(writer);
     m_transport.broadcastReliable(Channel::Control, writer.data());
@@ -6911,6 +7266,7 @@ bool NetplayCoordinator::resumeSession()
     StartSessionData data;
     data.state = SessionState::Running;
     data.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    data.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     data.topology = makeTopologyData(m_session.roomState());
     data.serialize(writer);
     m_transport.broadcastReliable(Channel::Control, writer.data());
@@ -6932,6 +7288,7 @@ bool NetplayCoordinator::endSession()
     StartSessionData data;
     data.state = SessionState::Ended;
     data.inputDelayFrames = m_session.roomState().inputDelayFrames;
+    data.rollbackEnabled = m_session.roomState().rollbackEnabled ? 1u : 0u;
     data.topology = makeTopologyData(m_session.roomState());
     data.serialize(writer);
     m_transport.broadcastReliable(Channel::Control, writer.data());
@@ -85,6 +85,27 @@ private:
         std::vector<uint8_t> payload;
         std::vector<uint8_t> receivedMask;
         std::chrono::steady_clock::time_point lastActivityAt = {};
+        // Segmented resyncs: payload is assembled from the local base plus the requested
+        // segments, which arrive through transfer instead of straight into payload.
+        std::vector<ResyncSegment> segments;
+        bool awaitingBase = false;
+        bool fullPayloadRequested = false;
+        std::vector<uint8_t> requestedMask;
+        std::optional<ResyncSegmentsData> transferInfo;
+        std::vector<uint8_t> transfer;
+        std::vector<uint8_t> transferReceivedMask;
+    };
+
+    struct OutgoingResyncTransfer
+    {
+        uint32_t resyncId = 0;
+        std::vector<uint8_t> payload;
+        std::vector<ResyncSegment> segments;
+        NetTransport::PeerHandle targetPeer = NetTransport::kInvalidPeerHandle;
+        // Last answer, reused while peers keep asking for the same segments.
+        std::vector<uint8_t> encodedMask;
+        ResyncSegmentsData encodedInfo;
+        std::vector<uint8_t> encoded;
     };
 
 public:
@@ -101,6 +122,12 @@ public:
         std::vector<uint8_t> payload;
     };
 
+    struct PendingResyncBase
+    {
+        uint32_t resyncId = 0;
+        FrameNumber targetFrame = 0;
+    };
+
     struct PendingHostResyncRequest
     {
         FrameNumber frame = 0;
@@ -175,6 +202,8 @@ private:
     uint32_t m_nextResyncId = 1;
     uint32_t m_activeResyncExpectedStateCrc32 = 0;
     std::optional<IncomingResyncTransfer> m_incomingResync;
+    std::deque<OutgoingResyncTransfer> m_outgoingResyncs;
+    bool m_partialResyncEnabled = false;
     std::optional<PendingResyncApply> m_pendingResyncApply;
     std::optional<ParticipantId> m_pendingHostLateJoinResyncParticipant;
     RemoteInputStallMonitor m_remoteInputStallMonitor;
@@ -271,6 +300,10 @@ private:
     std::vector<uint8_t> buildResyncAckPacket(const ResyncAckData& data) const;
     std::vector<uint8_t> buildResyncAbortPacket(const ResyncAbortData& data) const;
     std::vector<uint8_t> buildResyncRequestPacket(const ResyncRequestData& data) const;
+    std::vector<uint8_t> buildResyncSegmentRequestPacket(const ResyncSegmentRequestData& data) const;
+    std::vector<uint8_t> buildResyncSegmentsPacket(const ResyncSegmentsData& data) const;
+    void sendResyncChunks(NetTransport::PeerHandle peer, uint32_t resyncId, std::span<const uint8_t> data);
+    void requestResyncSegments(const std::vector<uint8_t>& segmentMask);
     std::vector<uint8_t> buildClockSyncRequestPacket(const ClockSyncRequestData& data) const;
     std::vector<uint8_t> buildClockSyncResponsePacket(const ClockSyncResponseData& data) const;
     std::vector<uint8_t> buildPeerHealthPacket(const PeerHealthData& data, uint32_t sessionId) const;
@@ -289,13 +322,15 @@ private:
     bool handleResyncAck(PacketReader& reader);
     bool handleResyncAbort(PacketReader& reader);
     bool handleResyncRequest(NetTransport::PeerHandle peer, PacketReader& reader);
+    bool handleResyncSegmentRequest(NetTransport::PeerHandle peer, PacketReader& reader);
+    bool handleResyncSegments(PacketReader& reader);
+    void applySegmentedResyncTransfer();
     bool handleClockSyncRequest(NetTransport::PeerHandle peer, PacketReader& reader);
     bool handleClockSyncResponse(NetTransport::PeerHandle peer, PacketReader& reader);
     bool handlePeerHealth(NetTransport::PeerHandle peer, PacketReader& reader);
     bool handleInputFrame(NetTransport::PeerHandle peer, PacketReader& reader);
     bool handleInputFrameEntry(NetTransport::PeerHandle peer,
                                const InputFrameData& input,
-                               const std::vector<uint8_t>& payload,
                                NetplayInputFrame netplayFrame);
     bool handleConfirmedInputFrames(PacketReader& reader);
     bool handleInputAck(PacketReader& reader);
@@ -319,7 +354,9 @@ private:
     void clearImplicitRemoteInputStall(ParticipantId participantId, FrameNumber recoveredThroughFrame);
     void tryScheduleImplicitRecoveryResync(ParticipantInfo& participant);
     void synthesizeSuspendedRemoteInputsUpTo(FrameNumber targetFrame);
-    bool tryBuildPlaybackFrameInternal(FrameNumber frame, ConfirmedFrameInputs& outFrame);
+    bool tryBuildPlaybackFrameInternal(FrameNumber frame,
+                                       ConfirmedFrameInputs& outFrame,
+                                       bool* predicted);
     // Frame terminology used by the coordinator:
     // - local simulation frame: last frame this peer has actually simulated.
     // - host input-confirmed frame: highest frame for which the host has
@@ -448,12 +485,17 @@ public:
     void recordLocalInputFrame(FrameNumber frame, PlayerSlot slot, const NetplayInputFrame& contribution);
     void recordLocalInputFrame(FrameNumber frame, PlayerSlot slot, uint64_t buttonMaskLo, uint64_t buttonMaskHi = 0);
     bool tryBuildPlaybackFrame(FrameNumber frame, ConfirmedFrameInputs& outFrame);
+    // Rollback mode: like tryBuildPlaybackFrame(), but a remote slot whose input has not
+    // arrived repeats that participant's newest known input instead of failing. predicted
+    // tells whether any slot was filled that way.
+    bool tryBuildPredictedPlaybackFrame(FrameNumber frame, ConfirmedFrameInputs& outFrame, bool& predicted);
     void submitLocalCrc(FrameNumber frame,
                         uint32_t crc32,
                         const char* source = "local CRC submission",
                         CrcSubmissionSource submissionSource = CrcSubmissionSource::Unknown,
                         FrameNumber senderLocalSimulationFrame = 0,
-                        FrameNumber senderConfirmedFrame = 0);
+                        FrameNumber senderConfirmedFrame = 0,
+                        std::vector<uint32_t> componentDigests = {});
     std::optional<uint32_t> findRecentLocalCrc(FrameNumber frame) const;
     void invalidateLocalCrcHistoryAfter(FrameNumber frame);
     bool beginResync(FrameNumber targetFrame,
@@ -461,7 +503,15 @@ public:
                      uint32_t payloadCrc32,
                      uint32_t stateCrc32,
                      ResyncReason reason = ResyncReason::Unspecified,
-                     ParticipantId targetParticipantId = kInvalidParticipantId);
+                     ParticipantId targetParticipantId = kInvalidParticipantId,
+                     std::span<const uint32_t> layoutSpans = {});
+    // With partial resync enabled an incoming resync waits for provideResyncBase(): the
+    // local state closest to the target frame, whose matching segments are kept so only
+    // the rest is requested. Otherwise, or with a base that matches nothing, the whole
+    // payload is requested.
+    void setPartialResyncEnabled(bool enabled);
+    std::optional<PendingResyncBase> pendingResyncBase() const;
+    bool provideResyncBase(uint32_t resyncId, std::span<const uint8_t> base);
     std::optional<PendingResyncApply> consumePendingResyncApply();
     bool acknowledgeResync(uint32_t resyncId, FrameNumber loadedFrame, uint32_t crc32, bool success);
     bool requestHostResync(ResyncReason reason = ResyncReason::ObserverVisibilityRestore);
@@ -475,6 +525,7 @@ public:
     bool kickParticipant(ParticipantId participantId);
     bool removeReconnectReservation(ParticipantId participantId);
     bool setInputDelayFrames(uint8_t frames);
+    bool setRollbackEnabled(bool enabled);
     bool startSession();
     bool pauseSession();
     bool resumeSession();
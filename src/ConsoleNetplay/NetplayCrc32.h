@@ -3,22 +3,15 @@
 #include <cstddef>
 #include <cstdint>
 
+#include "GeraNES/util/Crc32.h"
+
 namespace ConsoleNetplay {
 
+// Same CRC-32 the core uses for ROMs and states, so both sides of a check agree and share
+// the table and PCLMUL paths.
 inline uint32_t crc32(const void* data, size_t size)
 {
-    const auto* bytes = static_cast<const uint8_t*>(data);
-    uint32_t crc = ~0u;
-    for(size_t i = 0; i < size; ++i) {
-        uint32_t ch = bytes[i];
-        for(size_t bit = 0; bit < 8; ++bit) {
-            const uint32_t carry = (ch ^ crc) & 1u;
-            crc >>= 1u;
-            if(carry != 0u) crc ^= 0xEDB88320u;
-            ch >>= 1u;
-        }
-    }
-    return ~crc;
+    return GeraNES::Crc32::calc(data, size);
 }
 
 } // namespace ConsoleNetplay
@@ -1,5 +1,6 @@
 #include "ConsoleNetplay/NetplayInputFrameSerialization.h"
 
+#include <algorithm>
 #include <span>
 #include <utility>
 
@@ -74,6 +75,135 @@ bool readNetplayInputSlotWireHeader(PacketReader& reader, NetplayInputSlotWireHe
            reader.readPod(header.payloadSize);
 }
 
+
+enum PackedInputFlags : uint8_t
+{
+    kPackedInputRepeat = 0,
+    kPackedInputFrameGap = 1u << 0,
+    kPackedInputSequenceJump = 1u << 1,
+    kPackedInputClockJump = 1u << 2,
+    kPackedInputChanged = 1u << 3,
+    kPackedInputFrameStamp = 1u << 4
+};
+
+enum PackedInputSlotFlags : uint8_t
+{
+    kPackedSlotFrameInput = 1u << 0,
+    kPackedSlotSideMaskLo = 1u << 1,
+    kPackedSlotSideMaskHi = 1u << 2
+};
+
+uint64_t zigzagEncode(int64_t value)
+{
+    return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t zigzagDecode(uint64_t value)
+{
+    return static_cast<int64_t>((value >> 1) ^ (~(value & 1u) + 1u));
+}
+
+// Running state both ends derive from the entries already written, so each entry only
+// spends bytes where it differs from the prediction.
+struct PackedInputCursor
+{
+    FrameNumber frame = 0;
+    uint32_t sequence = 0;
+    uint64_t clockMicros = 0;
+    uint64_t clockStepMicros = 0;
+    std::vector<uint8_t> input;
+
+    uint64_t predictedClockMicros() const
+    {
+        return clockMicros + clockStepMicros;
+    }
+
+    void advance(const PackedInputFrameEntry& entry)
+    {
+        clockStepMicros = entry.clockMicros - clockMicros;
+        frame = entry.frame;
+        sequence = entry.sequence;
+        clockMicros = entry.clockMicros;
+    }
+};
+
+void writePackedInput(PacketWriter& writer, const PackedInputFrameEntry& entry)
+{
+    const NetplayInputFrame& frame = entry.netplayFrame;
+    std::vector<PlayerSlot> slots = frame.activeSlots();
+    for(const auto& side : entry.buttonMaskLo.entries()) {
+        if(side.value != 0u) slots.push_back(side.slot);
+    }
+    for(const auto& side : entry.buttonMaskHi.entries()) {
+        if(side.value != 0u) slots.push_back(side.slot);
+    }
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    writer.writeVarint(frame.framePayload.size());
+    writer.writeBytes(std::span<const uint8_t>(frame.framePayload.data(), frame.framePayload.size()));
+    writer.writeVarint(slots.size());
+    for(PlayerSlot slot : slots) {
+        const bool frameInput = slotHasPayload(frame, slot);
+        const uint64_t frameMaskLo = frame.buttonMaskLo[slot];
+        const uint64_t frameMaskHi = frame.buttonMaskHi[slot];
+        uint8_t flags = 0;
+        if(frameInput) flags |= kPackedSlotFrameInput;
+        if(entry.buttonMaskLo[slot] != frameMaskLo) flags |= kPackedSlotSideMaskLo;
+        if(entry.buttonMaskHi[slot] != frameMaskHi) flags |= kPackedSlotSideMaskHi;
+
+        writer.writePod(slot);
+        writer.writePod(flags);
+        if(frameInput) {
+            const std::vector<uint8_t>& payload = frame.slotPayloads[slot];
+            writer.writeVarint(frameMaskLo);
+            writer.writeVarint(frameMaskHi);
+            writer.writeVarint(payload.size());
+            writer.writeBytes(std::span<const uint8_t>(payload.data(), payload.size()));
+        }
+        if((flags & kPackedSlotSideMaskLo) != 0u) writer.writeVarint(entry.buttonMaskLo[slot]);
+        if((flags & kPackedSlotSideMaskHi) != 0u) writer.writeVarint(entry.buttonMaskHi[slot]);
+    }
+}
+
+bool readPackedInput(PacketReader& reader, PackedInputFrameEntry& entry)
+{
+    entry.buttonMaskLo = {};
+    entry.buttonMaskHi = {};
+    entry.netplayFrame = {};
+    NetplayInputFrame& frame = entry.netplayFrame;
+
+    uint32_t framePayloadSize = 0;
+    uint32_t slotCount = 0;
+    if(!reader.readVarint(framePayloadSize) ||
+       !reader.readBytes(frame.framePayload, framePayloadSize) ||
+       !reader.readVarint(slotCount)) {
+        return false;
+    }
+    for(uint32_t index = 0; index < slotCount; ++index) {
+        PlayerSlot slot = kObserverPlayerSlot;
+        uint8_t flags = 0;
+        if(!reader.readPod(slot) || !reader.readPod(flags)) return false;
+
+        uint64_t maskLo = 0;
+        uint64_t maskHi = 0;
+        if((flags & kPackedSlotFrameInput) != 0u) {
+            uint32_t payloadSize = 0;
+            if(!reader.readVarint(maskLo) || !reader.readVarint(maskHi) || !reader.readVarint(payloadSize)) {
+                return false;
+            }
+            if(maskLo != 0u) frame.buttonMaskLo[slot] = maskLo;
+            if(maskHi != 0u) frame.buttonMaskHi[slot] = maskHi;
+            if(payloadSize != 0u && !reader.readBytes(frame.slotPayloads[slot], payloadSize)) return false;
+        }
+        if((flags & kPackedSlotSideMaskLo) != 0u && !reader.readVarint(maskLo)) return false;
+        if((flags & kPackedSlotSideMaskHi) != 0u && !reader.readVarint(maskHi)) return false;
+        entry.buttonMaskLo[slot] = maskLo;
+        entry.buttonMaskHi[slot] = maskHi;
+    }
+    return true;
+}
+
 } // namespace
 
 std::vector<uint8_t> serializeNetplayInputFrame(const NetplayInputFrame& frame)
@@ -147,4 +277,134 @@ bool deserializeNetplayInputFrame(const uint8_t* data, size_t size, NetplayInput
     return true;
 }
 
+void writePackedInputFrames(PacketWriter& writer,
+                            uint32_t timelineEpoch,
+                            std::span<const PackedInputFrameEntry> entries)
+{
+    writer.writeVarint(entries.size());
+    if(entries.empty()) return;
+
+    PackedInputCursor cursor;
+    cursor.frame = entries.front().frame - 1u;
+    cursor.sequence = entries.front().sequence - 1u;
+    writer.writeVarint(entries.front().frame);
+    writer.writeVarint(entries.front().sequence);
+
+    size_t repeatRun = 0;
+    const auto flushRepeatRun = [&]() {
+        if(repeatRun == 0) return;
+        writer.writePod(static_cast<uint8_t>(kPackedInputRepeat));
+        writer.writeVarint(repeatRun - 1u);
+        repeatRun = 0;
+    };
+
+    for(const PackedInputFrameEntry& entry : entries) {
+        PacketWriter inputWriter;
+        writePackedInput(inputWriter, entry);
+
+        uint8_t flags = 0;
+        if(entry.frame != cursor.frame + 1u) flags |= kPackedInputFrameGap;
+        if(entry.sequence != cursor.sequence + 1u) flags |= kPackedInputSequenceJump;
+        if(entry.clockMicros != cursor.predictedClockMicros()) flags |= kPackedInputClockJump;
+        if(inputWriter.data() != cursor.input) flags |= kPackedInputChanged;
+        if(entry.netplayFrame.frame != entry.frame || entry.netplayFrame.timelineEpoch != timelineEpoch) {
+            flags |= kPackedInputFrameStamp;
+        }
+
+        if(flags == kPackedInputRepeat) {
+            ++repeatRun;
+        } else {
+            flushRepeatRun();
+            writer.writePod(flags);
+            if((flags & kPackedInputFrameGap) != 0u) {
+                writer.writeVarint(zigzagEncode(static_cast<int32_t>(entry.frame - (cursor.frame + 1u))));
+            }
+            if((flags & kPackedInputSequenceJump) != 0u) {
+                writer.writeVarint(zigzagEncode(static_cast<int32_t>(entry.sequence - (cursor.sequence + 1u))));
+            }
+            if((flags & kPackedInputClockJump) != 0u) {
+                writer.writeVarint(zigzagEncode(static_cast<int64_t>(entry.clockMicros - cursor.predictedClockMicros())));
+            }
+            if((flags & kPackedInputChanged) != 0u) {
+                writer.writeBytes(std::span<const uint8_t>(inputWriter.data().data(), inputWriter.data().size()));
+                cursor.input = inputWriter.data();
+            }
+            if((flags & kPackedInputFrameStamp) != 0u) {
+                writer.writeVarint(entry.netplayFrame.frame);
+                writer.writeVarint(entry.netplayFrame.timelineEpoch);
+            }
+        }
+        cursor.advance(entry);
+    }
+    flushRepeatRun();
+}
+
+bool readPackedInputFrames(PacketReader& reader,
+                           uint32_t timelineEpoch,
+                           size_t maxEntries,
+                           std::vector<PackedInputFrameEntry>& entries)
+{
+    entries.clear();
+    size_t count = 0;
+    if(!reader.readVarint(count) || count > maxEntries) return false;
+    if(count == 0) return true;
+
+    FrameNumber firstFrame = 0;
+    uint32_t firstSequence = 0;
+    if(!reader.readVarint(firstFrame) || !reader.readVarint(firstSequence)) return false;
+
+    PackedInputCursor cursor;
+    cursor.frame = firstFrame - 1u;
+    cursor.sequence = firstSequence - 1u;
+    PackedInputFrameEntry current;
+    current.netplayFrame.timelineEpoch = timelineEpoch;
+
+    entries.reserve(count);
+    while(entries.size() < count) {
+        uint8_t flags = 0;
+        if(!reader.readPod(flags)) return false;
+
+        size_t run = 1;
+        int64_t frameGap = 0;
+        int64_t sequenceJump = 0;
+        int64_t clockJump = 0;
+        uint64_t value = 0;
+        if(flags == kPackedInputRepeat) {
+            if(!reader.readVarint(value) || value >= count - entries.size()) return false;
+            run = static_cast<size_t>(value) + 1u;
+        }
+        if((flags & kPackedInputFrameGap) != 0u) {
+            if(!reader.readVarint(value)) return false;
+            frameGap = zigzagDecode(value);
+        }
+        if((flags & kPackedInputSequenceJump) != 0u) {
+            if(!reader.readVarint(value)) return false;
+            sequenceJump = zigzagDecode(value);
+        }
+        if((flags & kPackedInputClockJump) != 0u) {
+            if(!reader.readVarint(value)) return false;
+            clockJump = zigzagDecode(value);
+        }
+        if((flags & kPackedInputChanged) != 0u) {
+            if(!readPackedInput(reader, current)) return false;
+        }
+
+        for(size_t index = 0; index < run; ++index) {
+            current.frame = cursor.frame + 1u + static_cast<FrameNumber>(frameGap);
+            current.sequence = cursor.sequence + 1u + static_cast<uint32_t>(sequenceJump);
+            current.clockMicros = cursor.predictedClockMicros() + static_cast<uint64_t>(clockJump);
+            current.netplayFrame.frame = current.frame;
+            current.netplayFrame.timelineEpoch = timelineEpoch;
+            if((flags & kPackedInputFrameStamp) != 0u &&
+               (!reader.readVarint(current.netplayFrame.frame) ||
+                !reader.readVarint(current.netplayFrame.timelineEpoch))) {
+                return false;
+            }
+            cursor.advance(current);
+            entries.push_back(current);
+        }
+    }
+    return true;
+}
+
 } // namespace ConsoleNetplay
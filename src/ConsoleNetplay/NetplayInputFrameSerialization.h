@@ -2,14 +2,42 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <span>
 #include <vector>
 
 #include "ConsoleNetplay/NetplayInputFrame.h"
 
 namespace ConsoleNetplay {
 
+class PacketWriter;
+class PacketReader;
+
 std::vector<uint8_t> serializeNetplayInputFrame(const NetplayInputFrame& frame);
 size_t serializedNetplayInputFrameSize(const NetplayInputFrame& frame);
 bool deserializeNetplayInputFrame(const uint8_t* data, size_t size, NetplayInputFrame& frame);
 
+// One frame of an InputFrame or ConfirmedInputFrames batch. buttonMaskLo/Hi are the masks
+// the sender carries beside netplayFrame; they usually equal the frame's own.
+struct PackedInputFrameEntry
+{
+    FrameNumber frame = 0;
+    uint32_t sequence = 0;
+    uint64_t clockMicros = 0;
+    NetplayPerSlotValue<uint64_t> buttonMaskLo = {};
+    NetplayPerSlotValue<uint64_t> buttonMaskHi = {};
+    NetplayInputFrame netplayFrame = {};
+};
+
+// Consecutive entries are written as differences from the previous one: frame and sequence
+// gaps and clock steps as varints, inputs only when they change, and a run of entries that
+// only advance by one frame as a single count. netplayFrame.frame and timelineEpoch are
+// implied by the entry frame and the batch epoch unless they differ.
+void writePackedInputFrames(PacketWriter& writer,
+                            uint32_t timelineEpoch,
+                            std::span<const PackedInputFrameEntry> entries);
+bool readPackedInputFrames(PacketReader& reader,
+                           uint32_t timelineEpoch,
+                           size_t maxEntries,
+                           std::vector<PackedInputFrameEntry>& entries);
+
 } // namespace ConsoleNetplay
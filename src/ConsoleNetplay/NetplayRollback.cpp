@@ -0,0 +1,165 @@
+#include "NetplayRollback.h"
+
+#include <algorithm>
+
+namespace ConsoleNetplay {
+
+namespace {
+
+// A slot missing on one side reads as its default value, so an explicit neutral entry
+// matches an absent one.
+template<typename TValue>
+bool sameSlotValues(const NetplayPerSlotValue<TValue>& a, const NetplayPerSlotValue<TValue>& b)
+{
+    for(const auto& entry : a.entries()) {
+        if(!(b[entry.slot] == entry.value)) return false;
+    }
+    for(const auto& entry : b.entries()) {
+        if(!(a[entry.slot] == entry.value)) return false;
+    }
+    return true;
+}
+
+} // namespace
+
+void NetplayRollback::setEnabled(bool enabled)
+{
+    if(m_enabled == enabled) return;
+    m_enabled = enabled;
+    reset();
+}
+
+bool NetplayRollback::enabled() const
+{
+    return m_enabled;
+}
+
+void NetplayRollback::reset()
+{
+    m_predictions.clear();
+    for(Snapshot& snapshot : m_snapshots) {
+        snapshot.valid = false;
+    }
+    m_timelineEpoch.reset();
+}
+
+void NetplayRollback::syncTimeline(uint32_t timelineEpoch, FrameNumber consoleFrame)
+{
+    const bool epochChanged = m_timelineEpoch.has_value() && *m_timelineEpoch != timelineEpoch;
+    const bool consoleWentBack = !m_predictions.empty() && m_predictions.back().frame >= consoleFrame;
+    if(epochChanged || consoleWentBack) {
+        reset();
+    }
+    m_timelineEpoch = timelineEpoch;
+}
+
+bool NetplayRollback::captureSnapshot(FrameNumber frame, const StateSaver& save, const StateDigester& digest)
+{
+    Snapshot& snapshot = m_snapshots[frame % kSnapshotCapacity];
+    snapshot.frame = frame;
+    snapshot.valid = save(snapshot.data);
+    snapshot.digestTaken = snapshot.valid && digest != nullptr;
+    snapshot.hasDigest = snapshot.digestTaken && digest(snapshot.digest);
+    return snapshot.valid;
+}
+
+const std::vector<uint8_t>* NetplayRollback::snapshotForFrame(FrameNumber frame) const
+{
+    const Snapshot& snapshot = m_snapshots[frame % kSnapshotCapacity];
+    return snapshot.valid && snapshot.frame == frame ? &snapshot.data : nullptr;
+}
+
+const NetplayStateDigest* NetplayRollback::snapshotDigestForFrame(FrameNumber frame) const
+{
+    const Snapshot& snapshot = m_snapshots[frame % kSnapshotCapacity];
+    return snapshot.valid && snapshot.hasDigest && snapshot.frame == frame ? &snapshot.digest : nullptr;
+}
+
+bool NetplayRollback::snapshotDigestTaken(FrameNumber frame) const
+{
+    const Snapshot& snapshot = m_snapshots[frame % kSnapshotCapacity];
+    return snapshot.valid && snapshot.digestTaken && snapshot.frame == frame;
+}
+
+bool NetplayRollback::canPredict(FrameNumber frame) const
+{
+    if(!m_enabled) return false;
+    if(m_predictions.empty() || m_predictions.front().frame >= frame) {
+        return snapshotForFrame(frame) != nullptr;
+    }
+    return frame - m_predictions.front().frame < kMaxPredictionFrames;
+}
+
+void NetplayRollback::recordPrediction(FrameNumber frame, const NetplayInputFrame& input)
+{
+    const bool replacing = !m_predictions.empty() && m_predictions.back().frame >= frame;
+    dropPredictionsFrom(frame);
+    m_predictions.push_back(Prediction{frame, input});
+    if(!replacing) {
+        ++m_stats.predictedFrames;
+    }
+}
+
+void NetplayRollback::recordConfirmedPlayback(FrameNumber frame)
+{
+    dropPredictionsFrom(frame);
+}
+
+bool NetplayRollback::hasPredictionBefore(FrameNumber frame) const
+{
+    return !m_predictions.empty() && m_predictions.front().frame < frame;
+}
+
+std::optional<FrameNumber> NetplayRollback::verify(const InputLookup& actualInput)
+{
+    NetplayInputFrame actual;
+    while(!m_predictions.empty()) {
+        const Prediction& prediction = m_predictions.front();
+        if(!actualInput(prediction.frame, actual)) break;
+        if(!sameInput(prediction.input, actual)) {
+            const FrameNumber mispredictedFrame = prediction.frame;
+            m_predictions.clear();
+            return mispredictedFrame;
+        }
+        m_predictions.pop_front();
+    }
+    return std::nullopt;
+}
+
+void NetplayRollback::recordRollback(uint32_t depth)
+{
+    ++m_stats.rollbacks;
+    m_stats.resimulatedFrames += depth;
+    m_stats.lastRollbackDepth = depth;
+    m_stats.maxRollbackDepth = std::max(m_stats.maxRollbackDepth, depth);
+}
+
+void NetplayRollback::recordFailedRollback()
+{
+    ++m_stats.failedRollbacks;
+}
+
+NetplayRollback::Stats NetplayRollback::stats() const
+{
+    Stats stats = m_stats;
+    stats.pendingPredictions = static_cast<uint32_t>(m_predictions.size());
+    return stats;
+}
+
+bool NetplayRollback::sameInput(const NetplayInputFrame& a, const NetplayInputFrame& b)
+{
+    // frame and timelineEpoch only tag the input; they do not change what the console sees.
+    return sameSlotValues(a.buttonMaskLo, b.buttonMaskLo) &&
+           sameSlotValues(a.buttonMaskHi, b.buttonMaskHi) &&
+           sameSlotValues(a.slotPayloads, b.slotPayloads) &&
+           a.framePayload == b.framePayload;
+}
+
+void NetplayRollback::dropPredictionsFrom(FrameNumber frame)
+{
+    while(!m_predictions.empty() && m_predictions.back().frame >= frame) {
+        m_predictions.pop_back();
+    }
+}
+
+} // namespace ConsoleNetplay
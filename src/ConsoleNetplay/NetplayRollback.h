@@ -0,0 +1,105 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <optional>
+#include <vector>
+
+#include "NetplayInputFrame.h"
+#include "NetplayTypes.h"
+
+namespace ConsoleNetplay {
+
+// Bookkeeping for rollback mode. A frame whose remote input has not arrived yet is played
+// with a prediction, and the console state at the start of every frame is kept in a small
+// ring. Once the real input is known each prediction is checked; the first wrong one names
+// the frame to restore and play again. The runtime drives the console, this class only
+// keeps the records.
+class NetplayRollback
+{
+public:
+    static constexpr uint32_t kMaxPredictionFrames = 8;
+    static constexpr size_t kSnapshotCapacity = 2u * kMaxPredictionFrames;
+    // Upper bound for the auto-tuned input delay while rollback is on.
+    static constexpr uint32_t kMaxAutoInputDelayFrames = 2;
+
+    struct Stats
+    {
+        uint64_t predictedFrames = 0;
+        uint64_t rollbacks = 0;
+        uint64_t resimulatedFrames = 0;
+        uint64_t failedRollbacks = 0;
+        uint32_t lastRollbackDepth = 0;
+        uint32_t maxRollbackDepth = 0;
+        uint32_t pendingPredictions = 0;
+    };
+
+    using StateSaver = std::function<bool(std::vector<uint8_t>&)>;
+    using StateDigester = std::function<bool(NetplayStateDigest&)>;
+    using InputLookup = std::function<bool(FrameNumber, NetplayInputFrame&)>;
+
+    void setEnabled(bool enabled);
+    bool enabled() const;
+
+    // Drops predictions and snapshots; stats are kept.
+    void reset();
+    // Resets when the state moved under the runtime: a new timeline epoch, or a console
+    // that is no longer past every prediction.
+    void syncTimeline(uint32_t timelineEpoch, FrameNumber consoleFrame);
+
+    // Stores the state at the start of frame, overwriting the oldest entry, with its digest
+    // when a digester is given so the desync check can use it later.
+    bool captureSnapshot(FrameNumber frame, const StateSaver& save, const StateDigester& digest = nullptr);
+    const std::vector<uint8_t>* snapshotForFrame(FrameNumber frame) const;
+    const NetplayStateDigest* snapshotDigestForFrame(FrameNumber frame) const;
+    // Whether the snapshot of frame was stored with a digester, even one that had no digest
+    // to give. Without it the desync check cannot tell how the live state would be compared.
+    bool snapshotDigestTaken(FrameNumber frame) const;
+
+    bool canPredict(FrameNumber frame) const;
+    void recordPrediction(FrameNumber frame, const NetplayInputFrame& input);
+    // frame was played with its real input; a prediction left for it is stale.
+    void recordConfirmedPlayback(FrameNumber frame);
+    bool hasPredictionBefore(FrameNumber frame) const;
+
+    // Checks predictions oldest first. Correct ones are dropped; checking stops at the first
+    // frame whose real input is not known yet. Returns the first mispredicted frame, with it
+    // and every later prediction dropped since they are about to be played again.
+    std::optional<FrameNumber> verify(const InputLookup& actualInput);
+
+    void recordRollback(uint32_t depth);
+    void recordFailedRollback();
+    Stats stats() const;
+
+    static bool sameInput(const NetplayInputFrame& a, const NetplayInputFrame& b);
+
+private:
+    struct Prediction
+    {
+        FrameNumber frame = 0;
+        NetplayInputFrame input;
+    };
+
+    struct Snapshot
+    {
+        FrameNumber frame = 0;
+        bool valid = false;
+        bool digestTaken = false;
+        bool hasDigest = false;
+        std::vector<uint8_t> data;
+        NetplayStateDigest digest;
+    };
+
+    bool m_enabled = false;
+    std::optional<uint32_t> m_timelineEpoch;
+    std::deque<Prediction> m_predictions;
+    std::array<Snapshot, kSnapshotCapacity> m_snapshots;
+    Stats m_stats;
+
+    void dropPredictionsFrom(FrameNumber frame);
+};
+
+} // namespace ConsoleNetplay
@@ -52,6 +52,15 @@ uint32_t runtimeStateCrc32(const std::vector<uint8_t>& payload)
     return payload.empty() ? 0u : crc32(payload.data(), payload.size());
 }
 
+// The payload can be a stored snapshot rather than the running state; the console only
+// returns spans that cover it exactly.
+std::vector<uint32_t> runtimeStateLayout(INetplayStateBridge& emu, const std::vector<uint8_t>& statePayload)
+{
+    std::vector<uint32_t> spans;
+    if(!emu.valid() || !emu.stateLayout(statePayload, spans)) spans.clear();
+    return spans;
+}
+
 } // namespace
 
 SelfStallDetector::Snapshot runtimeBuildSelfStallSnapshot(const NetplayCoordinator& coordinator,
@@ -76,21 +85,30 @@ RuntimeInputDelayResult runtimeSyncInputDelaySettings(NetplayCoordinator& coordi
         inputDriver.setPrebufferFrames(settings.manualInputDelayFrames);
         return {
             settings.manualInputDelayFrames,
-            runtimeInputBufferCapacity(settings.manualInputDelayFrames)
+            runtimeInputBufferCapacity(settings.manualInputDelayFrames),
+            settings.rollback
         };
     }
 
     const RoomState& room = coordinator.session().roomState();
     if(coordinator.isHosting()) {
+        coordinator.setRollbackEnabled(settings.rollback);
         if(settings.autoGameplayTuning) {
             const NetplayAutoTune::Recommendations recommendations = autoTune.update(
                 room,
                 coordinator.recoveryStats(),
                 settings.regionFps
             );
-            if(recommendations.inputDelayFrames.has_value() &&
-               room.inputDelayFrames != *recommendations.inputDelayFrames) {
-                coordinator.setInputDelayFrames(*recommendations.inputDelayFrames);
+            uint8_t targetDelay = recommendations.inputDelayFrames.value_or(room.inputDelayFrames);
+            if(room.rollbackEnabled) {
+                // Every peer predicts, which covers the latency the delay would otherwise absorb.
+                targetDelay = std::min<uint8_t>(
+                    targetDelay,
+                    static_cast<uint8_t>(NetplayRollback::kMaxAutoInputDelayFrames)
+                );
+            }
+            if(room.inputDelayFrames != targetDelay) {
+                coordinator.setInputDelayFrames(targetDelay);
             }
         } else {
             const uint8_t manualDelay =
@@ -106,7 +124,8 @@ RuntimeInputDelayResult runtimeSyncInputDelaySettings(NetplayCoordinator& coordi
 
     return {
         static_cast<uint32_t>(effectiveRoom.inputDelayFrames),
-        runtimeInputBufferCapacity(effectiveRoom.inputDelayFrames)
+        runtimeInputBufferCapacity(effectiveRoom.inputDelayFrames),
+        effectiveRoom.rollbackEnabled
     };
 }
 
@@ -338,13 +357,15 @@ RuntimeAuthoritativeStateResult runtimeBeginAuthoritativeResync(
     } else if(!preferConfirmedSnapshot) {
         stateCrc32 = 0;
     }
+    const std::vector<uint32_t> layoutSpans = runtimeStateLayout(emu, statePayload);
     if(!coordinator.beginResync(
            authoritativeFrame,
            statePayload,
            payloadCrc32,
            stateCrc32,
            reason,
-           targetParticipantId
+           targetParticipantId,
+           layoutSpans
        )) {
         return result;
     }
@@ -378,7 +399,16 @@ RuntimeAuthoritativeStateResult runtimeBeginAuthoritativeResyncWithoutLocalReloa
     const uint32_t payloadCrc32 = crc32(statePayload.data(), statePayload.size());
     const uint32_t stateCrc32 =
         runtimeComputeAuthoritativeStateCrc32(emu, runtimeHost, authoritativeFrame, preferConfirmedSnapshot);
-    if(!coordinator.beginResync(authoritativeFrame, statePayload, payloadCrc32, stateCrc32, reason)) {
+    const std::vector<uint32_t> layoutSpans = runtimeStateLayout(emu, statePayload);
+    if(!coordinator.beginResync(
+           authoritativeFrame,
+           statePayload,
+           payloadCrc32,
+           stateCrc32,
+           reason,
+           kInvalidParticipantId,
+           layoutSpans
+       )) {
         return result;
     }
 
@@ -403,7 +433,8 @@ RuntimePeriodicCrcResult runtimeSubmitPeriodicLocalCrcIfNeeded(
     NetplayCoordinator& coordinator,
     INetplayStateBridge& emu,
     const INetplayStateHostBridge& runtimeHost,
-    RuntimePeriodicCrcState& state)
+    RuntimePeriodicCrcState& state,
+    const NetplayRollback* rollback)
 {
     RuntimePeriodicCrcResult result;
 
@@ -420,31 +451,57 @@ RuntimePeriodicCrcResult runtimeSubmitPeriodicLocalCrcIfNeeded(
     // cached "frame-ready" CRC for that older frame can diverge transiently
     // from a peer that is only confirmed through the older frame. Wait until
     // confirmed and frame-ready have converged before submitting periodic CRCs.
+    // In rollback mode the emulator normally runs ahead of the confirmed frame on predicted
+    // input. The rollback snapshot taken at the start of the confirmed frame is usable once
+    // no unchecked prediction precedes it: every wrong one has been replayed by then, and the
+    // replay stores that snapshot again. Snapshots stored without a digest are skipped; a
+    // later checkpoint has one.
+    const std::vector<uint8_t>* rollbackState =
+        rollback != nullptr &&
+        rollback->enabled() &&
+        confirmedFrame != 0u &&
+        confirmedFrame < lastFrameReadyFrame &&
+        !rollback->hasPredictionBefore(confirmedFrame) &&
+        rollback->snapshotDigestTaken(confirmedFrame)
+            ? rollback->snapshotForFrame(confirmedFrame)
+            : nullptr;
     const FrameNumber crcCheckpointFrame =
-        confirmedFrame != 0u && confirmedFrame == lastFrameReadyFrame
+        confirmedFrame != 0u && (confirmedFrame == lastFrameReadyFrame || rollbackState != nullptr)
             ? confirmedFrame
             : 0u;
     if(crcCheckpointFrame == 0) return result;
 
-    const bool periodicDue = crcCheckpointFrame >= state.nextScheduledLocalCrcFrame;
-    const bool postRecoveryRapidDue =
-        crcCheckpointFrame > state.lastSubmittedLocalCrcFrame &&
-        crcCheckpointFrame <= state.postRecoveryRapidCrcThroughFrame;
-    const bool forcedDue =
-        state.forceNextConfirmedCrcSubmission &&
-        crcCheckpointFrame != state.lastSubmittedLocalCrcFrame;
-    if(!periodicDue && !forcedDue && !postRecoveryRapidDue) return result;
+    if(!runtimePeriodicCrcMaySubmitFrame(state, crcCheckpointFrame)) return result;
 
     // Periodic desync checks compare only the live canonical state at the
     // confirmed checkpoint. Cached per-frame snapshots can be stale relative to
     // the currently loaded simulation state and are not trusted for resync.
+    // Consoles with a state digest submit its root and send the component digests along;
+    // the others fall back to the CRC of the whole serialized state. Both peers run the
+    // same console, so they always agree on which of the two is compared.
     std::optional<uint32_t> crc32;
+    std::vector<uint32_t> componentDigests;
     const char* submittedSource = nullptr;
     CrcSubmissionSource submittedSourceKind = CrcSubmissionSource::Unknown;
     if(emu.frameCount() == crcCheckpointFrame) {
-        crc32 = runtimeStateCrc32(emu.saveStateToMemory());
+        NetplayStateDigest digest;
+        if(emu.stateDigest(digest)) {
+            crc32 = digest.root;
+            componentDigests = std::move(digest.components);
+        } else {
+            crc32 = runtimeStateCrc32(emu.saveStateToMemory());
+        }
         submittedSource = "local CRC submission (live-canonical)";
         submittedSourceKind = CrcSubmissionSource::LiveCanonical;
+    } else if(rollbackState != nullptr) {
+        if(const NetplayStateDigest* digest = rollback->snapshotDigestForFrame(crcCheckpointFrame)) {
+            crc32 = digest->root;
+            componentDigests = digest->components;
+        } else {
+            crc32 = runtimeStateCrc32(*rollbackState);
+        }
+        submittedSource = "local CRC submission (rollback snapshot)";
+        submittedSourceKind = CrcSubmissionSource::LiveCanonical;
     }
     if(!crc32.has_value()) return result;
 
@@ -454,7 +511,8 @@ RuntimePeriodicCrcResult runtimeSubmitPeriodicLocalCrcIfNeeded(
         submittedSource,
         submittedSourceKind,
         emu.frameCount(),
-        confirmedFrame
+        confirmedFrame,
+        std::move(componentDigests)
     );
     state.lastSubmittedLocalCrcFrame = crcCheckpointFrame;
     state.forceNextConfirmedCrcSubmission = false;
@@ -471,6 +529,20 @@ RuntimePeriodicCrcResult runtimeSubmitPeriodicLocalCrcIfNeeded(
     return result;
 }
 
+bool runtimePeriodicCrcMaySubmitFrame(const RuntimePeriodicCrcState& state, FrameNumber frame)
+{
+    if(!kDesyncMonitorEnabled) return false;
+
+    const bool periodicDue = frame >= state.nextScheduledLocalCrcFrame;
+    const bool postRecoveryRapidDue =
+        frame > state.lastSubmittedLocalCrcFrame &&
+        frame <= state.postRecoveryRapidCrcThroughFrame;
+    const bool forcedDue =
+        state.forceNextConfirmedCrcSubmission &&
+        frame != state.lastSubmittedLocalCrcFrame;
+    return periodicDue || forcedDue || postRecoveryRapidDue;
+}
+
 std::string runtimeAssignmentLayoutKey(const NetplayCoordinator& coordinator)
 {
     if(!coordinator.isActive()) return {};
@@ -793,6 +865,23 @@ RuntimeHostResyncProcessResult runtimeProcessSelfStallRecoveryIfNeeded(
     return processResult;
 }
 
+bool runtimeProvideResyncBaseIfNeeded(NetplayCoordinator& coordinator,
+                                      INetplayStateBridge& emu,
+                                      const INetplayStateHostBridge& runtimeHost)
+{
+    const std::optional<NetplayCoordinator::PendingResyncBase> pending = coordinator.pendingResyncBase();
+    if(!pending.has_value()) return false;
+
+    if(const std::optional<std::shared_ptr<const std::vector<uint8_t>>> snapshot =
+           runtimeHost.netplaySnapshotForFrame(pending->targetFrame);
+       snapshot.has_value() && *snapshot) {
+        return coordinator.provideResyncBase(pending->resyncId, **snapshot);
+    }
+
+    const std::vector<uint8_t> base = emu.valid() ? emu.saveStateToMemory() : std::vector<uint8_t>{};
+    return coordinator.provideResyncBase(pending->resyncId, base);
+}
+
 RuntimePendingResyncApplyResult runtimeProcessPendingResyncApplyIfNeeded(
     NetplayCoordinator& coordinator,
     ConfirmedInputBufferDriver& inputDriver,
@@ -1555,6 +1644,113 @@ bool runtimeTryBuildPlaybackConfirmedFrame(NetplayCoordinator& coordinator,
     return true;
 }
 
+bool runtimeTryBuildRollbackPlaybackFrame(NetplayCoordinator& coordinator,
+                                          const ConfirmedInputBufferDriver& inputDriver,
+                                          NetplayRollback& rollback,
+                                          FrameNumber frame,
+                                          NetplayCoordinator::ConfirmedFrameInputs& outFrame)
+{
+    const std::optional<FrameNumber> maxPlaybackFrame = runtimeClientHostPlaybackCapFrame(coordinator);
+    if(rollback.enabled() && (!maxPlaybackFrame.has_value() || frame <= *maxPlaybackFrame)) {
+        bool predicted = false;
+        if(coordinator.tryBuildPredictedPlaybackFrame(frame, outFrame, predicted)) {
+            if(!predicted) {
+                rollback.recordConfirmedPlayback(frame);
+                return true;
+            }
+            if(rollback.canPredict(frame)) {
+                rollback.recordPrediction(frame, outFrame.netplayFrame);
+                return true;
+            }
+        }
+    }
+    return runtimeTryBuildPlaybackConfirmedFrame(coordinator, inputDriver, frame, outFrame);
+}
+
+void runtimeCaptureRollbackSnapshot(NetplayRollback& rollback,
+                                    INetplayConsole& console,
+                                    const RuntimePeriodicCrcState& crcState)
+{
+    if(!rollback.enabled() || !console.valid()) return;
+
+    const FrameNumber frame = console.frameCount();
+    // A digest walks the whole state, so only frames the CRC check may submit get one.
+    NetplayRollback::StateDigester digest;
+    if(runtimePeriodicCrcMaySubmitFrame(crcState, frame)) {
+        digest = [&console](NetplayStateDigest& outDigest) { return console.stateDigest(outDigest); };
+    }
+    rollback.captureSnapshot(
+        frame,
+        [&console](std::vector<uint8_t>& outState) { return console.saveRollbackState(outState); },
+        digest);
+}
+
+RuntimeRollbackResult runtimeRollbackMispredictedFrames(NetplayCoordinator& coordinator,
+                                                        NetplayRollback& rollback,
+                                                        INetplayConsole& console,
+                                                        INetplayStateHostBridge& hostBridge,
+                                                        const RuntimePeriodicCrcState& crcState)
+{
+    RuntimeRollbackResult result;
+    if(!rollback.enabled() || !console.valid()) return result;
+
+    const FrameNumber currentFrame = console.frameCount();
+    rollback.syncTimeline(coordinator.session().roomState().timelineEpoch, currentFrame);
+
+    NetplayCoordinator::ConfirmedFrameInputs actualFrame;
+    const std::optional<FrameNumber> mispredictedFrame = rollback.verify(
+        [&coordinator, &actualFrame](FrameNumber frame, NetplayInputFrame& outInput) {
+            bool predicted = false;
+            if(!coordinator.tryBuildPredictedPlaybackFrame(frame, actualFrame, predicted) || predicted) {
+                return false;
+            }
+            outInput = std::move(actualFrame.netplayFrame);
+            return true;
+        }
+    );
+    if(!mispredictedFrame.has_value()) return result;
+
+    result.fromFrame = *mispredictedFrame;
+    const std::vector<uint8_t>* snapshot = rollback.snapshotForFrame(*mispredictedFrame);
+    if(snapshot == nullptr || !console.loadRollbackState(*snapshot)) {
+        // The wrong frames cannot be replayed without their start state. The periodic CRC
+        // check reports the divergence and the usual resync repairs it.
+        rollback.recordFailedRollback();
+        rollback.reset();
+        result.failed = true;
+        return result;
+    }
+    hostBridge.discardQueuedNetplayInputsAfter(*mispredictedFrame);
+
+    const uint32_t frameDt =
+        std::max<uint32_t>(1u, 1000u / std::max<uint32_t>(1u, console.regionFps()));
+    while(console.frameCount() < currentFrame) {
+        const FrameNumber frame = console.frameCount();
+        runtimeCaptureRollbackSnapshot(rollback, console, crcState);
+
+        NetplayCoordinator::ConfirmedFrameInputs playbackFrame;
+        bool predicted = false;
+        if(!coordinator.tryBuildPredictedPlaybackFrame(frame, playbackFrame, predicted) ||
+           !console.resimulateFrame(playbackFrame, frameDt)) {
+            rollback.recordFailedRollback();
+            rollback.reset();
+            result.failed = true;
+            break;
+        }
+        if(predicted) {
+            rollback.recordPrediction(frame, playbackFrame.netplayFrame);
+        }
+        ++result.resimulatedFrames;
+    }
+
+    if(!result.failed) {
+        result.rolledBack = true;
+        rollback.recordRollback(result.resimulatedFrames);
+    }
+    coordinator.setLocalSimulationFrame(console.frameCount());
+    return result;
+}
+
 SelfStallDetector::Snapshot runtimeBuildSelfStallSnapshot(const NetplayCoordinator& coordinator,
                                                           FrameNumber localSimulationFrame)
 {
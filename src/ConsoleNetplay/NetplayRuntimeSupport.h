@@ -13,6 +13,7 @@
 #include "ConsoleNetplay/NetplayRuntimeTypes.h"
 #include "ConsoleNetplay/NetplayAutoTune.h"
 #include "ConsoleNetplay/NetplayCoordinator.h"
+#include "ConsoleNetplay/NetplayRollback.h"
 #include "ConsoleNetplay/SelfStallDetector.h"
 
 namespace ConsoleNetplay {
@@ -39,12 +40,15 @@ struct RuntimeInputDelaySettings
     bool autoGameplayTuning = false;
     uint32_t manualInputDelayFrames = 0;
     uint32_t regionFps = 60;
+    bool rollback = false;
 };
 
 struct RuntimeInputDelayResult
 {
     uint32_t inputDelayFrames = 0;
     size_t inputBufferCapacity = 64;
+    // The room's setting while in a session: the host's choice applies to every peer.
+    bool rollbackEnabled = false;
 };
 
 class INetplayStateBridge
@@ -59,6 +63,22 @@ public:
     virtual void discardQueuedInputFramesAfter(FrameNumber frame) = 0;
     virtual bool loadStateFromMemoryOnCleanBoot(const std::vector<uint8_t>& payload) = 0;
     virtual std::vector<uint8_t> saveStateToMemory() = 0;
+    // See INetplayConsole::stateDigest().
+    virtual bool stateDigest(NetplayStateDigest& outDigest)
+    {
+        (void)outDigest;
+        return false;
+    }
+    // Byte counts splitting state, a saveStateToMemory() output that may be older than the
+    // running one, at the console's component boundaries. Resyncs then resend whole
+    // components; without it they use fixed blocks. Called with the emulator locked, so it
+    // must not load or copy the state.
+    virtual bool stateLayout(const std::vector<uint8_t>& state, std::vector<uint32_t>& outSpans)
+    {
+        (void)state;
+        (void)outSpans;
+        return false;
+    }
 };
 
 class INetplayStateHostBridge
@@ -95,6 +115,20 @@ public:
         return m_host.loadStateFromMemoryOnCleanBoot(payload);
     }
     std::vector<uint8_t> saveStateToMemory() override { return m_host.saveStateToMemory(); }
+    bool stateDigest(NetplayStateDigest& outDigest) override
+    {
+        if(!m_host.valid()) return false;
+        const auto digest = m_host.stateDigest();
+        outDigest.root = digest.root;
+        outDigest.components.assign(digest.components.begin(), digest.components.end());
+        return true;
+    }
+    bool stateLayout(const std::vector<uint8_t>& state, std::vector<uint32_t>& outSpans) override
+    {
+        if(!m_host.valid()) return false;
+        outSpans = m_host.stateLayout(state);
+        return !outSpans.empty();
+    }
 
 private:
     EmulatorHost& m_host;
@@ -203,6 +237,14 @@ struct RuntimeHostResyncProcessResult
     ParticipantId targetParticipantId = kInvalidParticipantId;
 };
 
+struct RuntimeRollbackResult
+{
+    bool rolledBack = false;
+    bool failed = false;
+    FrameNumber fromFrame = 0;
+    uint32_t resimulatedFrames = 0;
+};
+
 struct RuntimePendingResyncApplyResult
 {
     bool consumed = false;
@@ -329,7 +371,12 @@ RuntimePeriodicCrcResult runtimeSubmitPeriodicLocalCrcIfNeeded(
     NetplayCoordinator& coordinator,
     INetplayStateBridge& emu,
     const INetplayStateHostBridge& runtimeHost,
-    RuntimePeriodicCrcState& state);
+    RuntimePeriodicCrcState& state,
+    const NetplayRollback* rollback = nullptr);
+
+// Whether runtimeSubmitPeriodicLocalCrcIfNeeded() would still submit frame once it is the
+// checkpoint. Rollback snapshots of other frames are stored without a digest.
+bool runtimePeriodicCrcMaySubmitFrame(const RuntimePeriodicCrcState& state, FrameNumber frame);
 
 RuntimeAutoStartResult runtimeProcessAutoStartIfNeeded(NetplayCoordinator& coordinator,
                                                        const INetplayStateBridge& emu,
@@ -363,6 +410,12 @@ RuntimeHostResyncProcessResult runtimeProcessSelfStallRecoveryIfNeeded(
     INetplayStateHostBridge& runtimeHost,
     std::chrono::steady_clock::time_point now);
 
+// Hands the coordinator the local state an incoming partial resync is diffed against: the
+// held snapshot of the target frame when there is one, the live state otherwise.
+bool runtimeProvideResyncBaseIfNeeded(NetplayCoordinator& coordinator,
+                                      INetplayStateBridge& emu,
+                                      const INetplayStateHostBridge& runtimeHost);
+
 RuntimePendingResyncApplyResult runtimeProcessPendingResyncApplyIfNeeded(
     NetplayCoordinator& coordinator,
     ConfirmedInputBufferDriver& inputDriver,
@@ -451,4 +504,26 @@ bool runtimeTryBuildPlaybackConfirmedFrame(NetplayCoordinator& coordinator,
                                            FrameNumber frame,
                                            NetplayCoordinator::ConfirmedFrameInputs& outFrame);
 
+// Rollback mode: a frame missing remote input is played on a prediction while the window
+// allows it; otherwise this is runtimeTryBuildPlaybackConfirmedFrame().
+bool runtimeTryBuildRollbackPlaybackFrame(NetplayCoordinator& coordinator,
+                                          const ConfirmedInputBufferDriver& inputDriver,
+                                          NetplayRollback& rollback,
+                                          FrameNumber frame,
+                                          NetplayCoordinator::ConfirmedFrameInputs& outFrame);
+
+// Stores the state at the start of the console's current frame, with its digest only when
+// the periodic CRC check may still ask for that frame.
+void runtimeCaptureRollbackSnapshot(NetplayRollback& rollback,
+                                    INetplayConsole& console,
+                                    const RuntimePeriodicCrcState& crcState);
+
+// Checks predictions against the inputs that arrived since. On a wrong one the console is
+// restored to the start of that frame and replayed silently up to where it was.
+RuntimeRollbackResult runtimeRollbackMispredictedFrames(NetplayCoordinator& coordinator,
+                                                        NetplayRollback& rollback,
+                                                        INetplayConsole& console,
+                                                        INetplayStateHostBridge& hostBridge,
+                                                        const RuntimePeriodicCrcState& crcState);
+
 } // namespace ConsoleNetplay
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstdint>
+#include <vector>
 
 namespace ConsoleNetplay {
 
@@ -38,4 +39,13 @@ enum class CrcSubmissionSource : uint8_t
     LiveCanonical
 };
 
+// Console state hashed as a tree: one digest per component (the console decides what the
+// components are) and a root over them. Desync checks compare roots; the components tell
+// which part of the machine diverged.
+struct NetplayStateDigest
+{
+    uint32_t root = 0;
+    std::vector<uint32_t> components;
+};
+
 } // namespace ConsoleNetplay
@@ -0,0 +1,185 @@
+#include "ConsoleNetplay/ResyncPayload.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "ConsoleNetplay/NetplayCrc32.h"
+
+// miniz.h carries its implementation, which the miniz library builds once from zip.c, so
+// only the zlib-style calls used here are declared, as miniz.h declares them.
+extern "C" {
+typedef unsigned long mz_ulong;
+mz_ulong mz_compressBound(mz_ulong source_len);
+int mz_compress2(unsigned char* pDest, mz_ulong* pDest_len,
+                 const unsigned char* pSource, mz_ulong source_len, int level);
+int mz_uncompress(unsigned char* pDest, mz_ulong* pDest_len,
+                  const unsigned char* pSource, mz_ulong source_len);
+}
+
+namespace ConsoleNetplay {
+
+namespace {
+constexpr int kMinizOk = 0;
+constexpr int kDeflateLevel = 6;
+
+void appendSegments(std::vector<ResyncSegment>& segments,
+                    std::span<const uint8_t> payload,
+                    size_t offset,
+                    size_t size,
+                    size_t segmentBytes)
+{
+    while(size > 0) {
+        const size_t length = std::min(size, segmentBytes);
+        ResyncSegment segment;
+        segment.size = static_cast<uint32_t>(length);
+        segment.crc32 = crc32(payload.data() + offset, length);
+        segments.push_back(segment);
+        offset += length;
+        size -= length;
+    }
+}
+} // namespace
+
+std::vector<ResyncSegment> buildResyncSegments(std::span<const uint8_t> payload,
+                                               std::span<const uint32_t> spans)
+{
+    std::vector<ResyncSegment> segments;
+
+    size_t spanTotal = 0;
+    size_t spanSegments = 0;
+    for(const uint32_t span : spans) {
+        spanTotal += span;
+        spanSegments += (span + kResyncSegmentBytes - 1) / kResyncSegmentBytes;
+    }
+    if(!spans.empty() && spanTotal == payload.size() && spanSegments <= kMaxResyncSegments) {
+        size_t offset = 0;
+        for(const uint32_t span : spans) {
+            appendSegments(segments, payload, offset, span, kResyncSegmentBytes);
+            offset += span;
+        }
+        return segments;
+    }
+
+    const size_t segmentBytes =
+        std::max(kResyncSegmentBytes, (payload.size() + kMaxResyncSegments - 1) / kMaxResyncSegments);
+    appendSegments(segments, payload, 0, payload.size(), segmentBytes);
+    return segments;
+}
+
+bool resyncSegmentsCover(const std::vector<ResyncSegment>& segments, size_t payloadSize)
+{
+    size_t total = 0;
+    for(const ResyncSegment& segment : segments) {
+        total += segment.size;
+    }
+    return total == payloadSize;
+}
+
+std::vector<uint8_t> fullResyncSegmentMask(size_t segmentCount)
+{
+    std::vector<uint8_t> mask((segmentCount + 7u) / 8u, 0xFFu);
+    if(segmentCount % 8u != 0u) {
+        mask.back() = static_cast<uint8_t>((1u << (segmentCount % 8u)) - 1u);
+    }
+    return mask;
+}
+
+bool resyncSegmentMasked(const std::vector<uint8_t>& mask, size_t index)
+{
+    return (index / 8u) < mask.size() && (mask[index / 8u] & (1u << (index % 8u))) != 0;
+}
+
+size_t resyncSegmentMaskCount(const std::vector<uint8_t>& mask, size_t segmentCount)
+{
+    size_t count = 0;
+    for(size_t index = 0; index < segmentCount; ++index) {
+        if(resyncSegmentMasked(mask, index)) ++count;
+    }
+    return count;
+}
+
+std::vector<uint8_t> reuseResyncSegments(const std::vector<ResyncSegment>& segments,
+                                         std::span<const uint8_t> base,
+                                         std::vector<uint8_t>& payload)
+{
+    std::vector<uint8_t> missing = fullResyncSegmentMask(segments.size());
+    if(base.size() != payload.size() || !resyncSegmentsCover(segments, payload.size())) {
+        return missing;
+    }
+
+    size_t offset = 0;
+    for(size_t index = 0; index < segments.size(); ++index) {
+        const ResyncSegment& segment = segments[index];
+        if(crc32(base.data() + offset, segment.size) == segment.crc32) {
+            std::memcpy(payload.data() + offset, base.data() + offset, segment.size);
+            missing[index / 8u] = static_cast<uint8_t>(missing[index / 8u] & ~(1u << (index % 8u)));
+        }
+        offset += segment.size;
+    }
+    return missing;
+}
+
+std::vector<uint8_t> gatherResyncSegments(const std::vector<ResyncSegment>& segments,
+                                          const std::vector<uint8_t>& mask,
+                                          std::span<const uint8_t> payload)
+{
+    std::vector<uint8_t> data;
+    size_t offset = 0;
+    for(size_t index = 0; index < segments.size() && offset <= payload.size(); ++index) {
+        const size_t size = std::min<size_t>(segments[index].size, payload.size() - offset);
+        if(resyncSegmentMasked(mask, index)) {
+            data.insert(data.end(), payload.begin() + offset, payload.begin() + offset + size);
+        }
+        offset += size;
+    }
+    return data;
+}
+
+bool scatterResyncSegments(const std::vector<ResyncSegment>& segments,
+                           const std::vector<uint8_t>& mask,
+                           std::span<const uint8_t> data,
+                           std::vector<uint8_t>& payload)
+{
+    if(!resyncSegmentsCover(segments, payload.size())) return false;
+
+    size_t offset = 0;
+    size_t read = 0;
+    for(size_t index = 0; index < segments.size(); ++index) {
+        const size_t size = segments[index].size;
+        if(resyncSegmentMasked(mask, index)) {
+            if(size > data.size() - read) return false;
+            std::memcpy(payload.data() + offset, data.data() + read, size);
+            read += size;
+        }
+        offset += size;
+    }
+    return read == data.size();
+}
+
+bool deflateResyncData(std::span<const uint8_t> input, std::vector<uint8_t>& output)
+{
+    mz_ulong outputSize = mz_compressBound(static_cast<mz_ulong>(input.size()));
+    output.resize(outputSize);
+    if(mz_compress2(output.data(), &outputSize, input.data(),
+                    static_cast<mz_ulong>(input.size()), kDeflateLevel) != kMinizOk) {
+        output.clear();
+        return false;
+    }
+    output.resize(outputSize);
+    return true;
+}
+
+bool inflateResyncData(std::span<const uint8_t> input, size_t outputSize, std::vector<uint8_t>& output)
+{
+    output.resize(outputSize);
+    mz_ulong inflatedSize = static_cast<mz_ulong>(outputSize);
+    if(mz_uncompress(output.data(), &inflatedSize, input.data(),
+                     static_cast<mz_ulong>(input.size())) != kMinizOk ||
+       inflatedSize != outputSize) {
+        output.clear();
+        return false;
+    }
+    return true;
+}
+
+} // namespace ConsoleNetplay
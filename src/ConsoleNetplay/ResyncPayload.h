@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "ConsoleNetplay/NetProtocol.h"
+
+namespace ConsoleNetplay {
+
+// Longest resync segment. Layout spans above it are cut, so a few written RAM or CHR-RAM
+// bytes resend a kilobyte instead of the whole region.
+constexpr size_t kResyncSegmentBytes = 1024;
+
+// Cuts payload along spans (INetplayStateBridge::stateLayout()) and hashes each piece.
+// Spans that do not add up to the payload are ignored and fixed blocks are used instead.
+std::vector<ResyncSegment> buildResyncSegments(std::span<const uint8_t> payload,
+                                               std::span<const uint32_t> spans = {});
+bool resyncSegmentsCover(const std::vector<ResyncSegment>& segments, size_t payloadSize);
+
+std::vector<uint8_t> fullResyncSegmentMask(size_t segmentCount);
+bool resyncSegmentMasked(const std::vector<uint8_t>& mask, size_t index);
+size_t resyncSegmentMaskCount(const std::vector<uint8_t>& mask, size_t segmentCount);
+
+// Copies the segments base already has (same offset, same CRC) into payload and returns
+// the mask of those still missing. A base of another size provides nothing.
+std::vector<uint8_t> reuseResyncSegments(const std::vector<ResyncSegment>& segments,
+                                         std::span<const uint8_t> base,
+                                         std::vector<uint8_t>& payload);
+
+// The masked segments back to back, and the way back into a payload.
+std::vector<uint8_t> gatherResyncSegments(const std::vector<ResyncSegment>& segments,
+                                          const std::vector<uint8_t>& mask,
+                                          std::span<const uint8_t> payload);
+bool scatterResyncSegments(const std::vector<ResyncSegment>& segments,
+                           const std::vector<uint8_t>& mask,
+                           std::span<const uint8_t> data,
+                           std::vector<uint8_t>& payload);
+
+// zlib streams, through the miniz bundled with the zip reader.
+bool deflateResyncData(std::span<const uint8_t> input, std::vector<uint8_t>& output);
+bool inflateResyncData(std::span<const uint8_t> input, size_t outputSize, std::vector<uint8_t>& output);
+
+} // namespace ConsoleNetplay
@@ -15,26 +15,38 @@
 
 namespace GeraNES {
 
-class APU
+// Persisted frame counter and register write state, saved as one block (see
+// SerializationBase::block). The channels save their own blocks.
+struct APUState
 {
-    IAudioOutput& m_audioOutput;
-    Settings& m_settings;
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+
+    int m_frameStep;
+    int m_nextDelay;
+    int m_writeChannelsAddr;
 
     bool m_mode;
     bool m_interruptInhibitFlag;
 
-    int m_frameStep;
-
     bool m_frameInterruptFlag;
     uint8_t m_frameInterruptClearDelay;
 
     bool m_jitter;
 
+    bool m_writeChannelsFlag;
+    uint8_t m_writeChannelsData;
+    uint8_t m_last4017Value;
+};
+
+class APU : private APUState
+{
+    IAudioOutput& m_audioOutput;
+    Settings& m_settings;
+
     const int mode0DelaysNtsc[6] = {7457, 7456, 7458, 7457, 1, 1 };
     const int mode1DelaysNtsc[5] = {7457, 7456, 7458, 7457, 7453};
     const int mode0DelaysPal[6] = {8313, 8314, 8312, 8313, 1, 1};
     const int mode1DelaysPal[5] = {8313, 8314, 8312, 8314, 8312};
-    int m_nextDelay;
 
     PulseChannel m_pulse1;
     PulseChannel m_pulse2;
@@ -42,11 +54,6 @@ class APU
     NoiseChannel m_noise;
     SampleChannel m_sample;
 
-    bool m_writeChannelsFlag;
-    int m_writeChannelsAddr;
-    uint8_t m_writeChannelsData;
-    uint8_t m_last4017Value;
-
     // Audio device parameters only need to be pushed when the generated
     // channel state actually changes.
     bool m_audioOutputStateDirty = true;
@@ -78,26 +85,24 @@ public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_mode);
-        SERIALIZEDATA(s, m_interruptInhibitFlag);
-
-        SERIALIZEDATA(s, m_frameStep);
-        SERIALIZEDATA(s, m_frameInterruptFlag);
-        SERIALIZEDATA(s, m_frameInterruptClearDelay);
-
-        SERIALIZEDATA(s, m_jitter);
-        SERIALIZEDATA(s, m_nextDelay);
+        s.block(static_cast<APUState&>(*this));
 
         m_pulse1.serialization(s);
         m_pulse2.serialization(s);
         m_triangle.serialization(s);
         m_noise.serialization(s);
         m_sample.serialization(s);
+    }
+
+    void copyStateFrom(const APU& source)
+    {
+        static_cast<APUState&>(*this) = source;
 
-        SERIALIZEDATA(s, m_writeChannelsFlag);
-        SERIALIZEDATA(s, m_writeChannelsAddr);
-        SERIALIZEDATA(s, m_writeChannelsData);
-        SERIALIZEDATA(s, m_last4017Value);
+        m_pulse1.copyStateFrom(source.m_pulse1);
+        m_pulse2.copyStateFrom(source.m_pulse2);
+        m_triangle.copyStateFrom(source.m_triangle);
+        m_noise.copyStateFrom(source.m_noise);
+        m_sample.copyStateFrom(source.m_sample);
     }
 
     APU(IAudioOutput& audioOutput, Settings& settings) :
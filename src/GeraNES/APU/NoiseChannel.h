@@ -5,24 +5,15 @@
 
 namespace GeraNES {
 
-class NoiseChannel
+// Persisted noise channel state, saved as one block (see SerializationBase::block).
+struct NoiseChannelState
 {
-private:
-
-    static constexpr std::array<uint16_t, 16> NTSC_NOISE_PERIOD_TABLE = {
-        4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
-    };
-
-    static constexpr std::array<uint16_t, 16> PAL_NOISE_PERIOD_TABLE = {
-        4, 7, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708, 944, 1890, 3778
-    };
-
-    Settings& m_settings;
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
-    bool m_enabled;
     uint16_t m_lengthCounter;
     uint16_t m_period;
 
+    bool m_enabled;
     bool m_loop;
 
     bool m_constantVolumeMode;
@@ -33,24 +24,32 @@ private:
     bool m_mode;
 
     bool m_lengthUpdated;
+};
+
+class NoiseChannel : private NoiseChannelState
+{
+private:
+
+    static constexpr std::array<uint16_t, 16> NTSC_NOISE_PERIOD_TABLE = {
+        4, 8, 16, 32, 64, 96, 128, 160, 202, 254, 380, 508, 762, 1016, 2034, 4068
+    };
+
+    static constexpr std::array<uint16_t, 16> PAL_NOISE_PERIOD_TABLE = {
+        4, 7, 14, 30, 60, 88, 118, 148, 188, 236, 354, 472, 708, 944, 1890, 3778
+    };
+
+    Settings& m_settings;
 
 public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_enabled);
-        SERIALIZEDATA(s, m_lengthCounter);
-        SERIALIZEDATA(s, m_period);
-
-        SERIALIZEDATA(s, m_loop);
-        SERIALIZEDATA(s, m_constantVolumeMode);
-        SERIALIZEDATA(s, m_envelopVolume);
-        SERIALIZEDATA(s, m_constantVolumeAndEnvelopPeriod);
-        SERIALIZEDATA(s, m_envelopCounter);
-
-        SERIALIZEDATA(s, m_mode);
+        s.block(static_cast<NoiseChannelState&>(*this));
+    }
 
-        SERIALIZEDATA(s, m_lengthUpdated);
+    void copyStateFrom(const NoiseChannel& source)
+    {
+        static_cast<NoiseChannelState&>(*this) = source;
     }
 
     NoiseChannel(Settings& settings) : m_settings(settings)
@@ -5,18 +5,20 @@
 
 namespace GeraNES {
 
-class PulseChannel
+// Persisted pulse channel state, saved as one block (see SerializationBase::block).
+struct PulseChannelState
 {
-private:
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
-    bool m_enabled;
     uint16_t m_lengthCounter;
     uint16_t m_period;
+    uint16_t m_sweepCounter;
+    uint16_t m_sweepResult;
 
+    bool m_enabled;
     uint8_t m_duty;
 
     bool m_loop;
-
     bool m_constantVolumeMode;
     uint8_t m_envelopPeriod;
     uint8_t m_envelopVolume;
@@ -29,38 +31,23 @@ private:
     uint8_t m_sweepShift;
     bool m_sweepWritten;
 
-    uint16_t m_sweepCounter;
-    uint16_t m_sweepResult;
-
     bool m_lengthUpdated;
+};
+
+class PulseChannel : private PulseChannelState
+{
+private:
 
 public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_enabled);
-        SERIALIZEDATA(s, m_lengthCounter);
-        SERIALIZEDATA(s, m_period);
-
-        SERIALIZEDATA(s, m_duty);
-
-        SERIALIZEDATA(s, m_loop);
-        SERIALIZEDATA(s, m_constantVolumeMode);
-        SERIALIZEDATA(s, m_envelopPeriod);
-        SERIALIZEDATA(s, m_envelopVolume);
-        SERIALIZEDATA(s, m_constantVolume);
-        SERIALIZEDATA(s, m_envelopCounter);
-
-        SERIALIZEDATA(s, m_sweepEnabled);
-        SERIALIZEDATA(s, m_sweepPeriod);
-        SERIALIZEDATA(s, m_sweepNegative);
-        SERIALIZEDATA(s, m_sweepShift);
-        SERIALIZEDATA(s, m_sweepWritten);
-
-        SERIALIZEDATA(s, m_sweepCounter);
-        SERIALIZEDATA(s, m_sweepResult);
+        s.block(static_cast<PulseChannelState&>(*this));
+    }
 
-        SERIALIZEDATA(s, m_lengthUpdated);
+    void copyStateFrom(const PulseChannel& source)
+    {
+        static_cast<PulseChannelState&>(*this) = source;
     }
 
     PulseChannel()
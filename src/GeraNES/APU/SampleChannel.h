@@ -9,29 +9,25 @@
 
 namespace GeraNES {
 
-class SampleChannel
+// Persisted DMC state, saved as one block (see SerializationBase::block).
+struct SampleChannelState
 {
-private:
-    static constexpr std::array<uint16_t, 16> NTSC_DMC_PERIOD_TABLE = {
-        428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
-    };
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
-    static constexpr std::array<uint16_t, 16> PAL_DMC_PERIOD_TABLE = {
-        398, 354, 316, 298, 276, 236, 210, 198, 176, 148, 132, 118, 98, 78, 66, 50
-    };
-
-    Settings& m_settings;
-    IAudioOutput& m_audioGenerator;
+    uint32_t m_periodIndex = 0;
+    int m_periodCounter = 0;
+    int m_bitsRemaining = 1;
+    uint32_t m_cpuCycleCounter = 0;
+    int m_enableReloadDelay = 0;
+    int m_disableDelay = 0;
 
-    uint8_t m_playMode = 0;
     uint16_t m_currentAddr = 0;
-    uint8_t m_deltaCounter = 64;
     uint16_t m_sampleAddr = 0;
     uint16_t m_sampleLength = 0;
     uint16_t m_bytesRemaining = 0;
-    size_t m_periodIndex = 0;
-    int m_periodCounter = 0;
-    int m_bitsRemaining = 1;
+
+    uint8_t m_playMode = 0;
+    uint8_t m_deltaCounter = 64;
     uint8_t m_shiftRegister = 0;
     uint8_t m_readBuffer = 0;
     bool m_readBufferFilled = false;
@@ -39,12 +35,27 @@ private:
 
     bool m_interruptFlag = false;
 
-    uint32_t m_cpuCycleCounter = 0;
     bool m_directControlFlag = false;
 
     bool m_enabled = false;
-    int m_enableReloadDelay = 0;
-    int m_disableDelay = 0;
+
+    // Explicit tail so the block has no compiler padding.
+    uint8_t m_reserved[3] = {};
+};
+
+class SampleChannel : private SampleChannelState
+{
+private:
+    static constexpr std::array<uint16_t, 16> NTSC_DMC_PERIOD_TABLE = {
+        428, 380, 340, 320, 286, 254, 226, 214, 190, 160, 142, 128, 106, 84, 72, 54
+    };
+
+    static constexpr std::array<uint16_t, 16> PAL_DMC_PERIOD_TABLE = {
+        398, 354, 316, 298, 276, 236, 210, 198, 176, 148, 132, 118, 98, 78, 66, 50
+    };
+
+    Settings& m_settings;
+    IAudioOutput& m_audioGenerator;
 
     GERANES_INLINE bool loopEnabled() const
     {
@@ -128,29 +139,15 @@ public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_playMode);
-        SERIALIZEDATA(s, m_currentAddr);
-        SERIALIZEDATA(s, m_deltaCounter);
-        SERIALIZEDATA(s, m_sampleAddr);
-        SERIALIZEDATA(s, m_sampleLength);
-        SERIALIZEDATA(s, m_bytesRemaining);
-        uint32_t periodIndex = static_cast<uint32_t>(m_periodIndex);
-        SERIALIZEDATA(s, periodIndex);
+        s.block(static_cast<SampleChannelState&>(*this));
         if(s.isReading()) {
-            m_periodIndex = periodIndex;
+            m_periodIndex &= 0x0F;
         }
-        SERIALIZEDATA(s, m_periodCounter);
-        SERIALIZEDATA(s, m_bitsRemaining);
-        SERIALIZEDATA(s, m_shiftRegister);
-        SERIALIZEDATA(s, m_readBuffer);
-        SERIALIZEDATA(s, m_readBufferFilled);
-        SERIALIZEDATA(s, m_silenceFlag);
-        SERIALIZEDATA(s, m_interruptFlag);
-        SERIALIZEDATA(s, m_cpuCycleCounter);
-        SERIALIZEDATA(s, m_directControlFlag);
-        SERIALIZEDATA(s, m_enabled);
-        SERIALIZEDATA(s, m_enableReloadDelay);
-        SERIALIZEDATA(s, m_disableDelay);
+    }
+
+    void copyStateFrom(const SampleChannel& source)
+    {
+        static_cast<SampleChannelState&>(*this) = source;
     }
 
     SampleChannel(Settings& settings, IAudioOutput& audioOutput)
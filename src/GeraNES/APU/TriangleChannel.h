@@ -5,34 +5,33 @@
 
 namespace GeraNES {
 
-class TriangleChannel
+// Persisted triangle channel state, saved as one block (see SerializationBase::block).
+struct TriangleChannelState
 {
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
-private:
-
-    bool m_enabled;
     uint16_t m_lengthCounter;
     uint16_t m_period;
+    uint16_t m_linearCounter;
 
+    bool m_enabled;
     bool m_loop;
-
     uint8_t m_linearLoad;
-    uint16_t m_linearCounter;
-
     bool m_linearReloadFlag;
+};
 
+class TriangleChannel : private TriangleChannelState
+{
 public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_enabled);
-        SERIALIZEDATA(s, m_lengthCounter);
-        SERIALIZEDATA(s, m_period);
-
-        SERIALIZEDATA(s, m_loop);
-        SERIALIZEDATA(s, m_linearLoad);
-        SERIALIZEDATA(s, m_linearCounter);
-        SERIALIZEDATA(s, m_linearReloadFlag);
+        s.block(static_cast<TriangleChannelState&>(*this));
+    }
+
+    void copyStateFrom(const TriangleChannel& source)
+    {
+        static_cast<TriangleChannelState&>(*this) = source;
     }
 
     TriangleChannel()
@@ -11,6 +11,7 @@
 #include "PPU.h"
 #include "APU/APU.h"
 #include "Cartridge.h"
+#include "Profiler.h"
 
 #include "signal/signal.h"
 
@@ -85,21 +86,21 @@ inline constexpr std::array<AddrMode, 256> addrMode = {
 /*0xF0*/    M::Rel,     M::IndY,        M::None,    M::IndYW,       M::ZeroX,       M::ZeroX,       M::ZeroX,       M::ZeroX,       M::Imp,     M::AbsY,    M::Imp,     M::AbsYW,   M::AbsX,    M::AbsX,    M::AbsXW,   M::AbsXW,
 };
 
-class CPU2A03
-{
-private:
-    friend class DMA;
-    const uint16_t NMI_VECTOR = 0xFFFA;
-    const uint16_t IRQ_VECTOR = 0xFFFE;
+// How emulateOpcode() reaches the instruction bodies: the member function pointer table,
+// or a switch whose direct calls can be inlined. Build with GERANES_CPU_SWITCH_DISPATCH
+// to make the switch the default.
+enum class OpcodeDispatch { Table, Switch };
 
-    Ibus& m_bus;
-    Console& m_console;
+#if defined(GERANES_CPU_SWITCH_DISPATCH)
+inline constexpr OpcodeDispatch DEFAULT_OPCODE_DISPATCH = OpcodeDispatch::Switch;
+#else
+inline constexpr OpcodeDispatch DEFAULT_OPCODE_DISPATCH = OpcodeDispatch::Table;
+#endif
 
-    uint16_t m_pc;
-    uint8_t m_sp;
-    uint8_t m_a;
-    uint8_t m_x;
-    uint8_t m_y;
+// Persisted CPU state, saved as one block (see SerializationBase::block).
+struct CPU2A03State
+{
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
     struct StatusFlags {
         bool carry : 1;
@@ -112,40 +113,62 @@ private:
         bool negative : 1;
     };
 
+    enum class NmiStep {WAITING_HIGH, WAITING_LOW, OK};
+    enum class Interrupt {NONE, NMI, IRQ};
+
+    unsigned int m_cyclesCounter;
+    int m_currentInstructionCycle;
+    int m_runCount;
+    NmiStep m_nmiStep;
+    Interrupt m_interrupt;
+    Settings::Region m_ppuTimingRegion = Settings::Region::NTSC;
+
+    uint16_t m_pc;
+    uint16_t m_addr;
+
+    uint8_t m_sp;
+    uint8_t m_a;
+    uint8_t m_x;
+    uint8_t m_y;
+
     union {
         uint8_t m_status;
         StatusFlags m_flags;
     };
 
-    unsigned int m_cyclesCounter;
     uint8_t m_opcode;
-    uint16_t m_addr;
     uint8_t m_addrHigh;
     bool m_addrPageCross;
 
     bool m_nmiSignal;
     bool m_irqSignal;
-
-    enum class NmiStep {WAITING_HIGH, WAITING_LOW, OK};
-
-    NmiStep m_nmiStep;
     bool m_irqStep;
 
-    enum class Interrupt {NONE, NMI, IRQ} m_interrupt;
-
-    int m_currentInstructionCycle;
-
     uint8_t m_poolIntsAtCycle;
 
-    int m_runCount;
-
     bool m_writeCycle;
 
-    bool m_resetRequest;
     bool m_lastReadHadDma = false;
     bool m_indexedDummyReadHadDma = false;
-    Settings::Region m_ppuTimingRegion = Settings::Region::NTSC;
     uint8_t m_ppuLateCycleRemainder = 0;
+};
+
+class CPU2A03 : private CPU2A03State
+{
+private:
+    friend class DMA;
+    const uint16_t NMI_VECTOR = 0xFFFA;
+    const uint16_t IRQ_VECTOR = 0xFFFE;
+
+    Ibus& m_bus;
+    Console& m_console;
+
+    bool m_resetRequest;
+    // Catch-up mode: PPU dots are queued and run in batches at the next point that can
+    // observe them. Never serialized; GeraNESEmu syncs before anything reads the PPU.
+    bool m_ppuCatchUp = false;
+    int m_pendingPpuCycles = 0;
+    int m_ppuCyclesUntilEvent = 0;
     DMA m_dma;
 
     GERANES_INLINE_HOT uint16_t MAKE16(uint8_t low, uint8_t high)
@@ -361,11 +384,37 @@ private:
             }
         }
 
+        if(m_ppuCatchUp) {
+            deferPpuCycles(lateCycles);
+            return;
+        }
+
         while(lateCycles-- > 0) {
             m_console.ppu().ppuCycle();
         }
     }
 
+    GERANES_INLINE void runPendingPpuCycles()
+    {
+        const int cycles = m_pendingPpuCycles;
+        m_pendingPpuCycles = 0;
+        m_console.ppu().runCycles(cycles);
+    }
+
+    GERANES_INLINE_HOT void deferPpuCycles(int cycles)
+    {
+        if(m_pendingPpuCycles == 0) {
+            m_ppuCyclesUntilEvent = m_console.ppu().cyclesUntilNextEvent();
+        }
+
+        m_pendingPpuCycles += cycles;
+
+        // The queue may grow up to the next event dot, but never run past it.
+        if(m_pendingPpuCycles > m_ppuCyclesUntilEvent) {
+            runPendingPpuCycles();
+        }
+    }
+
 
 public:
 
@@ -429,6 +478,24 @@ public:
         m_dma.init();
     }
 
+    GERANES_INLINE void syncPpu()
+    {
+        if(m_pendingPpuCycles > 0) {
+            runPendingPpuCycles();
+        }
+    }
+
+    void setPpuCatchUp(bool enabled)
+    {
+        syncPpu();
+        m_ppuCatchUp = enabled;
+    }
+
+    bool ppuCatchUp() const
+    {
+        return m_ppuCatchUp;
+    }
+
     void resetVolatileStateAfterLoad()
     {
         m_resetRequest = false;
@@ -1313,6 +1380,7 @@ public:
         }
     }
 
+    template<OpcodeDispatch dispatch>
     void emulateOpcode();
 
     template<bool IsDmaCycle>
@@ -1384,6 +1452,7 @@ public:
         m_resetRequest = true;
     }
     
+    template<OpcodeDispatch dispatch = DEFAULT_OPCODE_DISPATCH>
     GERANES_INLINE_HOT int run() {
 
         m_runCount = 0;
@@ -1413,7 +1482,7 @@ public:
             m_opcode = readMemory(m_pc++);                       
             m_poolIntsAtCycle = OPCODE_INT_POOL_CYCLE_TABLE[m_opcode];
             fetchOperand();
-            emulateOpcode();           
+            emulateOpcode<dispatch>();
         }
 
         return m_runCount;
@@ -1430,33 +1499,16 @@ public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_pc);
-        SERIALIZEDATA(s, m_sp);
-        SERIALIZEDATA(s, m_status);
-        SERIALIZEDATA(s, m_a);
-        SERIALIZEDATA(s, m_x);
-        SERIALIZEDATA(s, m_y);
-        SERIALIZEDATA(s, m_cyclesCounter);
-        SERIALIZEDATA(s, m_opcode);
-        SERIALIZEDATA(s, m_addr);
-        SERIALIZEDATA(s, m_addrHigh);
-        SERIALIZEDATA(s, m_addrPageCross);
-        SERIALIZEDATA(s, m_nmiSignal);
-        SERIALIZEDATA(s, m_nmiStep);
-        SERIALIZEDATA(s, m_irqSignal);
-        SERIALIZEDATA(s, m_irqStep);
-        SERIALIZEDATA(s, m_currentInstructionCycle);
-        SERIALIZEDATA(s, m_interrupt);
-        SERIALIZEDATA(s, m_poolIntsAtCycle);
-        SERIALIZEDATA(s, m_runCount);
-        SERIALIZEDATA(s, m_writeCycle);
-        SERIALIZEDATA(s, m_lastReadHadDma);
-        SERIALIZEDATA(s, m_indexedDummyReadHadDma);
-        SERIALIZEDATA(s, m_ppuTimingRegion);
-        SERIALIZEDATA(s, m_ppuLateCycleRemainder);
+        s.block(static_cast<CPU2A03State&>(*this));
         m_dma.serialization(s);
     }
 
+    void copyStateFrom(const CPU2A03& source)
+    {
+        static_cast<CPU2A03State&>(*this) = source;
+        m_dma.copyStateFrom(source.m_dma);
+    }
+
     unsigned int cycleCounter() const {
         return m_cyclesCounter;
     }
@@ -1522,6 +1574,7 @@ GERANES_INLINE_HOT void CPU2A03::beginCycle() {
     //CPU   --1-------2---1-------2---1-------2---1---...
 
     if(!m_console.ppu().inOverclockLines()){
+        GERANES_PROFILE_SAMPLED_SCOPE(Apu);
         m_console.apu().processDmcControlDelays();
         m_console.apu().cycle();                           
     }
@@ -1533,17 +1586,33 @@ inline void CPU2A03::endCycle(uint16_t addr, bool write) {
 
     phi1();
 
-    m_console.ppu().ppuCycle();      
+    bool nmiState;
+    if(m_ppuCatchUp) {
+        deferPpuCycles(2);
+        nmiState = m_pendingPpuCycles > 0
+            ? m_console.ppu().getDeferredInterruptFlag()
+            : m_console.ppu().getInterruptFlag();
+    }
+    else {
+        m_console.ppu().ppuCycle();      
+
+        m_console.ppu().ppuCycle();
 
-    m_console.ppu().ppuCycle();
+        nmiState = m_console.ppu().getInterruptFlag();
+    }
 
     phi2<IsDmaCycle == DmaCycle::Yes>(
-        m_console.ppu().getInterruptFlag(),
+        nmiState,
         m_console.apu().getInterruptFlag() || m_console.cartridge().getInterruptFlag()
     );    
 
     const bool getToPutTransition = isOddCycle();
     if constexpr(BusAccessed == BusAccess::Yes) {
+        // Addresses matching $2007's decode arm deferred PPU I/O and must see this
+        // cycle's dots first.
+        if(m_ppuCatchUp && (addr & 0x2007) == 0x2007) {
+            syncPpu();
+        }
         m_bus.onCpuBusAccessEnd(addr, write);
     }
 
@@ -1552,10 +1621,14 @@ inline void CPU2A03::endCycle(uint16_t addr, bool write) {
     }
 
     if(!m_console.ppu().inOverclockLines()) {       
+        GERANES_PROFILE_SAMPLED_SCOPE(MapperHooks);
         m_console.cartridge().cycle();
-        m_console.apu().processExpansionAudioSample(
-            m_console.cartridge().getExpansionAudioSample() * m_console.cartridge().getExpansionOutputGain(),
-            m_console.cartridge().getMixWeight());
+        // Without expansion audio the channel only ever receives silence with zero weight.
+        if(m_console.cartridge().hasExpansionAudio()) {
+            m_console.apu().processExpansionAudioSample(
+                m_console.cartridge().getExpansionAudioSample() * m_console.cartridge().getExpansionOutputGain(),
+                m_console.cartridge().getMixWeight());
+        }
     }       
 
     stepLatePpuCycles();
@@ -1588,8 +1661,272 @@ inline constexpr std::array<OpFunc, 256> OPCODE_TABLE = {
 /*0xF0*/ &CPU2A03::BEQ,     &CPU2A03::SBC,     &CPU2A03::U_HLT,  &CPU2A03::U_ISB,  &CPU2A03::U_DOP,  &CPU2A03::SBC,     &CPU2A03::INC,     &CPU2A03::U_ISB,  &CPU2A03::SED,     &CPU2A03::SBC,     &CPU2A03::NOP,         &CPU2A03::U_ISB,  &CPU2A03::U_DOP,  &CPU2A03::SBC,     &CPU2A03::INC,     &CPU2A03::U_ISB,
 };
 
+template<OpcodeDispatch dispatch>
 GERANES_INLINE_HOT void CPU2A03::emulateOpcode() {
-    (this->*OPCODE_TABLE[m_opcode])();
+    if constexpr(dispatch == OpcodeDispatch::Table) {
+        (this->*OPCODE_TABLE[m_opcode])();
+    }
+    else {
+        // Same mapping as OPCODE_TABLE, as direct calls the compiler can inline.
+        switch(m_opcode) {
+            case 0x00: BRK(); break;
+            case 0x01: ORA(); break;
+            case 0x02: U_HLT(); break;
+            case 0x03: U_SLO(); break;
+            case 0x04: U_DOP(); break;
+            case 0x05: ORA(); break;
+            case 0x06: ASL(); break;
+            case 0x07: U_SLO(); break;
+            case 0x08: PHP(); break;
+            case 0x09: ORA(); break;
+            case 0x0A: ASL_implied(); break;
+            case 0x0B: AAC(); break;
+            case 0x0C: U_DOP(); break;
+            case 0x0D: ORA(); break;
+            case 0x0E: ASL(); break;
+            case 0x0F: U_SLO(); break;
+            case 0x10: BPL(); break;
+            case 0x11: ORA(); break;
+            case 0x12: U_HLT(); break;
+            case 0x13: U_SLO(); break;
+            case 0x14: U_DOP(); break;
+            case 0x15: ORA(); break;
+            case 0x16: ASL(); break;
+            case 0x17: U_SLO(); break;
+            case 0x18: CLC(); break;
+            case 0x19: ORA(); break;
+            case 0x1A: NOP(); break;
+            case 0x1B: U_SLO(); break;
+            case 0x1C: U_DOP(); break;
+            case 0x1D: ORA(); break;
+            case 0x1E: ASL(); break;
+            case 0x1F: U_SLO(); break;
+            case 0x20: JSR(); break;
+            case 0x21: AND(); break;
+            case 0x22: U_HLT(); break;
+            case 0x23: U_RLA(); break;
+            case 0x24: BIT(); break;
+            case 0x25: AND(); break;
+            case 0x26: ROL(); break;
+            case 0x27: U_RLA(); break;
+            case 0x28: PLP(); break;
+            case 0x29: AND(); break;
+            case 0x2A: ROL_implied(); break;
+            case 0x2B: AAC(); break;
+            case 0x2C: BIT(); break;
+            case 0x2D: AND(); break;
+            case 0x2E: ROL(); break;
+            case 0x2F: U_RLA(); break;
+            case 0x30: BMI(); break;
+            case 0x31: AND(); break;
+            case 0x32: NOP(); break;
+            case 0x33: U_RLA(); break;
+            case 0x34: U_DOP(); break;
+            case 0x35: AND(); break;
+            case 0x36: ROL(); break;
+            case 0x37: U_RLA(); break;
+            case 0x38: SEC(); break;
+            case 0x39: AND(); break;
+            case 0x3A: NOP(); break;
+            case 0x3B: U_RLA(); break;
+            case 0x3C: U_DOP(); break;
+            case 0x3D: AND(); break;
+            case 0x3E: ROL(); break;
+            case 0x3F: U_RLA(); break;
+            case 0x40: RTI(); break;
+            case 0x41: EOR(); break;
+            case 0x42: U_HLT(); break;
+            case 0x43: U_SRE(); break;
+            case 0x44: U_DOP(); break;
+            case 0x45: EOR(); break;
+            case 0x46: LSR(); break;
+            case 0x47: U_SRE(); break;
+            case 0x48: PHA(); break;
+            case 0x49: EOR(); break;
+            case 0x4A: LSR_implied(); break;
+            case 0x4B: U_ASR(); break;
+            case 0x4C: JMP(); break;
+            case 0x4D: EOR(); break;
+            case 0x4E: LSR(); break;
+            case 0x4F: U_SRE(); break;
+            case 0x50: BVC(); break;
+            case 0x51: EOR(); break;
+            case 0x52: U_HLT(); break;
+            case 0x53: U_SRE(); break;
+            case 0x54: U_DOP(); break;
+            case 0x55: EOR(); break;
+            case 0x56: LSR(); break;
+            case 0x57: U_SRE(); break;
+            case 0x58: CLI(); break;
+            case 0x59: EOR(); break;
+            case 0x5A: NOP(); break;
+            case 0x5B: U_SRE(); break;
+            case 0x5C: U_DOP(); break;
+            case 0x5D: EOR(); break;
+            case 0x5E: LSR(); break;
+            case 0x5F: U_SRE(); break;
+            case 0x60: RTS(); break;
+            case 0x61: ADC(); break;
+            case 0x62: U_HLT(); break;
+            case 0x63: U_RRA(); break;
+            case 0x64: U_DOP(); break;
+            case 0x65: ADC(); break;
+            case 0x66: ROR(); break;
+            case 0x67: U_RRA(); break;
+            case 0x68: PLA(); break;
+            case 0x69: ADC(); break;
+            case 0x6A: ROR_implied(); break;
+            case 0x6B: U_ARR(); break;
+            case 0x6C: JMP(); break;
+            case 0x6D: ADC(); break;
+            case 0x6E: ROR(); break;
+            case 0x6F: U_RRA(); break;
+            case 0x70: BVS(); break;
+            case 0x71: ADC(); break;
+            case 0x72: U_HLT(); break;
+            case 0x73: U_RRA(); break;
+            case 0x74: U_DOP(); break;
+            case 0x75: ADC(); break;
+            case 0x76: ROR(); break;
+            case 0x77: U_RRA(); break;
+            case 0x78: SEI(); break;
+            case 0x79: ADC(); break;
+            case 0x7A: NOP(); break;
+            case 0x7B: U_RRA(); break;
+            case 0x7C: U_DOP(); break;
+            case 0x7D: ADC(); break;
+            case 0x7E: ROR(); break;
+            case 0x7F: U_RRA(); break;
+            case 0x80: U_DOP(); break;
+            case 0x81: STA(); break;
+            case 0x82: U_DOP(); break;
+            case 0x83: U_SAX(); break;
+            case 0x84: STY(); break;
+            case 0x85: STA(); break;
+            case 0x86: STX(); break;
+            case 0x87: U_SAX(); break;
+            case 0x88: DEY(); break;
+            case 0x89: U_DOP(); break;
+            case 0x8A: TXA(); break;
+            case 0x8B: U_ANE(); break;
+            case 0x8C: STY(); break;
+            case 0x8D: STA(); break;
+            case 0x8E: STX(); break;
+            case 0x8F: U_SAX(); break;
+            case 0x90: BCC(); break;
+            case 0x91: STA(); break;
+            case 0x92: U_HLT(); break;
+            case 0x93: U_AXA(); break;
+            case 0x94: STY(); break;
+            case 0x95: STA(); break;
+            case 0x96: STX(); break;
+            case 0x97: U_SAX(); break;
+            case 0x98: TYA(); break;
+            case 0x99: STA(); break;
+            case 0x9A: TXS(); break;
+            case 0x9B: U_TAS(); break;
+            case 0x9C: U_SYA(); break;
+            case 0x9D: STA(); break;
+            case 0x9E: U_SXA(); break;
+            case 0x9F: U_AXA(); break;
+            case 0xA0: LDY(); break;
+            case 0xA1: LDA(); break;
+            case 0xA2: LDX(); break;
+            case 0xA3: U_LAX(); break;
+            case 0xA4: LDY(); break;
+            case 0xA5: LDA(); break;
+            case 0xA6: LDX(); break;
+            case 0xA7: U_LAX(); break;
+            case 0xA8: TAY(); break;
+            case 0xA9: LDA(); break;
+            case 0xAA: TAX(); break;
+            case 0xAB: U_ATX(); break;
+            case 0xAC: LDY(); break;
+            case 0xAD: LDA(); break;
+            case 0xAE: LDX(); break;
+            case 0xAF: U_LAX(); break;
+            case 0xB0: BCS(); break;
+            case 0xB1: LDA(); break;
+            case 0xB2: U_HLT(); break;
+            case 0xB3: U_LAX(); break;
+            case 0xB4: LDY(); break;
+            case 0xB5: LDA(); break;
+            case 0xB6: LDX(); break;
+            case 0xB7: U_LAX(); break;
+            case 0xB8: CLV(); break;
+            case 0xB9: LDA(); break;
+            case 0xBA: TSX(); break;
+            case 0xBB: U_LAS(); break;
+            case 0xBC: LDY(); break;
+            case 0xBD: LDA(); break;
+            case 0xBE: LDX(); break;
+            case 0xBF: U_LAX(); break;
+            case 0xC0: CPY(); break;
+            case 0xC1: CMP(); break;
+            case 0xC2: U_DOP(); break;
+            case 0xC3: U_DCP(); break;
+            case 0xC4: CPY(); break;
+            case 0xC5: CMP(); break;
+            case 0xC6: DEC(); break;
+            case 0xC7: U_DCP(); break;
+            case 0xC8: INY(); break;
+            case 0xC9: CMP(); break;
+            case 0xCA: DEX(); break;
+            case 0xCB: U_AXS(); break;
+            case 0xCC: CPY(); break;
+            case 0xCD: CMP(); break;
+            case 0xCE: DEC(); break;
+            case 0xCF: U_DCP(); break;
+            case 0xD0: BNE(); break;
+            case 0xD1: CMP(); break;
+            case 0xD2: U_HLT(); break;
+            case 0xD3: U_DCP(); break;
+            case 0xD4: U_DOP(); break;
+            case 0xD5: CMP(); break;
+            case 0xD6: DEC(); break;
+            case 0xD7: U_DCP(); break;
+            case 0xD8: CLD(); break;
+            case 0xD9: CMP(); break;
+            case 0xDA: NOP(); break;
+            case 0xDB: U_DCP(); break;
+            case 0xDC: U_DOP(); break;
+            case 0xDD: CMP(); break;
+            case 0xDE: DEC(); break;
+            case 0xDF: U_DCP(); break;
+            case 0xE0: CPX(); break;
+            case 0xE1: SBC(); break;
+            case 0xE2: U_DOP(); break;
+            case 0xE3: U_ISB(); break;
+            case 0xE4: CPX(); break;
+            case 0xE5: SBC(); break;
+            case 0xE6: INC(); break;
+            case 0xE7: U_ISB(); break;
+            case 0xE8: INX(); break;
+            case 0xE9: SBC(); break;
+            case 0xEA: NOP(); break;
+            case 0xEB: SBC(); break;
+            case 0xEC: CPX(); break;
+            case 0xED: SBC(); break;
+            case 0xEE: INC(); break;
+            case 0xEF: U_ISB(); break;
+            case 0xF0: BEQ(); break;
+            case 0xF1: SBC(); break;
+            case 0xF2: U_HLT(); break;
+            case 0xF3: U_ISB(); break;
+            case 0xF4: U_DOP(); break;
+            case 0xF5: SBC(); break;
+            case 0xF6: INC(); break;
+            case 0xF7: U_ISB(); break;
+            case 0xF8: SED(); break;
+            case 0xF9: SBC(); break;
+            case 0xFA: NOP(); break;
+            case 0xFB: U_ISB(); break;
+            case 0xFC: U_DOP(); break;
+            case 0xFD: SBC(); break;
+            case 0xFE: INC(); break;
+            case 0xFF: U_ISB(); break;
+        }
+    }
 }
 
 #include "DMA.inl"
@@ -381,7 +381,8 @@ private:
     static float fastGetExpansionOutputGain(BaseMapper* mapper) { return static_cast<MapperT*>(mapper)->MapperT::getExpansionOutputGain(); }
 
     BaseMapper* m_mapper;
-    ICartridgeData* m_nesCartridgeData;
+    // Immutable once openRom() returns, so forks share it along with m_romFile.
+    std::shared_ptr<ICartridgeData> m_nesCartridgeData;
     DummyMapper m_dummyMapper;
     MapperWritePrgFn m_writePrgFn;
     MapperReadPrgFn m_readPrgFn;
@@ -416,14 +417,21 @@ private:
     MapperGetExpansionOutputGainFn m_getExpansionOutputGainFn;
     uint32_t m_mapperHookCaps;
 
+    // Last A12 level forwarded to the mapper, -1 when unknown.
+    int8_t m_a12Level = -1;
+
     bool m_isValid;
 
-    RomFile m_romFile;
+    std::shared_ptr<RomFile> m_romFile = std::make_shared<RomFile>();
+
+    // False on forks: the .sram file belongs to the emulator that opened the ROM.
+    bool m_persistSaveRam = true;
 
     template<typename MapperT>
     void assignMapperDispatch()
     {
-        m_mapperHookCaps = MapperT::kMapperHookCaps;
+        m_mapperHookCaps = MapperT::kMapperHookCaps | detectCpuCycleHookCaps<MapperT>();
+        m_a12Level = -1;
         m_writePrgFn = &fastWritePrg<MapperT>;
         m_readPrgFn = &fastReadPrg<MapperT>;
         m_writeSaveRamFn = &fastWriteSaveRam<MapperT>;
@@ -471,7 +479,12 @@ private:
     BaseMapper* createMapperAndBind(ICartridgeData& cd)
     {
         assignMapperDispatch<MapperT>();
-        return BaseMapper::create<MapperT>(cd);
+        MapperT* mapper = BaseMapper::create<MapperT>(cd, m_persistSaveRam);
+        if constexpr(!std::is_same_v<MapperT, typename MapperT::ReadPageOwner>) {
+            // Inherited page updates may not match a subclass's banking.
+            mapper->setReadPagesEnabled(false);
+        }
+        return mapper;
     }
 
     void configureMapperDispatch()
@@ -774,57 +787,55 @@ public:
     {
         m_isValid = false;
         m_mapper = &m_dummyMapper;
-        m_nesCartridgeData = NULL;
         assignDefaultMapperDispatch();
     }
 
     ~Cartridge()
     {
         if(m_mapper != &m_dummyMapper) delete m_mapper;
-        if(m_nesCartridgeData != NULL) delete m_nesCartridgeData;
     }
 
     void closeRom()
     {
         if(m_mapper != &m_dummyMapper) delete m_mapper;
-        if(m_nesCartridgeData != NULL) delete m_nesCartridgeData;
-
-        m_romFile = RomFile();
 
         m_mapper = &m_dummyMapper;
-        m_nesCartridgeData = NULL;
+        m_nesCartridgeData.reset();
+        m_romFile = std::make_shared<RomFile>();
         assignDefaultMapperDispatch();
 
         m_isValid = false;        
+        m_persistSaveRam = true;
     }
 
     bool openRom(const std::string& filename)
     {
         closeRom();
 
-        m_romFile.open(filename);
-        const std::string sourceName = m_romFile.fileName().empty() ? fs::path(filename).filename().string() : m_romFile.fileName();
+        m_romFile->open(filename);
+        const std::string sourceName = m_romFile->fileName().empty() ? fs::path(filename).filename().string() : m_romFile->fileName();
         const std::string sourceExtension = fs::path(sourceName).extension().string();
 
-        if(m_romFile.error() != "") {            
-            Logger::instance().log(std::string("Error processing file '") + filename + "': " + m_romFile.error(), Logger::Type::ERROR);
+        if(m_romFile->error() != "") {            
+            Logger::instance().log(std::string("Error processing file '") + filename + "': " + m_romFile->error(), Logger::Type::ERROR);
             closeRom();
             return false;
         }
 
         // Try iNES first, then FDS, then NSF.
-        _INesFormat* iNes = new _INesFormat(m_romFile);
+        ICartridgeData* data = nullptr;
+        _INesFormat* iNes = new _INesFormat(*m_romFile);
         if(iNes->valid()) {
-            m_nesCartridgeData = iNes;
+            data = iNes;
         }
         else {
             const bool iNesSizeMismatch = (iNes->error() == "file length does not match header information");
             delete iNes;
             iNes = nullptr;
 
-            _FdsFormat* fds = new _FdsFormat(m_romFile);
+            _FdsFormat* fds = new _FdsFormat(*m_romFile);
             if(fds->valid()) {
-                m_nesCartridgeData = fds;
+                data = fds;
             }
             else {
                 const std::string fdsError = fds->error();
@@ -841,9 +852,9 @@ public:
                 }
 
 #ifdef ENABLE_NSF_PLAYER
-                _NsfFormat* nsf = new _NsfFormat(m_romFile);
+                _NsfFormat* nsf = new _NsfFormat(*m_romFile);
                 if(nsf->valid()) {
-                    m_nesCartridgeData = nsf;
+                    data = nsf;
                 }
                 else {
                     const std::string nsfError = nsf->error();
@@ -877,19 +888,19 @@ public:
             }
         }
 
-        uint32_t prgCrc = m_nesCartridgeData->prgCrc32();
-        uint32_t prgChrCrc = m_nesCartridgeData->prgChrCrc32();
+        uint32_t prgCrc = data->prgCrc32();
+        uint32_t prgChrCrc = data->prgChrCrc32();
 
         std::string prgCrcStr = Crc32::toString(prgCrc);
         std::string prgChrCrcStr = Crc32::toString(prgChrCrc);
 
-        const auto* iNesData = dynamic_cast<_INesFormat*>(m_nesCartridgeData);
+        const auto* iNesData = dynamic_cast<_INesFormat*>(data);
         const bool skipDatabaseHeaderOverwrite =
             (iNesData != nullptr && iNesData->isNes20()) ||
 #ifdef ENABLE_NSF_PLAYER
-            dynamic_cast<_NsfFormat*>(m_nesCartridgeData) != nullptr ||
+            dynamic_cast<_NsfFormat*>(data) != nullptr ||
 #endif
-            dynamic_cast<_FdsFormat*>(m_nesCartridgeData) != nullptr;
+            dynamic_cast<_FdsFormat*>(data) != nullptr;
 
         // NSF/FDS are not iNES cartridge dumps, and NES 2.0 headers already provide
         // explicit mapper/submapper/RAM metadata that we prefer over DB overrides.
@@ -898,8 +909,8 @@ public:
 
             if(item != nullptr) {
                 Logger::instance().log("ROM found in database\nUsing DB header", Logger::Type::INFO);
-                m_nesCartridgeData = new DbOverwriteCartridgeData(m_nesCartridgeData, item);
-                m_nesCartridgeData->log("(DB)");
+                data = new DbOverwriteCartridgeData(data, item);
+                data->log("(DB)");
             }
             else {
                 Logger::instance().log("ROM not found in database\nUsing default header", Logger::Type::INFO);
@@ -909,7 +920,7 @@ public:
             if(iNesData != nullptr && iNesData->isNes20()) {
                 Logger::instance().log("NES 2.0 ROM detected\nUsing file header directly", Logger::Type::INFO);
             }
-            else if(dynamic_cast<_FdsFormat*>(m_nesCartridgeData) != nullptr) {
+            else if(dynamic_cast<_FdsFormat*>(data) != nullptr) {
                 Logger::instance().log("FDS file detected\nUsing FDS mapper", Logger::Type::INFO);
             }
 #ifdef ENABLE_NSF_PLAYER
@@ -919,6 +930,8 @@ public:
 #endif
         }
 
+        m_nesCartridgeData.reset(data);
+
         m_mapper = CreateMapper();
 
         if(m_mapper == &m_dummyMapper)
@@ -942,11 +955,42 @@ public:
         return true;
     }
 
+    // Binds a fresh mapper to the ROM already parsed by source. The mapper state is
+    // power-on; the caller copies the live state afterwards.
+    bool shareRom(const Cartridge& source)
+    {
+        closeRom();
+
+        if(!source.m_isValid) return false;
+
+        m_romFile = source.m_romFile;
+        m_nesCartridgeData = source.m_nesCartridgeData;
+        m_persistSaveRam = false;
+
+        m_mapper = CreateMapper();
+
+        if(m_mapper == &m_dummyMapper) {
+            closeRom();
+            return false;
+        }
+
+        m_isValid = true;
+
+        return true;
+    }
+
+    bool sharesRomWith(const Cartridge& other) const
+    {
+        return m_isValid && other.m_isValid && m_nesCartridgeData == other.m_nesCartridgeData;
+    }
+
     void reset()
     {
         if(m_mapper != nullptr) {
             m_mapper->reset();
+            m_mapper->refreshReadPages();
         }
+        m_a12Level = -1;
     }
 
     static std::vector<std::string> listFiles(const fs::path& directory) {
@@ -980,6 +1024,9 @@ public:
 
     GERANES_INLINE uint8_t readPrg(int addr)
     {
+        if(const uint8_t* page = m_mapper->cpuReadPage(0x08 | (addr >> 12))) {
+            return page[addr & 0x0FFF];
+        }
         return m_readPrgFn(m_mapper, addr);
     }
 
@@ -990,6 +1037,9 @@ public:
 
     GERANES_INLINE uint8_t readSaveRam(int addr)
     {
+        if(const uint8_t* page = m_mapper->cpuReadPage(0x06 | (addr >> 12))) {
+            return page[addr & 0x0FFF];
+        }
         return m_readSaveRamFn(m_mapper, addr);
     }
 
@@ -1000,6 +1050,9 @@ public:
 
     GERANES_INLINE uint8_t readChr(int addr)
     {
+        if(const uint8_t* page = m_mapper->chrReadPage((addr >> 10) & 0x07)) {
+            return page[addr & 0x03FF];
+        }
         return m_readChrFn(m_mapper, addr);
     }
 
@@ -1035,6 +1088,10 @@ public:
         static const uint8_t VERTICAL_MIRROR[] = {0,1,0,1};
         static const uint8_t FOUR_SCREEN_MIRROR[] = {0,1,2,3};
 
+        if(const int page = m_mapper->nameTablePage(blockIndex); page >= 0) {
+            return static_cast<uint8_t>(page);
+        }
+
         switch(m_mirroringTypeFn(m_mapper)){
 
             case MirroringType::HORIZONTAL:
@@ -1054,6 +1111,9 @@ public:
 
     GERANES_INLINE bool getInterruptFlag()
     {
+        if(!hasMapperHookCap(BaseMapper::HookCap_InterruptFlag)) {
+            return false;
+        }
         return m_getInterruptFlagFn(m_mapper);
     }
 
@@ -1062,14 +1122,38 @@ public:
         if(!hasMapperHookCap(BaseMapper::HookCap_SetA12State)) {
             return;
         }
+        // A12 watchers only act on edges; drop the repeats the PPU reports on every
+        // bus address change.
+        if(m_a12Level == static_cast<int8_t>(state)) {
+            return;
+        }
+        m_a12Level = static_cast<int8_t>(state);
         m_setA12StateFn(m_mapper, state);
     }
 
     GERANES_INLINE void cycle()
     {    
+        if(!hasMapperHookCap(BaseMapper::HookCap_Cycle)) {
+            return;
+        }
         m_cycleFn(m_mapper);
     }    
 
+    GERANES_INLINE bool hasExpansionAudio() const
+    {
+        return hasMapperHookCap(BaseMapper::HookCap_ExpansionAudio);
+    }
+
+    GERANES_INLINE bool hasPpuDotHooks() const
+    {
+        return hasMapperHookCap(BaseMapper::kPpuDotHookCaps);
+    }
+
+    GERANES_INLINE bool allowsPpuCatchUp() const
+    {
+        return !hasMapperHookCap(BaseMapper::kPpuCatchUpBlockingCaps);
+    }
+
     GERANES_INLINE_HOT bool useCustomNameTable(uint8_t index)
     {
         if(!hasMapperHookCap(BaseMapper::HookCap_UseCustomNameTable)) {
@@ -1090,6 +1174,9 @@ public:
 
     GERANES_INLINE void onScanlineStart(bool renderingEnabled, int scanline)
     {
+        if(!hasMapperHookCap(BaseMapper::HookCap_OnScanlineStart)) {
+            return;
+        }
         m_onScanlineStartFn(m_mapper, renderingEnabled, scanline);
     }
 
@@ -1137,6 +1224,9 @@ public:
         if(!hasMapperHookCap(BaseMapper::HookCap_OnPpuCycle)) {
             return;
         }
+        if(hasMapperHookCap(BaseMapper::HookCap_PpuCycleTileEdges) && (cycle & 0x07) != 0) {
+            return;
+        }
         m_onPpuCycleFn(m_mapper, scanline, cycle, isRendering, isPreLine);
     }
 
@@ -1293,13 +1383,33 @@ public:
         return m_mapper->saveRamSize();
     }
 
+    void setDirtyEpoch(uint32_t epoch)
+    {
+        m_mapper->setDirtyEpoch(epoch);
+    }
+
+    void markAllPagesDirty()
+    {
+        m_mapper->markAllPagesDirty();
+    }
+
+    const DirtyPages& saveRamPages() const
+    {
+        return m_mapper->saveRamPages();
+    }
+
+    const DirtyPages& chrRamPages() const
+    {
+        return m_mapper->chrRamPages();
+    }
+
     GERANES_INLINE bool hasBatterySaveRam() const
     {
         return m_mapper->hasBatterySaveRam();
     }
 
     GERANES_INLINE const RomFile& romFile() {
-        return m_romFile;
+        return *m_romFile;
     }
 
     GERANES_INLINE bool isNsf() const
@@ -1427,6 +1537,10 @@ public:
     {
         SERIALIZEDATA(s, m_isValid);
         m_mapper->serialization(s);
+        if(s.isReading()) {
+            m_mapper->refreshReadPages();
+            m_a12Level = -1;
+        }
     }
 
 };
@@ -9,18 +9,20 @@
 
 namespace GeraNES {
 
-class DMA
+// Persisted DMA state, saved as one block (see SerializationBase::block).
+struct DMAState
 {
-private:
-    Ibus& m_bus;
-    Console& m_console;
+    static constexpr uint32_t LAYOUT_VERSION = 1;
+
+    uint16_t m_oamDmaCounter = 0;
+    uint16_t m_dmcDmaAddr = 0;
+    uint16_t m_dmaPrevReadAddr = 0;
 
     bool m_dmaNeedHalt = false;
     bool m_dmaNeedDummyRead = false;
 
     bool m_oamDmaTransfer = false;
     uint8_t m_oamDmaPage = 0;
-    uint16_t m_oamDmaCounter = 0;
     uint8_t m_oamDmaReadAddr = 0;
     uint8_t m_oamDmaData = 0;
 
@@ -30,11 +32,16 @@ private:
     uint8_t m_dmcSingleCycleAbortDelay = 0;
     bool m_dmcInitialLoadPhasePending = false;
     bool m_dmcLastRequestWasReload = false;
-    uint16_t m_dmcDmaAddr = 0;
-    uint16_t m_dmaPrevReadAddr = 0;
 
     bool m_dmaReadInProgress = false;
     uint8_t m_dmaReadInputClockMask = 0;
+};
+
+class DMA : private DMAState
+{
+private:
+    Ibus& m_bus;
+    Console& m_console;
 
     GERANES_INLINE uint8_t inputClockMaskForAddr(uint16_t addr) const
     {
@@ -209,23 +216,12 @@ public:
 
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_dmaNeedHalt);
-        SERIALIZEDATA(s, m_dmaNeedDummyRead);
-        SERIALIZEDATA(s, m_oamDmaTransfer);
-        SERIALIZEDATA(s, m_oamDmaPage);
-        SERIALIZEDATA(s, m_oamDmaCounter);
-        SERIALIZEDATA(s, m_oamDmaReadAddr);
-        SERIALIZEDATA(s, m_oamDmaData);
-        SERIALIZEDATA(s, m_dmcDmaRunning);
-        SERIALIZEDATA(s, m_dmcAbortPending);
-        SERIALIZEDATA(s, m_dmcSingleCycleAbortPending);
-        SERIALIZEDATA(s, m_dmcSingleCycleAbortDelay);
-        SERIALIZEDATA(s, m_dmcInitialLoadPhasePending);
-        SERIALIZEDATA(s, m_dmcLastRequestWasReload);
-        SERIALIZEDATA(s, m_dmcDmaAddr);
-        SERIALIZEDATA(s, m_dmaPrevReadAddr);
-        SERIALIZEDATA(s, m_dmaReadInProgress);
-        SERIALIZEDATA(s, m_dmaReadInputClockMask);
+        s.block(static_cast<DMAState&>(*this));
+    }
+
+    void copyStateFrom(const DMA& source)
+    {
+        static_cast<DMAState&>(*this) = source;
     }
 
     void resetVolatileStateAfterLoad()
@@ -31,6 +31,7 @@
 #include "HardwareActions.h"
 #include "NsfPlayer.h"
 #include "InputFrame.h"
+#include "Profiler.h"
 
 #include "Serialization.h"
 #include "util/Crc32.h"
@@ -39,6 +40,8 @@
 #include "logger/logger.h"
 
 #include "Rewind.h"
+#include "StateHashTree.h"
+#include "StateLayout.h"
 
 #include <filesystem>
 #include <array>
@@ -55,6 +58,14 @@ enum class AccessType
     Write
 };
 
+// Selects the emulation tick/bus instantiation. Off compiles out debugger
+// breakpoints, the PPU event trace and external CPU bus handlers.
+enum class Instrumentation
+{
+    Off,
+    On
+};
+
 class GeraNESEmu : public Ibus, public SigSlot::SigSlotBase, public IRewindable
 {
 public:
@@ -140,6 +151,9 @@ private:
     PPU m_ppu;
     APU m_apu;
     uint8_t m_ram[0x800]; //2K
+    DirtyPages m_ramPages{0x800};
+    uint32_t m_dirtyEpoch = 1;
+    StateHashTree m_stateHashTree;
     std::unique_ptr<IControllerPortDevice> m_portDevice1;
     std::unique_ptr<IControllerPortDevice> m_portDevice2;
     std::unique_ptr<IExpansionDevice> m_expansionDevice;
@@ -183,6 +197,9 @@ private:
     bool m_busInstrumentationEnabled = false;
     std::vector<PpuRegisterAccessEvent> m_ppuRegisterAccessEvents;
     static constexpr size_t MAX_PPU_REGISTER_ACCESS_EVENTS = 4096;
+#if defined(GERANES_CPU_DISPATCH_SELECTABLE)
+    OpcodeDispatch m_opcodeDispatch = DEFAULT_OPCODE_DISPATCH;
+#endif
     std::function<bool(uint16_t, uint8_t)> m_externalCpuWriteHandler;
     std::function<std::optional<uint8_t>(uint16_t)> m_externalCpuReadHandler;
 
@@ -191,6 +208,7 @@ private:
     uint32_t m_ppuViewerMapperWriteGeneration = 0;
     std::vector<PpuViewerScanlineState> m_ppuViewerScanlineStates;
     std::vector<PpuViewerScanlineSnapshot> m_ppuViewerScanlineSnapshots;
+    std::vector<uint8_t> m_copyStateBuffer;
     bool m_saveStateFlag;
     bool m_loadStateFlag;
     uint8_t m_pendingSaveStateSlot = 0;
@@ -198,12 +216,29 @@ private:
     bool m_resetRequested;
 
     bool m_forceSkipAudioRender = false;
+    bool m_profilingSuspended = false; // forks: their frames are not the played ones
     std::optional<uint32_t> m_lastAudiblyRenderedPlaybackFrame;
     bool m_currentPlaybackFrameRenderedAudibly = false;
 
     std::optional<InputFrame> m_currentInputFrame;
     std::optional<InputFrame> m_nextInputFrame; // Transient queued playback/net input; intentionally not serialized.
 
+    // Save state size only moves with the ROM and the input topology, so it is measured
+    // once per combination instead of on every query.
+    struct StateSizeKey
+    {
+        std::optional<Settings::Device> port1;
+        std::optional<Settings::Device> port2;
+        Settings::ExpansionDevice expansion = Settings::ExpansionDevice::NONE;
+        Settings::NesMultitapDevice nesMultitap = Settings::NesMultitapDevice::NONE;
+        Settings::FamicomMultitapDevice famicomMultitap = Settings::FamicomMultitapDevice::NONE;
+
+        bool operator==(const StateSizeKey&) const = default;
+    };
+    StateSizeKey m_stateSizeKey;
+    size_t m_stateSize = 0;
+    size_t m_incrementalStateSizeHint = 0;
+
     Rewind m_rewind;
     NsfPlayer m_nsfPlayer;
 
@@ -228,6 +263,68 @@ private:
         return m_settings.getFamicomMultitapDevice() != Settings::FamicomMultitapDevice::NONE;
     }
 
+    StateSizeKey currentStateSizeKey() const
+    {
+        StateSizeKey key;
+        key.port1 = m_settings.getPortDevice(Settings::Port::P_1);
+        key.port2 = m_settings.getPortDevice(Settings::Port::P_2);
+        key.expansion = m_settings.getExpansionDevice();
+        key.nesMultitap = m_settings.getNesMultitapDevice();
+        key.famicomMultitap = m_settings.getFamicomMultitapDevice();
+        return key;
+    }
+
+    // In-memory states are taken as if between frames, so a state saved mid-loop loads
+    // the same way as one saved by the host.
+    template<typename Fn>
+    void runAsIfBetweenFrames(Fn&& fn)
+    {
+        const bool savedNewFrame = m_newFrame;
+        const bool savedFrameStarted = m_frameStarted;
+        const bool savedRunningLoop = m_runningLoop;
+        const HardwareActions savedHardwareActions = m_hardwareActions;
+        const uint32_t savedUpdateCyclesAcc = m_updateCyclesAcc;
+        const uint32_t savedAudioRenderCyclesAcc = m_audioRenderCyclesAcc;
+
+        m_newFrame = false;
+        m_frameStarted = false;
+        m_runningLoop = false;
+        m_hardwareActions.reset();
+        m_updateCyclesAcc = 0;
+        m_audioRenderCyclesAcc = 0;
+
+        fn();
+
+        m_newFrame = savedNewFrame;
+        m_frameStarted = savedFrameStarted;
+        m_runningLoop = savedRunningLoop;
+        m_hardwareActions = savedHardwareActions;
+        m_updateCyclesAcc = savedUpdateCyclesAcc;
+        m_audioRenderCyclesAcc = savedAudioRenderCyclesAcc;
+    }
+
+    void serializeForMemoryState(SerializationBase& s)
+    {
+        runAsIfBetweenFrames([&]() { serialization(s); });
+    }
+
+    void applyDirtyEpoch()
+    {
+        m_ramPages.setEpoch(m_dirtyEpoch);
+        m_ppu.setDirtyEpoch(m_dirtyEpoch);
+        m_cartridge.setDirtyEpoch(m_dirtyEpoch);
+    }
+
+    // For memory replaced wholesale (reset, ROM load, state load): every incremental state
+    // taken against an earlier base then carries the full regions.
+    void markAllPagesDirty()
+    {
+        applyDirtyEpoch();
+        m_ramPages.markAll();
+        m_ppu.markAllPagesDirty();
+        m_cartridge.markAllPagesDirty();
+    }
+
     bool isAnyMultitapActive() const
     {
         return isNesMultitapActive() || isFamicomMultitapActive();
@@ -393,6 +490,8 @@ private:
 
         if(!m_cartridge.isValid()) return false;        
 
+        GERANES_PROFILE_SUSPEND_IF(m_profilingSuspended);
+
         dt = std::min(dt, (uint32_t)1000/10);  //0.1s
 
         if constexpr(!waitForNewFrame)
@@ -412,30 +511,39 @@ private:
 
         m_runningLoop = true;
 
-        
+        {
+            GERANES_PROFILE_SCOPE(Emulation);
 
-        const bool skipAudioRender = m_forceSkipAudioRender || !renderAudio;
+            const bool skipAudioRender = m_forceSkipAudioRender || !renderAudio;
 
-        while(loop)
-        {
-            bool advanced = false;
-            if constexpr(waitForNewFrame) {
-                advanced = stepEmulationTick<false>(audioRenderCycles, renderedAudioMs, newFrame, skipAudioRender);
-            }
-            else {
-                advanced = stepEmulationTick<true>(audioRenderCycles, renderedAudioMs, newFrame, skipAudioRender);
-            }
-            if(!advanced) break;
+            while(loop)
+            {
+                bool advanced = false;
+                if constexpr(waitForNewFrame) {
+                    advanced = stepEmulationTick<false>(audioRenderCycles, renderedAudioMs, newFrame, skipAudioRender);
+                }
+                else {
+                    advanced = stepEmulationTick<true>(audioRenderCycles, renderedAudioMs, newFrame, skipAudioRender);
+                }
+                if(!advanced) break;
+
+                if(m_paused) {
+                    break;
+                }
+
+                if constexpr(waitForNewFrame)
+                    loop = !newFrame;
+                else
+                    loop = m_updateCyclesAcc >= 1000;
 
-            if(m_paused) {
-                break;
             }
 
-            if constexpr(waitForNewFrame)
-                loop = !newFrame;
-            else
-                loop = m_updateCyclesAcc >= 1000;
+            m_cpu.syncPpu();
+        }
 
+        // After the Emulation scope has closed, so the frame sees this call's time.
+        if(newFrame) {
+            GERANES_PROFILE_END_FRAME();
         }
 
         m_lastAudioRenderedMs = renderedAudioMs;
@@ -766,14 +874,31 @@ private:
             (m_debugBreakpointsArmed && m_debugBreakpointConfig.enabled) ||
             static_cast<bool>(m_externalCpuWriteHandler) ||
             static_cast<bool>(m_externalCpuReadHandler);
+        if(m_busInstrumentationEnabled) {
+            m_cpu.setPpuCatchUp(false);
+        }
     }
 
-    template<AccessType accessType>
+    // PPU catch-up is exact only while nothing outside the CPU bus watches individual
+    // dots. Re-evaluated every frame start; anything that may break the conditions
+    // mid-frame turns it off until then.
+    void refreshPpuCatchUp()
+    {
+        m_cpu.setPpuCatchUp(
+            !m_busInstrumentationEnabled &&
+            !m_ppuViewerScanlineTraceEnabled &&
+            m_settings.overclockLines() == 0 &&
+            !m_ppu.isOverclockFrame() &&
+            m_cartridge.allowsPpuCatchUp()
+        );
+    }
+
+    template<AccessType accessType, Instrumentation instrumentation>
     auto accessBus(int addr, uint8_t data = 0) -> std::conditional_t<accessType == AccessType::Write, void, uint8_t>
     {
         if constexpr(accessType == AccessType::Read) data = m_openBus;
 
-        if(m_busInstrumentationEnabled) {
+        if constexpr(instrumentation == Instrumentation::On) {
             if constexpr(accessType == AccessType::Write) {
                 if(m_externalCpuWriteHandler && m_externalCpuWriteHandler(static_cast<uint16_t>(addr), data)) {
                     return;
@@ -788,12 +913,24 @@ private:
             }
         }
 
+        if(m_cpu.ppuCatchUp()) {
+            // Everything the PPU can observe or be observed through: its registers,
+            // input ports (light guns sample the picture) and the cartridge registers.
+            const bool syncPpu = accessType == AccessType::Write
+                ? addr >= 0x2000
+                : (addr >= 0x2000 && addr < 0x6000);
+            if(syncPpu) m_cpu.syncPpu();
+        }
+
         bool updateOpenBusOnRead = true;
         switch(addr>>12)
         {
         case 0:
         case 1:
-            if constexpr(accessType == AccessType::Write) m_ram[addr&0x7FF] = data;
+            if constexpr(accessType == AccessType::Write) {
+                m_ram[addr&0x7FF] = data;
+                m_ramPages.mark(addr&0x7FF);
+            }
             else data = m_ram[addr&0x7FF];
             break;
         case 2:
@@ -838,7 +975,7 @@ private:
                     if constexpr(accessType == AccessType::Write)
                     {
                         uint16_t addr = static_cast<uint16_t>(data) << 8;
-                        if(m_debugBreakpointConfig.breakOnOamDmaStart) {
+                        if(instrumentation == Instrumentation::On && m_debugBreakpointConfig.breakOnOamDmaStart) {
                             triggerDebugBreakpoint("OAM DMA start", static_cast<uint16_t>(0x4014), data, true, true);
                         }
                         m_cpu.startOamDma(addr);
@@ -1015,7 +1152,7 @@ private:
             ? static_cast<uint16_t>(addr)
             : 0xFFFF;
 
-        if(m_busInstrumentationEnabled) {
+        if constexpr(instrumentation == Instrumentation::On) {
             processDebugBusAccess<accessType>(static_cast<uint16_t>(addr), data);
         }
 
@@ -1041,6 +1178,7 @@ private:
         m_hardwareActions.onFrameStart();
         m_nsfPlayer.onFrameStart();
         updateCyclesPerSecond();        
+        refreshPpuCatchUp();
 
         m_currentInputFrame = m_nextInputFrame;
         m_nextInputFrame.reset();
@@ -1194,6 +1332,7 @@ private:
         m_resetRequested = false;
         m_prevControllerReadAddr = 0xFFFF;
         m_cpu.resetVolatileStateAfterLoad();
+        m_cpu.setPpuCatchUp(false);
         m_prevNsfSelect = false;
         m_prevNsfStart = false;
         m_prevNsfLeft = false;
@@ -1369,11 +1508,24 @@ private:
             m_audioOutput.setRewinding(rewinding);
             m_audioOutputRewinding = rewinding;
         }
+        GERANES_PROFILE_SCOPE(AudioRender);
         m_audioOutput.render(ms);
         return true;
     }
 
     template<bool consumeUpdateBudget>
+    GERANES_INLINE bool stepEmulationTick(uint32_t audioRenderCycles,
+                                          uint32_t& renderedAudioMs,
+                                          bool& frameReady,
+                                          bool renderAudio)
+    {
+        if(m_busInstrumentationEnabled) {
+            return stepEmulationTick<consumeUpdateBudget, Instrumentation::On>(audioRenderCycles, renderedAudioMs, frameReady, renderAudio);
+        }
+        return stepEmulationTick<consumeUpdateBudget, Instrumentation::Off>(audioRenderCycles, renderedAudioMs, frameReady, renderAudio);
+    }
+
+    template<bool consumeUpdateBudget, Instrumentation instrumentation>
     GERANES_INLINE bool stepEmulationTick(uint32_t audioRenderCycles,
                                           uint32_t& renderedAudioMs,
                                           bool& frameReady,
@@ -1394,13 +1546,28 @@ private:
             playbackFrame <= *m_lastAudiblyRenderedPlaybackFrame;
         const bool tickSkipAudioRender =
             renderAudio || playbackFrameAlreadyRenderedAudibly;
-        const bool nmiBefore = m_ppu.nmiLineActive();
-        const bool irqBefore = m_apu.getInterruptFlag() || m_cartridge.getInterruptFlag();
-        const bool sprite0Before = m_ppu.sprite0Hit();
+        bool nmiBefore = false;
+        bool irqBefore = false;
+        bool sprite0Before = false;
+        if constexpr(instrumentation == Instrumentation::On) {
+            nmiBefore = m_ppu.nmiLineActive();
+            irqBefore = m_apu.getInterruptFlag() || m_cartridge.getInterruptFlag();
+            sprite0Before = m_ppu.sprite0Hit();
+        }
         ++m_emulationTickCounter;
 
         if(--m_cpuCyclesAcc == 0) {
+#if defined(GERANES_CPU_DISPATCH_SELECTABLE)
+            m_cpuCyclesAcc = m_opcodeDispatch == OpcodeDispatch::Switch
+                ? m_cpu.run<OpcodeDispatch::Switch>()
+                : m_cpu.run<OpcodeDispatch::Table>();
+#else
             m_cpuCyclesAcc = m_cpu.run();
+#endif
+
+            if(m_frameStarted || m_newFrame) {
+                m_cpu.syncPpu();
+            }
 
             if constexpr(!consumeUpdateBudget) {
                 m_audioRenderCyclesAcc += m_cpuCyclesAcc * 1000;
@@ -1418,7 +1585,10 @@ private:
                     m_lastAudiblyRenderedPlaybackFrame = playbackFrame;
                 }
                 m_currentPlaybackFrameRenderedAudibly = false;
-                m_rewind.newFrame();
+                {
+                    GERANES_PROFILE_SCOPE(RewindCapture);
+                    m_rewind.newFrame();
+                }
                 frameReady = true;
                 m_newFrame = false;
             }
@@ -1453,6 +1623,10 @@ private:
             return false;
         }
 
+        if constexpr(instrumentation == Instrumentation::Off) {
+            return true;
+        }
+
         const bool nmiAfter = m_ppu.nmiLineActive();
         if(!nmiBefore && nmiAfter && m_debugBreakpointConfig.breakOnNmiStart) {
             triggerDebugBreakpoint("PPU NMI start");
@@ -1692,10 +1866,10 @@ public:
         m_hardwareActions.reset();
     }
 
-    //maxTime - seconds
-    void setupRewindSystem(bool enabled, double maxTime, int FPSDivider = 1)
+    //maxMemoryMB - size of the rewind arena
+    void setupRewindSystem(bool enabled, size_t maxMemoryMB, int FPSDivider = 1)
     {
-        m_rewind.setup(enabled, maxTime, FPSDivider);
+        m_rewind.setup(enabled, maxMemoryMB, FPSDivider);
     }
 
     void setRewind(bool state)
@@ -1723,6 +1897,7 @@ public:
 
     void closeRom()
     {
+        m_cpu.setPpuCatchUp(false);
         m_cartridge.closeRom();
         m_ppu.clearFramebuffer();
         m_ppuRegisterAccessEvents.clear();
@@ -1731,6 +1906,8 @@ public:
 
     bool openRom(const std::string& filename, bool autoConfigureInputTopologyOnRomLoad = true)
     {
+        m_stateSize = 0;
+        m_cpu.setPpuCatchUp(false);
         m_audioOutput.clearAudioBuffers();
         m_ppu.clearFramebuffer();
 
@@ -1896,6 +2073,8 @@ public:
             m_cartridge.reset();
             ++m_ppuViewerMapperWriteGeneration;
             preloadNsfMemory();
+            markAllPagesDirty();
+            m_stateHashTree.invalidate();
             m_ppu.init();
             m_cpu.init();
             m_apu.init();
@@ -1909,12 +2088,14 @@ public:
 
     GERANES_HOT uint8_t read(int addr) override
     {
-        return accessBus<AccessType::Read>(addr);
+        if(m_busInstrumentationEnabled) return accessBus<AccessType::Read, Instrumentation::On>(addr);
+        return accessBus<AccessType::Read, Instrumentation::Off>(addr);
     }
 
     GERANES_HOT void write(int addr, uint8_t data) override
     {
-        accessBus<AccessType::Write>(addr,data);
+        if(m_busInstrumentationEnabled) accessBus<AccessType::Write, Instrumentation::On>(addr,data);
+        else accessBus<AccessType::Write, Instrumentation::Off>(addr,data);
     }    
 
     uint8_t debugPeekCpuMemory(uint16_t addr) const
@@ -1952,6 +2133,7 @@ public:
             case 0:
             case 1:
                 m_ram[addr & 0x7FF] = data;
+                m_ramPages.mark(addr & 0x7FF);
                 return;
 
             case 6:
@@ -2015,6 +2197,7 @@ public:
                 steppedInstruction = true;
             }
         }
+        m_cpu.syncPpu();
         m_lastAudioRenderedMs = renderedAudioMs;
         m_runningLoop = false;
 
@@ -2047,6 +2230,40 @@ public:
         return m_ppu.getFramebuffer();
     }
 
+    // Frontends that convert at present time keep the PPU writing 16-bit palette indices
+    // and build their own target-format LUT from buildIndexedColorLut().
+    void setIndexedFramebufferEnabled(bool enabled)
+    {
+        m_ppu.setIndexedFramebufferEnabled(enabled);
+    }
+
+    bool indexedFramebufferEnabled() const
+    {
+        return m_ppu.indexedFramebufferEnabled();
+    }
+
+    GERANES_INLINE const uint16_t* getIndexedFramebuffer() const
+    {
+        return m_ppu.getIndexedFramebuffer();
+    }
+
+    void buildIndexedColorLut(IndexedColorLut& lut) const
+    {
+        m_ppu.buildIndexedColorLut(lut);
+    }
+
+    // Whole-scanline rendering inside PPU catch-up batches. Turning it off keeps the
+    // dot-by-dot renderer, which is what the differential renderer tests compare against.
+    void setScanlineFastPathEnabled(bool enabled)
+    {
+        m_ppu.setScanlineFastPathEnabled(enabled);
+    }
+
+    bool scanlineFastPathEnabled() const
+    {
+        return m_ppu.scanlineFastPathEnabled();
+    }
+
     void _saveState(uint8_t slot = 0)
     {
         if(!m_cartridge.isValid()) return;
@@ -2090,8 +2307,12 @@ public:
             return;
         }
 
-        if(d.loadFromFile(fileName.string())) {
+        const bool loaded = d.loadFromFile(fileName.string());
+        if(loaded) {
             serialization(d);
+        }
+
+        if(loaded && !d.error()) {
             resyncAudioAfterStateLoad();
             resetVolatileStateAfterStateLoad();
             signalLoadExecuted(m_frameCounter);
@@ -2114,12 +2335,20 @@ public:
     }    
 
     void loadStateFromMemory(const std::vector<uint8_t>& data) override
+    {
+        loadStateFromMemory(data.data(), data.size());
+    }
+
+    // Reads in place from caller memory; nothing is copied before deserializing. Returns
+    // false when the state was rejected or cut short, which can leave it partly loaded.
+    bool loadStateFromMemory(const uint8_t* data, size_t size)
     {
         Deserialize d;
-        d.setData(data);
+        d.setData(data, size);
         serialization(d);
         resyncAudioAfterStateLoad();
         resetVolatileStateAfterStateLoad();
+        return !d.error();
     }
 
     bool loadStateFromMemoryOnCleanBoot(const std::vector<uint8_t>& data)
@@ -2130,44 +2359,196 @@ public:
         if(romPath.empty()) return false;
         if(!openRom(romPath) || !valid()) return false;
 
-        loadStateFromMemory(data);
-        return valid();
+        return loadStateFromMemory(data.data(), data.size()) && valid();
     }
 
     std::vector<uint8_t> saveStateToMemory()
     {
-        const bool savedNewFrame = m_newFrame;
-        const bool savedFrameStarted = m_frameStarted;
-        const bool savedRunningLoop = m_runningLoop;
-        const HardwareActions savedHardwareActions = m_hardwareActions;
-        const uint32_t savedUpdateCyclesAcc = m_updateCyclesAcc;
-        const uint32_t savedAudioRenderCyclesAcc = m_audioRenderCyclesAcc;
-
-        m_newFrame = false;
-        m_frameStarted = false;
-        m_runningLoop = false;
-        m_hardwareActions.reset();
-        m_updateCyclesAcc = 0;
-        m_audioRenderCyclesAcc = 0;
-
         Serialize s;
         static thread_local size_t reserveHint = 0;
         if(reserveHint > 0) {
             s.reserve(reserveHint);
         }
-        serialization(s);
+        serializeForMemoryState(s);
         std::vector<uint8_t> data = s.takeData();
         reserveHint = data.size();
+        return data;
+    }
 
-        m_newFrame = savedNewFrame;
-        m_frameStarted = savedFrameStarted;
-        m_runningLoop = savedRunningLoop;
-        m_hardwareActions = savedHardwareActions;
-        m_updateCyclesAcc = savedUpdateCyclesAcc;
-        m_audioRenderCyclesAcc = savedAudioRenderCyclesAcc;
+    // Same bytes as the vector overload, written into the caller's buffer. Returns the
+    // state length, or 0 when it does not fit. stateSize() is always enough room.
+    size_t saveStateToMemory(uint8_t* data, size_t size)
+    {
+        SerializeInto s(data, size);
+        serializeForMemoryState(s);
+        return s.error() ? 0 : s.size();
+    }
+
+    // Starts a new write epoch and returns it. saveIncrementalState(base) then stores CPU RAM,
+    // nametables, save RAM and CHR-RAM only for the 256-byte pages written after this call;
+    // everything else is stored in full. Take the base's full state right before calling it.
+    uint32_t markSnapshotBase()
+    {
+        ++m_dirtyEpoch;
+        applyDirtyEpoch();
+        return m_dirtyEpoch;
+    }
+
+    // Loads with loadStateFromMemory(), but only on top of the base's full state: the pages
+    // left out are whatever the emulator holds when it is loaded.
+    std::vector<uint8_t> saveIncrementalState(uint32_t baseEpoch)
+    {
+        Serialize s;
+        if(m_incrementalStateSizeHint > 0) {
+            s.reserve(m_incrementalStateSizeHint);
+        }
+        s.setIncremental(baseEpoch);
+        serializeForMemoryState(s);
+        std::vector<uint8_t> data = s.takeData();
+        m_incrementalStateSizeHint = data.size();
         return data;
     }
 
+    // Per-component digests of what saveStateToMemory() would store, and their root. Memory
+    // regions are hashed per 256-byte page and only pages written since the previous call
+    // are read again, so this is cheap enough to run every frame.
+    StateDigest stateDigest()
+    {
+        const uint32_t epoch = markSnapshotBase();
+        StateHashTree& h = m_stateHashTree;
+        h.mapRegion(m_ramPages, StateComponent::RAM);
+        h.mapRegion(m_ppu.nameTablePages(), StateComponent::CIRAM);
+        h.mapRegion(m_cartridge.chrRamPages(), StateComponent::CHR_RAM);
+        h.mapRegion(m_cartridge.saveRamPages(), StateComponent::SAVE_RAM);
+        h.begin(epoch);
+
+        serializeForMemoryState(h);
+        return h.finish();
+    }
+
+    // Pages stateDigest() had to read again on its last call.
+    size_t stateDigestRehashedPages() const
+    {
+        return m_stateHashTree.rehashedPages();
+    }
+
+    // Byte counts that split saveStateToMemory() output by component: header and CPU,
+    // mapper, PPU, APU and the input/timing tail, with RAM, nametables, CHR-RAM and save
+    // RAM each in a span of their own. Netplay uses it to resend only what differs.
+    std::vector<uint32_t> stateLayout()
+    {
+        StateLayout l;
+        serializeForMemoryState(l);
+        return l.takeSpans();
+    }
+
+    // Layout for another state of this ROM, such as an older snapshot. Spans only change
+    // with what the state holds (input devices, mapper extras), so the running layout is
+    // used when it covers exactly the state's bytes. Empty when it does not; the state is
+    // never loaded to measure it.
+    std::vector<uint32_t> stateLayout(const std::vector<uint8_t>& state)
+    {
+        std::vector<uint32_t> spans = stateLayout();
+        size_t total = 0;
+        for(const uint32_t span : spans) total += span;
+        if(total != state.size()) spans.clear();
+        return spans;
+    }
+
+    // Upper bound for saveStateToMemory(), fixed until the ROM or input topology changes.
+    // It is measured with an input frame holding the largest input payload any layout has,
+    // so played-back frames never outgrow it and it holds from right after openRom().
+    size_t stateSize()
+    {
+        const StateSizeKey key = currentStateSizeKey();
+        if(m_stateSize == 0 || !(key == m_stateSizeKey)) {
+            InputFrame largestFrame = makeDefaultInputFrame(0);
+            largestFrame.state.serializedInputData.resize(kMaxSerializedInputDataSize);
+            std::optional<InputFrame> currentInputFrame = std::move(m_currentInputFrame);
+            m_currentInputFrame = std::move(largestFrame);
+            SerializationSize s;
+            serialization(s);
+            m_currentInputFrame = std::move(currentInputFrame);
+            m_stateSize = s.size();
+            m_stateSizeKey = key;
+        }
+        return m_stateSize;
+    }
+
+    // Copies the whole machine state of an emulator running the same ROM (see fork()),
+    // with the same result as loadStateFromMemory(source.saveStateToMemory()). CPU, PPU,
+    // APU and RAM are plain struct copies; only the mapper and the input devices go
+    // through their serialization, into a buffer kept between calls. That buffer is filled
+    // before anything here changes, so a false return from it leaves this emulator as it
+    // was. A false return after that means the mapper did not read back what it wrote,
+    // and this emulator is then only fit to be discarded.
+    bool copyStateFrom(GeraNESEmu& source)
+    {
+        if(&source == this || !m_cartridge.sharesRomWith(source.m_cartridge)) return false;
+
+        source.m_cpu.syncPpu();
+
+        m_copyStateBuffer.resize(source.stateSize());
+        SerializeInto s(m_copyStateBuffer.data(), m_copyStateBuffer.size());
+        source.runAsIfBetweenFrames([&]() {
+            source.m_cartridge.serialization(s);
+            source.serializeInputAndTiming(s);
+        });
+        if(s.error()) return false;
+
+        m_cpu.copyStateFrom(source.m_cpu);
+        m_ppu.copyStateFrom(source.m_ppu);
+        m_apu.copyStateFrom(source.m_apu);
+        memcpy(m_ram, source.m_ram, sizeof(m_ram));
+
+        m_settings = source.m_settings;
+        recreateInputRouting();
+
+        Deserialize d;
+        d.setData(m_copyStateBuffer.data(), s.size());
+        m_cartridge.serialization(d);
+        serializeInputAndTiming(d);
+        if(d.error()) return false;
+
+        markAllPagesDirty();
+        resyncAudioAfterStateLoad();
+        resetVolatileStateAfterStateLoad();
+
+        return true;
+    }
+
+    // A second emulator on the ROM this one has open, already in its current state. The
+    // parsed ROM is shared rather than reloaded; save RAM is copied but never written back
+    // to disk by the fork, and rewind starts disabled. Sound goes to audioOutput. The fork's
+    // frames are left out of the profiler report.
+    std::unique_ptr<GeraNESEmu> fork(IAudioOutput& audioOutput = DummyAudioOutput::instance())
+    {
+        auto ret = std::make_unique<GeraNESEmu>(audioOutput);
+
+        if(!ret->m_cartridge.shareRom(m_cartridge)) return nullptr;
+
+        ret->m_settings = m_settings;
+        ret->m_profilingSuspended = true;
+        ret->recreateInputRouting();
+        ret->updateCyclesPerSecond();
+#if defined(GERANES_CPU_DISPATCH_SELECTABLE)
+        ret->m_opcodeDispatch = m_opcodeDispatch;
+#endif
+
+        ret->m_ppu.setVsPpuModel(ret->m_cartridge.vsPpuModel());
+        ret->m_ppu.setColorPalette(m_ppu.colorPalette());
+        ret->m_ppu.setIndexedFramebufferEnabled(m_ppu.indexedFramebufferEnabled());
+        ret->m_cartridge.reset();
+        ret->m_ppu.init();
+        ret->m_cpu.init();
+        ret->m_apu.init();
+        ret->m_nsfPlayer.onOpen();
+
+        if(!ret->copyStateFrom(*this)) return nullptr;
+
+        return ret;
+    }
+
     /*
     void calculateSerializationSize()
     {
@@ -2273,6 +2654,7 @@ public:
     {
         m_ppuViewerScanlineTraceEnabled = enabled;
         if(enabled) {
+            m_cpu.setPpuCatchUp(false);
             if(m_ppuViewerScanlineStates.size() != 240u) {
                 m_ppuViewerScanlineStates.resize(240u);
             }
@@ -2321,6 +2703,20 @@ public:
         refreshBusInstrumentationEnabled();
     }
 
+#if defined(GERANES_CPU_DISPATCH_SELECTABLE)
+    // Benchmark builds only: picks the opcode dispatcher at runtime so both can be
+    // compared in one binary.
+    void setOpcodeDispatch(OpcodeDispatch dispatch)
+    {
+        m_opcodeDispatch = dispatch;
+    }
+
+    OpcodeDispatch opcodeDispatch() const
+    {
+        return m_opcodeDispatch;
+    }
+#endif
+
     void clearExternalCpuIoHandlers()
     {
         m_externalCpuWriteHandler = {};
@@ -2368,10 +2764,15 @@ public:
 
     void serialization(SerializationBase& s) override
     {
+        m_cpu.syncPpu();
+
+        s.beginComponent(StateComponent::CPU); // the header counts with the CPU
+
         uint32_t saveStateMagic = SAVE_STATE_MAGIC;
         SERIALIZEDATA(s, saveStateMagic);
         if(saveStateMagic != SAVE_STATE_MAGIC) {
             Logger::instance().log("Invalid save state: incorrect magic header", Logger::Type::ERROR);
+            s.fail();
             return;
         }
 
@@ -2379,6 +2780,7 @@ public:
         SERIALIZEDATA(s, saveStateVersion);
         if(saveStateVersion != SAVE_STATE_VERSION) {
             Logger::instance().log("Incompatible save state: version mismatch", Logger::Type::ERROR);
+            s.fail();
             return;
         }
 
@@ -2386,18 +2788,47 @@ public:
         SERIALIZEDATA(s, fileCrc);
         if(fileCrc != m_cartridge.romFile().fileCrc32()) {
             Logger::instance().log("Save state mismatch: this state was created for a different ROM", Logger::Type::ERROR);
+            s.fail();
             return;
         }
 
+        // Zero for a full state, otherwise the epoch an incremental state was taken against.
+        uint32_t incrementalBase = s.incrementalBase();
+        SERIALIZEDATA(s, incrementalBase);
+        if(s.isReading()) {
+            s.setIncremental(incrementalBase);
+        }
+
         m_cpu.serialization(s);
+        s.beginComponent(StateComponent::MAPPER);
         m_cartridge.serialization(s);
+        s.beginComponent(StateComponent::PPU);
         m_ppu.serialization(s);
+        s.beginComponent(StateComponent::APU);
         m_apu.serialization(s);
-        s.array(m_ram, 1, 0x800);
+        s.pages(m_ram, sizeof(m_ram), &m_ramPages);
+        if(s.failed()) {
+            // Nothing more is read; stop before the input section rebuilds its devices
+            // and frame from defaults.
+            markAllPagesDirty();
+            return;
+        }
+        s.beginComponent(StateComponent::INPUT);
         m_settings.serialization(s);
         if(s.isReading()) {
             recreateInputRouting();
         }
+        serializeInputAndTiming(s);
+
+        if(s.isReading()) {
+            markAllPagesDirty();
+        }
+    }
+
+    // The part of serialization() after the settings: device state, the frame loop
+    // scalars and the current input frame. copyStateFrom() moves it through a buffer.
+    void serializeInputAndTiming(SerializationBase& s)
+    {
         if(m_portDevice1) m_portDevice1->serialization(s);
         if(m_portDevice2) m_portDevice2->serialization(s);
         if(m_expansionDevice) m_expansionDevice->serialization(s);
@@ -2443,7 +2874,8 @@ public:
 
     bool setPlaybackInputFrame(const InputFrame& inputFrame)
     {
-        if(inputFrame.frame != m_frameCounter) {
+        if(inputFrame.frame != m_frameCounter ||
+           inputFrame.state.serializedInputData.size() > kMaxSerializedInputDataSize) {
             return false;
         }
         m_nextInputFrame = inputFrame;
@@ -2451,6 +2883,12 @@ public:
         return true;
     }
 
+    // Input applied to the frame in progress, or to the last one once it is complete.
+    const std::optional<InputFrame>& currentInputFrame() const
+    {
+        return m_currentInputFrame;
+    }
+
     bool hasPlaybackInputFrame(uint32_t frame) const
     {
         return (m_currentInputFrame.has_value() && m_currentInputFrame->frame == frame) ||
@@ -2606,9 +3044,12 @@ public:
 
         if(!m_cartridge.isValid()) return;
 
+        m_cpu.setPpuCatchUp(false);
+
         m_cartridge.reset();
         ++m_ppuViewerMapperWriteGeneration;
         preloadNsfMemory();
+        markAllPagesDirty();
         m_apu.reset();
         m_ppu.init();
 
@@ -107,24 +107,7 @@ struct InputState
     IExpansionDevice::FamilyBasicKeyboardKeys familyBasicKeyboardKeys() const;
     void setFamilyBasicKeyboardKeys(const IExpansionDevice::FamilyBasicKeyboardKeys& keys);
 
-    void serialization(SerializationBase& s)
-    {
-        SERIALIZEDATA(s, topology.port1Device);
-        SERIALIZEDATA(s, topology.port2Device);
-        SERIALIZEDATA(s, topology.expansionDevice);
-        SERIALIZEDATA(s, topology.nesMultitapDevice);
-        SERIALIZEDATA(s, topology.famicomMultitapDevice);
-        uint32_t serializedSize = static_cast<uint32_t>(serializedInputData.size());
-        SERIALIZEDATA(s, serializedSize);
-        if(s.isReading()) {
-            serializedInputData.assign(serializedSize, 0u);
-            if(serializedSize != 0u) {
-                s.array(serializedInputData.data(), 1, serializedSize);
-            }
-        } else if(serializedSize != 0u) {
-            s.array(serializedInputData.data(), 1, serializedSize);
-        }
-    }
+    void serialization(SerializationBase& s);
 
 };
 
@@ -51,6 +51,29 @@ constexpr size_t kSuborKeyboardSerializedSize = IExpansionDevice::SuborKeyboardK
 constexpr size_t kFamilyBasicKeyboardSerializedSize = IExpansionDevice::FamilyBasicKeyboardKeys{}.size();
 constexpr size_t kBandaiExpansionSerializedSize = kPad8SerializedSize + kPointerSerializedSize;
 
+constexpr size_t kMaxPortSerializedSize = std::max({
+    kPad8SerializedSize,
+    kPad12SerializedSize,
+    kVirtualBoySerializedSize,
+    kPointerSerializedSize,
+    kArkanoidSerializedSize,
+    kRelativePointerSerializedSize,
+    kPowerPadSerializedSize
+});
+constexpr size_t kMaxExpansionSerializedSize = std::max({
+    kBandaiExpansionSerializedSize,
+    kKonamiHyperShotSerializedSize,
+    kArkanoidSerializedSize,
+    kPowerPadSerializedSize,
+    kSuborKeyboardSerializedSize,
+    kFamilyBasicKeyboardSerializedSize,
+    kPad8SerializedSize
+});
+// Largest serializedInputData any topology produces. Save state sizes reserve this much,
+// and input carrying more is rejected.
+constexpr size_t kMaxSerializedInputDataSize =
+    std::max(kPad8SerializedSize * 4, kMaxPortSerializedSize * 2 + kMaxExpansionSerializedSize);
+
 enum class PortButtonsKind
 {
     None,
@@ -554,6 +577,29 @@ void writePadButtonsAt(std::vector<uint8_t>& data, const PortButtonsLocation& lo
 
 }
 
+inline void InputState::serialization(SerializationBase& s)
+{
+    SERIALIZEDATA(s, topology.port1Device);
+    SERIALIZEDATA(s, topology.port2Device);
+    SERIALIZEDATA(s, topology.expansionDevice);
+    SERIALIZEDATA(s, topology.nesMultitapDevice);
+    SERIALIZEDATA(s, topology.famicomMultitapDevice);
+    uint32_t serializedSize = static_cast<uint32_t>(serializedInputData.size());
+    SERIALIZEDATA(s, serializedSize);
+    if(s.isReading()) {
+        if(serializedSize > kMaxSerializedInputDataSize) {
+            s.fail();
+            return;
+        }
+        serializedInputData.assign(serializedSize, 0u);
+        if(serializedSize != 0u) {
+            s.array(serializedInputData.data(), 1, serializedSize);
+        }
+    } else if(serializedSize != 0u) {
+        s.array(serializedInputData.data(), 1, serializedSize);
+    }
+}
+
 inline InputState::PadButtons InputState::portButtons(int port) const
 {
     const PortButtonsLocation location = locatePortButtons(*this, port);
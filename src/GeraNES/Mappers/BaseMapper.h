@@ -1,8 +1,11 @@
 #pragma once
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 #include <fstream>
 #include <string>
+#include <type_traits>
 
 #include "../defines.h"
 #include "../MirroringType.h"
@@ -30,10 +33,39 @@ public:
         HookCap_OnPpuCycle = 1u << 5,
         HookCap_OnCpuRead = 1u << 6,
         HookCap_OnCpuWrite = 1u << 7,
+        HookCap_Cycle = 1u << 8,
+        HookCap_ExpansionAudio = 1u << 9,
+        HookCap_InterruptFlag = 1u << 10,
+        // onPpuCycle only needs the tile-boundary dots ((cycle & 7) == 0).
+        HookCap_PpuCycleTileEdges = 1u << 11,
+        HookCap_OnScanlineStart = 1u << 12,
     };
 
+    // Any of these keeps the PPU on its hooked per-dot/per-fetch path.
+    static constexpr uint32_t kPpuDotHookCaps =
+        HookCap_UseCustomNameTable |
+        HookCap_SetPpuFetchSource |
+        HookCap_TransformNameTableRead |
+        HookCap_OnPpuRead |
+        HookCap_OnPpuCycle;
+
+    // Hooks that let the mapper see or steer the PPU between CPU register accesses; any
+    // of them keeps the CPU from queueing PPU dots (see CPU2A03::deferPpuCycles).
+    static constexpr uint32_t kPpuCatchUpBlockingCaps =
+        kPpuDotHookCaps |
+        HookCap_SetA12State |
+        HookCap_OnScanlineStart |
+        HookCap_OnCpuRead |
+        HookCap_OnCpuWrite |
+        HookCap_Cycle;
+
     static constexpr uint32_t kMapperHookCaps = 0;
 
+    // Mappers that fill the CPU/PPU read page tables redeclare this as their own type.
+    // Subclasses inherit the alias but not the guarantee, so Cartridge only trusts the
+    // table when the alias names the exact mapper type being bound.
+    using ReadPageOwner = BaseMapper;
+
 protected:    
 
     template<BankSize bs>
@@ -43,7 +75,9 @@ protected:
 
     template<BankSize bs>
     GERANES_INLINE void writeChrRam(int bank, int addr, uint8_t data) {
-        m_chrRam[(bank << log2(bs)) + (addr&(static_cast<int>(bs)-1))] = data;
+        const int offset = (bank << log2(bs)) + (addr&(static_cast<int>(bs)-1));
+        m_chrRam[offset] = data;
+        m_chrRamPages.mark(offset);
     }
 
     //helper function to generate bit mask
@@ -66,10 +100,17 @@ protected:
         return m_cd;
     }
 
-    uint8_t* chrRam() {
+    // Mappers with their own CHR-RAM addressing read through the view and write single
+    // bytes through writeChrRamAt(), so only the written page counts as dirty.
+    GERANES_INLINE const uint8_t* chrRamView() const {
         return m_chrRam;
     }
 
+    GERANES_INLINE void writeChrRamAt(int offset, uint8_t data) {
+        m_chrRam[offset] = data;
+        m_chrRamPages.mark(offset);
+    }
+
 private:
 
     ICartridgeData& m_cd;
@@ -77,6 +118,22 @@ private:
     int m_chrRamSize = 0;
     uint8_t* m_sRam = nullptr;    
 
+    DirtyPages m_chrRamPages;
+    DirtyPages m_saveRamPages;
+
+    // 4KB pages indexed by CPU address >> 12; only $6000-$FFFF are used.
+    // A null page routes the read through readSaveRam/readPrg.
+    const uint8_t* m_cpuReadPages[16] = {};
+
+    // 1KB CHR pages for PPU $0000-$1FFF and the CIRAM page behind each nametable slot.
+    // A null CHR page or a negative nametable page routes the fetch through readChr/mirroring.
+    const uint8_t* m_chrReadPages[8] = {};
+    int8_t m_nameTablePages[4] = {-1, -1, -1, -1};
+
+    bool m_readPagesEnabled = true;
+
+    bool m_persistSaveRam = true;
+
     std::filesystem::path saveRamFile()
     {
         auto romFile = cd().romFile();
@@ -85,7 +142,7 @@ private:
 
     void loadSaveRamFromFile()
     {
-        if(!cd().hasBattery()) return;
+        if(!cd().hasBattery() || !m_persistSaveRam) return;
 
         std::ifstream f(saveRamFile(), std::ios::binary);
 
@@ -108,7 +165,7 @@ private:
 
     void writeSaveRamToFile()
     {
-        if(!cd().hasBattery()) return;
+        if(!cd().hasBattery() || !m_persistSaveRam) return;
 
         const fs::path savePath = saveRamFile();
         std::error_code ec;
@@ -127,6 +184,7 @@ private:
         if(cd().saveRamSize() > 0) {
             m_sRam = new uint8_t[cd().saveRamSize()];
             memset(m_sRam, 0, cd().saveRamSize());
+            m_saveRamPages.resize(cd().saveRamSize());
             loadSaveRamFromFile();
         }
 
@@ -145,17 +203,131 @@ protected:
         m_chrRam = new uint8_t[size];
         m_chrRamSize = size;
         memset(m_chrRam, 0, size);
+        m_chrRamPages.resize(size);
+    }
+
+    // Rebuild m_cpuReadPages from the current bank registers. Only side-effect free
+    // readPrg/readSaveRam paths may be mapped; call it whenever a bank register changes.
+    virtual void updateCpuReadPages() {}
+
+    // Map a PRG-ROM bank at cpuAddr ($8000-$FFFF). Out of range banks stay on the slow path.
+    template<BankSize bs>
+    void mapCpuReadPrg(int cpuAddr, int bank)
+    {
+        static_assert(static_cast<int>(bs) >= 0x1000, "CPU read pages are 4KB");
+        const uint8_t* data = cd().prgBankData<bs>(bank);
+        for(int i = 0; i < static_cast<int>(bs); i += 0x1000) {
+            setCpuReadPage(cpuAddr + i, data != nullptr ? data + i : nullptr);
+        }
+    }
+
+    // Map $6000-$7FFF to the save RAM layout used by BaseMapper::readSaveRam.
+    void mapCpuReadSaveRam()
+    {
+        const int size = cd().saveRamSize();
+        const bool mappable = m_sRam != nullptr && size >= 0x1000 && (size & (size - 1)) == 0;
+        setCpuReadPage(0x6000, mappable ? m_sRam : nullptr);
+        setCpuReadPage(0x7000, mappable ? m_sRam + (0x1000 & (size - 1)) : nullptr);
+    }
+
+    GERANES_INLINE void setCpuReadPage(int cpuAddr, const uint8_t* page)
+    {
+        m_cpuReadPages[(cpuAddr >> 12) & 0x0F] = m_readPagesEnabled ? page : nullptr;
+    }
+
+    // Rebuild m_chrReadPages/m_nameTablePages from the CHR bank and mirroring state.
+    // Mappers with per-fetch CHR or nametable hooks must leave those pages unmapped.
+    virtual void updatePpuReadPages() {}
+
+    // Map a CHR-ROM bank at ppuAddr ($0000-$1FFF), or CHR-RAM when the cartridge has it.
+    template<BankSize bs>
+    void mapPpuReadChr(int ppuAddr, int bank)
+    {
+        static_assert(static_cast<int>(bs) >= 0x400, "PPU read pages are 1KB");
+        const uint8_t* data = hasChrRam() ? chrRamBankData<bs>(bank) : cd().chrBankData<bs>(bank);
+        for(int i = 0; i < static_cast<int>(bs); i += 0x400) {
+            setChrReadPage(ppuAddr + i, data != nullptr ? data + i : nullptr);
+        }
+    }
+
+    // Map all four nametable slots to CIRAM following a fixed mirroring arrangement.
+    void mapPpuNameTables(MirroringType mirroringType)
+    {
+        static const int8_t HORIZONTAL_PAGES[] = {0,0,1,1};
+        static const int8_t VERTICAL_PAGES[] = {0,1,0,1};
+        static const int8_t FOUR_SCREEN_PAGES[] = {0,1,2,3};
+
+        for(int i = 0; i < 4; i++) {
+            int8_t page = -1;
+            switch(mirroringType) {
+                case MirroringType::HORIZONTAL: page = HORIZONTAL_PAGES[i]; break;
+                case MirroringType::VERTICAL: page = VERTICAL_PAGES[i]; break;
+                case MirroringType::SINGLE_SCREEN_A: page = 0; break;
+                case MirroringType::SINGLE_SCREEN_B: page = 1; break;
+                case MirroringType::FOUR_SCREEN: page = FOUR_SCREEN_PAGES[i]; break;
+                default: break; //CUSTOM stays on the slow path
+            }
+            m_nameTablePages[i] = m_readPagesEnabled ? page : -1;
+        }
+    }
+
+    GERANES_INLINE void setChrReadPage(int ppuAddr, const uint8_t* page)
+    {
+        m_chrReadPages[(ppuAddr >> 10) & 0x07] = m_readPagesEnabled ? page : nullptr;
+    }
+
+    template<BankSize bs>
+    GERANES_INLINE const uint8_t* chrRamBankData(int bank)
+    {
+        const int offset = bank << log2(bs);
+        if(m_chrRam == nullptr || bank < 0 || offset + static_cast<int>(bs) > m_chrRamSize) return nullptr;
+        return m_chrRam + offset;
     }
     
 public:
 
+    // persistSaveRam=false keeps the mapper away from the .sram file (emulator forks).
     template<std::derived_from<BaseMapper> T>
-    static T* create(ICartridgeData& cd) {
+    static T* create(ICartridgeData& cd, bool persistSaveRam = true) {
         auto ret = new T(cd);
+        ret->m_persistSaveRam = persistSaveRam;
         ret->init();
+        ret->refreshReadPages();
         return ret;
     }    
 
+    GERANES_INLINE const uint8_t* cpuReadPage(int page) const
+    {
+        return m_cpuReadPages[page];
+    }
+
+    GERANES_INLINE const uint8_t* chrReadPage(int page) const
+    {
+        return m_chrReadPages[page];
+    }
+
+    GERANES_INLINE int nameTablePage(uint8_t index) const
+    {
+        return m_nameTablePages[index];
+    }
+
+    void setReadPagesEnabled(bool enabled)
+    {
+        m_readPagesEnabled = enabled;
+        refreshReadPages();
+    }
+
+    void refreshReadPages()
+    {
+        std::fill(std::begin(m_cpuReadPages), std::end(m_cpuReadPages), nullptr);
+        std::fill(std::begin(m_chrReadPages), std::end(m_chrReadPages), nullptr);
+        std::fill(std::begin(m_nameTablePages), std::end(m_nameTablePages), static_cast<int8_t>(-1));
+        if(m_readPagesEnabled) {
+            updateCpuReadPages();
+            updatePpuReadPages();
+        }
+    }
+
     virtual void reset(){}
 
     virtual void writePrg(int /*addr*/, uint8_t /*data*/) {}
@@ -185,6 +357,8 @@ public:
         return readMapperRegister(addr & 0x1FFF, openBusData);
     }
 
+    // Edge event: Cartridge only forwards PPU A12 level changes, so the first call after
+    // reset or a state load may repeat the mapper's last level.
     virtual void setA12State(bool /*state*/){}
 
     virtual void cycle(){ } //cpu cycle
@@ -199,8 +373,11 @@ public:
 
     virtual void writeSaveRam(int addr, uint8_t data)
     {
-        if(m_sRam != nullptr)
-            m_sRam[addr&(cd().saveRamSize()-1)] = data;
+        if(m_sRam != nullptr) {
+            const int offset = addr&(cd().saveRamSize()-1);
+            m_sRam[offset] = data;
+            m_saveRamPages.mark(offset);
+        }
     }
 
     virtual uint8_t readSaveRam(int addr)
@@ -327,24 +504,60 @@ public:
 
     virtual void serialization(SerializationBase& s)
     {
-        s.array(m_sRam, 1, cd().saveRamSize());
+        s.pages(m_sRam, cd().saveRamSize(), &m_saveRamPages);
 
         bool hasChrRam = (m_chrRam != NULL);
         SERIALIZEDATA(s, hasChrRam);
         if(hasChrRam) {
-            s.array(m_chrRam, 1, m_chrRamSize);
+            s.pages(m_chrRam, m_chrRamSize, &m_chrRamPages);
         }
     }
 
+    void setDirtyEpoch(uint32_t epoch)
+    {
+        m_saveRamPages.setEpoch(epoch);
+        m_chrRamPages.setEpoch(epoch);
+    }
+
+    void markAllPagesDirty()
+    {
+        m_saveRamPages.markAll();
+        m_chrRamPages.markAll();
+    }
+
+    const DirtyPages& saveRamPages() const
+    {
+        return m_saveRamPages;
+    }
+
+    const DirtyPages& chrRamPages() const
+    {
+        return m_chrRamPages;
+    }
+
     GERANES_INLINE bool hasChrRam() const {
         return (m_chrRam != nullptr) || (cd().chrRamSize() > 0);
     }
 
+    // Writes through the pointer are not tracked, so the whole save RAM counts as dirty.
+    // Read paths use saveRamView() and byte writes use writeSaveRamAt() instead.
     GERANES_INLINE uint8_t* saveRamData()
+    {
+        m_saveRamPages.markAll();
+        return m_sRam;
+    }
+
+    GERANES_INLINE const uint8_t* saveRamView() const
     {
         return m_sRam;
     }
 
+    GERANES_INLINE void writeSaveRamAt(size_t offset, uint8_t data)
+    {
+        m_sRam[offset] = data;
+        m_saveRamPages.mark(offset);
+    }
+
     GERANES_INLINE size_t saveRamSize() const
     {
         if(m_sRam == nullptr) return 0;
@@ -360,4 +573,31 @@ public:
 
 };
 
+/*
+Per CPU cycle hooks are detected from the overrides MapperT (or any of its bases)
+provides, so mappers never need to declare them by hand. A hook still inherited
+from BaseMapper is a no-op and can be skipped by the caller.
+*/
+template<typename MapperT>
+constexpr uint32_t detectCpuCycleHookCaps()
+{
+    uint32_t caps = 0;
+
+    if(!std::is_same_v<decltype(&MapperT::cycle), decltype(&BaseMapper::cycle)>) {
+        caps |= BaseMapper::HookCap_Cycle;
+    }
+
+    if(!std::is_same_v<decltype(&MapperT::getExpansionAudioSample), decltype(&BaseMapper::getExpansionAudioSample)> ||
+       !std::is_same_v<decltype(&MapperT::getMixWeight), decltype(&BaseMapper::getMixWeight)> ||
+       !std::is_same_v<decltype(&MapperT::getExpansionOutputGain), decltype(&BaseMapper::getExpansionOutputGain)>) {
+        caps |= BaseMapper::HookCap_ExpansionAudio;
+    }
+
+    if(!std::is_same_v<decltype(&MapperT::getInterruptFlag), decltype(&BaseMapper::getInterruptFlag)>) {
+        caps |= BaseMapper::HookCap_InterruptFlag;
+    }
+
+    return caps;
+}
+
 } // namespace GeraNES
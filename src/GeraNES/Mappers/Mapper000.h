@@ -8,8 +8,25 @@ namespace GeraNES {
 class Mapper000 : public BaseMapper
 {
 
+protected:
+
+    void updateCpuReadPages() override
+    {
+        mapCpuReadSaveRam();
+        mapCpuReadPrg<BankSize::B16K>(0x8000, 0);
+        mapCpuReadPrg<BankSize::B16K>(0xC000, cd().numberOfPRGBanks<BankSize::B16K>()-1);
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(mirroringType());
+        mapPpuReadChr<BankSize::B8K>(0x0000, 0);
+    }
+
 public:
 
+    using ReadPageOwner = Mapper000;
+
     Mapper000(ICartridgeData& cd) : BaseMapper(cd)
     {
     }
@@ -4,11 +4,10 @@
 
 namespace GeraNES {
 
-//MMC1
-//SxROM
-class Mapper001 : public BaseMapper
+// Persisted MMC1 registers, saved as one block (see SerializationBase::block).
+struct Mapper001State
 {
-private:
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
     int m_shiftCounter = 0;
     uint8_t m_shiftRegister = 0;
@@ -20,8 +19,53 @@ private:
     uint8_t m_PRGMask = 0; //16k banks mask
     uint8_t m_CHRMask = 0; //4k banks maks
 
+    uint8_t m_reserved = 0;
+};
+
+//MMC1
+//SxROM
+class Mapper001 : public BaseMapper, private Mapper001State
+{
+protected:
+
+    void updateCpuReadPages() override
+    {
+        mapCpuReadSaveRam();
+
+        switch( (m_control&0x0C)>>2 )
+        {
+        case 0:
+        case 1:
+            mapCpuReadPrg<BankSize::B16K>(0x8000, m_prgBank>>1);
+            mapCpuReadPrg<BankSize::B16K>(0xC000, (m_prgBank>>1)+1);
+            break;
+        case 2:
+            mapCpuReadPrg<BankSize::B16K>(0x8000, 0);
+            mapCpuReadPrg<BankSize::B16K>(0xC000, m_prgBank&0x0F);
+            break;
+        case 3:
+            mapCpuReadPrg<BankSize::B16K>(0x8000, m_prgBank&0x0F);
+            mapCpuReadPrg<BankSize::B16K>(0xC000, cd().numberOfPRGBanks<BankSize::B16K>()-1);
+            break;
+        }
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(mirroringType());
+
+        if(hasChrRam()) mapPpuReadChr<BankSize::B8K>(0x0000, 0);
+        else if(!(m_control&0x10)) mapPpuReadChr<BankSize::B8K>(0x0000, m_chrBank0>>1);
+        else {
+            mapPpuReadChr<BankSize::B4K>(0x0000, m_chrBank0);
+            mapPpuReadChr<BankSize::B4K>(0x1000, m_chrBank1);
+        }
+    }
+
 public:
 
+    using ReadPageOwner = Mapper001;
+
     Mapper001(ICartridgeData& cd) : BaseMapper(cd)
     { 
         m_PRGMask = calculateMask(cd.numberOfPRGBanks<BankSize::B16K>());
@@ -34,6 +78,8 @@ public:
         {
             m_shiftCounter = 0;
             m_control |= 0x0C;
+            updateCpuReadPages();
+            updatePpuReadPages();
         }
         else
         {
@@ -65,6 +111,8 @@ public:
 
                 m_shiftCounter = 0;
                 m_shiftRegister = 0;
+                updateCpuReadPages();
+                updatePpuReadPages();
             }
         }
     }
@@ -163,15 +211,7 @@ public:
     {
         BaseMapper::serialization(s); 
 
-        SERIALIZEDATA(s, m_shiftCounter);
-        SERIALIZEDATA(s, m_shiftRegister);
-        SERIALIZEDATA(s, m_control);
-        SERIALIZEDATA(s, m_chrBank0);
-        SERIALIZEDATA(s, m_chrBank1);
-        SERIALIZEDATA(s, m_prgBank);
-
-        SERIALIZEDATA(s, m_PRGMask);
-        SERIALIZEDATA(s, m_CHRMask);
+        s.block(static_cast<Mapper001State&>(*this));
     }
 
 };
@@ -12,8 +12,25 @@ private:
     int m_selectedBank = 0;
     bool m_hasBusConflicts = false;
 
+protected:
+
+    void updateCpuReadPages() override
+    {
+        mapCpuReadSaveRam();
+        mapCpuReadPrg<BankSize::B16K>(0x8000, m_selectedBank);
+        mapCpuReadPrg<BankSize::B16K>(0xC000, cd().numberOfPRGBanks<BankSize::B16K>()-1);
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(mirroringType());
+        if(hasChrRam()) mapPpuReadChr<BankSize::B8K>(0x0000, 0);
+    }
+
 public:
 
+    using ReadPageOwner = Mapper002;
+
     Mapper002(ICartridgeData& cd) : BaseMapper(cd)
     {
         // NES 2.0 Mapper 2:
@@ -35,6 +52,7 @@ public:
         }
 
         m_selectedBank = data;
+        updateCpuReadPages();
     };
 
     void reset() override
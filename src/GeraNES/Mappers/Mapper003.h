@@ -13,8 +13,25 @@ private:
     uint8_t m_CHRREGMask = 0;
     bool m_hasBusConflicts = false;
 
+protected:
+
+    void updateCpuReadPages() override
+    {
+        mapCpuReadSaveRam();
+        mapCpuReadPrg<BankSize::B16K>(0x8000, 0);
+        mapCpuReadPrg<BankSize::B16K>(0xC000, cd().numberOfPRGBanks<BankSize::B16K>()==2?1:0);
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(mirroringType());
+        mapPpuReadChr<BankSize::B8K>(0x0000, hasChrRam() ? 0 : m_CHRREG);
+    }
+
 public:
 
+    using ReadPageOwner = Mapper003;
+
     Mapper003(ICartridgeData& cd) : BaseMapper(cd)
     {
         m_CHRREGMask = calculateMask(cd.numberOfCHRBanks<BankSize::B8K>());
@@ -31,6 +48,7 @@ public:
         }
 
         m_CHRREG = data&m_CHRREGMask;
+        updatePpuReadPages();
     }
 
     GERANES_HOT uint8_t readPrg(int addr) override
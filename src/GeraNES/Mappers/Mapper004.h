@@ -5,16 +5,10 @@
 
 namespace GeraNES {
 
-//MMC3
-//TxROM
-//(MMC6)
-//(HxROM)
-class Mapper004 : public BaseMapper
+// Persisted MMC3 registers, saved as one block (see SerializationBase::block).
+struct Mapper004State
 {
-public:
-    static constexpr uint32_t kMapperHookCaps = BaseMapper::HookCap_SetA12State;
-
-protected:
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
     uint8_t m_addrReg = 0;
     bool m_chrMode = false;
@@ -49,13 +43,27 @@ protected:
 
     uint8_t m_cycleCounter = 0;
 
-    bool m_mmc3RevAIrqs = false;
-    bool m_isMMC6 = false;
     bool m_mmc6PrgRamEnabled = false;
     bool m_mmc6WriteLow = false;
     bool m_mmc6ReadLow = false;
     bool m_mmc6WriteHigh = false;
     bool m_mmc6ReadHigh = false;
+};
+
+//MMC3
+//TxROM
+//(MMC6)
+//(HxROM)
+class Mapper004 : public BaseMapper, protected Mapper004State
+{
+public:
+    static constexpr uint32_t kMapperHookCaps = BaseMapper::HookCap_SetA12State;
+    using ReadPageOwner = Mapper004;
+
+protected:
+
+    bool m_mmc3RevAIrqs = false;
+    bool m_isMMC6 = false;
 
     template<BankSize bs>
     GERANES_INLINE uint8_t readChrBank(int bank, int addr) {
@@ -68,6 +76,31 @@ protected:
         writeChrRam<bs>(bank, addr, data);
     }
 
+    void updateCpuReadPages() override
+    {
+        // MMC6 PRG-RAM reads depend on the protect bits, keep them on the slow path.
+        if(!m_isMMC6) mapCpuReadSaveRam();
+
+        const int secondLast = cd().numberOfPRGBanks<BankSize::B8K>()-2;
+        mapCpuReadPrg<BankSize::B8K>(0x8000, m_prgMode ? secondLast : m_prgReg0);
+        mapCpuReadPrg<BankSize::B8K>(0xA000, m_prgReg1);
+        mapCpuReadPrg<BankSize::B8K>(0xC000, m_prgMode ? m_prgReg0 : secondLast);
+        mapCpuReadPrg<BankSize::B8K>(0xE000, secondLast+1);
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(mirroringType());
+
+        const int lowHalf = m_chrMode ? 0x1000 : 0x0000;
+        const int highHalf = lowHalf ^ 0x1000;
+        mapPpuReadChr<BankSize::B2K>(lowHalf, (m_chrReg[0]&m_chrMask)>>1);
+        mapPpuReadChr<BankSize::B2K>(lowHalf + 0x800, (m_chrReg[1]&m_chrMask)>>1);
+        for(int i = 0; i < 4; i++) {
+            mapPpuReadChr<BankSize::B1K>(highHalf + i*0x400, m_chrReg[2+i]&m_chrMask);
+        }
+    }
+
 public:
 
     Mapper004(ICartridgeData& cd) : BaseMapper(cd)
@@ -135,7 +168,8 @@ public:
                     m_mmc6ReadHigh = false;
                 }
             }
-
+            updateCpuReadPages();
+            updatePpuReadPages();
             break;
         case 0x0001:
             switch(m_addrReg)
@@ -149,9 +183,12 @@ public:
             case 6: m_prgReg0 = data&m_prgMask; break;
             case 7: m_prgReg1 = data&m_prgMask; break;
             }
+            if(m_addrReg < 6) updatePpuReadPages();
+            else updateCpuReadPages();
             break;
         case 0x2000:
             m_mirroring = data & 0x01;
+            updatePpuReadPages();
             break;
         case 0x2001:
             if(m_isMMC6) {
@@ -281,9 +318,8 @@ public:
         // Per hardware, write-enable only matters if read-enable for that half is set.
         if(!(readAllowed && writeBitSet)) return;
 
-        uint8_t* ram = saveRamData();
-        if(ram != nullptr && saveRamSize() > 0) {
-            ram[off & 0x3FF] = data;
+        if(saveRamView() != nullptr && saveRamSize() > 0) {
+            writeSaveRamAt(off & 0x3FF, data);
         }
     }
 
@@ -303,7 +339,7 @@ public:
             return 0;
         }
 
-        uint8_t* ram = saveRamData();
+        const uint8_t* ram = saveRamView();
         if(ram != nullptr && saveRamSize() > 0) {
             return ram[off & 0x3FF];
         }
@@ -400,37 +436,7 @@ public:
     {
         BaseMapper::serialization(s);
 
-        SERIALIZEDATA(s, m_chrMode);
-        SERIALIZEDATA(s, m_prgMode);
-        SERIALIZEDATA(s, m_addrReg);
-        SERIALIZEDATA(s, m_chrReg[0]);
-        SERIALIZEDATA(s, m_chrReg[1]);
-        SERIALIZEDATA(s, m_chrReg[2]);
-        SERIALIZEDATA(s, m_chrReg[3]);
-        SERIALIZEDATA(s, m_chrReg[4]);
-        SERIALIZEDATA(s, m_chrReg[5]);
-        SERIALIZEDATA(s, m_prgReg0);
-        SERIALIZEDATA(s, m_prgReg1);
-
-        SERIALIZEDATA(s, m_prgMask);
-        SERIALIZEDATA(s, m_chrMask);
-
-        SERIALIZEDATA(s, m_mirroring);
-        SERIALIZEDATA(s, m_enableWRAM);
-        SERIALIZEDATA(s, m_writeProtectWRAM);
-        SERIALIZEDATA(s, m_reloadValue);
-        SERIALIZEDATA(s, m_irqCounter);
-        SERIALIZEDATA(s, m_enableInterrupt);
-        SERIALIZEDATA(s, m_irqClearFlag);
-        SERIALIZEDATA(s, m_interruptFlag);
-        
-        SERIALIZEDATA(s, m_a12LastState);    
-        SERIALIZEDATA(s, m_cycleCounter);
-        SERIALIZEDATA(s, m_mmc6PrgRamEnabled);
-        SERIALIZEDATA(s, m_mmc6WriteLow);
-        SERIALIZEDATA(s, m_mmc6ReadLow);
-        SERIALIZEDATA(s, m_mmc6WriteHigh);
-        SERIALIZEDATA(s, m_mmc6ReadHigh);
+        s.block(static_cast<Mapper004State&>(*this));
     }
 
 };
@@ -30,6 +30,8 @@ public:
         BaseMapper::HookCap_TransformNameTableRead |
         BaseMapper::HookCap_OnPpuRead |
         BaseMapper::HookCap_OnPpuCycle |
+        BaseMapper::HookCap_PpuCycleTileEdges |
+        BaseMapper::HookCap_OnScanlineStart |
         BaseMapper::HookCap_OnCpuRead;
 
 private:
@@ -14,8 +14,24 @@ private:
 
     bool m_mirroring = false;
 
+protected:
+
+    void updateCpuReadPages() override
+    {
+        mapCpuReadSaveRam();
+        mapCpuReadPrg<BankSize::B32K>(0x8000, m_PRGReg);
+    }
+
+    void updatePpuReadPages() override
+    {
+        mapPpuNameTables(m_mirroring ? MirroringType::SINGLE_SCREEN_B : MirroringType::SINGLE_SCREEN_A);
+        if(hasChrRam()) mapPpuReadChr<BankSize::B8K>(0x0000, 0);
+    }
+
 public:
 
+    using ReadPageOwner = Mapper007;
+
     Mapper007(ICartridgeData& cd) : BaseMapper(cd)
     {
         m_PRGRegMask = calculateMask(cd.numberOfPRGBanks<BankSize::B32K>());    
@@ -25,6 +41,8 @@ public:
     {
         m_mirroring = data&0x10;
         m_PRGReg = data&m_PRGRegMask;
+        updateCpuReadPages();
+        updatePpuReadPages();
     }
 
     GERANES_HOT uint8_t readPrg(int addr) override
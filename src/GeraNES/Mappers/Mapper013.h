@@ -31,14 +31,14 @@ public:
     {
         if(addr < 0x1000) addr &= 0x0FFF;
         else addr = (m_CHRReg * 0x1000) + (addr&0x0FFF);
-        return *(chrRam()+addr);
+        return chrRamView()[addr];
     }
 
     GERANES_HOT void writeChr(int addr, uint8_t data) override
     {
         if(addr < 0x1000) addr &= 0x0FFF;
         else addr = (m_CHRReg * 0x1000) + (addr&0x0FFF);
-        *(chrRam()+addr) = data;
+        writeChrRamAt(addr, data);
     }
 
     void reset() override
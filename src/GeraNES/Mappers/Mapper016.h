@@ -94,12 +94,20 @@ protected:
         }
     }
 
-    GERANES_INLINE uint8_t* eepromDataPtr()
+    GERANES_INLINE bool eepromInSaveRam() const
     {
-        if(saveRamData() != nullptr && saveRamSize() >= eepromStorageSize()) {
-            return saveRamData();
-        }
-        return m_eepromData.data();
+        return saveRamView() != nullptr && saveRamSize() >= eepromStorageSize();
+    }
+
+    GERANES_INLINE uint8_t readEepromByte(uint8_t address) const
+    {
+        return eepromInSaveRam() ? saveRamView()[address] : m_eepromData[address];
+    }
+
+    GERANES_INLINE void writeEepromByte(uint8_t address, uint8_t data)
+    {
+        if(eepromInSaveRam()) writeSaveRamAt(address, data);
+        else m_eepromData[address] = data;
     }
 
     void updatePrgBankSelect()
@@ -151,8 +159,6 @@ protected:
 
     void writeEeprom24C02(uint8_t scl, uint8_t sda)
     {
-        uint8_t* data = eepromDataPtr();
-
         if(m_eepromPrevScl && scl && sda < m_eepromPrevSda) {
             m_eepromMode = EepromMode::ChipAddress;
             m_eepromCounter = 0;
@@ -190,7 +196,7 @@ protected:
             case EepromMode::WaitAck:
                 if(!sda) {
                     m_eepromNextMode = EepromMode::Read;
-                    m_eepromLatch = data[m_eepromAddress];
+                    m_eepromLatch = readEepromByte(m_eepromAddress);
                 }
                 break;
             }
@@ -206,7 +212,7 @@ protected:
 
                         if(m_eepromChipAddress & 0x01) {
                             m_eepromNextMode = EepromMode::Read;
-                            m_eepromLatch = data[m_eepromAddress];
+                            m_eepromLatch = readEepromByte(m_eepromAddress);
                         }
                         else {
                             m_eepromNextMode = EepromMode::Address;
@@ -241,7 +247,7 @@ protected:
                     m_eepromCounter = 0;
                     m_eepromMode = EepromMode::SendAck;
                     m_eepromNextMode = EepromMode::Write;
-                    data[m_eepromAddress] = m_eepromLatch;
+                    writeEepromByte(m_eepromAddress, m_eepromLatch);
                     m_eepromAddress = static_cast<uint8_t>(m_eepromAddress + 1);
                 }
                 break;
@@ -264,8 +270,6 @@ protected:
 
     void writeEeprom24C01(uint8_t scl, uint8_t sda)
     {
-        uint8_t* data = eepromDataPtr();
-
         if(m_eepromPrevScl && scl && sda < m_eepromPrevSda) {
             m_eepromMode = EepromMode::Address;
             m_eepromAddress = 0;
@@ -287,7 +291,7 @@ protected:
 
                     if(sda) {
                         m_eepromNextMode = EepromMode::Read;
-                        m_eepromLatch = data[m_eepromAddress & 0x7F];
+                        m_eepromLatch = readEepromByte(m_eepromAddress & 0x7F);
                     }
                     else {
                         m_eepromNextMode = EepromMode::Write;
@@ -343,7 +347,7 @@ protected:
                 if(m_eepromCounter == 8) {
                     m_eepromMode = EepromMode::SendAck;
                     m_eepromNextMode = EepromMode::Idle;
-                    data[m_eepromAddress & 0x7F] = m_eepromLatch;
+                    writeEepromByte(m_eepromAddress & 0x7F, m_eepromLatch);
                     m_eepromAddress = static_cast<uint8_t>((m_eepromAddress + 1) & 0x7F);
                 }
                 break;
@@ -540,7 +544,7 @@ public:
         m_eepromPrevScl = 0;
         m_eepromPrevSda = 1;
 
-        if(saveRamData() == nullptr || saveRamSize() < eepromStorageSize()) {
+        if(!eepromInSaveRam()) {
             m_eepromData.fill(0x00);
         }
     }
@@ -561,7 +565,7 @@ public:
         SERIALIZEDATA(s, m_IRQFlag);
 
         SERIALIZEDATA(s, m_eepromType);
-        if(saveRamData() == nullptr || saveRamSize() < eepromStorageSize()) {
+        if(!eepromInSaveRam()) {
             s.array(m_eepromData.data(), 1, eepromStorageSize());
         }
 
@@ -42,14 +42,14 @@ private:
     GERANES_INLINE uint8_t readChrRam(int bank, int addr)
     {
         addr = (bank << log2(bs)) + (addr&(static_cast<int>(bs)-1));
-        return chrRam()[addr];
+        return chrRamView()[addr];
     }
 
     template<BankSize bs>
     GERANES_INLINE void writeChrRam(int bank, int addr, uint8_t data)
     {
         addr = (bank << log2(bs)) + (addr&(static_cast<int>(bs)-1));
-        chrRam()[addr] = data;
+        writeChrRamAt(addr, data);
     }
 
 public:
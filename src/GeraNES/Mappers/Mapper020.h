@@ -13,6 +13,9 @@ namespace GeraNES {
 
 class Mapper020 : public BaseMapper
 {
+public:
+    static constexpr uint32_t kMapperHookCaps = BaseMapper::HookCap_OnScanlineStart;
+
 private:
     static constexpr uint8_t FDS_ACTION_SWITCH_DISK_SIDE = 0x01;
     static constexpr uint8_t FDS_ACTION_EJECT_DISK = 0x02;
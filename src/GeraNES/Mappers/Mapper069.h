@@ -64,7 +64,9 @@ private:
 
     void serializePRGRAM(SerializationBase& s)
     {
-        std::vector<uint8_t> encoded = EscapedRle::encode(m_PRGRAM.get(), m_currentRAMSize);
+        // RLE only wins when smaller, so the raw form is the size to report when measuring.
+        std::vector<uint8_t> encoded;
+        if(!s.measuring()) encoded = EscapedRle::encode(m_PRGRAM.get(), m_currentRAMSize);
         const bool useRle = !encoded.empty() && encoded.size() < m_currentRAMSize;
         uint8_t format = useRle ? PRGRAM_SERIALIZATION_RLE : PRGRAM_SERIALIZATION_RAW;
         uint32_t payloadSize = useRle ? static_cast<uint32_t>(encoded.size()) : m_currentRAMSize;
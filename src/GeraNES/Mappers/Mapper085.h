@@ -24,9 +24,9 @@ private:
     Vrc7Audio m_audio;
     std::unique_ptr<uint8_t[]> m_workRam;
 
-    uint8_t* workRamData()
+    const uint8_t* workRamView() const
     {
-        return saveRamData() != nullptr ? saveRamData() : m_workRam.get();
+        return saveRamView() != nullptr ? saveRamView() : m_workRam.get();
     }
 
     uint16_t normalizeRegisterAddress(int addr) const
@@ -53,7 +53,7 @@ public:
         m_useA4Select = cd.subMapperId() != 1;
         m_hasAudio = cd.subMapperId() != 1;
 
-        if(saveRamData() == nullptr) {
+        if(saveRamView() == nullptr) {
             m_workRam = std::make_unique<uint8_t[]>(0x2000);
             memset(m_workRam.get(), 0, 0x2000);
         }
@@ -162,9 +162,11 @@ public:
     {
         if(!wramEnabled()) return;
 
-        uint8_t* ram = workRamData();
-        if(ram != nullptr) {
-            ram[addr & 0x1FFF] = data;
+        if(saveRamView() != nullptr) {
+            writeSaveRamAt(addr & 0x1FFF, data);
+        }
+        else if(m_workRam) {
+            m_workRam[addr & 0x1FFF] = data;
         }
     }
 
@@ -172,7 +174,7 @@ public:
     {
         if(!wramEnabled()) return 0;
 
-        uint8_t* ram = workRamData();
+        const uint8_t* ram = workRamView();
         return ram != nullptr ? ram[addr & 0x1FFF] : 0;
     }
 
@@ -33,7 +33,7 @@ public:
     {        
         addr = (bank << log2(bs)) + (addr&(static_cast<int>(bs)-1));
         addr = addr&(static_cast<int>(BankSize::B8K)-1);
-        return chrRam()[addr];
+        return chrRamView()[addr];
     }
 
     template<BankSize bs>
@@ -41,7 +41,7 @@ public:
     {
         addr = (bank << log2(bs)) + (addr&(static_cast<int>(bs)-1));
         addr = addr&(static_cast<int>(BankSize::B8K)-1);
-        chrRam()[addr] = data;
+        writeChrRamAt(addr, data);
     }
 
     GERANES_HOT uint8_t readChr(int addr) override
@@ -27,30 +27,28 @@ public:
 
     GERANES_HOT uint8_t readMapperRegister(int addr, uint8_t openBusData) override
     {
-        uint8_t* ram = saveRamData();
+        const uint8_t* ram = saveRamView();
         if(ram == nullptr || saveRamSize() == 0) return openBusData;
         return ram[ramOffset5000(addr) % saveRamSize()];
     }
 
     GERANES_HOT void writeMapperRegister(int addr, uint8_t value) override
     {
-        uint8_t* ram = saveRamData();
-        if(ram == nullptr || saveRamSize() == 0) return;
-        ram[ramOffset5000(addr) % saveRamSize()] = value;
+        if(saveRamView() == nullptr || saveRamSize() == 0) return;
+        writeSaveRamAt(ramOffset5000(addr) % saveRamSize(), value);
     }
 
     GERANES_HOT uint8_t readSaveRam(int addr) override
     {
-        uint8_t* ram = saveRamData();
+        const uint8_t* ram = saveRamView();
         if(ram == nullptr || saveRamSize() == 0) return 0;
         return ram[ramOffset6000(addr) % saveRamSize()];
     }
 
     GERANES_HOT void writeSaveRam(int addr, uint8_t value) override
     {
-        uint8_t* ram = saveRamData();
-        if(ram == nullptr || saveRamSize() == 0) return;
-        ram[ramOffset6000(addr) % saveRamSize()] = value;
+        if(saveRamView() == nullptr || saveRamSize() == 0) return;
+        writeSaveRamAt(ramOffset6000(addr) % saveRamSize(), value);
     }
 
     GERANES_HOT uint8_t readPrg(int addr) override
@@ -51,8 +51,8 @@ public:
         }
 
         if(addr >= 0x0800 && addr < 0x1000) {
-            if(saveRamData() != nullptr && saveRamSize() > 0) {
-                saveRamData()[(addr - 0x0800) & (saveRamSize() - 1)] = data;
+            if(saveRamView() != nullptr && saveRamSize() > 0) {
+                writeSaveRamAt((addr - 0x0800) & (saveRamSize() - 1), data);
             }
         }
     }
@@ -60,8 +60,8 @@ public:
     GERANES_HOT uint8_t readSaveRam(int addr) override
     {
         if(addr >= 0x0800 && addr < 0x1000) {
-            if(saveRamData() != nullptr && saveRamSize() > 0) {
-                return saveRamData()[(addr - 0x0800) & (saveRamSize() - 1)];
+            if(saveRamView() != nullptr && saveRamSize() > 0) {
+                return saveRamView()[(addr - 0x0800) & (saveRamSize() - 1)];
             }
         }
         return 0;
@@ -173,6 +173,19 @@ public:
         return m_src->readChr(addr);
     }
 
+    const uint8_t* prgData() override
+    {
+        // A database size larger than the dump would read past the source data.
+        if(m_prgSize > m_src->prgSize()) return nullptr;
+        return m_src->prgData();
+    }
+
+    const uint8_t* chrData() override
+    {
+        if(m_chrSize > m_src->chrSize()) return nullptr;
+        return m_src->chrData();
+    }
+
     std::string chip() override {
         return m_chip;
     }
@@ -63,6 +63,11 @@ public:
 
     virtual uint8_t readChr(int addr) = 0;
 
+    // Contiguous PRG/CHR-ROM bytes, or nullptr when the format can't expose them directly.
+    virtual const uint8_t* prgData() { return nullptr; }
+
+    virtual const uint8_t* chrData() { return nullptr; }
+
     virtual int saveRamSize() = 0;
     
     virtual bool foundInDatabase() { return false; }
@@ -89,6 +94,25 @@ public:
         return readChr((bank << log2(bs)) + (addr&(static_cast<int>(bs)-1)));
     }
 
+    // Pointer to the start of a PRG bank, or nullptr if the bank falls outside the PRG data.
+    template<BankSize bs>
+    GERANES_INLINE const uint8_t* prgBankData(int bank)
+    {
+        const uint8_t* data = prgData();
+        const int offset = bank << log2(bs);
+        if(data == nullptr || bank < 0 || offset + static_cast<int>(bs) > prgSize()) return nullptr;
+        return data + offset;
+    }
+
+    template<BankSize bs>
+    GERANES_INLINE const uint8_t* chrBankData(int bank)
+    {
+        const uint8_t* data = chrData();
+        const int offset = bank << log2(bs);
+        if(data == nullptr || bank < 0 || offset + static_cast<int>(bs) > chrSize()) return nullptr;
+        return data + offset;
+    }
+
     template<BankSize bs>
     GERANES_INLINE uint32_t numberOfPRGBanks()
     {
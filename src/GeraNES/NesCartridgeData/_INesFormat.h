@@ -203,6 +203,18 @@ public:
         return m_romFile.data(m_CHRStartIndex + addr);
     }
 
+    const uint8_t* prgData() override
+    {
+        if(!m_isValid) return nullptr;
+        return m_romFile.dataBytes().data() + m_PRGStartIndex;
+    }
+
+    const uint8_t* chrData() override
+    {
+        if(!m_isValid) return nullptr;
+        return m_romFile.dataBytes().data() + m_CHRStartIndex;
+    }
+
     int saveRamSize() override {
         if(isNes20()) {
             return decodeNes20RamSize((m_romFile.data(10) >> 4) & 0x0F);
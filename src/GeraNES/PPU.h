@@ -4,10 +4,13 @@
 
 #include "Settings.h"
 #include "Cartridge.h"
+#include "Profiler.h"
 
 #include "Serialization.h"
+#include "util/IndexedFramebuffer.h"
 
 #include <array>
+#include <cstring>
 #include <algorithm>
 #include <vector>
 
@@ -61,14 +64,28 @@ const uint8_t POWER_UP_PALETTE[] = {
     0x09, 0x01, 0x34, 0x03, 0x00, 0x04, 0x00, 0x14, 0x08, 0x3A, 0x00, 0x02, 0x00, 0x20, 0x2C, 0x08
 };
 
-class PPU
+// Spreads the 8 bits of a pattern byte into one byte per pixel, leftmost pixel in the
+// lowest byte, so a whole tile row of 4-bit palette indices decodes with four lookups.
+constexpr std::array<uint64_t, 256> makePixelSpreadTable()
 {
-public:
+    std::array<uint64_t, 256> table{};
+    for(int value = 0; value < 256; ++value) {
+        uint64_t spread = 0;
+        for(int pixel = 0; pixel < 8; ++pixel) {
+            if(value & (0x80 >> pixel)) spread |= uint64_t(1) << (pixel * 8);
+        }
+        table[value] = spread;
+    }
+    return table;
+}
 
-    static constexpr int SCREEN_WIDTH = 256;
-    static constexpr int SCREEN_HEIGHT = 240;
+inline constexpr std::array<uint64_t, 256> PIXEL_SPREAD_TABLE = makePixelSpreadTable();
 
-private:
+// Persisted PPU state, saved as one block (see SerializationBase::block). Fields are
+// grouped by size so the struct has no padding.
+struct PPUState
+{
+    static constexpr uint32_t LAYOUT_VERSION = 1;
 
     enum class SpriteHeight : uint8_t {
         H8 = 8,
@@ -85,29 +102,96 @@ private:
         X1000 = 0x1000
     };
 
-    struct Sprite {
-        uint8_t y;
-        uint8_t indexInPatternTable;
-        uint8_t attrib;
+    struct SpriteFetchEntry {
+        uint16_t tileIndex;
+        uint16_t patternAddress;
         uint8_t x;
+        uint8_t attr;
+        uint8_t lowByte;
+        uint8_t highByte;
+        uint8_t row;
+        bool sprite0;
+        bool valid;
+        uint8_t reserved;
+    };
+    struct SpriteRenderEntry {
+        uint16_t tileIndex;
+        uint16_t patternAddress;
+        uint8_t x;
+        uint8_t xCounter;
+        uint8_t attr;
+        uint8_t lowShift;
+        uint8_t highShift;
+        uint8_t row;
+        bool sprite0;
+        bool counting;
+        bool active;
+        bool valid;
     };
 
-    Settings& m_settings;
-    Cartridge& m_cartridge;
-
-    uint32_t m_framebuffer[SCREEN_WIDTH*SCREEN_HEIGHT];
-    std::array<uint32_t, 64> m_colorPalette = {};
-    std::array<uint32_t, 64> m_outputColorPalette = {};
+    struct DeferredPpuIoState {
+        uint16_t pendingDataLatchAddr = 0;
+        bool pendingDataLatchUpdate = false;
+        uint8_t pendingDataLatchDelay = 0;
+        bool deferredDataLatchArmPending = false;
+        bool deferredDataLatchStart = false;
+        uint8_t deferredDataLatchStartDelay = 0;
+        bool deferredVideoRamIncrementArmPending = false;
+        uint8_t deferredVideoRamIncrementDelay = 0;
+        uint8_t reserved = 0;
+    };
 
-    uint8_t m_currentPixelColorIndex;
+    // background temporary variables
+    uint64_t m_tileData;
 
     int m_scanline;
     int m_cycle;
 
+    int m_overflowBugCounter;
+
+    //Rendering position
+    int m_currentY;
+    int m_currentX;
+
+    int m_lastPPUSTATUSReadCycle; //record the cycle when ppustatus is read
+
+    //settings variables
+    int FRAME_NUMBER_OF_LINES;
+    int FRAME_VBLANK_START_LINE;
+    int FRAME_VBLANK_END_LINE;
+
+    int m_update_reg_v_delay;
+    int m_updateA12Delay;
+
+    GameDatabase::PpuModel m_vsPpuModel = GameDatabase::PpuModel::Ppu2C02;
+
     //PPUCTRL
-    VramAddressIncrement m_VRAMAddressIncrement;
     PatternTableAddress m_spritePatternTableAddress;
     PatternTableAddress m_backgroundPatternTableAddress;
+
+    //write/read internal regs
+    uint16_t m_reg_v;
+    uint16_t m_reg_t;
+
+    uint16_t m_tileAddr;
+    uint16_t m_bgPatternLowShift;
+    uint16_t m_bgPatternHighShift;
+    uint16_t m_bgAttribLowShift;
+    uint16_t m_bgAttribHighShift;
+
+    uint16_t m_firstSpriteFetchV;
+    uint16_t m_update_reg_v_value;
+    uint16_t m_busAddress;
+
+    SpriteFetchEntry m_spriteFetchEntries[8];
+    SpriteRenderEntry m_spriteRenderEntries[8];
+
+    DeferredPpuIoState m_deferredPpuIo;
+
+    uint8_t m_currentPixelColorIndex;
+
+    //PPUCTRL
+    VramAddressIncrement m_VRAMAddressIncrement;
     SpriteHeight m_spriteHeight;
     bool m_PPUSlave; // false = master true = slave
     bool m_NMIOnVBlank; //false = off on = true
@@ -142,28 +226,14 @@ private:
     uint8_t m_oamAddrN; //oam[N][M]
     uint8_t m_oamAddrM;
 
-    int m_overflowBugCounter;
     bool m_sprite0Added;
     bool m_corruptOamRow[32];
 
-    //Rendering position
-    int m_currentY;
-    int m_currentX;
-
     bool m_interruptFlag;
 
     bool m_oddFrameFlag;
 
-    /*
-    The NES has nametables 0 and 1 in the console, while nametables 2 and 3 are in the cartridge
-    when four-screen mirroring is used. They are declared here for simplification.
-    */
-    uint8_t m_nameTable[4][0x400]; //4x 1KB
-
     uint8_t m_palette[0x20]; //32 Bytes
-    uint32_t m_debugChrGeneration = 0;
-    uint32_t m_debugNametableGeneration = 0;
-    uint32_t m_debugPaletteGeneration = 0;
 
     uint8_t m_primaryOam[0x100]; //256 bytes
 
@@ -171,70 +241,88 @@ private:
 
     uint8_t m_spritesIndexesInThisLine[64];
 
-    struct SpriteFetchEntry {
-        uint8_t x;
-        uint8_t attr;
-        uint8_t lowByte;
-        uint8_t highByte;
-        uint16_t tileIndex;
-        uint16_t patternAddress;
-        uint8_t row;
-        bool sprite0;
-        bool valid;
-    };
-    struct SpriteRenderEntry {
-        uint8_t x;
-        uint8_t xCounter;
-        uint8_t attr;
-        uint8_t lowShift;
-        uint8_t highShift;
-        uint16_t tileIndex;
-        uint16_t patternAddress;
-        uint8_t row;
-        bool sprite0;
-        bool counting;
-        bool active;
-        bool valid;
-    };
-    SpriteFetchEntry m_spriteFetchEntries[8];
-    SpriteRenderEntry m_spriteRenderEntries[8];
     uint8_t m_spriteFetchCount;
 
     //write/read internal regs
-    uint16_t m_reg_v;
     uint8_t m_reg_x;
-    uint16_t m_reg_t;
     bool m_reg_w;
 
-    struct DeferredPpuIoState {
-        bool pendingDataLatchUpdate = false;
-        uint8_t pendingDataLatchDelay = 0;
-        uint16_t pendingDataLatchAddr = 0;
-        bool deferredDataLatchArmPending = false;
-        bool deferredDataLatchStart = false;
-        uint8_t deferredDataLatchStartDelay = 0;
-        bool deferredVideoRamIncrementArmPending = false;
-        uint8_t deferredVideoRamIncrementDelay = 0;
-    };
-
     uint8_t m_dataLatch;
-    DeferredPpuIoState m_deferredPpuIo;
-
-    int m_debugCursorX = 0;
-    int m_debugCursorY = 0;
 
     // background temporary variables
-    uint16_t m_tileAddr;
     uint8_t m_paletteOffset;
     uint8_t m_lowTileByte;
     uint8_t m_highTileByte;
-    uint16_t m_bgPatternLowShift;
-    uint16_t m_bgPatternHighShift;
-    uint16_t m_bgAttribLowShift;
-    uint16_t m_bgAttribHighShift;
     bool m_bgAttribLowLatch;
     bool m_bgAttribHighLatch;
-    uint64_t m_tileData;
+
+    uint8_t m_openBus;
+    uint8_t m_openBusTimer[8]; //1 timer for each bit, decay 1 time per frame
+
+    bool m_inOverclockLines;
+
+    bool m_preLine;
+    bool m_visibleLine;
+    bool m_renderLine;
+
+    bool m_overclockFrame;
+
+    bool m_needUpdateState;
+    bool m_needIncVideoRam;
+
+    bool m_prevCycleRenderingEnabled;
+    bool m_spriteRenderClockingActiveThisLine;
+    bool m_staleBgShiftActive;
+
+    uint8_t m_busAddressLowLatch;
+    bool m_isSpritePatternFetch;
+    bool m_currentReadAffectsBus;
+
+    // Explicit tail so the block has no compiler padding.
+    uint8_t m_reserved[4] = {};
+};
+
+class PPU : private PPUState
+{
+public:
+
+    static constexpr int SCREEN_WIDTH = 256;
+    static constexpr int SCREEN_HEIGHT = 240;
+
+private:
+
+    struct Sprite {
+        uint8_t y;
+        uint8_t indexInPatternTable;
+        uint8_t attrib;
+        uint8_t x;
+    };
+
+    Settings& m_settings;
+    Cartridge& m_cartridge;
+
+    /*
+    The NES has nametables 0 and 1 in the console, while nametables 2 and 3 are in the cartridge
+    when four-screen mirroring is used. They are declared here for simplification.
+    Saved after PPUState so incremental states only carry the pages written.
+    */
+    uint8_t m_nameTable[4][0x400]; //4x 1KB
+    DirtyPages m_nameTablePages{sizeof(m_nameTable)};
+
+    // Stale while the indexed framebuffer is enabled; getFramebuffer() converts into it.
+    mutable uint32_t m_framebuffer[SCREEN_WIDTH*SCREEN_HEIGHT];
+    uint16_t m_indexedFramebuffer[SCREEN_WIDTH*SCREEN_HEIGHT];
+    bool m_indexedFramebufferEnabled = false;
+    uint16_t m_indexedPixelBase = 0;
+    std::array<uint32_t, 64> m_colorPalette = {};
+    std::array<uint32_t, 64> m_outputColorPalette = {};
+
+    uint32_t m_debugChrGeneration = 0;
+    uint32_t m_debugNametableGeneration = 0;
+    uint32_t m_debugPaletteGeneration = 0;
+
+    int m_debugCursorX = 0;
+    int m_debugCursorY = 0;
 
 public:
     struct DebugModBackgroundPixel {
@@ -290,6 +378,7 @@ private:
     };
 
     bool m_debugModRenderCaptureEnabled = false;
+    bool m_scanlineFastPathEnabled = true;
     std::vector<DebugModBackgroundPixel> m_debugModBackgroundPixels;
     std::vector<DebugModSpritePixel> m_debugModSpritePixels;
     std::vector<DebugModBackgroundPixel> m_debugModPresentedBackgroundPixels;
@@ -300,42 +389,6 @@ private:
     std::array<int, SCREEN_HEIGHT> m_debugModPresentedScanlineScrollY = {};
     std::array<DebugModBackgroundShiftPixel, 16> m_debugModBackgroundShift = {};
 
-    int m_lastPPUSTATUSReadCycle; //record the cycle when ppustatus is read
-
-    uint8_t m_openBus;
-    uint8_t m_openBusTimer[8]; //1 timer for each bit, decay 1 time per frame
-
-    //settings variables
-    int FRAME_NUMBER_OF_LINES;
-    int FRAME_VBLANK_START_LINE;
-    int FRAME_VBLANK_END_LINE;
-    bool m_inOverclockLines;
-
-    bool m_preLine;
-    bool m_visibleLine;
-    bool m_renderLine;
-
-    bool m_overclockFrame;
-
-    bool m_needUpdateState;
-    bool m_needIncVideoRam;
-
-    bool m_prevCycleRenderingEnabled;
-    bool m_spriteRenderClockingActiveThisLine;
-    bool m_staleBgShiftActive;
-    uint16_t m_firstSpriteFetchV;
-
-    int m_update_reg_v_delay;
-    uint16_t m_update_reg_v_value;
-
-    uint16_t m_busAddress;
-    uint8_t m_busAddressLowLatch;
-    int m_updateA12Delay;
-    bool m_isSpritePatternFetch;
-    bool m_currentReadAffectsBus;
-
-    GameDatabase::PpuModel m_vsPpuModel = GameDatabase::PpuModel::Ppu2C02;
-
 
     //Do not serialize variables below
     bool m_cpuDmaReadInProgress;
@@ -371,12 +424,14 @@ private:
         }
     }
 
-    template<bool writeFlag, bool affectsTheBus, bool updateBusAddress = true>
+    // mapperHooks == false is the instantiation used while the cartridge declares no
+    // PPU-side hook capabilities; the mapper fetch hooks are compiled out entirely.
+    template<bool writeFlag, bool affectsTheBus, bool updateBusAddress = true, bool mapperHooks = true>
     GERANES_HOT auto readWritePpuMemory(uint16_t addr, uint8_t data = 0) -> std::conditional_t<writeFlag, void, uint8_t>
     {
         m_currentReadAffectsBus = affectsTheBus;
 
-        if constexpr(!writeFlag && affectsTheBus) {
+        if constexpr(!writeFlag && affectsTheBus && mapperHooks) {
             m_cartridge.onPpuRead(addr & 0x3FFF);
         }
 
@@ -387,7 +442,9 @@ private:
 
         if(addr < 0x2000)
         {
-            m_cartridge.setPpuFetchSource(m_isSpritePatternFetch);
+            if constexpr(mapperHooks) {
+                m_cartridge.setPpuFetchSource(m_isSpritePatternFetch);
+            }
             if constexpr(writeFlag) {
                 m_cartridge.writeChr(addr,data);
                 ++m_debugChrGeneration;
@@ -409,7 +466,7 @@ private:
                 ++m_debugNametableGeneration;
             }
             else {
-                uint8_t value = readNameTable(addrIndex, nameTableAddr);
+                uint8_t value = readNameTable<mapperHooks>(addrIndex, nameTableAddr);
                 commitPendingDataLatch(value);
                 return value;
             }
@@ -439,10 +496,11 @@ private:
         return readWritePpuMemory<false, true>(addr);
     }
 
+    template<bool mapperHooks = true>
     GERANES_INLINE uint8_t completePpuRead(uint16_t /*addr*/)
     {
         const uint16_t latchedAddr = static_cast<uint16_t>((m_busAddress & 0x3F00) | m_busAddressLowLatch);
-        return readWritePpuMemory<false, true, false>(latchedAddr);
+        return readWritePpuMemory<false, true, false, mapperHooks>(latchedAddr);
     }
 
     GERANES_INLINE void setupPpuReadAddress(uint16_t addr)
@@ -705,14 +763,16 @@ private:
 
         int index = m_cartridge.mirroring(addrIndex&0x03);
         m_nameTable[index&3][addr&0x3FF] = data;
+        m_nameTablePages.mark(((index&3) << 10) | (addr&0x3FF));
     }
 
     //index 0-3
+    template<bool mapperHooks = true>
     GERANES_INLINE_HOT uint8_t readNameTable(uint8_t addrIndex, uint16_t addr)
     {
         uint8_t ret = 0;
 
-        if(m_cartridge.useCustomNameTable(addrIndex&0x03)) {
+        if(mapperHooks && m_cartridge.useCustomNameTable(addrIndex&0x03)) {
             ret = m_cartridge.readCustomNameTable(addrIndex&0x03,addr&0x3FF);
         }
         else {
@@ -720,7 +780,7 @@ private:
             ret = m_nameTable[index&3][addr&0x3FF];
         }
 
-        if(!m_currentReadAffectsBus) {
+        if(!mapperHooks || !m_currentReadAffectsBus) {
             return ret;
         }
 
@@ -742,6 +802,9 @@ public:
 
     PPU(Settings& settings, Cartridge& cartridge) : m_settings(settings), m_cartridge(cartridge)
     {
+        // VRAM survives init() like on a console reset, but it is saved in every state, so
+        // it must not start out as whatever the allocator left there.
+        memset(m_nameTable, 0, sizeof(m_nameTable));
         std::copy(std::begin(NES_PALETTE), std::end(NES_PALETTE), m_colorPalette.begin());
         refreshOutputColorPalette();
         init();
@@ -1045,6 +1108,17 @@ public:
     }
 
 
+    // getInterruptFlag() as it would read with the CPU's queued dots already run. Only
+    // valid while those dots stay clear of the vblank edges (see cyclesUntilNextEvent()).
+    GERANES_INLINE bool getDeferredInterruptFlag()
+    {
+        // At least two dots separate any register access from the poll, and each dot
+        // either latches the NMI line or drops the flag once vblank is clear.
+        const bool ret = m_VBlankHasStarted && (m_interruptFlag || m_NMIOnVBlank);
+        m_interruptFlag = false;
+        return ret;
+    }
+
     GERANES_INLINE_HOT bool getInterruptFlag()
     {        
         if(m_interruptFlag)
@@ -1129,7 +1203,12 @@ public:
             value  = static_cast<uint8_t>(m_palette[m_currentPixelColorIndex]&0x3F);
         }
 
-        *m_pFrameBuffer = NESToRGBAColor(value);
+        if(m_indexedFramebufferEnabled) {
+            m_indexedFramebuffer[m_pFrameBuffer - m_framebuffer] = static_cast<uint16_t>(m_indexedPixelBase | value);
+        }
+        else {
+            *m_pFrameBuffer = NESToRGBAColor(value);
+        }
         m_pFrameBuffer++;
 
         if(++m_currentX == SCREEN_WIDTH){
@@ -2028,22 +2107,24 @@ yyy NN YYYYY XXXXX
         }
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void runBackgroundFetchPipeline()
     {
         shiftTileData();
 
         switch(m_cycle & 0x07) {
-            case 1: setupNameTableByte(); break;
-            case 2: fetchNameTableByte(); break;
-            case 3: setupAttributeTableByte(); break;
-            case 4: fetchAttributeTableByte(); break;
-            case 5: setupLowTileByte(); break;
-            case 6: fetchLowTileByte(); break;
-            case 7: setupHighTileByte(); break;
-            case 0: fetchHighTileByte(); storeTileData(); incrementVX(); break;
+            case 1: setupNameTableByte<mapperHooks>(); break;
+            case 2: fetchNameTableByte<mapperHooks>(); break;
+            case 3: setupAttributeTableByte<mapperHooks>(); break;
+            case 4: fetchAttributeTableByte<mapperHooks>(); break;
+            case 5: setupLowTileByte<mapperHooks>(); break;
+            case 6: fetchLowTileByte<mapperHooks>(); break;
+            case 7: setupHighTileByte<mapperHooks>(); break;
+            case 0: fetchHighTileByte<mapperHooks>(); storeTileData(); incrementVX(); break;
         }
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void runRenderLineFetches()
     {
         switch(m_cycle) {
@@ -2055,19 +2136,19 @@ yyy NN YYYYY XXXXX
                 copyVX();
                 break;
             case 337:
-                setupNameTableByte();
+                setupNameTableByte<mapperHooks>();
                 break;
             case 338:
-                fetchNameTableByte();
+                fetchNameTableByte<mapperHooks>();
                 break;
             case 339:
-                setupNameTableByte();
+                setupNameTableByte<mapperHooks>();
                 break;
             case 340:
-                fetchNameTableByte();
+                fetchNameTableByte<mapperHooks>();
                 break;
             case 0:
-                setupLowTileByte();
+                setupLowTileByte<mapperHooks>();
                 break;
         }
     }
@@ -2082,6 +2163,7 @@ yyy NN YYYYY XXXXX
         }
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE_HOT void ppuCycleVisibleLine(bool renderingEnabled, bool prevCycleRenderingEnabled)
     {
         const unsigned cycle = static_cast<unsigned>(m_cycle);
@@ -2105,15 +2187,15 @@ yyy NN YYYYY XXXXX
 
         if(prevCycleRenderingEnabled) {
             if(bgFetchCycles) {
-                runBackgroundFetchPipeline();
+                runBackgroundFetchPipeline<mapperHooks>();
             }
 
-            runRenderLineFetches();
+            runRenderLineFetches<mapperHooks>();
 
             if(spriteFetchCycles) {
                 // OAMADDR is forced to zero during sprite tile loading when rendering.
                 m_oamAddr = 0;
-                fetchSprites();
+                fetchSprites<mapperHooks>();
             }
 
             if(cycle == 339u) {
@@ -2128,6 +2210,7 @@ yyy NN YYYYY XXXXX
         }
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE_HOT void ppuCyclePreRenderLine(bool renderingEnabled, bool prevCycleRenderingEnabled)
     {
         const unsigned cycle = static_cast<unsigned>(m_cycle);
@@ -2137,15 +2220,15 @@ yyy NN YYYYY XXXXX
 
         if(prevCycleRenderingEnabled) {
             if(bgFetchCycles) {
-                runBackgroundFetchPipeline();
+                runBackgroundFetchPipeline<mapperHooks>();
             }
 
-            runRenderLineFetches();
+            runRenderLineFetches<mapperHooks>();
 
             if(spriteFetchCycles) {
                 // OAMADDR is forced to zero during sprite tile loading when rendering.
                 m_oamAddr = 0;
-                fetchSprites();
+                fetchSprites<mapperHooks>();
             }
 
             if(cycle == 339u) {
@@ -2153,7 +2236,7 @@ yyy NN YYYYY XXXXX
             }
         }
 
-        if(cycle <= 8u && renderingEnabled && m_oamAddr >= 0x08) {
+        if(cycle - 1u < 8u && renderingEnabled && m_oamAddr >= 0x08) {
             // If OAMADDR is not less than eight when rendering starts, the eight bytes
             // starting at OAMADDR & $F8 are copied to the first eight bytes of OAM.
             m_primaryOam[m_cycle - 1] = m_primaryOam[(m_oamAddr & 0xF8) + (m_cycle - 1)];
@@ -2183,21 +2266,24 @@ yyy NN YYYYY XXXXX
         }
     }
 
-    GERANES_HOT void ppuCycle()
-    {        
+    template<bool mapperHooks>
+    GERANES_INLINE_HOT void ppuCycleImpl()
+    {
         if(m_cycle == 0) onScanlineStart();
         const bool renderingEnabled = m_renderingEnabled;
         const bool prevCycleRenderingEnabled = m_prevCycleRenderingEnabled;
-        const bool renderLineWithPrevRendering = m_renderLine && prevCycleRenderingEnabled;
 
-        m_cartridge.onPpuCycle(m_scanline, m_cycle, renderLineWithPrevRendering, m_preLine);
+        if constexpr(mapperHooks) {
+            const bool renderLineWithPrevRendering = m_renderLine && prevCycleRenderingEnabled;
+            m_cartridge.onPpuCycle(m_scanline, m_cycle, renderLineWithPrevRendering, m_preLine);
+        }
         updateInterruptState();
 
         if(m_visibleLine) {
-            ppuCycleVisibleLine(renderingEnabled, prevCycleRenderingEnabled);
+            ppuCycleVisibleLine<mapperHooks>(renderingEnabled, prevCycleRenderingEnabled);
         }
         else if(m_preLine) {
-            ppuCyclePreRenderLine(renderingEnabled, prevCycleRenderingEnabled);
+            ppuCyclePreRenderLine<mapperHooks>(renderingEnabled, prevCycleRenderingEnabled);
         }
         else if(m_scanline == FRAME_VBLANK_START_LINE) {
             ppuCycleVBlankStartLine();
@@ -2216,6 +2302,241 @@ yyy NN YYYYY XXXXX
         if(m_needUpdateState) updateState();
     }
 
+    GERANES_HOT void ppuCycle()
+    {
+        GERANES_PROFILE_SAMPLED_SCOPE(PpuDots);
+
+        // Most boards never look at the PPU between bus accesses, so they get the
+        // instantiation without per-dot and per-fetch mapper hooks.
+        if(m_cartridge.hasPpuDotHooks()) {
+            ppuCycleImpl<true>();
+        }
+        else {
+            ppuCycleImpl<false>();
+        }
+    }
+
+    // Batched dots for the CPU's catch-up mode.
+    GERANES_HOT void runCycles(int cycles)
+    {
+        // A batch spans anything from one dot to whole scanlines, so every call is timed
+        // rather than sampled, and kept apart from the single-dot average.
+        GERANES_PROFILE_SCOPE(PpuBatches);
+
+        if(m_cartridge.hasPpuDotHooks()) {
+            while(cycles-- > 0) ppuCycleImpl<true>();
+            return;
+        }
+
+        while(cycles > 0) {
+            if(m_cycle == 1 && cycles >= SCREEN_WIDTH && canRenderScanlineFast()) {
+                renderScanlineFast();
+                cycles -= SCREEN_WIDTH;
+            }
+            else {
+                ppuCycleImpl<false>();
+                --cycles;
+            }
+        }
+    }
+
+    // Disabling the scanline fast path forces the dot-by-dot renderer everywhere; the
+    // differential tests run both and compare every framebuffer.
+    void setScanlineFastPathEnabled(bool enabled)
+    {
+        m_scanlineFastPathEnabled = enabled;
+    }
+
+    bool scanlineFastPathEnabled() const
+    {
+        return m_scanlineFastPathEnabled;
+    }
+
+    // Dots 1-256 of a visible line can be rendered in one pass when the whole span sits
+    // inside a catch-up batch: no register access, bank switch or A12 watcher can then
+    // act mid-line, and the only per-dot state left is what renderScanlineFast() replays.
+    GERANES_INLINE bool canRenderScanlineFast() const
+    {
+        return m_scanlineFastPathEnabled &&
+               m_visibleLine &&
+               m_currentX == 0 &&
+               m_renderingEnabled && m_prevCycleRenderingEnabled &&
+               (m_backgroundEnabled || m_spritesEnabled) &&
+               !m_VBlankHasStarted && !m_interruptFlag &&
+               m_update_reg_v_delay <= 0 &&
+               !hasPendingPpuDataReadUpdate() &&
+               !m_debugModRenderCaptureEnabled &&
+               !m_settings.spriteLimitDisabled() &&
+               m_cartridge.allowsPpuCatchUp();
+    }
+
+    // Same result as 256 calls to ppuCycleImpl<false>() from dot 1: the sprite layer is
+    // composed from this line's renderers up front, background rows are decoded a tile
+    // at a time from the shifters, and the palette goes through a 32-entry RGBA table.
+    // Background fetches, sprite evaluation and the renderer clocks use the per-dot code.
+    GERANES_HOT void renderScanlineFast()
+    {
+        // bits 0-4: sprite palette index, bit 5: behind background, bit 6: sprite 0
+        std::array<uint8_t, SCREEN_WIDTH> spriteLayer{};
+
+        if(m_spritesEnabled) {
+            bool spriteLimitDisabled = false;
+            int maxSprites = 0;
+            const int renderedSpriteLimit = getSpriteRenderLimit(spriteLimitDisabled, maxSprites);
+            const int firstVisibleX = m_showSpritesLeftmost8Pixels ? 0 : 8;
+
+            // Lower entries win, so paint them last.
+            for(int i = renderedSpriteLimit - 1; i >= 0; --i) {
+                const SpriteRenderEntry& sprite = m_spriteRenderEntries[i];
+                if(!sprite.active) {
+                    continue;
+                }
+
+                const int startX = sprite.counting ? std::max<int>(sprite.xCounter, 1) : 0;
+                const uint8_t flags = static_cast<uint8_t>(0x10 | ((sprite.attr & 0x03) << 2) |
+                                                           ((sprite.attr & 0x20) ? 0x20 : 0x00) |
+                                                           (sprite.sprite0 ? 0x40 : 0x00));
+
+                for(int j = 0; j < 8 && startX + j < SCREEN_WIDTH; ++j) {
+                    if(startX + j < firstVisibleX) {
+                        continue;
+                    }
+                    const int color = ((sprite.lowShift >> (7 - j)) & 0x01) |
+                                      (((sprite.highShift >> (7 - j)) & 0x01) << 1);
+                    if(color != 0) {
+                        spriteLayer[startX + j] = static_cast<uint8_t>(flags | color);
+                    }
+                }
+            }
+        }
+
+        std::array<uint8_t, SCREEN_WIDTH> lineIndices;
+
+        for(int tile = 0; tile < SCREEN_WIDTH / 8; ++tile) {
+            uint64_t bgPixels = 0;
+            if(m_backgroundEnabled && (tile != 0 || m_showBackgroundLeftmost8Pixels)) {
+                const int shift = 8 - m_reg_x;
+                bgPixels = PIXEL_SPREAD_TABLE[(m_bgPatternLowShift >> shift) & 0xFF] |
+                           (PIXEL_SPREAD_TABLE[(m_bgPatternHighShift >> shift) & 0xFF] << 1) |
+                           (PIXEL_SPREAD_TABLE[(m_bgAttribLowShift >> shift) & 0xFF] << 2) |
+                           (PIXEL_SPREAD_TABLE[(m_bgAttribHighShift >> shift) & 0xFF] << 3);
+            }
+
+            const int tileX = tile << 3;
+            for(int k = 0; k < 8; ++k) {
+                uint8_t index = static_cast<uint8_t>((bgPixels >> (k << 3)) & 0x0F);
+
+                if(const uint8_t sprite = spriteLayer[tileX + k]; sprite != 0) {
+                    if((sprite & 0x40) && m_backgroundEnabled && (index & 0x03) != 0 && tileX + k != 255) {
+                        m_sprite0Hit = true;
+                    }
+                    if((index & 0x03) == 0 || !(sprite & 0x20)) {
+                        index = static_cast<uint8_t>(sprite & 0x1F);
+                    }
+                }
+
+                if((index & 0x03) == 0) index = 0;
+                lineIndices[tileX + k] = index;
+            }
+
+            setupNameTableByte<false>();
+            fetchNameTableByte<false>();
+            setupAttributeTableByte<false>();
+            fetchAttributeTableByte<false>();
+            setupLowTileByte<false>();
+            fetchLowTileByte<false>();
+            setupHighTileByte<false>();
+            fetchHighTileByte<false>();
+
+            // Eight shiftTileData() calls; the ones shifted into the high plane are
+            // replaced by storeTileData() before anything reads them.
+            m_bgPatternLowShift = static_cast<uint16_t>(m_bgPatternLowShift << 8);
+            m_bgPatternHighShift = static_cast<uint16_t>((m_bgPatternHighShift << 8) | 0xFF);
+            m_bgAttribLowShift = static_cast<uint16_t>(m_bgAttribLowShift << 8);
+            m_bgAttribHighShift = static_cast<uint16_t>(m_bgAttribHighShift << 8);
+            storeTileData();
+            incrementVX();
+        }
+
+        incrementVY();
+
+        if(m_indexedFramebufferEnabled) {
+            uint16_t paletteKeys[0x20];
+            for(int i = 0; i < 0x20; ++i) {
+                paletteKeys[i] = static_cast<uint16_t>(m_indexedPixelBase | (m_palette[i] & 0x3F));
+            }
+            uint16_t* line = &m_indexedFramebuffer[m_pFrameBuffer - m_framebuffer];
+            for(int x = 0; x < SCREEN_WIDTH; ++x) {
+                line[x] = paletteKeys[lineIndices[x]];
+            }
+        }
+        else {
+            uint32_t paletteColors[0x20];
+            for(int i = 0; i < 0x20; ++i) {
+                paletteColors[i] = NESToRGBAColor(static_cast<uint8_t>(m_palette[i] & 0x3F));
+            }
+            for(int x = 0; x < SCREEN_WIDTH; ++x) {
+                m_pFrameBuffer[x] = paletteColors[lineIndices[x]];
+            }
+        }
+
+        for(int i = 0; i < 8; i++) {
+            SpriteRenderEntry& sprite = m_spriteRenderEntries[i];
+            if(!sprite.active) {
+                continue;
+            }
+
+            int shifts = SCREEN_WIDTH;
+            if(sprite.counting) {
+                shifts -= std::max<int>(sprite.xCounter, 1);
+                sprite.xCounter = 0;
+                sprite.counting = false;
+            }
+            sprite.lowShift = shifts >= 8 ? 0 : static_cast<uint8_t>(sprite.lowShift << shifts);
+            sprite.highShift = shifts >= 8 ? 0 : static_cast<uint8_t>(sprite.highShift << shifts);
+        }
+
+        // Evaluation only touches OAM state, so it can trail the pixels.
+        for(m_cycle = 1; m_cycle <= SCREEN_WIDTH; ++m_cycle) {
+            evaluateSprites();
+        }
+
+        m_currentPixelColorIndex = lineIndices[SCREEN_WIDTH - 1];
+        m_pFrameBuffer += SCREEN_WIDTH;
+        if(++m_currentY == SCREEN_HEIGHT) {
+            m_currentY = 0;
+            m_pFrameBuffer = &m_framebuffer[0];
+        }
+
+        // The last bus address change was at dot 255; its A12 delay has run out by now.
+        m_updateA12Delay = 0;
+        m_needUpdateState = false;
+    }
+
+    // Dots that can run before the next one whose effect is seen outside the PPU without
+    // a register access: frame start/ready signals, the vblank flag edges feeding NMI and
+    // the odd-frame dot skip (kept as a boundary so the distance stays exact).
+    int cyclesUntilNextEvent() const
+    {
+        const int frameCycles = FRAME_NUMBER_OF_LINES * 341;
+        const int position = m_scanline * 341 + m_cycle;
+        const int events[] = {
+            0,
+            241 * 341,
+            FRAME_VBLANK_START_LINE * 341 + VBLANK_CYCLE,
+            FRAME_VBLANK_END_LINE * 341 + VBLANK_CYCLE,
+            FRAME_VBLANK_END_LINE * 341 + 339
+        };
+
+        int ret = frameCycles;
+        for(const int event : events) {
+            int distance = event - position;
+            if(distance < 0) distance += frameCycles;
+            ret = std::min(ret, distance);
+        }
+        return ret;
+    }
+
     struct SpritePatternInfo {
         uint16_t tileIndex = 0xFFFF;
         uint8_t row = 0;
@@ -2290,9 +2611,10 @@ yyy NN YYYYY XXXXX
         }
     }
 
+    template<bool mapperHooks>
     void fetchSprites() {
         // Mapper hooks must classify sprite-cycle PPU reads as sprite-source.
-        setPpuFetchSourceCached(true);
+        setPpuFetchSourceCached<mapperHooks>(true);
 
         const int startCycle = 257;
         const int cycleOffset = m_cycle - startCycle;
@@ -2336,17 +2658,17 @@ yyy NN YYYYY XXXXX
                 break;
             case 1:
                 if(spriteIndex == 0) {
-                    completePpuRead(static_cast<uint16_t>(0x2000 | (m_firstSpriteFetchV & 0x0F00) | ((m_reg_v + 2) & 0x00FF)));
+                    completePpuRead<mapperHooks>(static_cast<uint16_t>(0x2000 | (m_firstSpriteFetchV & 0x0F00) | ((m_reg_v + 2) & 0x00FF)));
                 }
                 else {
-                    completePpuRead(nameTableAddr);
+                    completePpuRead<mapperHooks>(nameTableAddr);
                 }
                 break;
             case 2:
                 setupPpuReadAddress(nameTableAddr);
                 break;
             case 3:
-                completePpuRead(nameTableAddr);
+                completePpuRead<mapperHooks>(nameTableAddr);
                 break;
             case 4:
                 {
@@ -2362,7 +2684,7 @@ yyy NN YYYYY XXXXX
                 break;
             case 5:
                 {
-                    const uint8_t value = completePpuRead(getSpritePatternAddress(sprite, false));
+                    const uint8_t value = completePpuRead<mapperHooks>(getSpritePatternAddress(sprite, false));
                     entry.lowByte = (hasSpriteData && sprite.y != 0xFF) ? value : 0;
                 }
                 break;
@@ -2371,7 +2693,7 @@ yyy NN YYYYY XXXXX
                 break;
             case 7:
                 {
-                    const uint8_t value = completePpuRead(getSpritePatternAddress(sprite, true));
+                    const uint8_t value = completePpuRead<mapperHooks>(getSpritePatternAddress(sprite, true));
                     entry.highByte = (hasSpriteData && sprite.y != 0xFF) ? value : 0;
                     SpriteRenderEntry& renderEntry = m_spriteRenderEntries[spriteIndex];
                     if(hasSpriteData && sprite.y != 0xFF) {
@@ -2486,29 +2808,29 @@ yyy NN YYYYY XXXXX
         return colorIndex;
     }
 
-    GERANES_INLINE uint32_t getMonochromeColor(uint32_t color)
+    GERANES_INLINE uint32_t getMonochromeColor(uint32_t color) const
     {
         uint32_t temp = ( (color&0xFF) + ((color&0xFF00) >> 8) + ((color&0xFF0000) >> 16) ) / 3;
         return (color&0xFF000000) | (temp) | (temp<<8) | (temp<<16);
     }
 
-    GERANES_INLINE uint32_t getEmphasisColor(uint32_t color)
+    GERANES_INLINE uint32_t getEmphasisColor(uint32_t color, uint8_t emphasis) const
     {
         uint32_t r = color&0xFF;
         uint32_t g = (color&0xFF00) >> 8;
         uint32_t b = (color&0xFF0000) >> 16;
 
         if(m_settings.region() == Settings::Region::NTSC) {
-            if(m_colorEmphasis&0x01) r += 0x30;
-            if(m_colorEmphasis&0x02) g += 0x30;
+            if(emphasis&0x01) r += 0x30;
+            if(emphasis&0x02) g += 0x30;
         }
         else {
             //"Note that on the Dendy and PAL NES, the green and red bits swap meaning."
-            if(m_colorEmphasis&0x02) r += 0x30;
-            if(m_colorEmphasis&0x01) g += 0x30;
+            if(emphasis&0x02) r += 0x30;
+            if(emphasis&0x01) g += 0x30;
         }
         
-        if(m_colorEmphasis&0x04) b += 0x30;
+        if(emphasis&0x04) b += 0x30;
 
         if(r > 0xFF) r = 0xFF;
         if(g > 0xFF) g = 0xFF;
@@ -2517,31 +2839,70 @@ yyy NN YYYYY XXXXX
         return (color&0xFF000000) | (r) | (g<<8) | (b<<16);
     }
 
+    GERANES_INLINE uint32_t outputColor(uint8_t index, uint8_t emphasis, bool monochrome) const
+    {
+        index &= 0x3F;
+
+        switch(m_vsPpuModel) {
+        case GameDatabase::PpuModel::Ppu2C04A: index = VS_PALETTE_LUT_2C04_0001[index]; break;
+        case GameDatabase::PpuModel::Ppu2C04B: index = VS_PALETTE_LUT_2C04_0002[index]; break;
+        case GameDatabase::PpuModel::Ppu2C04C: index = VS_PALETTE_LUT_2C04_0003[index]; break;
+        case GameDatabase::PpuModel::Ppu2C04D: index = VS_PALETTE_LUT_2C04_0004[index]; break;
+        default:
+            break;
+        }
+
+        uint32_t color = m_colorPalette[index];
+
+        if(emphasis != 0) {
+            color = getEmphasisColor(color, emphasis);
+        }
+        if(monochrome) {
+            color = getMonochromeColor(color);
+        }
+
+        return color;
+    }
+
     GERANES_INLINE void refreshOutputColorPalette()
     {
         for(size_t i = 0; i < m_outputColorPalette.size(); ++i) {
-            uint8_t index = static_cast<uint8_t>(i);
-
-            switch(m_vsPpuModel) {
-            case GameDatabase::PpuModel::Ppu2C04A: index = VS_PALETTE_LUT_2C04_0001[index]; break;
-            case GameDatabase::PpuModel::Ppu2C04B: index = VS_PALETTE_LUT_2C04_0002[index]; break;
-            case GameDatabase::PpuModel::Ppu2C04C: index = VS_PALETTE_LUT_2C04_0003[index]; break;
-            case GameDatabase::PpuModel::Ppu2C04D: index = VS_PALETTE_LUT_2C04_0004[index]; break;
-            default:
-                break;
-            }
+            m_outputColorPalette[i] = outputColor(static_cast<uint8_t>(i), m_colorEmphasis, m_monochromeDisplay);
+        }
+        m_indexedPixelBase = makeIndexedPixelBase(m_colorEmphasis, m_monochromeDisplay);
+    }
 
-            uint32_t color = m_colorPalette[index];
+    GERANES_INLINE uint32_t indexedPixelColor(uint16_t pixel) const
+    {
+        return outputColor(static_cast<uint8_t>(pixel & 0x3F), static_cast<uint8_t>((pixel >> 6) & 0x07), (pixel & 0x200) != 0);
+    }
 
-            if(m_colorEmphasis != 0) {
-                color = getEmphasisColor(color);
-            }
-            if(m_monochromeDisplay) {
-                color = getMonochromeColor(color);
-            }
+    // RGBA colors for every indexed pixel key with the current palette, VS PPU model and
+    // region. Consumers rebuild it when presenting and convert into their own format.
+    void buildIndexedColorLut(IndexedColorLut& lut) const
+    {
+        for(int key = 0; key < INDEXED_PIXEL_KEYS; ++key) {
+            lut[static_cast<size_t>(key)] = indexedPixelColor(static_cast<uint16_t>(key));
+        }
+    }
 
-            m_outputColorPalette[i] = color;
+    // Keeps 16-bit palette indices (see IndexedFramebuffer.h) instead of RGBA pixels.
+    void setIndexedFramebufferEnabled(bool enabled)
+    {
+        if(m_indexedFramebufferEnabled && !enabled) {
+            convertIndexedFramebuffer();
         }
+        m_indexedFramebufferEnabled = enabled;
+    }
+
+    bool indexedFramebufferEnabled() const
+    {
+        return m_indexedFramebufferEnabled;
+    }
+
+    GERANES_INLINE const uint16_t* getIndexedFramebuffer() const
+    {
+        return m_indexedFramebuffer;
     }
 
     GERANES_INLINE_HOT uint32_t NESToRGBAColor(uint8_t index)
@@ -2905,10 +3266,21 @@ yyy NNYY YYYX XXXX
     GERANES_INLINE void clearFramebuffer()
     {
         fillFramebuffer(0xFF000000);
+        std::fill(std::begin(m_indexedFramebuffer), std::end(m_indexedFramebuffer), static_cast<uint16_t>(0x0F)); //black
+    }
+
+    void convertIndexedFramebuffer() const
+    {
+        IndexedColorLut lut;
+        buildIndexedColorLut(lut);
+        convertIndexedPixels(m_indexedFramebuffer, m_framebuffer, SCREEN_WIDTH*SCREEN_HEIGHT, lut.data());
     }
 
     GERANES_INLINE const uint32_t* getFramebuffer() const
     {
+        if(m_indexedFramebufferEnabled) {
+            convertIndexedFramebuffer();
+        }
         return m_framebuffer;
     }
 
@@ -2922,6 +3294,9 @@ yyy NNYY YYYX XXXX
         if(y > m_currentY) return 0;
         if(x > m_currentX) return 0;
 
+        if(m_indexedFramebufferEnabled) {
+            return indexedPixelColor(m_indexedFramebuffer[y * SCREEN_WIDTH + x]);
+        }
         return m_framebuffer[y * SCREEN_WIDTH + x];
     }
 
@@ -2982,11 +3357,14 @@ yyy NNYY YYYX XXXX
         m_reg_v = (m_reg_v & 0x841F) | (m_reg_t & 0x7BE0);
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void setPpuFetchSourceCached(bool spriteFetch)
     {
         if(m_isSpritePatternFetch != spriteFetch) {
             m_isSpritePatternFetch = spriteFetch;
-            m_cartridge.setPpuFetchSource(spriteFetch);
+            if constexpr(mapperHooks) {
+                m_cartridge.setPpuFetchSource(spriteFetch);
+            }
         }
     }
 
@@ -2995,16 +3373,18 @@ yyy NNYY YYYX XXXX
         return address;
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void setupNameTableByte() {
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
         setupPpuReadAddress(getNameTableAddr());
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void fetchNameTableByte() {
         // Background tile fetch source for mapper CHR/NT substitution.
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
         const uint16_t address = getNameTableAddr();
-        const uint8_t tileIndex = completePpuRead(address);
+        const uint8_t tileIndex = completePpuRead<mapperHooks>(address);
 
         const int fineY = (m_reg_v >> 12) & 7;
         const int table = static_cast<int>(m_backgroundPatternTableAddress);
@@ -3017,37 +3397,43 @@ yyy NNYY YYYX XXXX
         return address;
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void setupAttributeTableByte() {
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
         setupPpuReadAddress(getAttributeTableAddr());
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void fetchAttributeTableByte() {
         // Background tile fetch source for mapper CHR/NT substitution.
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
 
         const int address = getAttributeTableAddr();
         const int shift = ((m_reg_v >> 4) & 4) | (m_reg_v & 2);
-        m_paletteOffset = ((completePpuRead(address) >> shift) & 3) << 2;
+        m_paletteOffset = ((completePpuRead<mapperHooks>(address) >> shift) & 3) << 2;
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void fetchLowTileByte() {
-        setPpuFetchSourceCached(false);
-        m_lowTileByte = completePpuRead(m_tileAddr);        
+        setPpuFetchSourceCached<mapperHooks>(false);
+        m_lowTileByte = completePpuRead<mapperHooks>(m_tileAddr);        
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void setupLowTileByte() {
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
         setupPpuReadAddress(m_tileAddr);
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void fetchHighTileByte() {
-        setPpuFetchSourceCached(false);
-        m_highTileByte = completePpuRead(m_tileAddr + 8);        
+        setPpuFetchSourceCached<mapperHooks>(false);
+        m_highTileByte = completePpuRead<mapperHooks>(m_tileAddr + 8);        
     }
 
+    template<bool mapperHooks>
     GERANES_INLINE void setupHighTileByte() {
-        setPpuFetchSourceCached(false);
+        setPpuFetchSourceCached<mapperHooks>(false);
         setupPpuReadAddress(static_cast<uint16_t>(m_tileAddr + 8));
     }
 
@@ -3112,120 +3498,25 @@ yyy NNYY YYYX XXXX
         m_overclockFrame = state;
     }
 
+    void setDirtyEpoch(uint32_t epoch)
+    {
+        m_nameTablePages.setEpoch(epoch);
+    }
+
+    void markAllPagesDirty()
+    {
+        m_nameTablePages.markAll();
+    }
+
+    const DirtyPages& nameTablePages() const
+    {
+        return m_nameTablePages;
+    }
+
     void serialization(SerializationBase& s)
     {
-        SERIALIZEDATA(s, m_currentPixelColorIndex);
-        SERIALIZEDATA(s, m_scanline);
-        SERIALIZEDATA(s, m_cycle);
-
-        SERIALIZEDATA(s, m_VRAMAddressIncrement);
-        SERIALIZEDATA(s, m_spritePatternTableAddress);
-        SERIALIZEDATA(s, m_backgroundPatternTableAddress);
-        SERIALIZEDATA(s, m_spriteHeight);
-        SERIALIZEDATA(s, m_PPUSlave);
-        SERIALIZEDATA(s, m_NMIOnVBlank);
-
-        SERIALIZEDATA(s, m_monochromeDisplay);
-        SERIALIZEDATA(s, m_showBackgroundLeftmost8Pixels);
-        SERIALIZEDATA(s, m_showSpritesLeftmost8Pixels);
-        SERIALIZEDATA(s, m_backgroundEnabled);
-        SERIALIZEDATA(s, m_spritesEnabled);
-        SERIALIZEDATA(s, m_colorEmphasis);
-        SERIALIZEDATA(s, m_renderingEnabled);
-
-        SERIALIZEDATA(s, m_VBlankHasStarted);
-        SERIALIZEDATA(s, m_sprite0Hit);
-        SERIALIZEDATA(s, m_spriteOverflow);       
-
-        SERIALIZEDATA(s, m_spritesInThisLine);
-        SERIALIZEDATA(s, m_testSprite0HitInThisLine);
-
-        SERIALIZEDATA(s, m_oamAddr);
-        SERIALIZEDATA(s, m_oamCopyBuffer);
-        SERIALIZEDATA(s, m_oamCopyDone);
-        SERIALIZEDATA(s, m_secondaryOamAddr);
-        SERIALIZEDATA(s, m_spriteInRange);
-        SERIALIZEDATA(s, m_oamAddrN);
-        SERIALIZEDATA(s, m_oamAddrM);
-        SERIALIZEDATA(s, m_overflowBugCounter);
-        SERIALIZEDATA(s, m_sprite0Added);
-
-        SERIALIZEDATA(s, m_currentY);
-        SERIALIZEDATA(s, m_currentX);
-
-        SERIALIZEDATA(s, m_interruptFlag);
-
-        SERIALIZEDATA(s, m_oddFrameFlag);
-
-        s.array(reinterpret_cast<uint8_t*>(m_nameTable), 1, sizeof(m_nameTable)); //4 pages
-
-        s.array(m_palette, 1, sizeof(m_palette));
-        s.array(m_primaryOam, 1, sizeof(m_primaryOam));
-        s.array(m_secondaryOam, 1, sizeof(m_secondaryOam));
-        s.array(reinterpret_cast<uint8_t*>(m_spritesIndexesInThisLine), 1, sizeof(m_spritesIndexesInThisLine));
-        s.array(reinterpret_cast<uint8_t*>(m_corruptOamRow), 1, sizeof(m_corruptOamRow));
-        s.array(reinterpret_cast<uint8_t*>(m_spriteFetchEntries), 1, sizeof(m_spriteFetchEntries));
-        s.array(reinterpret_cast<uint8_t*>(m_spriteRenderEntries), 1, sizeof(m_spriteRenderEntries));
-        SERIALIZEDATA(s, m_spriteFetchCount);
-
-        SERIALIZEDATA(s, m_reg_v);
-        SERIALIZEDATA(s, m_reg_x);
-        SERIALIZEDATA(s, m_reg_t);
-        SERIALIZEDATA(s, m_reg_w);
-
-        SERIALIZEDATA(s, m_dataLatch);
-        SERIALIZEDATA(s, m_deferredPpuIo.pendingDataLatchUpdate);
-        SERIALIZEDATA(s, m_deferredPpuIo.pendingDataLatchDelay);
-        SERIALIZEDATA(s, m_deferredPpuIo.pendingDataLatchAddr);
-        SERIALIZEDATA(s, m_deferredPpuIo.deferredDataLatchArmPending);
-        SERIALIZEDATA(s, m_deferredPpuIo.deferredDataLatchStart);
-        SERIALIZEDATA(s, m_deferredPpuIo.deferredDataLatchStartDelay);
-        SERIALIZEDATA(s, m_deferredPpuIo.deferredVideoRamIncrementArmPending);
-        SERIALIZEDATA(s, m_deferredPpuIo.deferredVideoRamIncrementDelay);
-
-        SERIALIZEDATA(s, m_tileAddr);
-        SERIALIZEDATA(s, m_paletteOffset);
-        SERIALIZEDATA(s, m_lowTileByte);
-        SERIALIZEDATA(s, m_highTileByte);
-        SERIALIZEDATA(s, m_bgPatternLowShift);
-        SERIALIZEDATA(s, m_bgPatternHighShift);
-        SERIALIZEDATA(s, m_bgAttribLowShift);
-        SERIALIZEDATA(s, m_bgAttribHighShift);
-        SERIALIZEDATA(s, m_bgAttribLowLatch);
-        SERIALIZEDATA(s, m_bgAttribHighLatch);
-        SERIALIZEDATA(s, m_tileData);
-
-        SERIALIZEDATA(s, m_lastPPUSTATUSReadCycle);
-
-        SERIALIZEDATA(s, m_openBus);
-        s.array(m_openBusTimer, 1, 8);
-
-        SERIALIZEDATA(s, FRAME_NUMBER_OF_LINES);
-        SERIALIZEDATA(s, FRAME_VBLANK_START_LINE);
-        SERIALIZEDATA(s, FRAME_VBLANK_END_LINE);
-        SERIALIZEDATA(s, m_inOverclockLines);
-        SERIALIZEDATA(s, m_overclockFrame);
-        SERIALIZEDATA(s, m_preLine);
-        SERIALIZEDATA(s, m_visibleLine);
-        SERIALIZEDATA(s, m_renderLine);
-
-        SERIALIZEDATA(s, m_needUpdateState);
-        SERIALIZEDATA(s, m_needIncVideoRam);
-
-        SERIALIZEDATA(s, m_prevCycleRenderingEnabled);
-        SERIALIZEDATA(s, m_spriteRenderClockingActiveThisLine);
-        SERIALIZEDATA(s, m_staleBgShiftActive);
-        SERIALIZEDATA(s, m_firstSpriteFetchV);
-
-        SERIALIZEDATA(s, m_update_reg_v_delay);
-        SERIALIZEDATA(s, m_update_reg_v_value);
-
-        SERIALIZEDATA(s, m_busAddress);
-        SERIALIZEDATA(s, m_busAddressLowLatch);
-        SERIALIZEDATA(s, m_updateA12Delay);
-        SERIALIZEDATA(s, m_isSpritePatternFetch);
-        SERIALIZEDATA(s, m_currentReadAffectsBus);
-        SERIALIZEDATA(s, m_vsPpuModel);
+        s.block(static_cast<PPUState&>(*this));
+        s.pages(&m_nameTable[0][0], sizeof(m_nameTable), &m_nameTablePages);
 
         if(s.isReading()) {
             refreshOutputColorPalette();
@@ -3233,6 +3524,16 @@ yyy NNYY YYYX XXXX
         m_pFrameBuffer = &m_framebuffer[m_currentY*SCREEN_WIDTH+m_currentX];
     }
 
+    // Same result as a save/load through serialization(): the framebuffer is left alone.
+    void copyStateFrom(const PPU& source)
+    {
+        static_cast<PPUState&>(*this) = source;
+        std::memcpy(m_nameTable, source.m_nameTable, sizeof(m_nameTable));
+
+        refreshOutputColorPalette();
+        m_pFrameBuffer = &m_framebuffer[m_currentY*SCREEN_WIDTH+m_currentX];
+    }
+
 };
 
 } // namespace GeraNES
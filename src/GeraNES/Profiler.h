@@ -0,0 +1,434 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+
+#include "defines.h"
+
+#if defined(GERANES_PROFILING) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86))
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <x86intrin.h>
+    #endif
+    #define GERANES_PROFILING_TSC 1
+#endif
+
+namespace GeraNES {
+
+// Per-subsystem wall time, attributed at frame granularity. Instrumentation only exists
+// in builds configured with GERANES_PROFILING (CMake: GERANES_ENABLE_PROFILING); otherwise
+// the GERANES_PROFILE_* macros expand to nothing and every report stays empty.
+enum class ProfileSection : size_t {
+    Emulation,      // whole GeraNESEmu::_update call, CPU core included
+    PpuDots,        // single dots, sampled
+    PpuBatches,     // catch-up runs of dots, each timed
+    Apu,
+    MapperHooks,
+    AudioRender,
+    RewindCapture,
+    ModComposition, // runs in the emulation host after _update returns
+    Presentation,   // UI thread
+    Count
+};
+
+static constexpr size_t PROFILE_SECTION_COUNT = static_cast<size_t>(ProfileSection::Count);
+
+inline const char* profileSectionName(ProfileSection section)
+{
+    switch(section) {
+    case ProfileSection::Emulation: return "emulation";
+    case ProfileSection::PpuDots: return "ppuDots";
+    case ProfileSection::PpuBatches: return "ppuBatches";
+    case ProfileSection::Apu: return "apu";
+    case ProfileSection::MapperHooks: return "mapperHooks";
+    case ProfileSection::AudioRender: return "audioRender";
+    case ProfileSection::RewindCapture: return "rewindCapture";
+    case ProfileSection::ModComposition: return "modComposition";
+    case ProfileSection::Presentation: return "presentation";
+    case ProfileSection::Count: break;
+    }
+    return "unknown";
+}
+
+struct ProfileSectionStats
+{
+    uint64_t calls = 0;
+    double ms = 0.0;
+};
+
+struct ProfileReport
+{
+    uint64_t frames = 0;
+    double wallMs = 0.0;
+    std::array<ProfileSectionStats, PROFILE_SECTION_COUNT> sections = {};
+
+    const ProfileSectionStats& section(ProfileSection s) const
+    {
+        return sections[static_cast<size_t>(s)];
+    }
+
+    // Emulation time not claimed by any subsystem nested inside _update.
+    double cpuCoreMs() const
+    {
+        double nested = 0.0;
+        for(const ProfileSection s : {ProfileSection::PpuDots, ProfileSection::PpuBatches, ProfileSection::Apu, ProfileSection::MapperHooks,
+                                      ProfileSection::AudioRender, ProfileSection::RewindCapture}) {
+            nested += section(s).ms;
+        }
+        return std::max(0.0, section(ProfileSection::Emulation).ms - nested);
+    }
+
+    ProfileReport& operator+=(const ProfileReport& other)
+    {
+        frames += other.frames;
+        wallMs += other.wallMs;
+        for(size_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+            sections[i].calls += other.sections[i].calls;
+            sections[i].ms += other.sections[i].ms;
+        }
+        return *this;
+    }
+};
+
+class Profiler
+{
+public:
+    static constexpr size_t RECENT_FRAMES = 60;
+
+    // Hot-path scopes on the PPU/APU/mapper paths only time one call in this many and
+    // scale the result by the call count.
+    static constexpr uint64_t SAMPLE_INTERVAL = 64;
+
+    // Each section has a single writer thread, so relaxed load/store pairs are enough and
+    // keep the hot path free of locked instructions.
+    struct alignas(64) Counters
+    {
+        std::atomic<uint64_t> calls{0};
+        std::atomic<uint64_t> sampledCalls{0};
+        std::atomic<uint64_t> sampledTicks{0};
+
+        GERANES_INLINE static void add(std::atomic<uint64_t>& counter, uint64_t value)
+        {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+    };
+
+    static constexpr bool enabled()
+    {
+#if defined(GERANES_PROFILING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static Profiler& instance();
+
+    // Emulators whose frames are thrown away, such as run-ahead forks, emulate with
+    // profiling suspended on their thread, so the report keeps describing the emulator
+    // that is actually played.
+    GERANES_INLINE static bool suspended()
+    {
+        return s_suspendDepth > 0;
+    }
+
+    static void suspend()
+    {
+        ++s_suspendDepth;
+    }
+
+    static void resume()
+    {
+        --s_suspendDepth;
+    }
+
+    GERANES_INLINE static uint64_t ticks()
+    {
+#if defined(GERANES_PROFILING_TSC)
+        return static_cast<uint64_t>(__rdtsc());
+#else
+        return nowNs();
+#endif
+    }
+
+    GERANES_INLINE Counters& counters(ProfileSection section)
+    {
+        return m_counters[static_cast<size_t>(section)];
+    }
+
+    // Closes the current frame: folds the counters accumulated since the previous call
+    // into one frame entry. Called by the emulation thread after each completed frame.
+    void endFrame()
+    {
+        if(suspended()) return;
+
+        const uint64_t nowTicks = ticks();
+        const uint64_t now = nowNs();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if(!m_started) {
+            startLocked(nowTicks, now);
+            return;
+        }
+
+        ProfileReport frame;
+        frame.frames = 1;
+        frame.wallMs = static_cast<double>(now - m_lastFrameNs) / 1000000.0;
+        m_lastFrameNs = now;
+
+        const double msPerTick = msPerTickLocked(nowTicks, now);
+        for(size_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+            const Snapshot current = {
+                m_counters[i].calls.load(std::memory_order_relaxed),
+                m_counters[i].sampledCalls.load(std::memory_order_relaxed),
+                m_counters[i].sampledTicks.load(std::memory_order_relaxed)
+            };
+            Snapshot& previous = m_previous[i];
+            const uint64_t calls = current.calls - previous.calls;
+            const uint64_t sampledCalls = current.sampledCalls - previous.sampledCalls;
+            const uint64_t sampledTicks = netTicks(current.sampledTicks - previous.sampledTicks, sampledCalls);
+
+            double estimatedTicks = 0.0;
+            if(sampledCalls > 0) {
+                estimatedTicks = static_cast<double>(sampledTicks) * static_cast<double>(calls) / static_cast<double>(sampledCalls);
+            }
+            else if(calls > 0 && current.sampledCalls > 0) {
+                // Too few calls this frame to hit a sample; use the running average.
+                estimatedTicks = static_cast<double>(netTicks(current.sampledTicks, current.sampledCalls)) * static_cast<double>(calls) / static_cast<double>(current.sampledCalls);
+            }
+
+            frame.sections[i].calls = calls;
+            frame.sections[i].ms = estimatedTicks * msPerTick;
+            previous = current;
+        }
+
+        m_lastFrame = frame;
+        m_total += frame;
+        m_recent[m_recentNext] = frame;
+        m_recentNext = (m_recentNext + 1) % RECENT_FRAMES;
+        m_recentCount = std::min(m_recentCount + 1, RECENT_FRAMES);
+    }
+
+    ProfileReport frameReport() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_lastFrame;
+    }
+
+    // Sum of the last RECENT_FRAMES frames.
+    ProfileReport recentReport() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ProfileReport report;
+        for(size_t i = 0; i < m_recentCount; ++i) {
+            report += m_recent[i];
+        }
+        return report;
+    }
+
+    // Everything since the last reset().
+    ProfileReport totalReport() const
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_total;
+    }
+
+    // Counters keep running; the next frame is measured from this point.
+    void reset()
+    {
+        const uint64_t nowTicks = ticks();
+        const uint64_t now = nowNs();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastFrame = {};
+        m_total = {};
+        m_recent = {};
+        m_recentNext = 0;
+        m_recentCount = 0;
+        startLocked(nowTicks, now);
+    }
+
+private:
+    struct Snapshot
+    {
+        uint64_t calls = 0;
+        uint64_t sampledCalls = 0;
+        uint64_t sampledTicks = 0;
+    };
+
+    std::array<Counters, PROFILE_SECTION_COUNT> m_counters;
+
+    mutable std::mutex m_mutex;
+    bool m_started = false;
+    std::array<Snapshot, PROFILE_SECTION_COUNT> m_previous = {};
+    uint64_t m_lastFrameNs = 0;
+    uint64_t m_calibrationTicks = 0;
+    uint64_t m_calibrationNs = 0;
+    uint64_t m_scopeOverheadTicks = 0;
+    ProfileReport m_lastFrame;
+    ProfileReport m_total;
+    std::array<ProfileReport, RECENT_FRAMES> m_recent = {};
+    size_t m_recentNext = 0;
+    size_t m_recentCount = 0;
+
+    static Profiler s_instance;
+    static thread_local int s_suspendDepth;
+
+    static uint64_t nowNs()
+    {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    }
+
+    void startLocked(uint64_t nowTicks, uint64_t now)
+    {
+        for(size_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+            m_previous[i] = {
+                m_counters[i].calls.load(std::memory_order_relaxed),
+                m_counters[i].sampledCalls.load(std::memory_order_relaxed),
+                m_counters[i].sampledTicks.load(std::memory_order_relaxed)
+            };
+        }
+        m_lastFrameNs = now;
+        m_calibrationTicks = nowTicks;
+        m_calibrationNs = now;
+        m_scopeOverheadTicks = measureScopeOverhead();
+        m_started = true;
+    }
+
+    // Cost of the two timer reads an empty scope makes. For one-instruction mapper hooks it
+    // is most of what a sample measures, so it is taken off every sample.
+    static uint64_t measureScopeOverhead()
+    {
+        uint64_t best = ~uint64_t(0);
+        for(int i = 0; i < 1000; ++i) {
+            const uint64_t start = ticks();
+            best = std::min(best, ticks() - start);
+        }
+        return best;
+    }
+
+    uint64_t netTicks(uint64_t ticks, uint64_t samples) const
+    {
+        const uint64_t overhead = samples * m_scopeOverheadTicks;
+        return ticks > overhead ? ticks - overhead : 0;
+    }
+
+    // TSC ticks are calibrated against steady_clock over the whole session since the
+    // last reset, which converges quickly and needs no startup busy-wait.
+    double msPerTickLocked(uint64_t nowTicks, uint64_t now) const
+    {
+#if defined(GERANES_PROFILING_TSC)
+        const uint64_t elapsedTicks = nowTicks - m_calibrationTicks;
+        const uint64_t elapsedNs = now - m_calibrationNs;
+        if(elapsedTicks == 0 || elapsedNs == 0) return 0.0;
+        return static_cast<double>(elapsedNs) / static_cast<double>(elapsedTicks) / 1000000.0;
+#else
+        (void)nowTicks;
+        (void)now;
+        return 1.0 / 1000000.0;
+#endif
+    }
+};
+
+inline Profiler Profiler::s_instance;
+inline thread_local int Profiler::s_suspendDepth = 0;
+
+inline Profiler& Profiler::instance()
+{
+    return s_instance;
+}
+
+#if defined(GERANES_PROFILING)
+
+class ProfileScope
+{
+public:
+    GERANES_INLINE explicit ProfileScope(ProfileSection section)
+        : m_counters(Profiler::suspended() ? nullptr : &Profiler::instance().counters(section))
+    {
+        if(m_counters != nullptr) m_startedAt = Profiler::ticks();
+    }
+
+    GERANES_INLINE ~ProfileScope()
+    {
+        if(m_counters == nullptr) return;
+        const uint64_t elapsed = Profiler::ticks() - m_startedAt;
+        Profiler::Counters::add(m_counters->calls, 1);
+        Profiler::Counters::add(m_counters->sampledCalls, 1);
+        Profiler::Counters::add(m_counters->sampledTicks, elapsed);
+    }
+
+private:
+    Profiler::Counters* m_counters;
+    uint64_t m_startedAt = 0;
+};
+
+class ProfileSampledScope
+{
+public:
+    GERANES_INLINE explicit ProfileSampledScope(ProfileSection section)
+        : m_counters(Profiler::instance().counters(section))
+    {
+        if(Profiler::suspended()) return;
+        const uint64_t calls = m_counters.calls.load(std::memory_order_relaxed) + 1;
+        m_counters.calls.store(calls, std::memory_order_relaxed);
+        m_sampled = (calls % Profiler::SAMPLE_INTERVAL) == 0;
+        if(m_sampled) m_startedAt = Profiler::ticks();
+    }
+
+    GERANES_INLINE ~ProfileSampledScope()
+    {
+        if(!m_sampled) return;
+        const uint64_t elapsed = Profiler::ticks() - m_startedAt;
+        Profiler::Counters::add(m_counters.sampledCalls, 1);
+        Profiler::Counters::add(m_counters.sampledTicks, elapsed);
+    }
+
+private:
+    Profiler::Counters& m_counters;
+    uint64_t m_startedAt = 0;
+    bool m_sampled = false;
+};
+
+class ProfileSuspendScope
+{
+public:
+    explicit ProfileSuspendScope(bool suspend)
+        : m_suspended(suspend)
+    {
+        if(m_suspended) Profiler::suspend();
+    }
+
+    ~ProfileSuspendScope()
+    {
+        if(m_suspended) Profiler::resume();
+    }
+
+    ProfileSuspendScope(const ProfileSuspendScope&) = delete;
+    ProfileSuspendScope& operator=(const ProfileSuspendScope&) = delete;
+
+private:
+    bool m_suspended;
+};
+
+#define GERANES_PROFILE_JOIN_IMPL(a, b) a##b
+#define GERANES_PROFILE_JOIN(a, b) GERANES_PROFILE_JOIN_IMPL(a, b)
+#define GERANES_PROFILE_SCOPE(section) ::GeraNES::ProfileScope GERANES_PROFILE_JOIN(geranesProfileScope, __LINE__)(::GeraNES::ProfileSection::section)
+#define GERANES_PROFILE_SAMPLED_SCOPE(section) ::GeraNES::ProfileSampledScope GERANES_PROFILE_JOIN(geranesProfileScope, __LINE__)(::GeraNES::ProfileSection::section)
+#define GERANES_PROFILE_END_FRAME() ::GeraNES::Profiler::instance().endFrame()
+#define GERANES_PROFILE_SUSPEND_IF(condition) ::GeraNES::ProfileSuspendScope GERANES_PROFILE_JOIN(geranesProfileSuspend, __LINE__)(condition)
+#else
+#define GERANES_PROFILE_SCOPE(section) do { } while(false)
+#define GERANES_PROFILE_SAMPLED_SCOPE(section) do { } while(false)
+#define GERANES_PROFILE_END_FRAME() do { } while(false)
+#define GERANES_PROFILE_SUSPEND_IF(condition) do { } while(false)
+#endif
+
+} // namespace GeraNES
@@ -1,33 +1,391 @@
 #pragma once
 
+#include <array>
 #include <cstdint>
+#include <cstring>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+    #include <condition_variable>
+    #include <mutex>
+    #include <thread>
+    #define GERANES_REWIND_WORKER 1
+#endif
 
 #include "IRewindable.h"
+#include "Serialization.h"
 #include "util/CircularBuffer.h"
+#include "util/XorDeltaRle.h"
 
 namespace GeraNES {
 
+// Rewind snapshots live in one preallocated byte ring sized in megabytes. Each sampled
+// frame is stored with XorDeltaRle against the keyframe that opens its group, so any
+// frame decodes from two entries and whole groups are dropped when the ring wraps.
+//
+// Where threads are available the emulation thread only serializes into a capture slot;
+// a worker encodes and files the slots, and while rewinding it decodes the next frame
+// back before it is asked for. Builds without threads do the same work inline.
 class Rewind
 {
 private:
 
+    // Captured frames the worker may fall behind by before newFrame() waits for it.
+    static constexpr size_t MAX_PENDING_FRAMES = 4;
+
+    // Sampled frames per keyframe group. Deltas grow as RAM drifts from the keyframe, and
+    // a new keyframe costs a few times a delta, so one per second or two is the sweet spot.
+    static constexpr uint32_t KEYFRAME_INTERVAL = 60;
+
+    struct Entry
+    {
+        size_t offset = 0;
+        uint32_t size = 0;
+        uint32_t rawSize = 0;
+        uint64_t sequence = 0;
+        uint64_t keyframeSequence = 0;
+
+        bool isKeyframe() const { return sequence == keyframeSequence; }
+    };
+
     IRewindable& m_target;
     bool m_enabled = false;
-    double m_maxTime = 0.0;
+    size_t m_maxMemoryMB = 0;
     bool m_activeFlag = false;
-    double m_timer = 0.0;
     int m_FPSDivider = 1;
     int m_FPSAuxCounter = 0;
-    CircularBuffer<std::vector<uint8_t>>* m_buffer = nullptr;
 
-    void addState(const std::vector<uint8_t> data)
+    // Pages are only committed as the ring fills, so a large budget costs nothing up front.
+    std::unique_ptr<uint8_t[]> m_arena;
+    size_t m_arenaSize = 0;
+    size_t m_head = 0;
+    CircularBuffer<Entry> m_entries{4096, CircularBuffer<Entry>::GROW};
+    uint64_t m_nextSequence = 0;
+
+    // Raw bytes of the keyframe that new deltas are taken against; it always belongs to the
+    // newest group in the ring when m_keyframeValid is set.
+    std::vector<uint8_t> m_keyframe;
+    uint64_t m_keyframeSequence = 0;
+    bool m_keyframeValid = false;
+
+    // Reused between frames so capture and playback stop allocating once warmed up.
+    std::array<Serialize, MAX_PENDING_FRAMES> m_captureSlots;
+    size_t m_pendingHead = 0;
+    size_t m_pendingCount = 0;
+    std::vector<uint8_t> m_encoded;
+    std::vector<uint8_t> m_decoded;
+    uint64_t m_decodedSequence = 0;
+    bool m_decodedValid = false;
+    std::vector<uint8_t> m_decodedKeyframe;
+    uint64_t m_decodedKeyframeSequence = 0;
+    bool m_decodedKeyframeValid = false;
+    std::vector<uint8_t> m_prefetched;
+    uint64_t m_prefetchedSequence = 0;
+    bool m_prefetchedValid = false;
+
+#if defined(GERANES_REWIND_WORKER)
+    // Guards the arena, the entry ring, the pending slot counters and the prefetch buffer.
+    // Capture slots are owned by whichever side the counters say, so serializing and
+    // encoding happen outside it.
+    mutable std::mutex m_mutex;
+    std::condition_variable m_workerWake;
+    std::condition_variable m_workerProgress;
+    std::thread m_worker;
+    bool m_stopWorker = false;
+    bool m_prefetchRequested = false;
+#endif
+
+    bool active() const
+    {
+        return m_arena != nullptr;
+    }
+
+    void clearEntries()
+    {
+        m_entries.clear();
+        m_head = 0;
+        m_pendingHead = 0;
+        m_pendingCount = 0;
+        m_keyframeValid = false;
+        m_decodedValid = false;
+        m_decodedKeyframeValid = false;
+        m_prefetchedValid = false;
+    }
+
+    // Contiguous free bytes at m_head, wrapping to the start of the arena when the tail end
+    // is too short. Returns false when the oldest entry is in the way.
+    bool findSpace(size_t size, size_t& offset)
+    {
+        if(m_entries.empty()) {
+            m_head = 0;
+            offset = 0;
+            return size <= m_arenaSize;
+        }
+
+        const size_t tail = m_entries.peak().offset;
+        if(m_head > tail) {
+            if(m_arenaSize - m_head >= size) {
+                offset = m_head;
+                return true;
+            }
+            if(tail >= size) {
+                offset = 0;
+                return true;
+            }
+            return false;
+        }
+
+        if(tail - m_head >= size) {
+            offset = m_head;
+            return true;
+        }
+        return false;
+    }
+
+    // Drops the oldest group; its deltas cannot be decoded without the keyframe.
+    void evictOldestGroup()
+    {
+        const uint64_t droppedGroup = m_entries.peak().keyframeSequence;
+        while(!m_entries.empty() && m_entries.peak().keyframeSequence == droppedGroup) {
+            m_entries.read();
+        }
+        if(m_keyframeValid && m_keyframeSequence == droppedGroup) {
+            m_keyframeValid = false;
+        }
+        if(m_decodedKeyframeValid && m_decodedKeyframeSequence == droppedGroup) {
+            m_decodedKeyframeValid = false;
+        }
+    }
+
+    void encodeFrame(const std::vector<uint8_t>& raw, bool keyframe)
+    {
+        m_encoded.clear();
+        XorDeltaRle::encode(raw.data(), keyframe ? nullptr : m_keyframe.data(), raw.size(), m_encoded);
+    }
+
+    bool needsKeyframe(const std::vector<uint8_t>& raw) const
+    {
+        return !m_keyframeValid ||
+               m_entries.empty() ||
+               m_keyframe.size() != raw.size() ||
+               m_nextSequence - m_keyframeSequence >= KEYFRAME_INTERVAL;
+    }
+
+    // Files m_encoded, which holds raw encoded as a keyframe or as a delta against m_keyframe.
+    void fileEncoded(const std::vector<uint8_t>& raw, bool keyframe)
+    {
+        size_t offset = 0;
+        while(!findSpace(m_encoded.size(), offset)) {
+            if(m_entries.empty()) return; // a single state does not fit the budget
+
+            if(!keyframe && m_entries.peak().keyframeSequence == m_keyframeSequence) {
+                // Making room would drop this delta's own keyframe.
+                keyframe = true;
+                encodeFrame(raw, true);
+            }
+            evictOldestGroup();
+        }
+
+        Entry entry;
+        entry.offset = offset;
+        entry.size = static_cast<uint32_t>(m_encoded.size());
+        entry.rawSize = static_cast<uint32_t>(raw.size());
+        entry.sequence = m_nextSequence++;
+        entry.keyframeSequence = keyframe ? entry.sequence : m_keyframeSequence;
+
+        std::memcpy(m_arena.get() + offset, m_encoded.data(), m_encoded.size());
+        m_head = offset + m_encoded.size();
+        m_entries.write(entry);
+
+        if(keyframe) {
+            m_keyframe = raw;
+            m_keyframeSequence = entry.sequence;
+            m_keyframeValid = true;
+        }
+    }
+
+    bool decodeEntry(const Entry& entry, const uint8_t* reference, std::vector<uint8_t>& out) const
+    {
+        out.resize(entry.rawSize);
+        return XorDeltaRle::decode(m_arena.get() + entry.offset, entry.size, reference, out.data(), out.size());
+    }
+
+    // Entry i positions back from the newest one.
+    const Entry& entryFromBack(size_t i)
+    {
+        return m_entries.peakAt(m_entries.size() - 1 - i);
+    }
+
+    bool decodeNewest(std::vector<uint8_t>& out)
+    {
+        const Entry& newest = m_entries.peakBack();
+        if(newest.isKeyframe()) {
+            return decodeEntry(newest, nullptr, out);
+        }
+
+        if(!m_decodedKeyframeValid || m_decodedKeyframeSequence != newest.keyframeSequence) {
+            const size_t distance = static_cast<size_t>(newest.sequence - newest.keyframeSequence);
+            if(distance >= m_entries.size()) return false;
+            if(!decodeEntry(entryFromBack(distance), nullptr, m_decodedKeyframe)) return false;
+            m_decodedKeyframeSequence = newest.keyframeSequence;
+            m_decodedKeyframeValid = true;
+        }
+
+        return decodeEntry(newest, m_decodedKeyframe.data(), out);
+    }
+
+    // Removes the newest entry after rewinding past it. Sequence numbers are handed out
+    // again so each group stays contiguous, and captures resume against the keyframe of
+    // whatever group is now newest.
+    void popNewest()
+    {
+        const Entry popped = m_entries.readBack();
+        m_nextSequence = popped.sequence;
+        m_head = m_entries.empty() ? 0 : m_entries.peakBack().offset + m_entries.peakBack().size;
+        if(m_decodedSequence == popped.sequence) m_decodedValid = false;
+        if(m_prefetchedSequence == popped.sequence) m_prefetchedValid = false;
+
+        if(popped.isKeyframe() || m_entries.empty()) {
+            m_keyframeValid = false;
+            if(m_decodedKeyframeSequence == popped.keyframeSequence) {
+                m_decodedKeyframeValid = false;
+            }
+            return;
+        }
+
+        if(!m_keyframeValid || m_keyframeSequence != popped.keyframeSequence) {
+            if(m_decodedKeyframeValid && m_decodedKeyframeSequence == popped.keyframeSequence) {
+                m_keyframe = m_decodedKeyframe;
+                m_keyframeSequence = popped.keyframeSequence;
+                m_keyframeValid = true;
+            }
+            else {
+                m_keyframeValid = false;
+            }
+        }
+    }
+
+    // Emulation thread: takes the next free capture slot, waiting only when the worker is
+    // MAX_PENDING_FRAMES behind.
+    void capture()
+    {
+#if defined(GERANES_REWIND_WORKER)
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workerProgress.wait(lock, [this] { return m_pendingCount < MAX_PENDING_FRAMES; });
+        Serialize& slot = m_captureSlots[(m_pendingHead + m_pendingCount) % MAX_PENDING_FRAMES];
+        lock.unlock();
+
+        slot.clear();
+        m_target.serialization(slot);
+
+        lock.lock();
+        ++m_pendingCount;
+        lock.unlock();
+        m_workerWake.notify_one();
+#else
+        Serialize& slot = m_captureSlots[0];
+        slot.clear();
+        m_target.serialization(slot);
+        const bool keyframe = needsKeyframe(slot.getData());
+        encodeFrame(slot.getData(), keyframe);
+        fileEncoded(slot.getData(), keyframe);
+#endif
+    }
+
+    // Emulation thread, while rewinding: restores the newest frame and steps back over it.
+    void restore()
+    {
+#if defined(GERANES_REWIND_WORKER)
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workerProgress.wait(lock, [this] { return m_pendingCount == 0; });
+#endif
+        if(m_entries.empty()) return;
+
+        const Entry& newest = m_entries.peakBack();
+        const bool stepBack = m_entries.size() > 1 && update();
+        bool decoded = m_decodedValid && m_decodedSequence == newest.sequence;
+        if(!decoded && m_prefetchedValid && m_prefetchedSequence == newest.sequence) {
+            std::swap(m_decoded, m_prefetched);
+            m_prefetchedValid = false;
+            decoded = true;
+        }
+        if(!decoded) {
+            decoded = decodeNewest(m_decoded);
+        }
+        m_decodedSequence = newest.sequence;
+        m_decodedValid = decoded;
+
+        if(stepBack) {
+            popNewest();
+        }
+
+#if defined(GERANES_REWIND_WORKER)
+        // m_decoded belongs to this thread, so the worker can decode the next frame back
+        // while this one is being loaded.
+        if(stepBack) m_prefetchRequested = true;
+        lock.unlock();
+        if(stepBack) m_workerWake.notify_one();
+#endif
+
+        if(decoded) {
+            m_target.loadStateFromMemory(m_decoded);
+        }
+    }
+
+#if defined(GERANES_REWIND_WORKER)
+    void workerLoop()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        while(true) {
+            m_workerWake.wait(lock, [this] { return m_stopWorker || m_pendingCount > 0 || m_prefetchRequested; });
+            if(m_stopWorker) return;
+
+            if(m_pendingCount > 0) {
+                // m_keyframe only changes on this thread or while nothing is pending.
+                const std::vector<uint8_t>& raw = m_captureSlots[m_pendingHead].getData();
+                const bool keyframe = needsKeyframe(raw);
+                lock.unlock();
+                encodeFrame(raw, keyframe);
+                lock.lock();
+                fileEncoded(raw, keyframe);
+                m_pendingHead = (m_pendingHead + 1) % MAX_PENDING_FRAMES;
+                --m_pendingCount;
+                m_workerProgress.notify_all();
+                continue;
+            }
+
+            m_prefetchRequested = false;
+            if(!m_entries.empty()) {
+                m_prefetchedSequence = m_entries.peakBack().sequence;
+                m_prefetchedValid = decodeNewest(m_prefetched);
+            }
+        }
+    }
+
+    void startWorker()
     {
-        if(m_buffer != nullptr) m_buffer->write(data);
+        m_stopWorker = false;
+        m_worker = std::thread([this] { workerLoop(); });
     }
 
+    // Pending captures are dropped; every caller clears the ring right after.
+    void stopWorker()
+    {
+        if(!m_worker.joinable()) return;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopWorker = true;
+        }
+        m_workerWake.notify_one();
+        m_worker.join();
+    }
+#endif
+
 public:
 
-    Rewind(IRewindable& target) : m_target(target) {        
+    Rewind(IRewindable& target) : m_target(target) {
     }
 
     ~Rewind()
@@ -35,34 +393,35 @@ public:
         destroy();
     }
 
-    void setup(bool enabled, double maxTime, int _FPSDivider)
-    {   
-        m_enabled = enabled;
-        m_maxTime = maxTime;
+    void setup(bool enabled, size_t maxMemoryMB, int _FPSDivider)
+    {
+#if defined(GERANES_REWIND_WORKER)
+        stopWorker();
+#endif
+
+        m_enabled = enabled && maxMemoryMB > 0;
+        m_maxMemoryMB = maxMemoryMB;
         m_FPSDivider = _FPSDivider;
 
         m_FPSAuxCounter = m_FPSDivider;
 
-        if(m_buffer != nullptr) {
-            delete m_buffer;
-            m_buffer = nullptr;
+        const size_t arenaSize = m_enabled ? maxMemoryMB * 1024 * 1024 : 0;
+        if(arenaSize != m_arenaSize) {
+            m_arena.reset(arenaSize > 0 ? new uint8_t[arenaSize] : nullptr);
+            m_arenaSize = arenaSize;
         }
 
-        if(m_enabled) m_buffer = new CircularBuffer<std::vector<uint8_t>>(static_cast<size_t>((float)m_target.getFPS()/m_FPSDivider * m_maxTime),CircularBuffer<std::vector<uint8_t>>::REPLACE);
-
+        clearEntries();
         m_activeFlag = false;
-        m_timer = 0.0;
+
+#if defined(GERANES_REWIND_WORKER)
+        if(active()) startWorker();
+#endif
     }
 
     void reset()
     {
-        /*
-        m_activeFlag = false;
-        m_timer = 0.0;
-        m_FPSAuxCounter = m_FPSDivider;
-        if(m_buffer != nullptr) m_buffer->clear();
-        */
-       setup(m_enabled, m_maxTime, m_FPSDivider);
+       setup(m_enabled, m_maxMemoryMB, m_FPSDivider);
     }
 
     //return true when sample a frame
@@ -76,41 +435,34 @@ public:
         }
 
         return ret;
-    }      
+    }
 
     void destroy()
     {
+#if defined(GERANES_REWIND_WORKER)
+        stopWorker();
+#endif
         m_FPSAuxCounter = m_FPSDivider;
 
-        if(m_buffer != nullptr) {
-            delete m_buffer;
-            m_buffer = nullptr;
-        }
+        m_arena.reset();
+        m_arenaSize = 0;
+        clearEntries();
 
         m_enabled = false;
-        m_maxTime = 0.0;
+        m_maxMemoryMB = 0;
         m_activeFlag = false;
-        m_timer = 0.0;
     }
 
     void newFrame() {
 
-        if(m_buffer != nullptr && (!m_activeFlag || m_buffer->size() == 0) && update() ) {
-            Serialize s;
-            m_target.serialization(s);
-            addState(s.getData());
-        }
-
-        if(m_buffer != nullptr && m_activeFlag) {
+        if(!active()) return;
 
-            if(m_buffer->size() > 1 && update()) {
-                //load state from memory
-                m_target.loadStateFromMemory(m_buffer->readBack());
-            }
-            else {
-                m_target.loadStateFromMemory(m_buffer->peakBack());
-            }
+        if((!m_activeFlag || storedFrames() == 0) && update() ) {
+            capture();
+        }
 
+        if(m_activeFlag) {
+            restore();
         }
 
     }
@@ -122,22 +474,46 @@ public:
 
     bool isRewinding() const
     {
-        return m_buffer != nullptr && m_activeFlag;
+        return active() && m_activeFlag;
     }
 
     bool rewindLimit() {
 
         bool ret = false;
 
-        if(m_buffer == nullptr) ret = true;
+        if(!active()) ret = true;
         else {
             if(!m_activeFlag) ret = true;
-            else if(m_buffer->size() > 1) ret = true;
+            else if(storedFrames() > 1) ret = true;
         }
 
         return ret;
     }
 
+    // Sampled frames held, counting those still waiting for the worker.
+    size_t storedFrames() const
+    {
+#if defined(GERANES_REWIND_WORKER)
+        std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+        return m_entries.size() + m_pendingCount;
+    }
+
+    size_t bufferedFrames() const
+    {
+        return storedFrames() * static_cast<size_t>(m_FPSDivider);
+    }
+
+    size_t usedBytes() const
+    {
+#if defined(GERANES_REWIND_WORKER)
+        std::lock_guard<std::mutex> lock(m_mutex);
+#endif
+        if(m_entries.empty()) return 0;
+        const size_t tail = m_entries.peak().offset;
+        return m_head > tail ? m_head - tail : m_arenaSize - tail + m_head;
+    }
+
 };
 
 } // namespace GeraNES
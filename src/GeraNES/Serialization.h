@@ -3,22 +3,67 @@
 #include <cstdint>
 #include <cstring>
 
+#include <algorithm>
+#include <bit>
+#include <type_traits>
 #include <vector>
 #include <fstream>
 #include <utility>
 
 #include "util/map_util.h"
+#include "GeraNES/util/DirtyPages.h"
 
 #include <filesystem>
 namespace GeraNES {
 
 namespace fs = std::filesystem;
 
+// Hot components keep their persisted fields in one padding-free struct with a
+// LAYOUT_VERSION, so a state is a single copy instead of a virtual call per field. Bump
+// LAYOUT_VERSION when fields are reordered or retyped without changing the struct size.
+// Alignment is left out: a block has no padding, so its field offsets are the same on
+// ABIs that align 64-bit members differently.
+template<typename T>
+constexpr uint32_t stateBlockLayoutHash()
+{
+    const uint32_t words[] = {
+        static_cast<uint32_t>(sizeof(T)),
+        static_cast<uint32_t>(T::LAYOUT_VERSION),
+        static_cast<uint32_t>(std::endian::native == std::endian::little ? 1 : 0)
+    };
+
+    uint32_t hash = 2166136261u;
+    for(const uint32_t word : words) {
+        for(int shift = 0; shift < 32; shift += 8) {
+            hash = (hash ^ ((word >> shift) & 0xFF)) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+enum class StateComponent : uint8_t
+{
+    CPU,
+    RAM,
+    PPU,        // registers, OAM and palette
+    CIRAM,      // nametables
+    CHR_RAM,
+    SAVE_RAM,
+    APU,
+    MAPPER,
+    INPUT,      // settings, input devices and frame timing
+    COUNT
+};
+
+static constexpr size_t STATE_COMPONENT_COUNT = static_cast<size_t>(StateComponent::COUNT);
+
 class SerializationBase
 {
     private:
 
         bool _littleEndian;
+        bool _incremental = false;
+        uint32_t _incrementalBase = 0;
 
     public:
 
@@ -37,6 +82,30 @@ class SerializationBase
         virtual Mode mode() const = 0;
         virtual void single(uint8_t* pointer, size_t size) = 0;
 
+        // True when nothing is stored and only the byte count matters. Components whose
+        // payload size depends on their contents report their largest form here.
+        virtual bool measuring() const
+        {
+            return false;
+        }
+
+        // Marks a read as failed. Only Deserialize keeps it, as error(); it reads nothing more
+        // afterwards, so the components that follow keep their live state.
+        virtual void fail()
+        {
+        }
+
+        virtual bool failed() const
+        {
+            return false;
+        }
+
+        // GeraNESEmu::serialization() announces each top-level component before its bytes.
+        // Only writers that split a state by component (StateLayout, StateHashTree) use it.
+        virtual void beginComponent(StateComponent /*component*/)
+        {
+        }
+
         void array(uint8_t* pointer, size_t typeSize, size_t nelements)
         {
             if(nelements == 0 || typeSize == 0) return;
@@ -54,6 +123,94 @@ class SerializationBase
             }
         }
 
+        // Layout hash and size, then the struct bytes. Reading a block written with another
+        // layout fails the load and leaves the component as it was.
+        template<typename T>
+        void block(T& state)
+        {
+            static_assert(std::is_trivially_copyable_v<T>, "state blocks are copied as raw bytes");
+            static_assert(std::has_unique_object_representations_v<T>, "state blocks must not contain padding");
+
+            uint32_t layoutHash = stateBlockLayoutHash<T>();
+            uint32_t size = static_cast<uint32_t>(sizeof(T));
+            single(reinterpret_cast<uint8_t*>(&layoutHash), sizeof(layoutHash));
+            single(reinterpret_cast<uint8_t*>(&size), sizeof(size));
+
+            if(isReading() && (layoutHash != stateBlockLayoutHash<T>() || size != sizeof(T))) {
+                fail();
+                return;
+            }
+
+            uint8_t* bytes = reinterpret_cast<uint8_t*>(&state);
+            if(littleEndian()) {
+                single(bytes, sizeof(T));
+                return;
+            }
+
+            // Keep host byte order: single() would reverse a multi-byte run.
+            for(size_t i = 0; i < sizeof(T); ++i) {
+                single(bytes + i, 1);
+            }
+        }
+
+        // Incremental states store only the tracked pages written since baseEpoch (see
+        // pages()). Reading one needs the region to hold its content at that epoch.
+        void setIncremental(uint32_t baseEpoch)
+        {
+            _incremental = baseEpoch != 0;
+            _incrementalBase = baseEpoch;
+        }
+
+        bool incremental() const
+        {
+            return _incremental;
+        }
+
+        uint32_t incrementalBase() const
+        {
+            return _incrementalBase;
+        }
+
+        // A region with write tracking. Full states store it like array(); incremental ones
+        // store a mask byte per 8 pages followed by the dirty pages it selects. A null
+        // tracker means the writes are not tracked and every page is dirty.
+        virtual void pages(uint8_t* data, size_t size, const DirtyPages* dirty)
+        {
+            if(!_incremental) {
+                array(data, 1, size);
+                return;
+            }
+
+            const size_t pageCount = DirtyPages::pageCount(size);
+            for(size_t group = 0; group < pageCount; group += 8) {
+                const size_t groupEnd = std::min(pageCount, group + 8);
+
+                uint8_t mask = 0;
+                if(isWriting()) {
+                    for(size_t page = group; page < groupEnd; ++page) {
+                        if(dirty == nullptr || dirty->dirtySince(page, _incrementalBase)) {
+                            mask |= static_cast<uint8_t>(1u << (page - group));
+                        }
+                    }
+                }
+                single(&mask, 1);
+
+                // Consecutive dirty pages go out as one run.
+                size_t page = group;
+                while(page < groupEnd) {
+                    if((mask & (1u << (page - group))) == 0) {
+                        ++page;
+                        continue;
+                    }
+                    size_t runEnd = page + 1;
+                    while(runEnd < groupEnd && (mask & (1u << (runEnd - group))) != 0) ++runEnd;
+                    const size_t offset = page << DirtyPages::PAGE_SHIFT;
+                    array(data + offset, 1, std::min(size, runEnd << DirtyPages::PAGE_SHIFT) - offset);
+                    page = runEnd;
+                }
+            }
+        }
+
         bool littleEndian()
         {
             return _littleEndian;
@@ -88,9 +245,7 @@ class Serialize : public SerializationBase
             if(size == 0) return;
 
             if(littleEndian()) {
-                const size_t offset = _data.size();
-                _data.resize(offset + size);
-                std::memcpy(_data.data() + offset, pointer, size);
+                _data.insert(_data.end(), pointer, pointer + size);
                 return;
             }
 
@@ -137,6 +292,64 @@ class Serialize : public SerializationBase
 
 };
 
+// Writes straight into caller memory, for frontends that hand over their own state buffer.
+// Running out of room sets error() and drops the rest; size() is still the full length.
+class SerializeInto : public SerializationBase
+{
+    private:
+
+        uint8_t* _data = nullptr;
+        size_t _capacity = 0;
+        size_t _index = 0;
+        bool _error = false;
+
+    public:
+
+        SerializeInto(uint8_t* data, size_t capacity) : _data(data), _capacity(capacity)
+        {
+            _error = (data == nullptr && capacity > 0);
+        }
+
+        Mode mode() const override
+        {
+            return Mode::Write;
+        }
+
+        void single(uint8_t* pointer, size_t size) override
+        {
+            if(size == 0) return;
+
+            if(_error || size > _capacity - _index) {
+                _error = true;
+                _index += size;
+                return;
+            }
+
+            if(littleEndian()) {
+                std::memcpy(_data + _index, pointer, size);
+                _index += size;
+                return;
+            }
+
+            // Big-endian fallback: emit bytes in reverse memory order.
+            for(size_t i = 0; i < size; ++i) {
+                _data[_index + i] = pointer[size - 1 - i];
+            }
+            _index += size;
+        }
+
+        size_t size() const
+        {
+            return _index;
+        }
+
+        bool error() const
+        {
+            return _error;
+        }
+
+};
+
 class Deserialize : public SerializationBase
 {
     private:
@@ -157,7 +370,7 @@ class Deserialize : public SerializationBase
 
         void single(uint8_t* pointer, size_t size) override
         {
-            if(size == 0) return;
+            if(size == 0 || _error) return;
 
             const size_t dataSize = _useDataView ? _dataViewSize : _data.size();
             if(_index + size > dataSize){
@@ -236,6 +449,16 @@ class Deserialize : public SerializationBase
             _error = (data == nullptr && size > 0);
         }
 
+        void fail() override
+        {
+            _error = true;
+        }
+
+        bool failed() const override
+        {
+            return _error;
+        }
+
         bool error()
         {
             return _error;
@@ -251,9 +474,16 @@ private:
 
 public:
 
+    // Walks the writer path so components emit exactly what Serialize would, without
+    // running the post-load fixups a Read pass triggers.
     Mode mode() const override
     {
-        return Mode::Read;
+        return Mode::Write;
+    }
+
+    bool measuring() const override
+    {
+        return true;
     }
 
     void single(uint8_t* /*pointer*/, size_t size) override
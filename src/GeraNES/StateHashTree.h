@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Serialization.h"
+#include "util/Crc32.h"
+#include "util/DirtyPages.h"
+
+namespace GeraNES {
+
+inline const char* stateComponentName(StateComponent component)
+{
+    switch(component) {
+        case StateComponent::CPU: return "CPU";
+        case StateComponent::RAM: return "RAM";
+        case StateComponent::PPU: return "PPU";
+        case StateComponent::CIRAM: return "CIRAM";
+        case StateComponent::CHR_RAM: return "CHR-RAM";
+        case StateComponent::SAVE_RAM: return "Save RAM";
+        case StateComponent::APU: return "APU";
+        case StateComponent::MAPPER: return "Mapper";
+        case StateComponent::INPUT: return "Input";
+        default: return "?";
+    }
+}
+
+struct StateDigest
+{
+    uint32_t root = 0;
+    std::array<uint32_t, STATE_COMPONENT_COUNT> components = {};
+};
+
+// Hashes the machine state component by component instead of storing it. It is fed the
+// same serialization() calls a save state goes through; tracked regions (see pages()) keep
+// a CRC per 256-byte page between runs and only rehash the pages written since the last
+// one, so a digest costs the small register blocks plus whatever memory actually changed.
+// A component digest is the CRC of its bytes, with each paged region standing in as the
+// CRC of its page CRCs; the root is the CRC of the component digests.
+class StateHashTree : public SerializationBase
+{
+private:
+
+    struct Region
+    {
+        const DirtyPages* tracker = nullptr;
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        StateComponent component = StateComponent::COUNT;
+        std::vector<uint32_t> pageCrcs;
+        bool hashed = false;
+    };
+
+    std::vector<Region> m_regions;
+    std::array<uint32_t, STATE_COMPONENT_COUNT> m_crcs = {};
+    StateComponent m_component = StateComponent::CPU;
+    uint32_t m_hashedEpoch = 0;
+    uint32_t m_epoch = 0;
+    size_t m_rehashedPages = 0;
+
+    Region& regionFor(const DirtyPages* tracker)
+    {
+        for(Region& region : m_regions) {
+            if(region.tracker == tracker) return region;
+        }
+        m_regions.emplace_back();
+        m_regions.back().tracker = tracker;
+        return m_regions.back();
+    }
+
+    void feed(StateComponent component, const uint8_t* data, size_t size)
+    {
+        uint32_t& crc = m_crcs[static_cast<size_t>(component)];
+        if(littleEndian()) {
+            crc = Crc32::update(crc, data, size);
+            return;
+        }
+        // Same byte order a save state has.
+        for(size_t i = 0; i < size; ++i) {
+            crc = Crc32::update(crc, data + size - 1 - i, 1);
+        }
+    }
+
+    // Digests are chained little-endian so every host builds the same tree.
+    static uint32_t updateWord(uint32_t crc, uint32_t value)
+    {
+        const uint8_t bytes[4] = {
+            static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8),
+            static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24)
+        };
+        return Crc32::update(crc, bytes, sizeof(bytes));
+    }
+
+public:
+
+    Mode mode() const override
+    {
+        return Mode::Write;
+    }
+
+    void single(uint8_t* pointer, size_t size) override
+    {
+        if(size == 0) return;
+        feed(m_component, pointer, size);
+    }
+
+    // Assigns a tracked region to its own component; the others count toward the component
+    // being hashed when they are reached.
+    void mapRegion(const DirtyPages& tracker, StateComponent component)
+    {
+        regionFor(&tracker).component = component;
+    }
+
+    // epoch must be a write epoch started right before this run (GeraNESEmu::markSnapshotBase):
+    // pages written from the previous run's epoch on are rehashed, the rest come from cache.
+    void begin(uint32_t epoch)
+    {
+        m_crcs.fill(~0u);
+        m_component = StateComponent::CPU;
+        m_epoch = epoch;
+        m_rehashedPages = 0;
+    }
+
+    void beginComponent(StateComponent component) override
+    {
+        m_component = component;
+    }
+
+    void pages(uint8_t* data, size_t size, const DirtyPages* dirty) override
+    {
+        Region& region = regionFor(dirty);
+        const StateComponent component = region.component != StateComponent::COUNT ? region.component : m_component;
+
+        const size_t pageCount = DirtyPages::pageCount(size);
+        const bool rehashAll = dirty == nullptr || !region.hashed || m_hashedEpoch == 0 ||
+                               region.data != data || region.size != size;
+        region.pageCrcs.resize(pageCount);
+        for(size_t page = 0; page < pageCount; ++page) {
+            if(!rehashAll && !dirty->dirtySince(page, m_hashedEpoch)) continue;
+            const size_t offset = page << DirtyPages::PAGE_SHIFT;
+            const size_t length = std::min(DirtyPages::PAGE_SIZE, size - offset);
+            region.pageCrcs[page] = ~Crc32::update(~0u, data + offset, length);
+            ++m_rehashedPages;
+        }
+        region.data = data;
+        region.size = size;
+        region.hashed = true;
+
+        uint32_t regionCrc = ~0u;
+        for(const uint32_t pageCrc : region.pageCrcs) {
+            regionCrc = updateWord(regionCrc, pageCrc);
+        }
+        uint32_t& crc = m_crcs[static_cast<size_t>(component)];
+        crc = updateWord(crc, static_cast<uint32_t>(size));
+        crc = updateWord(crc, ~regionCrc);
+    }
+
+    StateDigest finish()
+    {
+        m_hashedEpoch = m_epoch;
+
+        StateDigest digest;
+        uint32_t root = ~0u;
+        for(size_t i = 0; i < STATE_COMPONENT_COUNT; ++i) {
+            digest.components[i] = ~m_crcs[i];
+            root = updateWord(root, digest.components[i]);
+        }
+        digest.root = ~root;
+        return digest;
+    }
+
+    // Drops the page cache; the next run hashes every page.
+    void invalidate()
+    {
+        m_regions.clear();
+        m_hashedEpoch = 0;
+    }
+
+    // Pages hashed by the last run, for tests and diagnostics.
+    size_t rehashedPages() const
+    {
+        return m_rehashedPages;
+    }
+};
+
+} // namespace GeraNES
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "Serialization.h"
+#include "util/DirtyPages.h"
+
+namespace GeraNES {
+
+// Measures a full state as a list of consecutive spans, in the order the bytes are
+// stored. Every tracked region (see pages()) is a span of its own and each component the
+// state announces starts a new one, so the spans follow the state's components.
+class StateLayout : public SerializationBase
+{
+private:
+
+    std::vector<uint32_t> m_spans;
+    size_t m_open = 0;
+
+public:
+
+    Mode mode() const override
+    {
+        return Mode::Write;
+    }
+
+    void single(uint8_t* /*pointer*/, size_t size) override
+    {
+        m_open += size;
+    }
+
+    void pages(uint8_t* /*data*/, size_t size, const DirtyPages* /*dirty*/) override
+    {
+        split();
+        if(size > 0) m_spans.push_back(static_cast<uint32_t>(size));
+    }
+
+    void beginComponent(StateComponent /*component*/) override
+    {
+        split();
+    }
+
+    void split()
+    {
+        if(m_open == 0) return;
+        m_spans.push_back(static_cast<uint32_t>(m_open));
+        m_open = 0;
+    }
+
+    std::vector<uint32_t> takeSpans()
+    {
+        split();
+        return std::move(m_spans);
+    }
+};
+
+} // namespace GeraNES
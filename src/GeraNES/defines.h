@@ -29,7 +29,7 @@ static constexpr const char* GERANES_NAME = "GeraNES";
 static constexpr const char* GERANES_VERSION = "2.2.1";
 
 static constexpr uint32_t SAVE_STATE_MAGIC = makeMagic('G','N','E','S');
-static constexpr uint32_t SAVE_STATE_VERSION = 12;
+static constexpr uint32_t SAVE_STATE_VERSION = 14;
 
 static constexpr const char* STATES_FOLDER  = "states/";
 
@@ -1,17 +1,111 @@
 #pragma once
 
+#include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <string>
 
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #include <cpuid.h>
+    #include <emmintrin.h>
+    #include <wmmintrin.h>
+    #define GERANES_CRC32_PCLMUL 1
+    #define GERANES_CRC32_PCLMUL_TARGET __attribute__((target("pclmul,sse2")))
+#elif defined(_M_X64)
+    #include <intrin.h>
+    #include <emmintrin.h>
+    #include <wmmintrin.h>
+    #define GERANES_CRC32_PCLMUL 1
+    #define GERANES_CRC32_PCLMUL_TARGET
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+    #include <arm_acle.h>
+    #define GERANES_CRC32_ARMV8 1
+#endif
+
 namespace GeraNES {
 
+static constexpr uint32_t CRC32_POLYNOMIAL = 0xEDB88320;
+
+using Crc32Tables = std::array<std::array<uint32_t, 256>, 8>;
+
+// Slicing-by-8 tables: [k][i] is the CRC of byte i followed by k zero bytes.
+constexpr Crc32Tables makeCrc32Tables()
+{
+    Crc32Tables tables{};
+    for(uint32_t i = 0; i < 256; ++i) {
+        uint32_t crc = i;
+        for(int bit = 0; bit < 8; ++bit) {
+            crc = (crc >> 1) ^ (CRC32_POLYNOMIAL & (0u - (crc & 1u)));
+        }
+        tables[0][i] = crc;
+    }
+    for(size_t k = 1; k < tables.size(); ++k) {
+        for(size_t i = 0; i < 256; ++i) {
+            tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+        }
+    }
+    return tables;
+}
+
+inline constexpr Crc32Tables CRC32_TABLES = makeCrc32Tables();
+
+// CRC-32 as in zip and PNG (reflected, polynomial 0xEDB88320). ROM identification, save
+// state checks and netplay all go through update(), which uses the fastest path the CPU
+// has: carry-less multiply folding on x86 with PCLMULQDQ, the CRC32 instructions on ARMv8
+// builds that target them, and slicing-by-8 tables everywhere else. The static update
+// functions work on the raw register; the class adds the usual inversion around it.
 class Crc32 {
 
+public:
+
+    enum class Implementation : uint8_t
+    {
+        BITWISE,
+        SLICING_8,
+        PCLMUL,
+        ARMV8
+    };
+
+    static constexpr uint32_t POLYNOMIAL = CRC32_POLYNOMIAL;
+
 private:
 
+    static uint32_t load32(const uint8_t* p)
+    {
+        return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+    }
+
+#if defined(GERANES_CRC32_PCLMUL)
+    GERANES_CRC32_PCLMUL_TARGET static __m128i loadBlock(const uint8_t* p)
+    {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    }
+
+    GERANES_CRC32_PCLMUL_TARGET static __m128i foldBlock(__m128i value, __m128i constants, __m128i next)
+    {
+        const __m128i low = _mm_clmulepi64_si128(value, constants, 0x00);
+        const __m128i high = _mm_clmulepi64_si128(value, constants, 0x11);
+        return _mm_xor_si128(_mm_xor_si128(low, high), next);
+    }
+
+    static bool cpuHasPclmul()
+    {
+    #if defined(_M_X64) && !defined(__clang__) && !defined(__GNUC__)
+        int info[4] = {};
+        __cpuid(info, 1);
+        const unsigned ecx = static_cast<unsigned>(info[2]);
+        const unsigned edx = static_cast<unsigned>(info[3]);
+    #else
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        if(__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0) return false;
+    #endif
+        return (ecx & (1u << 1)) != 0 && (edx & (1u << 26)) != 0;
+    }
+#endif
+
     uint32_t m_crc;
 
 public:
@@ -24,18 +118,9 @@ public:
         add(&ch, 1);
     }
 
-    void add(const char *s, size_t n) {
-
-        for(size_t i=0;i<n;i++) {
-            char ch=s[i];
-            for(size_t j=0;j<8;j++) {
-                uint32_t b=(ch^m_crc)&1;
-                m_crc>>=1;
-                if(b) m_crc=m_crc^0xEDB88320;
-                ch>>=1;
-            }
-        }
-	}
+    void add(const void* s, size_t n) {
+        m_crc = update(m_crc, s, n);
+    }
 
     uint32_t get() {
         return ~m_crc;
@@ -45,10 +130,8 @@ public:
         return toString(get());
     }
 
-    static uint32_t calc(const char *s,size_t n) {
-        Crc32 c;
-        c.add(s,n);
-        return c.get();
+    static uint32_t calc(const void* s, size_t n) {
+        return ~update(~0u, s, n);
     }
 
     static std::string toString(uint32_t crc) {
@@ -56,7 +139,167 @@ public:
         ss << std::uppercase << std::setfill('0') << std::setw(8) << std::hex << crc;
         return ss.str();
     }
-    
+
+    // Reference version, one polynomial step per bit.
+    static uint32_t updateBitwise(uint32_t crc, const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for(size_t i = 0; i < size; ++i) {
+            crc ^= p[i];
+            for(int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ (POLYNOMIAL & (0u - (crc & 1u)));
+            }
+        }
+        return crc;
+    }
+
+    static uint32_t updateSlicing8(uint32_t crc, const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while(size >= 8) {
+            const uint32_t lo = crc ^ load32(p);
+            const uint32_t hi = load32(p + 4);
+            crc = CRC32_TABLES[7][lo & 0xFF] ^ CRC32_TABLES[6][(lo >> 8) & 0xFF] ^
+                  CRC32_TABLES[5][(lo >> 16) & 0xFF] ^ CRC32_TABLES[4][lo >> 24] ^
+                  CRC32_TABLES[3][hi & 0xFF] ^ CRC32_TABLES[2][(hi >> 8) & 0xFF] ^
+                  CRC32_TABLES[1][(hi >> 16) & 0xFF] ^ CRC32_TABLES[0][hi >> 24];
+            p += 8;
+            size -= 8;
+        }
+        while(size-- > 0) {
+            crc = (crc >> 8) ^ CRC32_TABLES[0][(crc ^ *p++) & 0xFF];
+        }
+        return crc;
+    }
+
+#if defined(GERANES_CRC32_PCLMUL)
+    // Folds four 128-bit lanes over 64-byte blocks, then one lane over 16-byte blocks, and
+    // ends with a Barrett reduction (Intel, "Fast CRC Computation for Generic Polynomials
+    // Using PCLMULQDQ Instruction"). The tail under 16 bytes goes through the tables.
+    GERANES_CRC32_PCLMUL_TARGET static uint32_t updatePclmul(uint32_t crc, const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        if(size < 64) return updateSlicing8(crc, p, size);
+
+        // x^(k) mod P for the fold distances, bit-reflected and shifted left by one.
+        const __m128i k1k2 = _mm_set_epi64x(0x1C6E41596LL, 0x154442BD4LL);
+        const __m128i k3k4 = _mm_set_epi64x(0x0CCAA009ELL, 0x1751997D0LL);
+        const __m128i k5 = _mm_set_epi64x(0, 0x163CD6124LL);
+        const __m128i barrett = _mm_set_epi64x(0x1F7011641LL, 0x1DB710641LL);
+        const __m128i mask32 = _mm_set_epi32(0, 0, 0, -1);
+
+        __m128i x1 = _mm_xor_si128(loadBlock(p), _mm_cvtsi32_si128(static_cast<int>(crc)));
+        __m128i x2 = loadBlock(p + 16);
+        __m128i x3 = loadBlock(p + 32);
+        __m128i x4 = loadBlock(p + 48);
+        p += 64;
+        size -= 64;
+
+        while(size >= 64) {
+            x1 = foldBlock(x1, k1k2, loadBlock(p));
+            x2 = foldBlock(x2, k1k2, loadBlock(p + 16));
+            x3 = foldBlock(x3, k1k2, loadBlock(p + 32));
+            x4 = foldBlock(x4, k1k2, loadBlock(p + 48));
+            p += 64;
+            size -= 64;
+        }
+
+        x1 = foldBlock(x1, k3k4, x2);
+        x1 = foldBlock(x1, k3k4, x3);
+        x1 = foldBlock(x1, k3k4, x4);
+        while(size >= 16) {
+            x1 = foldBlock(x1, k3k4, loadBlock(p));
+            p += 16;
+            size -= 16;
+        }
+
+        // 128 -> 64 bits, then 64 -> 32 with the Barrett reduction.
+        x1 = _mm_xor_si128(_mm_srli_si128(x1, 8), _mm_clmulepi64_si128(k3k4, x1, 0x01));
+        x2 = _mm_srli_si128(x1, 4);
+        x1 = _mm_xor_si128(_mm_clmulepi64_si128(_mm_and_si128(x1, mask32), k5, 0x00), x2);
+
+        x2 = x1;
+        x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), barrett, 0x10);
+        x1 = _mm_clmulepi64_si128(_mm_and_si128(x1, mask32), barrett, 0x00);
+        x1 = _mm_xor_si128(x1, x2);
+        crc = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_srli_si128(x1, 4)));
+
+        return updateSlicing8(crc, p, size);
+    }
+#endif
+
+#if defined(GERANES_CRC32_ARMV8)
+    static uint32_t updateArmv8(uint32_t crc, const void* data, size_t size)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        while(size >= 8) {
+            uint64_t value = 0;
+            std::memcpy(&value, p, sizeof(value));
+            crc = __crc32d(crc, value);
+            p += 8;
+            size -= 8;
+        }
+        while(size-- > 0) {
+            crc = __crc32b(crc, *p++);
+        }
+        return crc;
+    }
+#endif
+
+    static bool available(Implementation implementation)
+    {
+        switch(implementation) {
+            case Implementation::BITWISE:
+            case Implementation::SLICING_8:
+                return true;
+            case Implementation::PCLMUL:
+            #if defined(GERANES_CRC32_PCLMUL)
+                return cpuHasPclmul();
+            #else
+                return false;
+            #endif
+            case Implementation::ARMV8:
+            #if defined(GERANES_CRC32_ARMV8)
+                return true;
+            #else
+                return false;
+            #endif
+        }
+        return false;
+    }
+
+    static Implementation fastest()
+    {
+        if(available(Implementation::PCLMUL)) return Implementation::PCLMUL;
+        if(available(Implementation::ARMV8)) return Implementation::ARMV8;
+        return Implementation::SLICING_8;
+    }
+
+    // Runs one particular implementation; it must be available().
+    static uint32_t updateWith(Implementation implementation, uint32_t crc, const void* data, size_t size)
+    {
+        switch(implementation) {
+            case Implementation::BITWISE:
+                return updateBitwise(crc, data, size);
+        #if defined(GERANES_CRC32_PCLMUL)
+            case Implementation::PCLMUL:
+                return updatePclmul(crc, data, size);
+        #endif
+        #if defined(GERANES_CRC32_ARMV8)
+            case Implementation::ARMV8:
+                return updateArmv8(crc, data, size);
+        #endif
+            default:
+                return updateSlicing8(crc, data, size);
+        }
+    }
+
+    static uint32_t update(uint32_t crc, const void* data, size_t size)
+    {
+        static const Implementation implementation = fastest();
+        return updateWith(implementation, crc, data, size);
+    }
+
 };
 
 } // namespace GeraNES
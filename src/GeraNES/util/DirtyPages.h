@@ -0,0 +1,68 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "GeraNES/defines.h"
+
+namespace GeraNES {
+
+// Write tracking for a memory region in 256-byte pages. Every write stamps its page with
+// the current epoch, so "written since epoch N" is a compare per page and any number of
+// snapshot bases can be served from one table. Code that hands out a raw pointer to the
+// region cannot see the writes behind it and calls markAll() instead.
+class DirtyPages
+{
+public:
+
+    static constexpr size_t PAGE_SHIFT = 8;
+    static constexpr size_t PAGE_SIZE = size_t(1) << PAGE_SHIFT;
+
+private:
+
+    std::vector<uint32_t> m_pageEpochs;
+    uint32_t m_epoch = 1;
+    uint32_t m_allEpoch = 1;
+
+public:
+
+    DirtyPages() = default;
+
+    explicit DirtyPages(size_t bytes)
+    {
+        resize(bytes);
+    }
+
+    static constexpr size_t pageCount(size_t bytes)
+    {
+        return (bytes + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    }
+
+    void resize(size_t bytes)
+    {
+        m_pageEpochs.assign(pageCount(bytes), m_epoch);
+    }
+
+    void setEpoch(uint32_t epoch)
+    {
+        m_epoch = epoch;
+    }
+
+    GERANES_INLINE void mark(size_t offset)
+    {
+        m_pageEpochs[offset >> PAGE_SHIFT] = m_epoch;
+    }
+
+    GERANES_INLINE void markAll()
+    {
+        m_allEpoch = m_epoch;
+    }
+
+    bool dirtySince(size_t page, uint32_t baseEpoch) const
+    {
+        return m_allEpoch >= baseEpoch || page >= m_pageEpochs.size() || m_pageEpochs[page] >= baseEpoch;
+    }
+};
+
+} // namespace GeraNES
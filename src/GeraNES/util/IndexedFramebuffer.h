@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+    #define GERANES_INDEXED_FRAMEBUFFER_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <emmintrin.h>
+    #define GERANES_INDEXED_FRAMEBUFFER_SSE2 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define GERANES_INDEXED_FRAMEBUFFER_NEON 1
+#endif
+
+namespace GeraNES {
+
+// Indexed framebuffer pixel: bits 0-5 NES color, bits 6-8 PPUMASK emphasis, bit 9 greyscale.
+// Everything the PPU output palette depends on per pixel fits in the key, so a frame can be
+// kept as indices and converted with a single lookup table when it is presented.
+static constexpr int INDEXED_PIXEL_KEY_BITS = 10;
+static constexpr int INDEXED_PIXEL_KEYS = 1 << INDEXED_PIXEL_KEY_BITS;
+static constexpr uint16_t INDEXED_PIXEL_KEY_MASK = INDEXED_PIXEL_KEYS - 1;
+
+using IndexedColorLut = std::array<uint32_t, INDEXED_PIXEL_KEYS>;
+
+constexpr uint16_t makeIndexedPixelBase(uint8_t emphasis, bool greyscale)
+{
+    return static_cast<uint16_t>(((emphasis & 0x07) << 6) | (greyscale ? 0x200 : 0x000));
+}
+
+// dst[i] = lut[src[i]]. The LUT holds colors already in the consumer's target format.
+inline void convertIndexedPixels(const uint16_t* src, uint32_t* dst, size_t count, const uint32_t* lut)
+{
+    size_t i = 0;
+
+#if defined(GERANES_INDEXED_FRAMEBUFFER_AVX2)
+    const __m256i keyMask = _mm256_set1_epi32(INDEXED_PIXEL_KEY_MASK);
+    const int* table = reinterpret_cast<const int*>(lut);
+    for(const size_t blocks = count & ~size_t(15); i < blocks; i += 16) {
+        const __m256i keys = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        const __m256i low = _mm256_and_si256(_mm256_cvtepu16_epi32(_mm256_castsi256_si128(keys)), keyMask);
+        const __m256i high = _mm256_and_si256(_mm256_cvtepu16_epi32(_mm256_extracti128_si256(keys, 1)), keyMask);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_i32gather_epi32(table, low, 4));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), _mm256_i32gather_epi32(table, high, 4));
+    }
+#elif defined(GERANES_INDEXED_FRAMEBUFFER_SSE2)
+    // No gather before AVX2: keys come out of one 128-bit load and colors go back four per store.
+    const __m128i keyMask = _mm_set1_epi16(static_cast<short>(INDEXED_PIXEL_KEY_MASK));
+    for(const size_t blocks = count & ~size_t(7); i < blocks; i += 8) {
+        const __m128i keys = _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i)), keyMask);
+        const __m128i low = _mm_setr_epi32(
+            static_cast<int>(lut[_mm_extract_epi16(keys, 0)]), static_cast<int>(lut[_mm_extract_epi16(keys, 1)]),
+            static_cast<int>(lut[_mm_extract_epi16(keys, 2)]), static_cast<int>(lut[_mm_extract_epi16(keys, 3)]));
+        const __m128i high = _mm_setr_epi32(
+            static_cast<int>(lut[_mm_extract_epi16(keys, 4)]), static_cast<int>(lut[_mm_extract_epi16(keys, 5)]),
+            static_cast<int>(lut[_mm_extract_epi16(keys, 6)]), static_cast<int>(lut[_mm_extract_epi16(keys, 7)]));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), low);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), high);
+    }
+#elif defined(GERANES_INDEXED_FRAMEBUFFER_NEON)
+    const uint16x8_t keyMask = vdupq_n_u16(INDEXED_PIXEL_KEY_MASK);
+    for(const size_t blocks = count & ~size_t(7); i < blocks; i += 8) {
+        const uint16x8_t keys = vandq_u16(vld1q_u16(src + i), keyMask);
+        uint32x4_t low = vdupq_n_u32(lut[vgetq_lane_u16(keys, 0)]);
+        low = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 1)], low, 1);
+        low = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 2)], low, 2);
+        low = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 3)], low, 3);
+        uint32x4_t high = vdupq_n_u32(lut[vgetq_lane_u16(keys, 4)]);
+        high = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 5)], high, 1);
+        high = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 6)], high, 2);
+        high = vsetq_lane_u32(lut[vgetq_lane_u16(keys, 7)], high, 3);
+        vst1q_u32(dst + i, low);
+        vst1q_u32(dst + i + 4, high);
+    }
+#endif
+
+    for(; i < count; ++i) {
+        dst[i] = lut[src[i] & INDEXED_PIXEL_KEY_MASK];
+    }
+}
+
+} // namespace GeraNES
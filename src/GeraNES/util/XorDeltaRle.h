@@ -0,0 +1,132 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace GeraNES {
+
+// Delta codec for consecutive save states: the data is XORed against a reference of the
+// same size and the result is stored as (zero run, literal run) pairs with LEB128 lengths.
+// Two states a few frames apart differ in a handful of RAM bytes and registers, so almost
+// everything collapses into zero runs. A null reference encodes the data itself, which
+// still packs the large zero-filled regions of a state.
+namespace XorDeltaRle
+{
+    // Shorter zero gaps stay inside the literal run; splitting there would cost more in
+    // length bytes than it saves.
+    static constexpr size_t MIN_ZERO_RUN = 4;
+
+    namespace Detail
+    {
+        inline uint8_t delta(const uint8_t* data, const uint8_t* reference, size_t index)
+        {
+            return reference != nullptr ? static_cast<uint8_t>(data[index] ^ reference[index]) : data[index];
+        }
+
+        inline size_t zeroRun(const uint8_t* data, const uint8_t* reference, size_t index, size_t size)
+        {
+            const size_t start = index;
+            while(index + sizeof(uint64_t) <= size) {
+                uint64_t a = 0;
+                uint64_t b = 0;
+                std::memcpy(&a, data + index, sizeof(a));
+                if(reference != nullptr) std::memcpy(&b, reference + index, sizeof(b));
+                if((a ^ b) != 0) break;
+                index += sizeof(uint64_t);
+            }
+            while(index < size && delta(data, reference, index) == 0) ++index;
+            return index - start;
+        }
+
+        inline void writeLength(std::vector<uint8_t>& out, size_t value)
+        {
+            while(value >= 0x80) {
+                out.push_back(static_cast<uint8_t>(value | 0x80));
+                value >>= 7;
+            }
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        inline bool readLength(const uint8_t* encoded, size_t encodedSize, size_t& index, size_t& value)
+        {
+            value = 0;
+            for(int shift = 0; shift < 64; shift += 7) {
+                if(index >= encodedSize) return false;
+                const uint8_t byte = encoded[index++];
+                value |= static_cast<size_t>(byte & 0x7F) << shift;
+                if((byte & 0x80) == 0) return true;
+            }
+            return false;
+        }
+    }
+
+    // Appends to out, so callers can reuse one buffer and keep its capacity.
+    inline void encode(const uint8_t* data, const uint8_t* reference, size_t size, std::vector<uint8_t>& out)
+    {
+        size_t index = 0;
+        while(index < size) {
+            const size_t zeros = Detail::zeroRun(data, reference, index, size);
+            const size_t literalStart = index + zeros;
+
+            size_t literalEnd = literalStart;
+            while(literalEnd < size) {
+                if(Detail::delta(data, reference, literalEnd) != 0) {
+                    ++literalEnd;
+                    continue;
+                }
+                size_t gapEnd = literalEnd;
+                while(gapEnd < size && gapEnd - literalEnd < MIN_ZERO_RUN && Detail::delta(data, reference, gapEnd) == 0) ++gapEnd;
+                if(gapEnd - literalEnd >= MIN_ZERO_RUN || gapEnd == size) break;
+                literalEnd = gapEnd;
+            }
+
+            Detail::writeLength(out, zeros);
+            Detail::writeLength(out, literalEnd - literalStart);
+            for(size_t i = literalStart; i < literalEnd; ++i) {
+                out.push_back(Detail::delta(data, reference, i));
+            }
+            index = literalEnd;
+        }
+    }
+
+    inline bool decode(const uint8_t* encoded,
+                       size_t encodedSize,
+                       const uint8_t* reference,
+                       uint8_t* output,
+                       size_t outputSize)
+    {
+        if(output == nullptr) return encodedSize == 0 && outputSize == 0;
+        if(encoded == nullptr) return encodedSize == 0 && outputSize == 0;
+
+        size_t sourceIndex = 0;
+        size_t destIndex = 0;
+        while(destIndex < outputSize) {
+            size_t zeros = 0;
+            size_t literals = 0;
+            if(!Detail::readLength(encoded, encodedSize, sourceIndex, zeros) || zeros > outputSize - destIndex) return false;
+
+            if(reference != nullptr) std::memcpy(output + destIndex, reference + destIndex, zeros);
+            else std::memset(output + destIndex, 0, zeros);
+            destIndex += zeros;
+
+            if(!Detail::readLength(encoded, encodedSize, sourceIndex, literals) ||
+               literals > outputSize - destIndex ||
+               literals > encodedSize - sourceIndex) {
+                return false;
+            }
+
+            for(size_t i = 0; i < literals; ++i) {
+                const uint8_t value = encoded[sourceIndex + i];
+                output[destIndex + i] = reference != nullptr ? static_cast<uint8_t>(value ^ reference[destIndex + i]) : value;
+            }
+            sourceIndex += literals;
+            destIndex += literals;
+        }
+
+        return sourceIndex == encodedSize;
+    }
+}
+
+} // namespace GeraNES
@@ -99,9 +99,10 @@ public:
 
         bool disableSpritesLimit = false;
         bool overclock = false;
-        int maxRewindTime = 10;
+        int rewindMemoryMB = 32;
+        int runAheadFrames = 0;
 
-        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Improvements, disableSpritesLimit, overclock, maxRewindTime)
+        NLOHMANN_DEFINE_TYPE_INTRUSIVE_WITH_DEFAULT(Improvements, disableSpritesLimit, overclock, rewindMemoryMB, runAheadFrames)
     };
 
     struct Video {
@@ -338,6 +339,7 @@ public:
         std::string signalingPassword;
         bool autoGameplayTuning = true;
         int inputDelayFrames = 2;
+        bool rollback = false;
         bool showNetplayDebugLog = false;
         int gameplayReceiveDelayMs = 0;
         std::string displayName = "Participant";
@@ -357,6 +359,7 @@ public:
                 {"signalingPassword", value.signalingPassword},
                 {"autoGameplayTuning", value.autoGameplayTuning},
                 {"inputDelayFrames", value.inputDelayFrames},
+                {"rollback", value.rollback},
                 {"showNetplayDebugLog", value.showNetplayDebugLog},
                 {"gameplayReceiveDelayMs", value.gameplayReceiveDelayMs},
                 {"displayName", value.displayName},
@@ -382,6 +385,7 @@ public:
             value.signalingPassword = j.value("signalingPassword", defaults.signalingPassword);
             value.autoGameplayTuning = j.value("autoGameplayTuning", defaults.autoGameplayTuning);
             value.inputDelayFrames = j.value("inputDelayFrames", defaults.inputDelayFrames);
+            value.rollback = j.value("rollback", defaults.rollback);
             value.showNetplayDebugLog =
                 j.value("showNetplayDebugLog",
                         j.value("debugMode", defaults.showNetplayDebugLog));
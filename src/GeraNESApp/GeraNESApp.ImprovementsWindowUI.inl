@@ -23,17 +23,31 @@ inline void GeraNESApp::drawImprovementsWindow()
         const bool netplayRewindDisabled = shouldSuppressRewindForNetplay();
         int value = netplayRewindDisabled
             ? 0
-            : AppSettings::instance().data.improvements.maxRewindTime;
+            : AppSettings::instance().data.improvements.rewindMemoryMB;
         ImGui::BeginDisabled(netplayRewindDisabled);
-        if(ImGui::InputInt("Max Rewind Time(s)", &value)) {
+        if(ImGui::InputInt("Rewind Memory (MB)", &value)) {
             value = std::max(0, value);
-            AppSettings::instance().data.improvements.maxRewindTime = value;
+            AppSettings::instance().data.improvements.rewindMemoryMB = value;
             m_emu.setupRewindSystem(value > 0, value);
         }
         ImGui::EndDisabled();
         if(netplayRewindDisabled) {
             ImGui::TextDisabled("Rewind is disabled while netplay is active.");
         }
+
+        SetNextItemWidthScaledClamped(100.0f);
+
+        int runAheadFrames = netplayRewindDisabled
+            ? 0
+            : AppSettings::instance().data.improvements.runAheadFrames;
+        ImGui::BeginDisabled(netplayRewindDisabled);
+        if(ImGui::SliderInt("Run-Ahead Frames", &runAheadFrames, 0, static_cast<int>(RunAhead::MAX_FRAMES))) {
+            AppSettings::instance().data.improvements.runAheadFrames = std::clamp(runAheadFrames, 0, static_cast<int>(RunAhead::MAX_FRAMES));
+        }
+        ImGui::EndDisabled();
+        if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenDisabled)) {
+            ImGui::SetTooltip("Shows each frame as it will look this many frames later,\nhiding that much input lag. Costs one extra frame of\nemulation per step.");
+        }
     }
 
     ImGui::End();
@@ -1121,6 +1121,10 @@ inline void GeraNESApp::menuBar() {
                 requestEnableCpuDebugger();
             }
 
+            if(ImGui::MenuItem(withMenuIcon(FontAwesomeIcons::kSliders, "Profiler").c_str())) {
+                m_showProfilerWindow = true;
+            }
+
             ImGui::Separator();
 
             if (ImGui::BeginMenu(withMenuIcon(FontAwesomeIcons::kGear, "Advanced").c_str()))
@@ -0,0 +1,87 @@
+#pragma once
+
+inline void GeraNESApp::drawProfilerWindow()
+{
+    SetNextWindowCenteredOnMainViewport(ImVec2(520.0f, 0.0f), ImGuiCond_Once);
+
+    if(!ImGui::Begin("Profiler", &m_showProfilerWindow)) {
+        ImGui::End();
+        return;
+    }
+    m_imGuiWindowFocusBlocksEmulator |= ImGui::IsWindowFocused(ImGuiFocusedFlags_RootAndChildWindows);
+
+    if(!Profiler::enabled()) {
+        ImGui::TextDisabled("This build was configured without GERANES_ENABLE_PROFILING.");
+        ImGui::End();
+        return;
+    }
+
+    const ProfileReport report = Profiler::instance().recentReport();
+    if(report.frames == 0) {
+        ImGui::TextDisabled("Waiting for emulated frames.");
+        ImGui::End();
+        return;
+    }
+
+    const double frames = static_cast<double>(report.frames);
+    const double wallMsPerFrame = report.wallMs / frames;
+    ImGui::Text("Last %llu frames, %.3f ms/frame wall time", static_cast<unsigned long long>(report.frames), wallMsPerFrame);
+
+    const ImGuiTableFlags tableFlags =
+        ImGuiTableFlags_Borders |
+        ImGuiTableFlags_RowBg |
+        ImGuiTableFlags_SizingStretchProp;
+
+    if(ImGui::BeginTable("ProfilerTable", 4, tableFlags)) {
+        ImGui::TableSetupColumn("Section");
+        ImGui::TableSetupColumn("ms/frame", ImGuiTableColumnFlags_WidthFixed, 72.0f);
+        ImGui::TableSetupColumn("% wall", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("calls/frame", ImGuiTableColumnFlags_WidthFixed, 84.0f);
+        ImGui::PushStyleColor(ImGuiCol_Text, ImGuiTheme::textOnAccent());
+        ImGui::TableHeadersRow();
+        ImGui::PopStyleColor();
+
+        const auto drawRow = [&](const char* name, double ms, const uint64_t* calls, bool nested) {
+            ImGui::TableNextRow();
+            ImGui::TableSetColumnIndex(0);
+            if(nested) ImGui::Indent();
+            ImGui::TextUnformatted(name);
+            if(nested) ImGui::Unindent();
+            ImGui::TableSetColumnIndex(1);
+            ImGui::Text("%.3f", ms / frames);
+            ImGui::TableSetColumnIndex(2);
+            ImGui::Text("%.1f", report.wallMs > 0.0 ? ms * 100.0 / report.wallMs : 0.0);
+            ImGui::TableSetColumnIndex(3);
+            if(calls != nullptr) {
+                ImGui::Text("%.0f", static_cast<double>(*calls) / frames);
+            }
+        };
+
+        const auto drawSection = [&](ProfileSection section, bool nested) {
+            const ProfileSectionStats& stats = report.section(section);
+            drawRow(profileSectionName(section), stats.ms, &stats.calls, nested);
+        };
+
+        drawSection(ProfileSection::Emulation, false);
+        drawRow("cpuCore", report.cpuCoreMs(), nullptr, true);
+        drawSection(ProfileSection::PpuDots, true);
+        drawSection(ProfileSection::PpuBatches, true);
+        drawSection(ProfileSection::Apu, true);
+        drawSection(ProfileSection::MapperHooks, true);
+        drawSection(ProfileSection::AudioRender, true);
+        drawSection(ProfileSection::RewindCapture, true);
+        drawSection(ProfileSection::ModComposition, false);
+        drawSection(ProfileSection::Presentation, false);
+
+        ImGui::EndTable();
+    }
+
+    ImGui::TextDisabled("PPU dot, APU and mapper times are sampled every %llu calls.",
+                        static_cast<unsigned long long>(Profiler::SAMPLE_INTERVAL));
+
+    if(ImGui::Button("Reset")) {
+        Profiler::instance().reset();
+    }
+
+    ImGui::End();
+}
@@ -113,6 +113,7 @@ inline void GeraNESApp::fillNoRomStaticFramebuffer()
 
 inline void GeraNESApp::render()
 {
+    GERANES_PROFILE_SCOPE(Presentation);
     IEmulationHost::ModRenderSnapshot modSnapshot;
     std::vector<uint32_t> modFramebuffer;
     const bool showPendingRomLoadScreen = m_pendingRomLoad.active && !m_emu.valid();
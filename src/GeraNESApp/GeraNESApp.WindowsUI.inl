@@ -20,6 +20,7 @@
 #include "GeraNESApp/GeraNESApp.MemoryCompareWindowUI.inl"
 #include "GeraNESApp/GeraNESApp.CpuDebuggerWindowUI.inl"
 #include "GeraNESApp/GeraNESApp.CpuBreakpointsWindowUI.inl"
+#include "GeraNESApp/GeraNESApp.ProfilerWindowUI.inl"
 #include "GeraNESApp/GeraNESApp.InputMiniaturesOverlayUI.inl"
 
 inline void GeraNESApp::showGui()
@@ -114,6 +115,10 @@ inline void GeraNESApp::showGui()
         m_cpuBreakpointsFocused = false;
     }
 
+    if(m_showProfilerWindow) {
+        drawProfilerWindow();
+    }
+
     if(m_showAboutWindow) {
         drawAboutWindow();
     }
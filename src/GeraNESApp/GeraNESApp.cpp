@@ -2073,16 +2073,32 @@ bool GeraNESApp::shouldSuppressRewindForNetplay() const
 
 void GeraNESApp::applyEffectiveRewindSettings()
 {
-    static int lastAppliedEffectiveMaxRewindTime = -1;
-    const int effectiveMaxRewindTime = shouldSuppressRewindForNetplay()
+    static int lastAppliedEffectiveRewindMemoryMB = -1;
+    const int effectiveRewindMemoryMB = shouldSuppressRewindForNetplay()
         ? 0
-        : std::max(0, AppSettings::instance().data.improvements.maxRewindTime);
-    if(effectiveMaxRewindTime == lastAppliedEffectiveMaxRewindTime) {
+        : std::max(0, AppSettings::instance().data.improvements.rewindMemoryMB);
+    if(effectiveRewindMemoryMB == lastAppliedEffectiveRewindMemoryMB) {
         return;
     }
 
-    lastAppliedEffectiveMaxRewindTime = effectiveMaxRewindTime;
-    m_emu.setupRewindSystem(effectiveMaxRewindTime > 0, effectiveMaxRewindTime);
+    lastAppliedEffectiveRewindMemoryMB = effectiveRewindMemoryMB;
+    m_emu.setupRewindSystem(effectiveRewindMemoryMB > 0, effectiveRewindMemoryMB);
+}
+
+// Netplay already delays input on purpose and drives frames from the session, so
+// run-ahead is held off the same way rewind is.
+void GeraNESApp::applyEffectiveRunAheadSettings()
+{
+    static int lastAppliedEffectiveRunAheadFrames = -1;
+    const int effectiveRunAheadFrames = shouldSuppressRewindForNetplay()
+        ? 0
+        : std::clamp(AppSettings::instance().data.improvements.runAheadFrames, 0, static_cast<int>(RunAhead::MAX_FRAMES));
+    if(effectiveRunAheadFrames == lastAppliedEffectiveRunAheadFrames) {
+        return;
+    }
+
+    lastAppliedEffectiveRunAheadFrames = effectiveRunAheadFrames;
+    m_emu.setRunAheadFrames(static_cast<uint32_t>(effectiveRunAheadFrames));
 }
 
 bool GeraNESApp::isTouchCompatibleControllerDevice(Settings::Device device)
@@ -2749,6 +2765,7 @@ void GeraNESApp::refreshModFrameCaptureHook()
             return false;
         }
 
+        GERANES_PROFILE_SCOPE(ModComposition);
         ModManager::ChrRenderSnapshot modSnapshot;
         const ModManager::OverscanConfig overscan = effectiveOverscan();
         const bool captureDebugSnapshot = m_showModPixelInspectorWindow;
@@ -2828,10 +2845,10 @@ bool GeraNESApp::finishOpenRomPath(const fs::path& requestedPath, const std::str
         Logger::Type::INFO
     );
     if(modDefinitionLoaded && m_emu.open(effectivePath, AppSettings::instance().data.input.automaticOnRomLoad)) {
-        const int effectiveMaxRewindTime = shouldSuppressRewindForNetplay()
+        const int effectiveRewindMemoryMB = shouldSuppressRewindForNetplay()
             ? 0
-            : std::max(0, AppSettings::instance().data.improvements.maxRewindTime);
-        m_emu.setupRewindSystem(effectiveMaxRewindTime > 0, effectiveMaxRewindTime);
+            : std::max(0, AppSettings::instance().data.improvements.rewindMemoryMB);
+        m_emu.setupRewindSystem(effectiveRewindMemoryMB > 0, effectiveRewindMemoryMB);
         m_inputTopology = normalizeMultitapTopology(m_emu.getInputTopologySnapshot());
         m_preMultitapInputTopology.reset();
 
@@ -3049,9 +3066,9 @@ void GeraNESApp::syncSettings()
     m_inputTopology = normalizeMultitapTopology(m_emu.getInputTopologySnapshot());
     m_preMultitapInputTopology.reset();
 
-    cfg.improvements.maxRewindTime = std::max(0, cfg.improvements.maxRewindTime);
-    const int effectiveMaxRewindTime = shouldSuppressRewindForNetplay() ? 0 : cfg.improvements.maxRewindTime;
-    m_emu.setupRewindSystem(effectiveMaxRewindTime > 0, effectiveMaxRewindTime);
+    cfg.improvements.rewindMemoryMB = std::max(0, cfg.improvements.rewindMemoryMB);
+    const int effectiveRewindMemoryMB = shouldSuppressRewindForNetplay() ? 0 : cfg.improvements.rewindMemoryMB;
+    m_emu.setupRewindSystem(effectiveRewindMemoryMB > 0, effectiveRewindMemoryMB);
     m_emu.disableSpriteLimit(cfg.improvements.disableSpritesLimit);
     m_emu.enableOverclock(cfg.improvements.overclock);
     m_emu.configureNetplaySnapshots(std::max(0, cfg.netplay.snapshotWindowFrames));
@@ -3396,7 +3413,7 @@ GeraNESApp::GeraNESApp()
         }
         auto& cfg = AppSettings::instance().data.netplay;
         ConsoleNetplay::setNetplayDebugLogEnabled(cfg.showNetplayDebugLog);
-        const ConsoleNetplay::RuntimeExecutionSettings runtimeSettings =
+        ConsoleNetplay::RuntimeExecutionSettings runtimeSettings =
             GeraNESNetplay::buildGeraNESRuntimeExecutionSettings(
                 m_emu,
                 cfg.autoGameplayTuning,
@@ -3404,6 +3421,7 @@ GeraNESApp::GeraNESApp()
                 cfg.gameplayReceiveDelayMs,
                 cfg.inputDelayFrames
             );
+        runtimeSettings.inputDelaySettings.rollback = cfg.rollback;
         const ConsoleNetplay::NetplayAppRuntime::UpdateResult updateResult =
             GeraNESNetplay::executeRuntimeFrame(
             m_netplayRuntime,
@@ -5453,6 +5471,7 @@ void GeraNESApp::mainLoop()
     m_touch->update(dt);
     dispatch_queued_calls();
     applyEffectiveRewindSettings();
+    applyEffectiveRunAheadSettings();
     syncReplayRuntimeState();
     pollAndPrepareInput();
 
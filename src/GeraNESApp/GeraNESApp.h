@@ -250,6 +250,7 @@ private:
     std::string m_modPixelInspectorFilter;
     bool m_modPixelInspectorInspectMod = false;
     bool m_showEventViewerWindow = false;
+    bool m_showProfilerWindow = false;
     bool m_ppuEventViewerEnabled = false;
     bool m_showArkanoidNesConfigWindow = false;
     bool m_showArkanoidFamicomConfigWindow = false;
@@ -521,6 +522,7 @@ private:
     void resetShowOriginalGraphicsInsteadOfModFramebuffer();
     bool shouldSuppressRewindForNetplay() const;
     void applyEffectiveRewindSettings();
+    void applyEffectiveRunAheadSettings();
     static bool isTouchCompatibleControllerDevice(Settings::Device device);
     static const char* touchDeviceLabel(Settings::Device device);
     static bool isTouchCompatibleExpansionDevice(Settings::ExpansionDevice device);
@@ -555,6 +557,7 @@ private:
     void drawPpuViewerWindow();
     void drawModPixelInspectorWindow();
     void drawEventViewerWindow();
+    void drawProfilerWindow();
     void drawImprovementsWindow();
     void drawAboutWindow();
     bool openDocumentation();
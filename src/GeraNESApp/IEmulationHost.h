@@ -158,7 +158,8 @@ public:
     virtual bool setAudioChannelVolumeById(const std::string& id, float volume) = 0;
     virtual void setColorPalette(const std::array<uint32_t, 64>& palette) = 0;
     virtual bool valid() const = 0;
-    virtual void setupRewindSystem(bool enabled, int maxSeconds) = 0;
+    virtual void setupRewindSystem(bool enabled, int maxMemoryMB) = 0;
+    virtual void setRunAheadFrames(uint32_t frames) = 0;
     virtual void disableSpriteLimit(bool disabled) = 0;
     virtual bool spriteLimitDisabled() const = 0;
     virtual void enableOverclock(bool enabled) = 0;
@@ -214,6 +215,8 @@ public:
     virtual void updateUntilFrame(uint32_t dt) = 0;
     virtual void configureNetplaySnapshots(size_t snapshotCapacity) = 0;
     virtual std::vector<uint8_t> saveStateToMemory() = 0;
+    virtual StateDigest stateDigest() = 0;
+    virtual std::vector<uint32_t> stateLayout(const std::vector<uint8_t>& state) = 0;
     virtual bool loadStateFromMemory(const std::vector<uint8_t>& data) = 0;
     virtual bool loadStateFromMemoryOnCleanBoot(const std::vector<uint8_t>& data) = 0;
     virtual bool loadStateFromMemoryAsManualStateChange(const std::vector<uint8_t>& data) = 0;
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+
+#include "GeraNES/GeraNESEmu.h"
+using namespace GeraNES;
+
+// Hides input latency by presenting the frame the game would show a few frames from now
+// if the player kept holding the current input. The emulator itself never runs ahead or
+// rolls back: a silent fork is brought to its state after every frame with
+// copyStateFrom() and emulated the extra frames, and only its picture is shown.
+class RunAhead
+{
+public:
+    static constexpr uint32_t MAX_FRAMES = 4;
+
+private:
+    uint32_t m_frames = 0;
+    std::unique_ptr<GeraNESEmu> m_ahead;
+
+public:
+    void setFrames(uint32_t frames)
+    {
+        m_frames = std::min(frames, MAX_FRAMES);
+        if(m_frames == 0) {
+            m_ahead.reset();
+        }
+    }
+
+    uint32_t frames() const
+    {
+        return m_frames;
+    }
+
+    bool enabled() const
+    {
+        return m_frames > 0;
+    }
+
+    // Drops the fork; the next run() makes a new one.
+    void reset()
+    {
+        m_ahead.reset();
+    }
+
+    // Call right after emu completes a frame. Returns the framebuffer frames() frames
+    // later, or nullptr when run-ahead is off or the frames could not be emulated.
+    const uint32_t* run(GeraNESEmu& emu)
+    {
+        const GeraNESEmu* ahead = advance(emu);
+        return ahead != nullptr ? ahead->getFramebuffer() : nullptr;
+    }
+
+    // Same as run(), but hands back the fork itself for frontends that read its indexed
+    // framebuffer and palette. Valid until the next call or reset().
+    const GeraNESEmu* advance(GeraNESEmu& emu)
+    {
+        if(!enabled() || !emu.valid()) return nullptr;
+
+        if(m_ahead == nullptr || !m_ahead->copyStateFrom(emu)) {
+            m_ahead = emu.fork();
+            if(m_ahead == nullptr) return nullptr;
+        }
+
+        if(m_ahead->getConsole().ppu().colorPalette() != emu.getConsole().ppu().colorPalette()) {
+            m_ahead->getConsole().ppu().setColorPalette(emu.getConsole().ppu().colorPalette());
+        }
+
+        const uint32_t frameDt = std::max<uint32_t>(1u, 1000u / std::max<uint32_t>(1u, emu.getRegionFPS()));
+        for(uint32_t i = 0; i < m_frames; ++i) {
+            const uint32_t frame = m_ahead->frameCount();
+            InputFrame input = m_ahead->currentInputFrame().value_or(m_ahead->createInputFrame(frame));
+            input.frame = frame;
+            if(!m_ahead->setPlaybackInputFrame(input)) return nullptr;
+            if(!m_ahead->updateUntilFrame(frameDt, false)) return nullptr;
+        }
+
+        return m_ahead.get();
+    }
+};
@@ -366,9 +366,13 @@ void SingleThreadEmulationHost::onFrameReady()
         refreshPpuEventViewerSnapshot();
         return;
     }
+    const uint32_t* runAheadFramebuffer = nullptr;
+    if(m_runAhead.enabled() && !m_emu.paused() && !m_emu.isRewinding() && !m_replayPlayback.seeking) {
+        runAheadFramebuffer = m_runAhead.run(m_emu);
+    }
     std::memcpy(
         m_presentedFramebuffer.data(),
-        m_emu.getFramebuffer(),
+        runAheadFramebuffer != nullptr ? runAheadFramebuffer : m_emu.getFramebuffer(),
         m_presentedFramebuffer.size() * sizeof(uint32_t)
     );
 
@@ -742,6 +746,16 @@ std::vector<uint8_t> SingleThreadEmulationHost::saveStateToMemory()
     return data;
 }
 
+StateDigest SingleThreadEmulationHost::stateDigest()
+{
+    return m_emu.stateDigest();
+}
+
+std::vector<uint32_t> SingleThreadEmulationHost::stateLayout(const std::vector<uint8_t>& state)
+{
+    return m_emu.stateLayout(state);
+}
+
 bool SingleThreadEmulationHost::loadStateFromMemory(const std::vector<uint8_t>& data)
 {
     return loadStateFromMemoryOnCleanBoot(data);
@@ -16,6 +16,7 @@
 #include "GeraNESApp/IEmulationHost.h"
 #include "GeraNESApp/PendingInputFrames.h"
 #include "GeraNESApp/ReplayPlaybackController.h"
+#include "GeraNESApp/RunAhead.h"
 #include "GeraNES/GeraNESEmu.h"
 #include "GeraNES/PPU.h"
 using namespace GeraNES;
@@ -210,6 +211,7 @@ private:
 
     GeraNESEmu m_emu;
     IAudioOutput& m_audioOutput;
+    RunAhead m_runAhead;
     bool m_holdPresentedFramebufferUntilFrameReady = false;
     std::vector<uint32_t> m_presentedFramebuffer =
         std::vector<uint32_t>(PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT, 0);
@@ -421,9 +423,14 @@ public:
         return m_emu.valid();
     }
 
-    void setupRewindSystem(bool enabled, int maxSeconds)
+    void setupRewindSystem(bool enabled, int maxMemoryMB)
      override{
-        m_emu.setupRewindSystem(enabled, maxSeconds);
+        m_emu.setupRewindSystem(enabled, static_cast<size_t>(maxMemoryMB));
+    }
+
+    void setRunAheadFrames(uint32_t frames) override
+    {
+        m_runAhead.setFrames(frames);
     }
 
     void disableSpriteLimit(bool disabled)
@@ -482,6 +489,7 @@ public:
     {
         resetFreeRunningPacing();
         m_emu.closeRom();
+        m_runAhead.reset();
         refreshPresentedFramebuffer();
     }
 
@@ -633,6 +641,8 @@ public:
     void updateUntilFrame(uint32_t dt) override;
     void configureNetplaySnapshots(size_t snapshotCapacity) override;
     std::vector<uint8_t> saveStateToMemory() override;
+    StateDigest stateDigest() override;
+    std::vector<uint32_t> stateLayout(const std::vector<uint8_t>& state) override;
     bool loadStateFromMemory(const std::vector<uint8_t>& data) override;
     bool loadStateFromMemoryOnCleanBoot(const std::vector<uint8_t>& data) override;
     bool loadStateFromMemoryAsManualStateChange(const std::vector<uint8_t>& data) override;
@@ -532,13 +532,18 @@ void ThreadedEmulationHost::publishPresentedStateLocked(bool recordNetplayState)
         recordFrameReadyNetplayState(m_emu);
     }
     m_holdPresentedFramebufferUntilFrameReady.store(false, std::memory_order_release);
+    // Emulated before taking the framebuffer lock, so the presenter is not held up.
+    const uint32_t* runAheadFramebuffer = nullptr;
+    if(m_runAhead.enabled() && !m_emu.paused() && !m_emu.isRewinding() && !m_replayPlayback.seeking) {
+        runAheadFramebuffer = m_runAhead.run(m_emu);
+    }
     {
         std::scoped_lock framebufferLock(m_framebufferMutex);
         if(m_emu.valid()) {
             const int backIndex = 1 - m_frontFramebufferIndex.load(std::memory_order_relaxed);
             std::memcpy(
                 m_framebuffers[backIndex].data(),
-                m_emu.getFramebuffer(),
+                runAheadFramebuffer != nullptr ? runAheadFramebuffer : m_emu.getFramebuffer(),
                 m_framebuffers[backIndex].size() * sizeof(uint32_t)
             );
             m_frontFramebufferIndex.store(backIndex, std::memory_order_release);
@@ -1008,6 +1013,26 @@ std::vector<uint8_t> ThreadedEmulationHost::saveStateToMemory()
     return data;
 }
 
+StateDigest ThreadedEmulationHost::stateDigest()
+{
+    if(hasDirectEmuAccess()) {
+        return m_emu.stateDigest();
+    }
+
+    std::scoped_lock emuLock(m_emuMutex);
+    return m_emu.stateDigest();
+}
+
+std::vector<uint32_t> ThreadedEmulationHost::stateLayout(const std::vector<uint8_t>& state)
+{
+    if(hasDirectEmuAccess()) {
+        return m_emu.stateLayout(state);
+    }
+
+    std::scoped_lock emuLock(m_emuMutex);
+    return m_emu.stateLayout(state);
+}
+
 bool ThreadedEmulationHost::loadStateFromMemory(const std::vector<uint8_t>& data)
 {
     return loadStateFromMemoryOnCleanBoot(data);
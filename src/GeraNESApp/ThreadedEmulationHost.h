@@ -21,6 +21,7 @@
 #include "GeraNESApp/IEmulationHost.h"
 #include "GeraNESApp/PendingInputFrames.h"
 #include "GeraNESApp/ReplayPlaybackController.h"
+#include "GeraNESApp/RunAhead.h"
 #include "GeraNES/GeraNESEmu.h"
 #include "GeraNES/PPU.h"
 using namespace GeraNES;
@@ -200,6 +201,7 @@ private:
     };
 
     GeraNESEmu m_emu;
+    RunAhead m_runAhead; // Worker thread only.
     IAudioOutput& m_audioOutput;
     mutable std::mutex m_emuMutex;
     mutable std::mutex m_snapshotMutex;
@@ -546,10 +548,18 @@ public:
         return m_snapshot.valid;
     }
 
-    void setupRewindSystem(bool enabled, int maxSeconds) override
+    void setupRewindSystem(bool enabled, int maxMemoryMB) override
     {
         postCommand([=](GeraNESEmu& emu) {
-            emu.setupRewindSystem(enabled, maxSeconds);
+            emu.setupRewindSystem(enabled, static_cast<size_t>(maxMemoryMB));
+        });
+    }
+
+    void setRunAheadFrames(uint32_t frames) override
+    {
+        postCommand([this, frames](GeraNESEmu& emu) {
+            (void)emu;
+            m_runAhead.setFrames(frames);
         });
     }
 
@@ -621,6 +631,7 @@ public:
         m_holdPresentedFramebufferUntilFrameReady.store(false, std::memory_order_release);
         postCommand([this](GeraNESEmu& emu) {
             emu.closeRom();
+            m_runAhead.reset();
             {
                 std::scoped_lock framebufferLock(m_framebufferMutex);
                 for(auto& framebuffer : m_framebuffers) {
@@ -822,6 +833,8 @@ public:
     void updateUntilFrame(uint32_t dt) override;
     void configureNetplaySnapshots(size_t snapshotCapacity) override;
     std::vector<uint8_t> saveStateToMemory() override;
+    StateDigest stateDigest() override;
+    std::vector<uint32_t> stateLayout(const std::vector<uint8_t>& state) override;
     bool loadStateFromMemory(const std::vector<uint8_t>& data) override;
     bool loadStateFromMemoryOnCleanBoot(const std::vector<uint8_t>& data) override;
     bool loadStateFromMemoryAsManualStateChange(const std::vector<uint8_t>& data) override;
@@ -0,0 +1,499 @@
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#if defined(_WIN32)
+    #ifndef NOMINMAX
+        #define NOMINMAX
+    #endif
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <sched.h>
+#endif
+
+#include <nlohmann/json.hpp>
+
+#include "GeraNES/GeraNESEmu.h"
+#include "GeraNES/IAudioOutput.h"
+#include "GeraNES/Profiler.h"
+#include "GeraNES/defines.h"
+#include "GeraNES/util/MapperUtil.h"
+
+using namespace GeraNES;
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    struct Options
+    {
+        std::vector<fs::path> romPaths;
+        uint32_t frames = 1800;
+        uint32_t warmupFrames = 60;
+        uint32_t repetitions = 3;
+        bool audio = false;
+        bool video = false;
+        std::optional<uint32_t> pinCore;
+        fs::path outPath;
+        fs::path profilePath;
+    };
+
+    // Swallows the APU output but still touches every sample, so "audio on" costs what
+    // the resampler and mixer cost without depending on an audio device.
+    class CountingAudioOutput : public IAudioOutput
+    {
+    public:
+        uint64_t samples = 0;
+        float checksum = 0.0f;
+
+        void addSample(float sample) override
+        {
+            ++samples;
+            checksum += sample;
+        }
+
+        void addSampleDirect(float /*period*/, float sample) override
+        {
+            ++samples;
+            checksum += sample;
+        }
+    };
+
+    struct RunResult
+    {
+        double seconds = 0.0;
+        uint32_t frames = 0;
+        uint64_t cpuCycles = 0;
+        ProfileReport profile;
+
+        double fps() const { return seconds > 0.0 ? frames / seconds : 0.0; }
+        double nsPerCpuCycle() const { return cpuCycles > 0 ? seconds * 1e9 / static_cast<double>(cpuCycles) : 0.0; }
+    };
+
+    struct RomResult
+    {
+        fs::path path;
+        bool opened = false;
+        int mapperId = -1;
+        std::vector<RunResult> runs;
+        ProfileReport profile;
+
+        // The median run stands for the ROM in the aggregates; best and worst are reported
+        // next to it so noisy machines are easy to spot.
+        const RunResult& medianRun() const
+        {
+            std::vector<const RunResult*> sorted;
+            for(const RunResult& run : runs) sorted.push_back(&run);
+            std::sort(sorted.begin(), sorted.end(), [](const RunResult* a, const RunResult* b) {
+                return a->fps() < b->fps();
+            });
+            return *sorted[sorted.size() / 2];
+        }
+    };
+
+    void printUsage()
+    {
+        std::cerr
+            << "Usage:\n"
+            << "  GeraNESBench [options] <rom_or_dir>...\n\n"
+            << "Runs every ROM headless and prints a JSON report.\n"
+            << "Directories are searched recursively for .nes, .fds and .unf files.\n\n"
+            << "Options:\n"
+            << "  --frames <n>   Timed frames per run. Default: 1800\n"
+            << "  --warmup <n>   Untimed frames run after power on. Default: 60\n"
+            << "  --repeat <n>   Runs per ROM, each on a fresh emulator. Default: 3\n"
+            << "  --list <file>  Read ROM paths from a file, one per line.\n"
+            << "  --audio        Render audio into a null sink.\n"
+            << "  --video        Copy out the presented framebuffer every frame.\n"
+            << "  --pin <core>   Pin the benchmark thread to one CPU core.\n"
+            << "  --out <file>   Write the JSON report to a file instead of stdout.\n"
+            << "  --profile <file>  Write per-subsystem timings of the timed frames to a JSON file.\n"
+            << "                    Needs a build configured with GERANES_ENABLE_PROFILING.\n";
+    }
+
+    bool parseUintArg(const char* value, uint32_t& outValue)
+    {
+        if(value == nullptr || value[0] == '\0') return false;
+
+        char* end = nullptr;
+        const unsigned long parsed = std::strtoul(value, &end, 10);
+        if(end == value || (end != nullptr && *end != '\0')) return false;
+        if(parsed > std::numeric_limits<uint32_t>::max()) return false;
+
+        outValue = static_cast<uint32_t>(parsed);
+        return true;
+    }
+
+    bool isRomFile(const fs::path& path)
+    {
+        std::string ext = path.extension().string();
+        std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return ext == ".nes" || ext == ".fds" || ext == ".unf";
+    }
+
+    void addRomPath(const fs::path& path, std::vector<fs::path>& out)
+    {
+        std::error_code ec;
+        if(fs::is_directory(path, ec)) {
+            std::vector<fs::path> found;
+            for(const fs::directory_entry& entry : fs::recursive_directory_iterator(path, ec)) {
+                if(entry.is_regular_file() && isRomFile(entry.path())) {
+                    found.push_back(entry.path());
+                }
+            }
+            std::sort(found.begin(), found.end());
+            out.insert(out.end(), found.begin(), found.end());
+        }
+        else {
+            out.push_back(path);
+        }
+    }
+
+    bool parseArgs(int argc, char* argv[], Options& options)
+    {
+        for(int i = 1; i < argc; ++i) {
+            const std::string arg = argv[i];
+            const bool hasValue = i + 1 < argc;
+
+            if(arg == "--frames" && hasValue) {
+                if(!parseUintArg(argv[++i], options.frames) || options.frames == 0) return false;
+            }
+            else if(arg == "--warmup" && hasValue) {
+                if(!parseUintArg(argv[++i], options.warmupFrames)) return false;
+            }
+            else if(arg == "--repeat" && hasValue) {
+                if(!parseUintArg(argv[++i], options.repetitions) || options.repetitions == 0) return false;
+            }
+            else if(arg == "--list" && hasValue) {
+                std::ifstream list(argv[++i]);
+                if(!list.is_open()) return false;
+                std::string line;
+                while(std::getline(list, line)) {
+                    if(!line.empty() && line.back() == '\r') line.pop_back();
+                    if(!line.empty()) addRomPath(line, options.romPaths);
+                }
+            }
+            else if(arg == "--audio") {
+                options.audio = true;
+            }
+            else if(arg == "--video") {
+                options.video = true;
+            }
+            else if(arg == "--pin" && hasValue) {
+                uint32_t core = 0;
+                if(!parseUintArg(argv[++i], core)) return false;
+                options.pinCore = core;
+            }
+            else if(arg == "--out" && hasValue) {
+                options.outPath = argv[++i];
+            }
+            else if(arg == "--profile" && hasValue) {
+                options.profilePath = argv[++i];
+            }
+            else if(!arg.empty() && arg[0] == '-') {
+                return false;
+            }
+            else {
+                addRomPath(arg, options.romPaths);
+            }
+        }
+
+        return !options.romPaths.empty();
+    }
+
+    bool pinCurrentThread(uint32_t core)
+    {
+#if defined(_WIN32)
+        if(core >= sizeof(DWORD_PTR) * 8) return false;
+        return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << core) != 0;
+#elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core, &set);
+        return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+        (void)core;
+        return false;
+#endif
+    }
+
+    bool advanceFrame(GeraNESEmu& emu, const Options& options, uint32_t frameDtMs)
+    {
+        if(!emu.setPlaybackInputFrame(emu.createInputFrame(emu.frameCount()))) {
+            return false;
+        }
+
+        const uint32_t frameBefore = emu.frameCount();
+        (void)emu.updateUntilFrame(frameDtMs, options.audio);
+        return emu.valid() && emu.frameCount() != frameBefore;
+    }
+
+    std::optional<RunResult> runOnce(const fs::path& romPath, const Options& options, int& mapperId)
+    {
+        CountingAudioOutput audio;
+        GeraNESEmu emu(audio);
+        if(!emu.openRom(romPath.string()) || !emu.valid()) {
+            return std::nullopt;
+        }
+
+        emu.setPaused(false);
+        mapperId = emu.getConsole().cartridge().mapperId();
+
+        const uint32_t fps = std::max<uint32_t>(1, emu.getRegionFPS());
+        const uint32_t frameDtMs = std::max<uint32_t>(1, 1000 / fps);
+
+        for(uint32_t i = 0; i < options.warmupFrames; ++i) {
+            if(!advanceFrame(emu, options, frameDtMs)) return std::nullopt;
+        }
+
+        std::vector<uint32_t> presented(options.video ? PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT : 0);
+        RunResult result;
+        uint32_t lastCycleCounter = emu.getConsole().cpu().cycleCounter();
+
+        Profiler::instance().reset();
+        const auto start = std::chrono::steady_clock::now();
+        for(uint32_t i = 0; i < options.frames; ++i) {
+            if(!advanceFrame(emu, options, frameDtMs)) break;
+
+            // The counter is 32 bits wide; accumulating per frame keeps long runs exact.
+            const uint32_t cycleCounter = emu.getConsole().cpu().cycleCounter();
+            result.cpuCycles += cycleCounter - lastCycleCounter;
+            lastCycleCounter = cycleCounter;
+            ++result.frames;
+
+            if(options.video) {
+                std::memcpy(presented.data(), emu.getFramebuffer(), presented.size() * sizeof(uint32_t));
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        result.profile = Profiler::instance().totalReport();
+        return result;
+    }
+
+    nlohmann::json runToJson(const RunResult& run)
+    {
+        return {
+            {"seconds", run.seconds},
+            {"frames", run.frames},
+            {"cpuCycles", run.cpuCycles},
+            {"fps", run.fps()},
+            {"nsPerCpuCycle", run.nsPerCpuCycle()}
+        };
+    }
+
+    nlohmann::json profileToJson(const ProfileReport& profile)
+    {
+        const double frames = static_cast<double>(std::max<uint64_t>(1, profile.frames));
+        auto sectionJson = [&](double ms, std::optional<uint64_t> calls) {
+            nlohmann::json json = {
+                {"ms", ms},
+                {"msPerFrame", ms / frames},
+                {"percentOfWall", profile.wallMs > 0.0 ? ms * 100.0 / profile.wallMs : 0.0}
+            };
+            if(calls.has_value()) {
+                json["calls"] = *calls;
+                json["callsPerFrame"] = static_cast<double>(*calls) / frames;
+            }
+            return json;
+        };
+
+        nlohmann::json sections = nlohmann::json::object();
+        for(size_t i = 0; i < PROFILE_SECTION_COUNT; ++i) {
+            const ProfileSection section = static_cast<ProfileSection>(i);
+            sections[profileSectionName(section)] = sectionJson(profile.section(section).ms, profile.section(section).calls);
+        }
+        sections["cpuCore"] = sectionJson(profile.cpuCoreMs(), std::nullopt);
+
+        return {
+            {"frames", profile.frames},
+            {"wallMs", profile.wallMs},
+            {"sections", sections}
+        };
+    }
+
+    // Every timed run of every ROM is summed; warmup frames are never included.
+    nlohmann::json buildProfileReport(const std::vector<RomResult>& roms)
+    {
+        nlohmann::json romsJson = nlohmann::json::array();
+        ProfileReport total;
+
+        for(const RomResult& rom : roms) {
+            if(!rom.opened) continue;
+            nlohmann::json entry = profileToJson(rom.profile);
+            entry["path"] = rom.path.generic_string();
+            entry["mapper"] = rom.mapperId;
+            romsJson.push_back(entry);
+            total += rom.profile;
+        }
+
+        return {
+            {"emulatorVersion", GERANES_VERSION},
+            {"sampleInterval", Profiler::SAMPLE_INTERVAL},
+            {"total", profileToJson(total)},
+            {"roms", romsJson}
+        };
+    }
+
+    bool writeJson(const fs::path& path, const nlohmann::json& json)
+    {
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << json.dump(2) << "\n";
+        return out.good();
+    }
+
+    nlohmann::json buildReport(const Options& options, const std::vector<RomResult>& roms, bool pinned)
+    {
+        struct Aggregate
+        {
+            uint32_t roms = 0;
+            RunResult total;
+        };
+
+        nlohmann::json romsJson = nlohmann::json::array();
+        std::map<int, Aggregate> mappers;
+        Aggregate overall;
+        uint32_t failed = 0;
+
+        for(const RomResult& rom : roms) {
+            nlohmann::json entry = {
+                {"path", rom.path.generic_string()},
+                {"status", rom.opened ? "ok" : "open_failed"}
+            };
+
+            if(!rom.opened) {
+                ++failed;
+                romsJson.push_back(entry);
+                continue;
+            }
+
+            const RunResult& median = rom.medianRun();
+            const auto [worst, best] = std::minmax_element(rom.runs.begin(), rom.runs.end(), [](const RunResult& a, const RunResult& b) {
+                return a.fps() < b.fps();
+            });
+
+            nlohmann::json runs = nlohmann::json::array();
+            for(const RunResult& run : rom.runs) runs.push_back(runToJson(run));
+
+            entry["mapper"] = rom.mapperId;
+            entry["mapperName"] = getMapperName(rom.mapperId);
+            entry["median"] = runToJson(median);
+            entry["bestFps"] = best->fps();
+            entry["worstFps"] = worst->fps();
+            entry["runs"] = runs;
+            romsJson.push_back(entry);
+
+            for(Aggregate* aggregate : {&mappers[rom.mapperId], &overall}) {
+                ++aggregate->roms;
+                aggregate->total.seconds += median.seconds;
+                aggregate->total.frames += median.frames;
+                aggregate->total.cpuCycles += median.cpuCycles;
+            }
+        }
+
+        auto aggregateToJson = [](const Aggregate& aggregate) {
+            nlohmann::json json = runToJson(aggregate.total);
+            json["roms"] = aggregate.roms;
+            return json;
+        };
+
+        nlohmann::json mappersJson = nlohmann::json::array();
+        for(const auto& [mapperId, aggregate] : mappers) {
+            nlohmann::json json = aggregateToJson(aggregate);
+            json["mapper"] = mapperId;
+            json["mapperName"] = getMapperName(mapperId);
+            mappersJson.push_back(json);
+        }
+
+        nlohmann::json totalJson = aggregateToJson(overall);
+        totalJson["failedRoms"] = failed;
+
+        return {
+            {"emulatorVersion", GERANES_VERSION},
+            {"config", {
+                {"frames", options.frames},
+                {"warmupFrames", options.warmupFrames},
+                {"repetitions", options.repetitions},
+                {"audio", options.audio},
+                {"video", options.video},
+                {"pinnedCore", options.pinCore.has_value() && pinned ? nlohmann::json(*options.pinCore) : nlohmann::json(nullptr)}
+            }},
+            {"total", totalJson},
+            {"mappers", mappersJson},
+            {"roms", romsJson}
+        };
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if(!parseArgs(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+
+    if(!options.profilePath.empty() && !Profiler::enabled()) {
+        std::cerr << "--profile needs a build configured with GERANES_ENABLE_PROFILING." << std::endl;
+        return 2;
+    }
+
+    bool pinned = false;
+    if(options.pinCore.has_value()) {
+        pinned = pinCurrentThread(*options.pinCore);
+        if(!pinned) {
+            std::cerr << "Could not pin to core " << *options.pinCore << ", running unpinned." << std::endl;
+        }
+    }
+
+    std::vector<RomResult> roms;
+    roms.reserve(options.romPaths.size());
+    for(const fs::path& romPath : options.romPaths) {
+        RomResult rom;
+        rom.path = romPath;
+
+        for(uint32_t rep = 0; rep < options.repetitions; ++rep) {
+            const std::optional<RunResult> run = runOnce(romPath, options, rom.mapperId);
+            if(!run.has_value() || run->frames == 0) {
+                rom.runs.clear();
+                break;
+            }
+            rom.runs.push_back(*run);
+            rom.profile += run->profile;
+        }
+
+        rom.opened = !rom.runs.empty();
+        std::cerr << romPath.generic_string() << ": "
+                  << (rom.opened ? std::to_string(static_cast<int>(rom.medianRun().fps())) + " fps" : std::string("failed"))
+                  << std::endl;
+        roms.push_back(std::move(rom));
+    }
+
+    const nlohmann::json report = buildReport(options, roms, pinned);
+    if(options.outPath.empty()) {
+        std::cout << report.dump(2) << std::endl;
+    }
+    else if(!writeJson(options.outPath, report)) {
+        std::cerr << "Could not write " << options.outPath.generic_string() << std::endl;
+        return 1;
+    }
+
+    if(!options.profilePath.empty() && !writeJson(options.profilePath, buildProfileReport(roms))) {
+        std::cerr << "Could not write " << options.profilePath.generic_string() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
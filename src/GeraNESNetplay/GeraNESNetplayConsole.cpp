@@ -118,6 +118,58 @@ void GeraNESNetplayConsole::discardQueuedInputFramesAfter(FrameNumber frame)
     m_host.discardQueuedNetplayInputsAfter(frame);
 }
 
+bool GeraNESNetplayConsole::saveRollbackState(std::vector<uint8_t>& outState)
+{
+    if(!m_emu.valid()) return false;
+
+    // stateSize() is an upper bound for any state of this ROM and input topology, and
+    // resize() keeps the capacity, so after the first frame this is a plain in-place save.
+    outState.resize(m_emu.stateSize());
+    const size_t written = m_emu.saveStateToMemory(outState.data(), outState.size());
+    if(written == 0) {
+        // Never leave a truncated buffer behind as a usable snapshot.
+        outState = m_emu.saveStateToMemory();
+        return !outState.empty();
+    }
+    outState.resize(written);
+    return true;
+}
+
+bool GeraNESNetplayConsole::loadRollbackState(const std::vector<uint8_t>& state)
+{
+    if(state.empty() || !m_emu.valid()) return false;
+
+    return m_emu.loadStateFromMemory(state.data(), state.size()) && m_emu.valid();
+}
+
+bool GeraNESNetplayConsole::resimulateFrame(const NetplayCoordinator::ConfirmedFrameInputs& inputs,
+                                            uint32_t frameDtMs)
+{
+    IEmulationHost::ReplayFrameInput replayInput;
+    if(!buildReplayFrameInput(inputs, m_emu.frameCount(), replayInput)) {
+        return false;
+    }
+    if(!m_emu.setPlaybackInputFrame(replayInput.frameOverride)) {
+        return false;
+    }
+
+    // The frames being replayed were already shown and heard; only the last one is kept
+    // on screen, and no audio is rendered for any of them.
+    const uint32_t frameBefore = m_emu.frameCount();
+    m_emu.updateUntilFrame(frameDtMs, false);
+    return m_emu.frameCount() == frameBefore + 1u;
+}
+
+bool GeraNESNetplayConsole::stateDigest(NetplayStateDigest& outDigest)
+{
+    if(!m_emu.valid()) return false;
+
+    const StateDigest digest = m_emu.stateDigest();
+    outDigest.root = digest.root;
+    outDigest.components.assign(digest.components.begin(), digest.components.end());
+    return true;
+}
+
 bool GeraNESNetplayConsole::buildReplayFrameInput(const NetplayCoordinator::ConfirmedFrameInputs& confirmed,
                                                   FrameNumber frame,
                                                   IEmulationHost::ReplayFrameInput& outFrame)
@@ -36,6 +36,11 @@ public:
     void queueStandaloneBootstrapInputFrame() override;
     bool queuePlaybackInputFrame(const ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs& confirmed) override;
     void discardQueuedInputFramesAfter(ConsoleNetplay::FrameNumber frame) override;
+    bool saveRollbackState(std::vector<uint8_t>& outState) override;
+    bool loadRollbackState(const std::vector<uint8_t>& state) override;
+    bool resimulateFrame(const ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs& inputs,
+                         uint32_t frameDtMs) override;
+    bool stateDigest(ConsoleNetplay::NetplayStateDigest& outDigest) override;
 
     static bool buildReplayFrameInput(const ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs& confirmed,
                                       ConsoleNetplay::FrameNumber frame,
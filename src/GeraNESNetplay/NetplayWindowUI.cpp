@@ -474,6 +474,11 @@ void drawNetplayWindow(bool& showWindow,
 #else
     cfg.autoGameplayTuning = true;
 #endif
+    ImGui::Checkbox("Rollback##NetplayRollback", &cfg.rollback);
+    if(ImGui::IsItemHovered()) {
+        ImGui::SetTooltip("Plays on predicted input from the other players and corrects it when theirs arrives.\n"
+                          "Lets auto tuning keep the input delay at 1-2 frames. The host's setting applies to the whole room.");
+    }
     cfg.inputDelayFrames = std::clamp(cfg.inputDelayFrames, 1, 16);
     cfg.gameplayReceiveDelayMs = std::clamp(cfg.gameplayReceiveDelayMs, 0, 500);
 
@@ -726,6 +731,16 @@ void drawNetplayWindow(bool& showWindow,
         ImGui::Text("Mapper/Sub: %u / %u", room.romValidation.mapperId, room.romValidation.subMapperId);
         ImGui::Text("Input Delay: %u frame(s)", static_cast<unsigned>(room.inputDelayFrames));
         ImGui::Text("Gameplay Lag: %d ms", cfg.gameplayReceiveDelayMs);
+        if(snapshot.rollbackEnabled) {
+            const ConsoleNetplay::NetplayRollback::Stats& rollback = snapshot.rollbackStats;
+            ImGui::Text("Rollbacks: %llu (last %u, max %u frame(s))",
+                        static_cast<unsigned long long>(rollback.rollbacks),
+                        rollback.lastRollbackDepth,
+                        rollback.maxRollbackDepth);
+            ImGui::Text("Predicted Frames: %llu, pending %u",
+                        static_cast<unsigned long long>(rollback.predictedFrames),
+                        rollback.pendingPredictions);
+        }
 #ifndef NDEBUG
         ImGui::Text("Gameplay Tuning: %s", snapshot.autoSettings.enabled ? "Auto" : "Manual");
         if(!snapshot.autoSettings.lastDecisionReason.empty()) {
@@ -847,6 +862,17 @@ void drawNetplayWindow(bool& showWindow,
         ImGui::Text("Stabilization Frames Remaining: %u", room.stabilizationFramesRemaining);
         ImGui::Text("Stabilization CRC Passes: %u", room.stabilizationCrcPassCount);
         ImGui::Text("Last Remote CRC: %08X @ frame %u", room.lastRemoteCrc32, room.lastRemoteCrcFrame);
+        if(room.lastCrcMismatchFrame != 0) {
+            std::string components;
+            for(size_t i = 0; i < STATE_COMPONENT_COUNT; ++i) {
+                if((room.lastCrcMismatchComponentMask & (1u << i)) == 0) continue;
+                if(!components.empty()) components += ", ";
+                components += stateComponentName(static_cast<StateComponent>(i));
+            }
+            ImGui::Text("Last CRC Mismatch: frame %u (%s)",
+                        room.lastCrcMismatchFrame,
+                        components.empty() ? "components unknown" : components.c_str());
+        }
 
         ImGui::Separator();
         ImGui::Text("Shared Clock: %s", room.sharedClockSynchronized ? "Synchronized" : "Unsynchronized");
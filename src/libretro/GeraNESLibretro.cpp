@@ -20,6 +20,7 @@
 #include "GeraNES/util/FileUtil.h"
 #include "GeraNESApp/AudioOutputBase.h"
 #include "GeraNESApp/PendingInputFrames.h"
+#include "GeraNESApp/RunAhead.h"
 #include "logger/logger.h"
 using namespace GeraNES;
 
@@ -122,6 +123,24 @@ enum {
     , RETRO_ENVIRONMENT_SET_VARIABLE = 70
 };
 
+enum {
+    RETRO_ENVIRONMENT_EXPERIMENTAL = 0x10000,
+    RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE = (47 | RETRO_ENVIRONMENT_EXPERIMENTAL),
+    RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT = (72 | RETRO_ENVIRONMENT_EXPERIMENTAL)
+};
+
+enum {
+    RETRO_AV_ENABLE_VIDEO = 1,
+    RETRO_AV_ENABLE_AUDIO = 2
+};
+
+enum retro_savestate_context {
+    RETRO_SAVESTATE_CONTEXT_NORMAL = 0,
+    RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE = 1,
+    RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_BINARY = 2,
+    RETRO_SAVESTATE_CONTEXT_ROLLBACK_NETPLAY = 3
+};
+
 enum {
     RETRO_DEVICE_NONE = 0,
     RETRO_DEVICE_JOYPAD = 1
@@ -261,8 +280,10 @@ public:
 LibretroAudioOutput g_audio;
 GeraNESEmu g_emu(g_audio);
 PendingInputFrames g_pendingInputFrames;
+RunAhead g_runAhead;
 
 std::array<uint32_t, PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT> g_videoFrame{};
+IndexedColorLut g_videoColorLut{};
 std::string g_tempRomPath;
 std::string g_systemDirectory;
 
@@ -329,6 +350,7 @@ constexpr const char* kOptionDisableSpriteLimit = "geranes_disable_sprite_limit"
 constexpr const char* kOptionOverclock = "geranes_overclock";
 constexpr const char* kOptionVerticalCrop = "geranes_vertical_crop";
 constexpr const char* kOptionRegion = "geranes_region";
+constexpr const char* kOptionRunAhead = "geranes_run_ahead";
 int g_verticalCropPx = 8;
 
 void registerCoreOptions()
@@ -340,6 +362,7 @@ void registerCoreOptions()
         {kOptionOverclock, "Overclock; disabled|enabled"},
         {kOptionVerticalCrop, "Vertical crop (top/bottom lines); 8|0|4|12|16"},
         {kOptionRegion, "Region; NTSC|PAL|Dendy"},
+        {kOptionRunAhead, "Internal run-ahead frames (leave frontend run-ahead off); 0|1|2|3|4"},
         {nullptr, nullptr}
     };
 
@@ -546,6 +569,7 @@ void applyCoreOptions(bool applyRegion = true)
 
     g_emu.disableSpriteLimit(getCoreOptionBool(kOptionDisableSpriteLimit, false));
     g_emu.enableOverclock(getCoreOptionBool(kOptionOverclock, false));
+    g_runAhead.setFrames(static_cast<uint32_t>(std::max(0, getCoreOptionInt(kOptionRunAhead, 0))));
 
     int newCrop = getCoreOptionInt(kOptionVerticalCrop, 8);
     if(newCrop < 0) newCrop = 0;
@@ -639,17 +663,37 @@ void updateControllerState(unsigned port)
     }
 }
 
-void convertVideoFrame()
+void convertVideoFrame(const GeraNESEmu& emu)
 {
-    const uint32_t* src = g_emu.getFramebuffer();
-
-    for(size_t i = 0; i < g_videoFrame.size(); ++i) {
-        const uint32_t p = src[i]; // 0xAABBGGRR
+    // The PPU keeps palette indices; only the LUT gets swizzled to XRGB8888.
+    emu.buildIndexedColorLut(g_videoColorLut);
+    for(uint32_t& p : g_videoColorLut) { // 0xAABBGGRR
         const uint32_t r = (p & 0x000000FFu) << 16;
         const uint32_t g = (p & 0x0000FF00u);
         const uint32_t b = (p & 0x00FF0000u) >> 16;
-        g_videoFrame[i] = r | g | b;
+        p = r | g | b;
+    }
+
+    convertIndexedPixels(emu.getIndexedFramebuffer(), g_videoFrame.data(), g_videoFrame.size(), g_videoColorLut.data());
+}
+
+// Bits of RETRO_AV_ENABLE_*; frontends without the call always want both.
+int frontendAudioVideoEnable()
+{
+    int enable = RETRO_AV_ENABLE_VIDEO | RETRO_AV_ENABLE_AUDIO;
+    if(g_environmentCb != nullptr && !g_environmentCb(RETRO_ENVIRONMENT_GET_AUDIO_VIDEO_ENABLE, &enable)) {
+        enable = RETRO_AV_ENABLE_VIDEO | RETRO_AV_ENABLE_AUDIO;
     }
+    return enable;
+}
+
+int frontendSavestateContext()
+{
+    int context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+    if(g_environmentCb != nullptr && !g_environmentCb(RETRO_ENVIRONMENT_GET_SAVESTATE_CONTEXT, &context)) {
+        context = RETRO_SAVESTATE_CONTEXT_NORMAL;
+    }
+    return context;
 }
 
 void frontendMessage(const std::string& msg, unsigned frames)
@@ -1013,6 +1057,7 @@ RETRO_API void retro_init(void)
 RETRO_API void retro_deinit(void)
 {
     if(g_gameLoaded) {
+        g_runAhead.reset();
         g_emu.closeRom();
         g_gameLoaded = false;
     }
@@ -1130,17 +1175,29 @@ RETRO_API void retro_run(void)
        currentFrameInput.has_value()) {
         (void)g_emu.setPlaybackInputFrame(*currentFrameInput);
     }
-    g_emu.updateUntilFrame(0);
+    const int avEnable = frontendAudioVideoEnable();
+    g_emu.updateUntilFrame(0, (avEnable & RETRO_AV_ENABLE_AUDIO) != 0);
     g_pendingInputFrames.eraseFramesBefore(g_emu.frameCount());
 
-    convertVideoFrame();
+    // Frames the frontend runs ahead itself are never shown: skip the conversion and
+    // dupe. Otherwise the picture may come from the internal run-ahead fork, which runs
+    // silently, so the audio below is always the real frame's.
+    if((avEnable & RETRO_AV_ENABLE_VIDEO) == 0) {
+        if(g_videoCb != nullptr) {
+            g_videoCb(nullptr, PPU::SCREEN_WIDTH, static_cast<unsigned>(getCroppedHeight()), 0);
+        }
+    }
+    else {
+        const GeraNESEmu* ahead = g_runAhead.advance(g_emu);
+        convertVideoFrame(ahead != nullptr ? *ahead : g_emu);
 
-    if(g_videoCb != nullptr) {
-        const auto cropOffset = static_cast<size_t>(g_verticalCropPx) * PPU::SCREEN_WIDTH;
-        g_videoCb(g_videoFrame.data() + cropOffset,
-                  PPU::SCREEN_WIDTH,
-                  static_cast<unsigned>(getCroppedHeight()),
-                  PPU::SCREEN_WIDTH * sizeof(uint32_t));
+        if(g_videoCb != nullptr) {
+            const auto cropOffset = static_cast<size_t>(g_verticalCropPx) * PPU::SCREEN_WIDTH;
+            g_videoCb(g_videoFrame.data() + cropOffset,
+                      PPU::SCREEN_WIDTH,
+                      static_cast<unsigned>(getCroppedHeight()),
+                      PPU::SCREEN_WIDTH * sizeof(uint32_t));
+        }
     }
 
     g_audio.submit();
@@ -1150,22 +1207,22 @@ RETRO_API size_t retro_serialize_size(void)
 {
     if(!g_gameLoaded) return 0;
 
-    SerializationSize s;
-    g_emu.serialization(s);
-    return s.size();
+    return g_emu.stateSize();
 }
 
 RETRO_API bool retro_serialize(void* data, size_t size)
 {
     if(!g_gameLoaded || data == nullptr) return false;
 
-    Serialize s;
-    g_emu.serialization(s);
-    const auto& serialized = s.getData();
+    auto* raw = static_cast<uint8_t*>(data);
+    const size_t written = g_emu.saveStateToMemory(raw, size);
+    if(written == 0) return false;
 
-    if(size < serialized.size()) return false;
-
-    std::memcpy(data, serialized.data(), serialized.size());
+    // stateSize() is an upper bound; keep the tail deterministic. Same-instance run-ahead
+    // states are loaded back a frame later and never compared or stored, so skip it there.
+    if(frontendSavestateContext() != RETRO_SAVESTATE_CONTEXT_RUNAHEAD_SAME_INSTANCE) {
+        std::memset(raw + written, 0, size - written);
+    }
     return true;
 }
 
@@ -1174,9 +1231,7 @@ RETRO_API bool retro_unserialize(const void* data, size_t size)
     if(!g_gameLoaded || data == nullptr || size == 0) return false;
 
     g_pendingInputFrames.clear();
-    const auto* raw = static_cast<const uint8_t*>(data);
-    g_emu.loadStateFromMemory(std::vector<uint8_t>(raw, raw + size));
-    return true;
+    return g_emu.loadStateFromMemory(static_cast<const uint8_t*>(data), size);
 }
 
 RETRO_API void retro_cheat_reset(void)
@@ -1196,6 +1251,7 @@ RETRO_API bool retro_load_game(const struct retro_game_info* game)
 
     if(g_gameLoaded) {
         g_pendingInputFrames.clear();
+        g_runAhead.reset();
         g_emu.closeRom();
         g_gameLoaded = false;
     }
@@ -1209,6 +1265,7 @@ RETRO_API bool retro_load_game(const struct retro_game_info* game)
     g_arkanoidPosition[1] = 0.5f;
 
     bool loaded = false;
+    g_emu.setIndexedFramebufferEnabled(true);
 
     if(game->path != nullptr && std::strlen(game->path) > 0) {
         loaded = g_emu.openRom(game->path);
@@ -1264,6 +1321,7 @@ RETRO_API void retro_unload_game(void)
 {
     if(g_gameLoaded) {
         g_pendingInputFrames.clear();
+        g_runAhead.reset();
         g_emu.closeRom();
     }
 
@@ -0,0 +1,454 @@
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "GeraNES/GeraNESEmu.h"
+#include "GeraNES/IAudioOutput.h"
+#include "GeraNES/util/Crc32.h"
+#include "GeraNES/util/NesAssembler.h"
+#include "SyntheticCartridge.h"
+
+using namespace GeraNES;
+using GeraNESTestSupport::SyntheticCartridge;
+
+// Each workload is a synthetic cartridge that hammers one subsystem in an endless loop.
+// The test case first checks that the loop really exercises what it claims, then times
+// single emulated frames of it. Run `GeraNESComponentBenchmarks "[mmc3]"` and so on to
+// time one subsystem; CTest runs the checks only (--skip-benchmarks).
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // Main loops bump PROGRESS once per iteration; the MMC3 IRQ handler bumps IRQ_PROGRESS.
+    constexpr uint8_t PROGRESS = 0xF0;
+    constexpr uint8_t IRQ_PROGRESS = 0xF1;
+
+    void emitResetPrologue(NesAssembler& a, bool waitForPpu)
+    {
+        a.sei();
+        a.cld();
+        a.ldxImm(0xFF);
+        a.txs();
+        a.ldaImm(0x00);
+        a.staAbs(0x2000);
+        a.staAbs(0x2001);
+        a.staAbs(0x4015);
+        a.ldaImm(0x40); // no APU frame IRQ
+        a.staAbs(0x4017);
+
+        if(waitForPpu) {
+            // PPU register writes are ignored until the second vblank after power on.
+            for(int i = 0; i < 2; ++i) {
+                const uint16_t wait = a.position();
+                a.bitAbs(0x2002);
+                a.bpl(wait);
+            }
+        }
+    }
+
+    void emitLoopTail(NesAssembler& a, uint16_t loop)
+    {
+        a.incZero(PROGRESS);
+        a.jmp(loop);
+    }
+
+    class WorkloadEmu
+    {
+    private:
+        fs::path m_romPath;
+        GeraNESEmu m_emu;
+
+    public:
+        WorkloadEmu(const std::string& name, const SyntheticCartridge& cart)
+            : m_romPath(fs::temp_directory_path() / ("geranes_bench_" + name + ".nes"))
+            , m_emu(DummyAudioOutput::instance())
+        {
+            REQUIRE(cart.writeTo(m_romPath));
+            REQUIRE(m_emu.openRom(m_romPath.string()));
+            REQUIRE(m_emu.valid());
+            m_emu.setPaused(false);
+
+            // Get past power-on and the prologue so every measured frame is steady state.
+            for(int i = 0; i < 4; ++i) {
+                REQUIRE(advanceFrame());
+            }
+        }
+
+        ~WorkloadEmu()
+        {
+            std::error_code ec;
+            fs::remove(m_romPath, ec);
+        }
+
+        bool advanceFrame()
+        {
+            if(!m_emu.setPlaybackInputFrame(m_emu.createInputFrame(m_emu.frameCount()))) {
+                return false;
+            }
+            const uint32_t frameBefore = m_emu.frameCount();
+            (void)m_emu.updateUntilFrame(0);
+            return m_emu.frameCount() == frameBefore + 1u;
+        }
+
+        // Bus accesses over one frame whose address falls in [first, last].
+        uint32_t countAccesses(bool writes, uint16_t first, uint16_t last)
+        {
+            uint32_t count = 0;
+            auto inRange = [&](uint16_t addr) { return addr >= first && addr <= last; };
+            m_emu.setExternalCpuIoHandlers(
+                [&](uint16_t addr, uint8_t) {
+                    if(writes && inRange(addr)) ++count;
+                    return false;
+                },
+                [&](uint16_t addr) -> std::optional<uint8_t> {
+                    if(!writes && inRange(addr)) ++count;
+                    return std::nullopt;
+                });
+            const bool advanced = advanceFrame();
+            m_emu.clearExternalCpuIoHandlers();
+            REQUIRE(advanced);
+            return count;
+        }
+
+        uint32_t countWrites(uint16_t first, uint16_t last) { return countAccesses(true, first, last); }
+        uint32_t countReads(uint16_t first, uint16_t last) { return countAccesses(false, first, last); }
+
+        // INC writes twice: the dummy write of the old value, then the result.
+        uint32_t increments(uint8_t zeroPageAddr) { return countWrites(zeroPageAddr, zeroPageAddr) / 2; }
+
+        std::vector<uint8_t> saveState() { return m_emu.saveStateToMemory(); }
+    };
+
+    SyntheticCartridge aluLoopCartridge()
+    {
+        SyntheticCartridge cart(0);
+        NesAssembler a = cart.assembler(0x8000);
+        emitResetPrologue(a, false);
+
+        const uint16_t loop = a.position();
+        a.ldxImm(0x00);
+        const uint16_t inner = a.position();
+        a.ldaZero(0x10);
+        a.adcImm(0x13);
+        a.eorZero(0x11);
+        a.staZero(0x11);
+        a.aslAcc();
+        a.rolZero(0x12);
+        a.lsrZero(0x13);
+        a.rorAcc();
+        a.sbcImm(0x07);
+        a.andImm(0xF7);
+        a.oraZero(0x14);
+        a.staZero(0x14);
+        a.cmpImm(0x40);
+        a.dex();
+        a.bne(inner);
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0x8000, loop);
+        return cart;
+    }
+
+    SyntheticCartridge addressingCartridge()
+    {
+        SyntheticCartridge cart(0);
+        NesAssembler a = cart.assembler(0x8000);
+        emitResetPrologue(a, false);
+
+        // ($10) -> $0300, ($12) -> $0400, ($14) -> $0600
+        const uint8_t pointers[][2] = {{0x10, 0x03}, {0x12, 0x04}, {0x14, 0x06}};
+        for(const auto& pointer : pointers) {
+            a.ldaImm(0x00);
+            a.staZero(pointer[0]);
+            a.ldaImm(pointer[1]);
+            a.staZero(static_cast<uint8_t>(pointer[0] + 1));
+        }
+
+        const uint16_t loop = a.position();
+        a.ldxImm(0x00);
+        a.ldyImm(0x00);
+        const uint16_t inner = a.position();
+        a.ldaAbsY(0x0300);
+        a.adcAbsX(0x0500);
+        a.staAbsY(0x0400);
+        a.ldaIndY(0x10);
+        a.eorIndY(0x12);
+        a.staIndY(0x12);
+        a.ldaIndX(0x14);
+        a.staZeroX(0x40);
+        a.ldaZeroX(0x40);
+        a.cmpAbsX(0x0700);
+        a.iny();
+        a.bne(inner);
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0x8000, loop);
+        return cart;
+    }
+
+    SyntheticCartridge oamDmaCartridge()
+    {
+        SyntheticCartridge cart(0);
+        NesAssembler a = cart.assembler(0x8000);
+        emitResetPrologue(a, false);
+
+        const uint16_t loop = a.position();
+        a.ldaImm(0x02);
+        a.staAbs(0x4014);
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0x8000, loop);
+        return cart;
+    }
+
+    SyntheticCartridge vramStreamCartridge()
+    {
+        SyntheticCartridge cart(0);
+        NesAssembler a = cart.assembler(0x8000);
+        emitResetPrologue(a, true);
+
+        auto setVramAddress = [&a]() {
+            a.ldaImm(0x20);
+            a.staAbs(0x2006);
+            a.ldaImm(0x00);
+            a.staAbs(0x2006);
+        };
+
+        const uint16_t loop = a.position();
+        setVramAddress();
+        a.ldxImm(0x00);
+        const uint16_t writeLoop = a.position();
+        a.stxAbs(0x2007);
+        a.inx();
+        a.bne(writeLoop);
+        setVramAddress();
+        const uint16_t readLoop = a.position();
+        a.ldaAbs(0x2007);
+        a.inx();
+        a.bne(readLoop);
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0x8000, loop);
+        return cart;
+    }
+
+    // 128KB PRG / 16KB CHR; code lives in the fixed bank at $C000.
+    SyntheticCartridge mmc1SerialCartridge()
+    {
+        SyntheticCartridge cart(1, 8, 2);
+        for(size_t bank = 0; bank < cart.prg().size() / 0x4000; ++bank) {
+            cart.prg()[bank * 0x4000] = static_cast<uint8_t>(bank);
+        }
+
+        NesAssembler a = cart.assembler(0xC000);
+        emitResetPrologue(a, false);
+        a.ldaImm(0x80);
+        a.staAbs(0x8000);
+
+        auto serialWrite = [&a](uint16_t reg) {
+            for(int bit = 0; bit < 5; ++bit) {
+                a.staAbs(reg);
+                if(bit < 4) a.lsrAcc();
+            }
+        };
+
+        a.ldaImm(0x1E); // 16KB PRG at $8000, 4KB CHR banks, vertical mirroring
+        serialWrite(0x8000);
+        a.ldyImm(0x00);
+
+        const uint16_t loop = a.position();
+        a.tya();
+        serialWrite(0xE000);
+        a.tya();
+        serialWrite(0xA000);
+        a.tya();
+        a.eorImm(0xFF);
+        serialWrite(0xC000);
+        a.ldaAbs(0x8000);
+        a.staAbs(0x0200);
+        a.iny();
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0xC000, loop);
+        return cart;
+    }
+
+    // 64KB PRG / 16KB CHR with rendering on so A12 clocks the scanline counter. The IRQ
+    // handler acknowledges and reloads the counter every time it fires while the main
+    // loop cycles through all eight bank registers.
+    SyntheticCartridge mmc3IrqCartridge()
+    {
+        SyntheticCartridge cart(4, 4, 2, true);
+
+        NesAssembler a = cart.assembler(0xE000);
+        emitResetPrologue(a, true);
+        a.ldaImm(0x07);
+        a.staAbs(0xC000);
+        a.staAbs(0xC001);
+        a.staAbs(0xE001);
+        a.ldaImm(0x08); // sprites from $1000
+        a.staAbs(0x2000);
+        a.ldaImm(0x1E);
+        a.staAbs(0x2001);
+        a.cli();
+
+        const uint16_t loop = a.position();
+        a.ldxImm(0x00);
+        const uint16_t storm = a.position();
+        a.txa();
+        a.andImm(0x07);
+        a.staAbs(0x8000);
+        a.txa();
+        a.lsrAcc();
+        a.staAbs(0x8001);
+        a.inx();
+        a.cpxImm(0x40);
+        a.bne(storm);
+        emitLoopTail(a, loop);
+
+        const uint16_t irq = a.position();
+        a.pha();
+        a.staAbs(0xE000);
+        a.ldaImm(0x07);
+        a.staAbs(0xC000);
+        a.staAbs(0xC001);
+        a.staAbs(0xE001);
+        a.incZero(IRQ_PROGRESS);
+        a.pla();
+        a.rti();
+
+        cart.setVectors(irq, 0xE000, irq);
+        return cart;
+    }
+
+    // Looping DMC sample at $C000 at the fastest rate while the CPU idles.
+    SyntheticCartridge dmcCartridge()
+    {
+        SyntheticCartridge cart(0);
+        for(uint16_t addr = 0xC000; addr < 0xD000; ++addr) {
+            cart.poke(addr, static_cast<uint8_t>(addr * 37u));
+        }
+
+        NesAssembler a = cart.assembler(0x8000);
+        emitResetPrologue(a, false);
+        a.ldaImm(0x4F); // loop, rate 15
+        a.staAbs(0x4010);
+        a.ldaImm(0x00); // $C000
+        a.staAbs(0x4012);
+        a.ldaImm(0xFF); // 4081 bytes
+        a.staAbs(0x4013);
+        a.ldaImm(0x10);
+        a.staAbs(0x4015);
+
+        const uint16_t loop = a.position();
+        a.ldxImm(0x20);
+        const uint16_t wait = a.position();
+        a.dex();
+        a.bne(wait);
+        emitLoopTail(a, loop);
+
+        cart.setVectors(loop, 0x8000, loop);
+        return cart;
+    }
+}
+
+TEST_CASE("Component benchmark: ALU loop", "[component-bench][cpu]")
+{
+    WorkloadEmu workload("alu", aluLoopCartridge());
+    REQUIRE(workload.increments(PROGRESS) > 1);
+
+    BENCHMARK("ALU loop, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: indexed and indirect addressing", "[component-bench][cpu]")
+{
+    WorkloadEmu workload("addressing", addressingCartridge());
+    REQUIRE(workload.increments(PROGRESS) > 1);
+    REQUIRE(workload.countWrites(0x0400, 0x04FF) > 500);
+
+    BENCHMARK("Indexed/indirect addressing, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: OAM DMA bursts", "[component-bench][dma]")
+{
+    WorkloadEmu workload("oam_dma", oamDmaCartridge());
+    REQUIRE(workload.countWrites(0x4014, 0x4014) > 40);
+
+    BENCHMARK("OAM DMA bursts, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: $2007 streaming", "[component-bench][ppu]")
+{
+    WorkloadEmu workload("vram_stream", vramStreamCartridge());
+    REQUIRE(workload.countWrites(0x2007, 0x2007) > 1000);
+    REQUIRE(workload.countReads(0x2007, 0x2007) > 1000);
+
+    BENCHMARK("$2007 streaming, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: MMC1 serial bank-switch storm", "[component-bench][mapper][mmc1]")
+{
+    WorkloadEmu workload("mmc1", mmc1SerialCartridge());
+    REQUIRE(workload.countWrites(0x8000, 0xFFFF) > 1000);
+
+    BENCHMARK("MMC1 serial writes, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: MMC3 IRQ reload", "[component-bench][mapper][mmc3]")
+{
+    WorkloadEmu workload("mmc3", mmc3IrqCartridge());
+    REQUIRE(workload.increments(IRQ_PROGRESS) > 20);
+    REQUIRE(workload.countWrites(0x8000, 0x8001) > 1000);
+
+    BENCHMARK("MMC3 bank switching with IRQ reload, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: DMC playback", "[component-bench][apu]")
+{
+    WorkloadEmu workload("dmc", dmcCartridge());
+    REQUIRE(workload.countReads(0xC000, 0xCFFF) > 50);
+
+    BENCHMARK("DMC playback, one frame") {
+        return workload.advanceFrame();
+    };
+}
+
+TEST_CASE("Component benchmark: CRC32 of a save state", "[component-bench][crc32]")
+{
+    WorkloadEmu workload("crc32", aluLoopCartridge());
+    const std::vector<uint8_t> state = workload.saveState();
+    REQUIRE(state.size() > 1024);
+
+    const uint32_t expected = Crc32::updateWith(Crc32::Implementation::BITWISE, ~0u, state.data(), state.size());
+    const auto measure = [&](const char* name, Crc32::Implementation implementation) {
+        if(!Crc32::available(implementation)) return;
+        REQUIRE(Crc32::updateWith(implementation, ~0u, state.data(), state.size()) == expected);
+        BENCHMARK(name) {
+            return Crc32::updateWith(implementation, ~0u, state.data(), state.size());
+        };
+    };
+
+    measure("CRC32 bitwise, one state", Crc32::Implementation::BITWISE);
+    measure("CRC32 slicing-by-8, one state", Crc32::Implementation::SLICING_8);
+    measure("CRC32 PCLMULQDQ, one state", Crc32::Implementation::PCLMUL);
+    measure("CRC32 ARMv8, one state", Crc32::Implementation::ARMV8);
+}
@@ -0,0 +1,255 @@
+// Runs a fixed 6502 workload through both opcode dispatchers (see OpcodeDispatch in
+// CPU2A03.h), checks that their bus-level cycle traces are identical and reports the
+// time each one takes. Built with GERANES_CPU_DISPATCH_SELECTABLE so a single binary can
+// switch between them.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "GeraNES/GeraNESEmu.h"
+#include "GeraNES/util/Crc32.h"
+#include "GeraNES/util/NesAssembler.h"
+#include "SyntheticCartridge.h"
+
+using namespace GeraNES;
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    // NROM-256 image whose reset code loops over a mix of addressing modes, ALU ops,
+    // stack traffic, subroutine calls and a few unofficial opcodes with rendering off.
+    GeraNESTestSupport::SyntheticCartridge buildWorkloadCartridge()
+    {
+        GeraNESTestSupport::SyntheticCartridge cart(0);
+        NesAssembler a = cart.assembler(0x8000);
+        a.sei();
+        a.cld();
+        a.ldxImm(0xFF);
+        a.txs();
+        a.ldaImm(0x00);
+        a.staAbs(0x2000);
+        a.staAbs(0x2001);
+        a.staZero(0x10);
+        a.ldaImm(0x03);
+        a.staZero(0x11);
+
+        const uint16_t outerLoop = a.position();
+        a.ldxImm(0x00);
+        const uint16_t innerLoop = a.position();
+        a.ldaAbsX(0x0300);
+        a.adcImm(0x37);
+        a.staAbsX(0x0300);
+        a.eorZero(0x20);
+        a.rolAcc();
+        a.staZero(0x20);
+        a.ldyImm(0x03);
+        a.ldaIndY(0x10);
+        a.sbcZero(0x21);
+        a.staIndY(0x10);
+        a.ldaIndX(0x10);
+        a.cmpAbsY(0x0400);
+        const uint16_t subroutineCall = a.position();
+        a.jsr(0x0000); // patched below
+        a.inx();
+        a.bne(innerLoop);
+        a.sed();
+        a.adcImm(0x01);
+        a.cld();
+        a.uLaxZero(0x20);
+        a.uDcpAbs(0x0401);
+        a.uIsbZeroX(0x30);
+        a.incZero(0x21);
+        a.jmp(outerLoop);
+
+        const uint16_t subroutine = a.position();
+        a.pha();
+        a.txa();
+        a.aslAcc();
+        a.tay();
+        a.pla();
+        a.lsrAcc();
+        a.incAbsX(0x0400);
+        a.bitZero(0x20);
+        a.php();
+        a.plp();
+        a.rts();
+
+        const uint16_t returnFromInterrupt = a.position();
+        a.rti();
+
+        cart.pokeWord(static_cast<uint16_t>(subroutineCall + 1), subroutine);
+        cart.setVectors(returnFromInterrupt, 0x8000, returnFromInterrupt);
+        return cart;
+    }
+
+    bool advanceFrame(GeraNESEmu& emu)
+    {
+        InputFrame frame;
+        frame.frame = emu.frameCount();
+        if(!emu.setPlaybackInputFrame(frame)) {
+            return false;
+        }
+        const uint32_t frameBefore = emu.frameCount();
+        (void)emu.updateUntilFrame(0);
+        return emu.frameCount() == frameBefore + 1u;
+    }
+
+    struct TraceResult
+    {
+        uint64_t hash = 1469598103934665603ull;
+        uint64_t accesses = 0;
+        uint32_t stateCrc32 = 0;
+    };
+
+    void hashValue(TraceResult& trace, uint64_t value)
+    {
+        for(int i = 0; i < 8; ++i) {
+            trace.hash ^= (value >> (i * 8)) & 0xFF;
+            trace.hash *= 1099511628211ull;
+        }
+    }
+
+    uint32_t stateCrc32(GeraNESEmu& emu)
+    {
+        const std::vector<uint8_t> state = emu.saveStateToMemory();
+        return Crc32::calc(reinterpret_cast<const char*>(state.data()), state.size());
+    }
+
+    // Every CPU bus access, tagged with the emulation tick it happened on.
+    std::optional<TraceResult> traceRun(const std::string& romPath, OpcodeDispatch dispatch, int frames)
+    {
+        GeraNESEmu emu;
+        emu.setOpcodeDispatch(dispatch);
+        if(!emu.openRom(romPath)) {
+            return std::nullopt;
+        }
+
+        TraceResult trace;
+        emu.setExternalCpuIoHandlers(
+            [&](uint16_t addr, uint8_t data) {
+                hashValue(trace, (emu.emulationTickCount() << 25) | (uint64_t(1) << 24) | (uint64_t(addr) << 8) | data);
+                ++trace.accesses;
+                return false;
+            },
+            [&](uint16_t addr) -> std::optional<uint8_t> {
+                hashValue(trace, (emu.emulationTickCount() << 25) | (uint64_t(addr) << 8));
+                ++trace.accesses;
+                return std::nullopt;
+            });
+
+        for(int i = 0; i < frames; ++i) {
+            if(!advanceFrame(emu)) {
+                return std::nullopt;
+            }
+        }
+
+        emu.clearExternalCpuIoHandlers();
+        trace.stateCrc32 = stateCrc32(emu);
+        return trace;
+    }
+
+    struct TimedResult
+    {
+        double ms = 0.0;
+        uint32_t stateCrc32 = 0;
+    };
+
+    std::optional<TimedResult> timedRun(const std::string& romPath, OpcodeDispatch dispatch, int frames)
+    {
+        GeraNESEmu emu;
+        emu.setOpcodeDispatch(dispatch);
+        if(!emu.openRom(romPath)) {
+            return std::nullopt;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for(int i = 0; i < frames; ++i) {
+            if(!advanceFrame(emu)) {
+                return std::nullopt;
+            }
+        }
+        const auto end = std::chrono::steady_clock::now();
+
+        return TimedResult{std::chrono::duration<double, std::milli>(end - start).count(), stateCrc32(emu)};
+    }
+
+    const char* dispatchName(OpcodeDispatch dispatch)
+    {
+        return dispatch == OpcodeDispatch::Switch ? "switch" : "table";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int traceFrames = 60;
+    int benchFrames = 600;
+
+    for(int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if(arg == "--trace-frames" && i + 1 < argc) {
+            traceFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else if(arg == "--frames" && i + 1 < argc) {
+            benchFrames = std::max(1, std::atoi(argv[++i]));
+        }
+        else {
+            std::fprintf(stderr, "Usage: %s [--trace-frames N] [--frames N]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    const fs::path romPath = fs::temp_directory_path() / "geranes_cpu_dispatch_workload.nes";
+    if(!buildWorkloadCartridge().writeTo(romPath)) {
+        std::fprintf(stderr, "Could not write %s\n", romPath.string().c_str());
+        return 1;
+    }
+
+    const std::optional<TraceResult> tableTrace = traceRun(romPath.string(), OpcodeDispatch::Table, traceFrames);
+    const std::optional<TraceResult> switchTrace = traceRun(romPath.string(), OpcodeDispatch::Switch, traceFrames);
+    if(!tableTrace.has_value() || !switchTrace.has_value()) {
+        std::fprintf(stderr, "Workload ROM failed to run\n");
+        fs::remove(romPath);
+        return 1;
+    }
+
+    const bool tracesMatch = tableTrace->hash == switchTrace->hash &&
+                             tableTrace->accesses == switchTrace->accesses &&
+                             tableTrace->stateCrc32 == switchTrace->stateCrc32;
+    std::printf("cycle trace (%d frames): table %016llX/%llu, switch %016llX/%llu -> %s\n",
+                traceFrames,
+                static_cast<unsigned long long>(tableTrace->hash), static_cast<unsigned long long>(tableTrace->accesses),
+                static_cast<unsigned long long>(switchTrace->hash), static_cast<unsigned long long>(switchTrace->accesses),
+                tracesMatch ? "identical" : "MISMATCH");
+
+    bool statesMatch = true;
+    uint32_t expectedState = 0;
+    for(const OpcodeDispatch dispatch : {OpcodeDispatch::Table, OpcodeDispatch::Switch}) {
+        const std::optional<TimedResult> result = timedRun(romPath.string(), dispatch, benchFrames);
+        if(!result.has_value()) {
+            std::fprintf(stderr, "Workload ROM failed to run\n");
+            fs::remove(romPath);
+            return 1;
+        }
+        if(dispatch == OpcodeDispatch::Table) {
+            expectedState = result->stateCrc32;
+        }
+        else {
+            statesMatch = result->stateCrc32 == expectedState;
+        }
+        std::printf("%-6s %d frames: %.1f ms (%.3f ms/frame), state crc %08X%s\n",
+                    dispatchName(dispatch), benchFrames, result->ms, result->ms / benchFrames, result->stateCrc32,
+                    dispatch == DEFAULT_OPCODE_DISPATCH ? " [build default]" : "");
+    }
+
+    fs::remove(romPath);
+    return (tracesMatch && statesMatch) ? 0 : 1;
+}
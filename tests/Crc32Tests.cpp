@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ConsoleNetplay/NetplayCrc32.h"
+#include "GeraNES/util/Crc32.h"
+
+using namespace GeraNES;
+
+TEST_CASE("CRC32 implementations agree with the bitwise reference", "[crc32]")
+{
+    std::vector<uint8_t> data(64 * 1024 + 37);
+    uint32_t seed = 0x12345678u;
+    for(uint8_t& byte : data) {
+        seed = seed * 1664525u + 1013904223u;
+        byte = static_cast<uint8_t>(seed >> 24);
+    }
+
+    REQUIRE(Crc32::calc("123456789", 9) == 0xCBF43926u);
+
+    const Crc32::Implementation implementations[] = {
+        Crc32::Implementation::SLICING_8,
+        Crc32::Implementation::PCLMUL,
+        Crc32::Implementation::ARMV8,
+    };
+    for(Crc32::Implementation implementation : implementations) {
+        if(!Crc32::available(implementation)) continue;
+        INFO("implementation " << static_cast<int>(implementation));
+
+        // Every length around the block sizes, from unaligned starts, with a non-trivial
+        // incoming register.
+        for(size_t offset = 0; offset < 16; ++offset) {
+            for(size_t size = 0; size <= 300; ++size) {
+                const uint32_t expected = Crc32::updateBitwise(~0u ^ static_cast<uint32_t>(size), data.data() + offset, size);
+                REQUIRE(Crc32::updateWith(implementation, ~0u ^ static_cast<uint32_t>(size), data.data() + offset, size) == expected);
+            }
+        }
+
+        const uint32_t expected = Crc32::updateBitwise(~0u, data.data(), data.size());
+        REQUIRE(Crc32::updateWith(implementation, ~0u, data.data(), data.size()) == expected);
+    }
+
+    // Chained adds and the running class match one call over the whole buffer.
+    Crc32 chained;
+    chained.add(data.data(), 1000);
+    chained.add(data.data() + 1000, data.size() - 1000);
+    const uint32_t whole = Crc32::calc(data.data(), data.size());
+    REQUIRE(chained.get() == whole);
+
+    Crc32 resumed(Crc32::calc(data.data(), 4097));
+    resumed.add(data.data() + 4097, data.size() - 4097);
+    REQUIRE(resumed.get() == whole);
+}
+
+TEST_CASE("Netplay CRC32 is the core CRC32", "[crc32][netplay]")
+{
+    std::vector<uint8_t> data(4096 + 5);
+    for(size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<uint8_t>(i * 31u + 7u);
+    }
+
+    REQUIRE(ConsoleNetplay::crc32(data.data(), data.size()) == Crc32::calc(data.data(), data.size()));
+    REQUIRE(ConsoleNetplay::crc32(data.data() + 3, 1000) == ~Crc32::updateBitwise(~0u, data.data() + 3, 1000));
+}
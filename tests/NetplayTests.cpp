@@ -19,6 +19,7 @@
 #include "GeraNESNetplay/GeraNESInputFrameAdapter.h"
 #include "ConsoleNetplay/DesyncMonitor.h"
 #include "GeraNESNetplay/GeraNESNetplayAdapters.h"
+#include "GeraNESNetplay/GeraNESNetplayConsole.h"
 #include "ConsoleNetplay/SelfStallDetector.h"
 #include "ConsoleNetplay/RemoteInputStallMonitor.h"
 #include "ConsoleNetplay/NetplayAutoTune.h"
@@ -26,8 +27,11 @@
 #include "ConsoleNetplay/NetplayInputAssignment.h"
 #include "ConsoleNetplay/NetplayInputFrameSerialization.h"
 #include "ConsoleNetplay/NetplayAppRuntime.h"
+#include "ConsoleNetplay/NetplayCrc32.h"
+#include "ConsoleNetplay/NetplayRollback.h"
 #include "ConsoleNetplay/NetProtocol.h"
 #include "ConsoleNetplay/NetSerialization.h"
+#include "ConsoleNetplay/ResyncPayload.h"
 #include "ConsoleNetplay/WebRtcPeerConnection.h"
 #include "ConsoleNetplay/WebRtcSignaling.h"
 #include "ConsoleNetplay/WebRtcSignalingClient.h"
@@ -595,6 +599,146 @@ TEST_CASE("Netplay desync monitor drops same-frame CRC history on realignment",
     REQUIRE(remoteMatch.mismatchDetected == false);
 }
 
+TEST_CASE("Netplay desync monitor names the state components that differ", "[netplay][crc][monitor]")
+{
+    ConsoleNetplay::DesyncMonitor monitor;
+
+    ConsoleNetplay::DesyncMonitor::HistoryEntry local;
+    local.frame = 90u;
+    local.crc32 = 0xAAAAAAAAu;
+    local.componentDigests = {1u, 2u, 3u, 4u};
+
+    ConsoleNetplay::DesyncMonitor::HistoryEntry remote = local;
+    remote.crc32 = 0xBBBBBBBBu;
+    remote.componentDigests[2] = 33u;
+
+    REQUIRE(monitor.submitLocalCrc(local).compared == false);
+    const auto mismatch = monitor.submitRemoteCrc(remote);
+    REQUIRE(mismatch.mismatchDetected == true);
+    REQUIRE(mismatch.mismatchedComponentMask == (1u << 2));
+
+    // A peer without component digests still reports the mismatch, just not where.
+    local.frame = remote.frame = 120u;
+    remote.componentDigests.clear();
+    REQUIRE(monitor.submitLocalCrc(local).compared == false);
+    const auto unnamed = monitor.submitRemoteCrc(remote);
+    REQUIRE(unnamed.mismatchDetected == true);
+    REQUIRE(unnamed.mismatchedComponentMask == 0u);
+}
+
+TEST_CASE("Netplay CRC report protocol roundtrip preserves component digests", "[netplay][protocol][crc]")
+{
+    ConsoleNetplay::CrcReportData report;
+    report.timelineEpoch = 4u;
+    report.frame = 600u;
+    report.crc32 = 0x01234567u;
+    report.componentDigests = {0xDEADBEEFu, 0u, 0x89ABCDEFu};
+
+    ConsoleNetplay::PacketWriter writer;
+    report.serialize(writer);
+
+    ConsoleNetplay::CrcReportData decoded;
+    ConsoleNetplay::PacketReader reader(writer.data().data(), writer.data().size());
+    REQUIRE(ConsoleNetplay::CrcReportData::deserialize(reader, decoded));
+    REQUIRE(reader.remaining() == 0u);
+    REQUIRE(decoded.frame == report.frame);
+    REQUIRE(decoded.crc32 == report.crc32);
+    REQUIRE(decoded.componentDigests == report.componentDigests);
+}
+
+TEST_CASE("Netplay resync segment protocol roundtrip preserves segments and masks", "[netplay][protocol][resync]")
+{
+    ConsoleNetplay::ResyncBeginData begin;
+    begin.resyncId = 7u;
+    begin.targetFrame = 1200u;
+    begin.payloadSize = 3000u;
+    begin.payloadCrc32 = 0x55AA55AAu;
+    begin.segments = {{1024u, 0x11111111u}, {1024u, 0x22222222u}, {952u, 0x33333333u}};
+
+    ConsoleNetplay::PacketWriter beginWriter;
+    begin.serialize(beginWriter);
+    ConsoleNetplay::ResyncBeginData decodedBegin;
+    ConsoleNetplay::PacketReader beginReader(beginWriter.data().data(), beginWriter.data().size());
+    REQUIRE(ConsoleNetplay::ResyncBeginData::deserialize(beginReader, decodedBegin));
+    REQUIRE(beginReader.remaining() == 0u);
+    REQUIRE(decodedBegin.segments.size() == 3u);
+    REQUIRE(decodedBegin.segments[1].size == 1024u);
+    REQUIRE(decodedBegin.segments[2].crc32 == 0x33333333u);
+
+    ConsoleNetplay::ResyncSegmentRequestData request;
+    request.resyncId = 7u;
+    request.participantId = 2u;
+    request.segmentMask = {0x05u};
+
+    ConsoleNetplay::PacketWriter requestWriter;
+    request.serialize(requestWriter);
+    ConsoleNetplay::ResyncSegmentRequestData decodedRequest;
+    ConsoleNetplay::PacketReader requestReader(requestWriter.data().data(), requestWriter.data().size());
+    REQUIRE(ConsoleNetplay::ResyncSegmentRequestData::deserialize(requestReader, decodedRequest));
+    REQUIRE(decodedRequest.participantId == 2u);
+    REQUIRE(decodedRequest.segmentMask == request.segmentMask);
+
+    ConsoleNetplay::ResyncSegmentsData segments;
+    segments.resyncId = 7u;
+    segments.segmentMask = {0x05u};
+    segments.rawSize = 1976u;
+    segments.transferSize = 211u;
+    segments.encoding = ConsoleNetplay::ResyncEncoding::Deflate;
+
+    ConsoleNetplay::PacketWriter segmentsWriter;
+    segments.serialize(segmentsWriter);
+    ConsoleNetplay::ResyncSegmentsData decodedSegments;
+    ConsoleNetplay::PacketReader segmentsReader(segmentsWriter.data().data(), segmentsWriter.data().size());
+    REQUIRE(ConsoleNetplay::ResyncSegmentsData::deserialize(segmentsReader, decodedSegments));
+    REQUIRE(decodedSegments.segmentMask == segments.segmentMask);
+    REQUIRE(decodedSegments.rawSize == segments.rawSize);
+    REQUIRE(decodedSegments.transferSize == segments.transferSize);
+    REQUIRE(decodedSegments.encoding == ConsoleNetplay::ResyncEncoding::Deflate);
+}
+
+TEST_CASE("Netplay partial resync rebuilds the payload from a base and the differing segments",
+          "[netplay][resync][partial]")
+{
+    std::vector<uint8_t> authoritative(5000u);
+    for(size_t i = 0; i < authoritative.size(); ++i) {
+        authoritative[i] = static_cast<uint8_t>(i * 7u);
+    }
+    std::vector<uint8_t> base = authoritative;
+    base[100] ^= 0xFFu;
+    base[4500] ^= 0xFFu;
+
+    const std::vector<uint32_t> spans = {16u, 2048u, 2936u};
+    const std::vector<ConsoleNetplay::ResyncSegment> segments =
+        ConsoleNetplay::buildResyncSegments(authoritative, spans);
+    REQUIRE(segments.size() == 6u);
+    REQUIRE(segments[0].size == 16u);
+    REQUIRE(ConsoleNetplay::resyncSegmentsCover(segments, authoritative.size()));
+
+    std::vector<uint8_t> rebuilt(authoritative.size());
+    const std::vector<uint8_t> missing = ConsoleNetplay::reuseResyncSegments(segments, base, rebuilt);
+    REQUIRE(ConsoleNetplay::resyncSegmentMaskCount(missing, segments.size()) == 2u);
+    REQUIRE(ConsoleNetplay::resyncSegmentMasked(missing, 1u));
+    REQUIRE(ConsoleNetplay::resyncSegmentMasked(missing, 5u));
+
+    const std::vector<uint8_t> transfer =
+        ConsoleNetplay::gatherResyncSegments(segments, missing, authoritative);
+    REQUIRE(transfer.size() == 1024u + 888u);
+
+    std::vector<uint8_t> deflated;
+    REQUIRE(ConsoleNetplay::deflateResyncData(transfer, deflated));
+    REQUIRE(deflated.size() < transfer.size());
+    std::vector<uint8_t> inflated;
+    REQUIRE(ConsoleNetplay::inflateResyncData(deflated, transfer.size(), inflated));
+    REQUIRE(inflated == transfer);
+
+    REQUIRE(ConsoleNetplay::scatterResyncSegments(segments, missing, inflated, rebuilt));
+    REQUIRE(rebuilt == authoritative);
+
+    std::vector<uint8_t> unrelated(authoritative.size() - 1u);
+    const std::vector<uint8_t> everything = ConsoleNetplay::reuseResyncSegments(segments, unrelated, rebuilt);
+    REQUIRE(everything == ConsoleNetplay::fullResyncSegmentMask(segments.size()));
+}
+
 TEST_CASE("Periodic netplay CRC skips historical snapshot checkpoints behind live frame",
           "[netplay][crc][runtime][regression]")
 {
@@ -743,6 +887,276 @@ TEST_CASE("Periodic netplay CRC waits for frame-ready frontier to catch confirme
     host.disconnect();
 }
 
+TEST_CASE("Periodic netplay CRC uses the rollback snapshot while running ahead of confirmed input",
+          "[netplay][crc][runtime][rollback]")
+{
+    ConsoleNetplay::NetplayCoordinator host;
+    const uint16_t port = reserveLoopbackPort();
+    for(int attempt = 0; attempt < 64; ++attempt) {
+        if(host.host(port, 1, "Host")) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    INFO(host.lastError());
+    const bool hostAvailable = host.isConnected() || host.isHosting();
+    REQUIRE(hostAvailable);
+
+    auto& room = const_cast<ConsoleNetplay::RoomState&>(host.session().roomState());
+    room.state = ConsoleNetplay::SessionState::Running;
+    room.currentFrame = 30u;
+    room.lastConfirmedFrame = 30u;
+    host.setLocalSimulationFrame(34u);
+
+    ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs confirmed{};
+    confirmed.frame = 30u;
+    confirmed.netplayFrame =
+        GeraNESNetplay::toNetplayInputFrame(GeraNESNetplay::makeRoomTopologyBaseFrame(30u, room));
+    ConsoleNetplay::ConfirmedInputFramesData confirmedData{};
+    confirmedData.timelineEpoch = room.timelineEpoch;
+    confirmedData.startFrame = 30u;
+    confirmedData.frameCount = 1u;
+    REQUIRE(host.injectConfirmedPlaybackFramesForTests(confirmedData, {confirmed}));
+    REQUIRE(host.latestConfirmedFrame() == 30u);
+
+    FakeNetplayStateBridge emu;
+    emu.frameValue = 34u;
+
+    FakeNetplayStateHostBridge runtimeHost;
+    runtimeHost.lastFrameReadyFrameValue = 34u;
+
+    const std::vector<uint8_t> rollbackState = {1u, 2u, 3u, 4u};
+    const auto saveState = [&rollbackState](std::vector<uint8_t>& out) {
+        out = rollbackState;
+        return true;
+    };
+    // This console has no state digest, so its snapshots are compared by their CRC.
+    const auto noDigest = [](ConsoleNetplay::NetplayStateDigest&) { return false; };
+    ConsoleNetplay::NetplayRollback rollback;
+    rollback.setEnabled(true);
+    REQUIRE(rollback.captureSnapshot(30u, saveState));
+
+    ConsoleNetplay::RuntimePeriodicCrcState state;
+    state.nextScheduledLocalCrcFrame = 30u;
+    REQUIRE(ConsoleNetplay::runtimePeriodicCrcMaySubmitFrame(state, 30u));
+    REQUIRE_FALSE(ConsoleNetplay::runtimePeriodicCrcMaySubmitFrame(state, 29u));
+
+    // A snapshot stored without a digester cannot stand in for the live state.
+    auto result = ConsoleNetplay::runtimeSubmitPeriodicLocalCrcIfNeeded(host, emu, runtimeHost, state, &rollback);
+    REQUIRE(result.submitted == false);
+    REQUIRE(rollback.captureSnapshot(30u, saveState, noDigest));
+
+    // An unchecked prediction before the checkpoint makes the snapshot untrustworthy.
+    rollback.recordPrediction(29u, confirmed.netplayFrame);
+    result = ConsoleNetplay::runtimeSubmitPeriodicLocalCrcIfNeeded(host, emu, runtimeHost, state, &rollback);
+    REQUIRE(result.submitted == false);
+
+    rollback.recordConfirmedPlayback(29u);
+    result = ConsoleNetplay::runtimeSubmitPeriodicLocalCrcIfNeeded(host, emu, runtimeHost, state, &rollback);
+    REQUIRE(result.submitted == true);
+    REQUIRE(result.submittedFrame == 30u);
+    REQUIRE(result.submittedCrc32 == ConsoleNetplay::crc32(rollbackState.data(), rollbackState.size()));
+
+    host.disconnect();
+}
+
+TEST_CASE("Netplay rollback finds the first mispredicted frame", "[netplay][rollback][unit]")
+{
+    using ConsoleNetplay::NetplayInputFrame;
+    using ConsoleNetplay::NetplayRollback;
+
+    const auto inputWithMask = [](ConsoleNetplay::FrameNumber frame, uint64_t mask) {
+        NetplayInputFrame input;
+        input.frame = frame;
+        input.buttonMaskLo[GeraNESNetplay::kPort2PlayerSlot] = mask;
+        return input;
+    };
+    const auto saveState = [](std::vector<uint8_t>& out) {
+        out.assign(16u, 0xA5u);
+        return true;
+    };
+
+    NetplayRollback rollback;
+    REQUIRE(rollback.canPredict(10u) == false);
+    rollback.setEnabled(true);
+    REQUIRE(rollback.canPredict(10u) == false);
+
+    REQUIRE(rollback.captureSnapshot(10u, saveState));
+    REQUIRE(rollback.canPredict(10u));
+    for(ConsoleNetplay::FrameNumber frame = 10u; frame < 14u; ++frame) {
+        rollback.recordPrediction(frame, inputWithMask(frame, 0x01u));
+    }
+    REQUIRE(rollback.canPredict(10u + NetplayRollback::kMaxPredictionFrames - 1u));
+    REQUIRE(rollback.canPredict(10u + NetplayRollback::kMaxPredictionFrames) == false);
+    REQUIRE(rollback.stats().predictedFrames == 4u);
+
+    // A neutral slot left out of one side still matches an explicit neutral entry.
+    NetplayInputFrame neutral;
+    neutral.buttonMaskLo[GeraNESNetplay::kPort1PlayerSlot] = 0u;
+    REQUIRE(NetplayRollback::sameInput(neutral, NetplayInputFrame{}));
+
+    std::optional<ConsoleNetplay::FrameNumber> mispredicted = rollback.verify(
+        [&inputWithMask](ConsoleNetplay::FrameNumber frame, NetplayInputFrame& out) {
+            if(frame > 11u) return false;
+            out = inputWithMask(frame, 0x01u);
+            return true;
+        }
+    );
+    REQUIRE(mispredicted.has_value() == false);
+    REQUIRE(rollback.stats().pendingPredictions == 2u);
+    REQUIRE(rollback.hasPredictionBefore(12u) == false);
+    REQUIRE(rollback.hasPredictionBefore(13u));
+
+    mispredicted = rollback.verify(
+        [&inputWithMask](ConsoleNetplay::FrameNumber frame, NetplayInputFrame& out) {
+            out = inputWithMask(frame, frame == 13u ? 0x02u : 0x01u);
+            return true;
+        }
+    );
+    REQUIRE(mispredicted == std::optional<ConsoleNetplay::FrameNumber>(13u));
+    REQUIRE(rollback.stats().pendingPredictions == 0u);
+    REQUIRE(rollback.snapshotForFrame(10u) != nullptr);
+    REQUIRE(rollback.snapshotForFrame(10u + NetplayRollback::kSnapshotCapacity) == nullptr);
+
+    rollback.recordRollback(3u);
+    REQUIRE(rollback.stats().rollbacks == 1u);
+    REQUIRE(rollback.stats().maxRollbackDepth == 3u);
+
+    rollback.recordPrediction(14u, inputWithMask(14u, 0x01u));
+    rollback.syncTimeline(1u, 15u);
+    rollback.syncTimeline(2u, 15u);
+    REQUIRE(rollback.stats().pendingPredictions == 0u);
+    REQUIRE(rollback.snapshotForFrame(10u) == nullptr);
+}
+
+TEST_CASE("Netplay rollback replay ends in the state of a run on the confirmed inputs",
+          "[netplay][rollback][runtime]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    using ConsoleNetplay::FrameNumber;
+    using ConfirmedFrameInputs = ConsoleNetplay::NetplayCoordinator::ConfirmedFrameInputs;
+
+    ConsoleNetplay::NetplayCoordinator host;
+    const uint16_t port = reserveLoopbackPort();
+    for(int attempt = 0; attempt < 64; ++attempt) {
+        if(host.host(port, 1, "Host")) {
+            break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    INFO(host.lastError());
+    const bool hostAvailable = host.isConnected() || host.isHosting();
+    REQUIRE(hostAvailable);
+
+    auto& room = const_cast<ConsoleNetplay::RoomState&>(host.session().roomState());
+    room.state = ConsoleNetplay::SessionState::Running;
+
+    ConsoleNetplay::ParticipantInfo remote;
+    remote.id = 99u;
+    remote.displayName = "Client";
+    remote.connected = true;
+    remote.romLoaded = true;
+    remote.romCompatible = true;
+    remote.role = ConsoleNetplay::ParticipantRole::SessionParticipant;
+    remote.controllerAssignment = GeraNESNetplay::kPort1PlayerSlot;
+    remote.controllerAssignments = {GeraNESNetplay::kPort1PlayerSlot};
+    remote.normalizeControllerAssignments(&room.inputTopology);
+    room.participants.push_back(remote);
+
+    // The remote player holds A from kPressFrame on. Input up to kLastConfirmedFrame arrives
+    // in time; the rest is predicted to stay neutral, which goes wrong at kPressFrame.
+    constexpr FrameNumber kLastConfirmedFrame = 3u;
+    constexpr FrameNumber kPressFrame = 6u;
+    constexpr FrameNumber kEndFrame = 10u;
+    const auto confirmedInput = [&room](FrameNumber frame) {
+        InputFrame input = GeraNESNetplay::makeRoomTopologyBaseFrame(frame, room);
+        setFramePortButtons(input, 1, frame >= kPressFrame);
+        ConfirmedFrameInputs confirmed{};
+        confirmed.frame = frame;
+        confirmed.netplayFrame = GeraNESNetplay::toNetplayInputFrame(input);
+        return confirmed;
+    };
+    const auto confirmFrames = [&host, &room, &confirmedInput](FrameNumber first, FrameNumber end) {
+        std::vector<ConfirmedFrameInputs> frames;
+        for(FrameNumber frame = first; frame < end; ++frame) {
+            frames.push_back(confirmedInput(frame));
+        }
+        ConsoleNetplay::ConfirmedInputFramesData data{};
+        data.timelineEpoch = room.timelineEpoch;
+        data.startFrame = first;
+        data.frameCount = static_cast<uint16_t>(frames.size());
+        REQUIRE(host.injectConfirmedPlaybackFramesForTests(data, frames));
+    };
+
+    EmulationHost referenceHost(DummyAudioOutput::instance());
+    EmulationHost predictedHost(DummyAudioOutput::instance());
+    for(EmulationHost* emulationHost : {&referenceHost, &predictedHost}) {
+        emulationHost->setSimulationSuspended(true);
+        REQUIRE(emulationHost->open(GeraNESTestSupport::romPath().string()));
+        REQUIRE(emulationHost->valid());
+    }
+    const IEmulationHost::InputState noLocalInput{};
+
+    // Both consoles run with their host's emulator locked, as the runtime driver runs them.
+    referenceHost.withExclusiveAccess([&](GeraNESEmu& reference) {
+    predictedHost.withExclusiveAccess([&](GeraNESEmu& predicted) {
+        for(GeraNESEmu* emu : {&reference, &predicted}) {
+            REQUIRE(emu->setPlaybackInputFrame(emu->createInputFrame(0u)));
+            REQUIRE(emu->updateUntilFrame(16u));
+            REQUIRE(emu->frameCount() == 1u);
+        }
+        const uint32_t frameDt = std::max<uint32_t>(1u, 1000u / std::max<uint32_t>(1u, reference.getRegionFPS()));
+
+        GeraNESNetplay::GeraNESNetplayConsole referenceConsole(referenceHost, reference, noLocalInput);
+        for(FrameNumber frame = 1u; frame < kEndFrame; ++frame) {
+            REQUIRE(referenceConsole.resimulateFrame(confirmedInput(frame), frameDt));
+        }
+
+        GeraNESNetplay::GeraNESNetplayConsole console(predictedHost, predicted, noLocalInput);
+        ConsoleNetplay::NetplayRollback rollback;
+        rollback.setEnabled(true);
+        // No CRC is due in this window, so no snapshot should pay for a digest.
+        ConsoleNetplay::RuntimePeriodicCrcState crcState;
+        crcState.nextScheduledLocalCrcFrame = 1000u;
+
+        confirmFrames(1u, kLastConfirmedFrame + 1u);
+        for(FrameNumber frame = 1u; frame < kEndFrame; ++frame) {
+            ConsoleNetplay::runtimeCaptureRollbackSnapshot(rollback, console, crcState);
+            REQUIRE(rollback.snapshotForFrame(frame) != nullptr);
+            REQUIRE_FALSE(rollback.snapshotDigestTaken(frame));
+
+            ConfirmedFrameInputs playbackFrame;
+            bool wasPredicted = false;
+            REQUIRE(host.tryBuildPredictedPlaybackFrame(frame, playbackFrame, wasPredicted));
+            REQUIRE(wasPredicted == (frame > kLastConfirmedFrame));
+            if(wasPredicted) {
+                REQUIRE(rollback.canPredict(frame));
+                rollback.recordPrediction(frame, playbackFrame.netplayFrame);
+            }
+            REQUIRE(console.resimulateFrame(playbackFrame, frameDt));
+        }
+        REQUIRE(predicted.frameCount() == kEndFrame);
+        REQUIRE(stateCrc32(predicted.saveStateToMemory()) != stateCrc32(reference.saveStateToMemory()));
+
+        confirmFrames(kLastConfirmedFrame + 1u, kEndFrame);
+        FakeNetplayStateHostBridge hostBridge;
+        const ConsoleNetplay::RuntimeRollbackResult result =
+            ConsoleNetplay::runtimeRollbackMispredictedFrames(host, rollback, console, hostBridge, crcState);
+        REQUIRE(result.rolledBack);
+        REQUIRE_FALSE(result.failed);
+        REQUIRE(result.fromFrame == kPressFrame);
+        REQUIRE(result.resimulatedFrames == kEndFrame - kPressFrame);
+        REQUIRE(hostBridge.lastDiscardedNetplayInputsAfterFrame == kPressFrame);
+
+        REQUIRE(predicted.frameCount() == kEndFrame);
+        REQUIRE(stateCrc32(predicted.saveStateToMemory()) == stateCrc32(reference.saveStateToMemory()));
+    });
+    });
+
+    host.disconnect();
+}
+
 TEST_CASE("Queued topology mutations stay deferred while assignment recovery is blocked",
           "[netplay][assignment][topology][runtime][regression]")
 {
@@ -847,6 +1261,7 @@ TEST_CASE("Netplay frame status protocol roundtrip preserves dynamic topology",
     status.currentFrame = 321u;
     status.lastConfirmedFrame = 318u;
     status.inputDelayFrames = 3u;
+    status.rollbackEnabled = 1u;
     status.topology.slots = {
         ConsoleNetplay::InputTopologyData::Slot{2u, 1u, 4u, 0x0402u, "Port 2", "Standard Controller"},
         ConsoleNetplay::InputTopologyData::Slot{9u, 1u, 9u, 0x0301u, "Famicom Multitap", "P1"}
@@ -863,6 +1278,7 @@ TEST_CASE("Netplay frame status protocol roundtrip preserves dynamic topology",
     REQUIRE(decoded.currentFrame == status.currentFrame);
     REQUIRE(decoded.lastConfirmedFrame == status.lastConfirmedFrame);
     REQUIRE(decoded.inputDelayFrames == status.inputDelayFrames);
+    REQUIRE(decoded.rollbackEnabled == status.rollbackEnabled);
     REQUIRE(decoded.topology.slots.size() == status.topology.slots.size());
     for(size_t i = 0; i < status.topology.slots.size(); ++i) {
         REQUIRE(decoded.topology.slots[i].slot == status.topology.slots[i].slot);
@@ -1313,6 +1729,55 @@ TEST_CASE("Netplay input frame serialization preserves sparse non-contiguous slo
     REQUIRE(decoded.activeSlots() == std::vector<ConsoleNetplay::PlayerSlot>{2u, 9u, 42u});
 }
 
+TEST_CASE("Netplay packed input frames roundtrip runs, gaps and side masks",
+          "[netplay][frame][serialization][packed]")
+{
+    constexpr uint32_t kEpoch = 3u;
+    std::vector<ConsoleNetplay::PackedInputFrameEntry> entries;
+    for(uint32_t index = 0; index < 32u; ++index) {
+        ConsoleNetplay::PackedInputFrameEntry entry;
+        entry.frame = 100u + index + (index >= 28u ? 12u : 0u);
+        entry.sequence = 50u + index + (index >= 29u ? 5u : 0u);
+        entry.clockMicros = index == 30u ? 0u : 1000000u + static_cast<uint64_t>(index) * 16667u;
+        entry.netplayFrame.frame = entry.frame;
+        entry.netplayFrame.timelineEpoch = index == 31u ? kEpoch - 1u : kEpoch;
+        const uint64_t mask = index < 10u ? 0x01u : (index < 20u ? 0x81u : 0u);
+        if(mask != 0u) {
+            entry.netplayFrame.buttonMaskLo[1u] = mask;
+        }
+        entry.buttonMaskLo[1u] = mask;
+        if(index == 20u) {
+            entry.netplayFrame.slotPayloads[42u] = {0x10u, 0x20u};
+        }
+        if(index == 25u) {
+            entry.buttonMaskHi[9u] = 0x22u;
+        }
+        entries.push_back(entry);
+    }
+
+    ConsoleNetplay::PacketWriter writer;
+    ConsoleNetplay::writePackedInputFrames(writer, kEpoch, entries);
+    REQUIRE(writer.data().size() < entries.size() * 4u);
+
+    std::vector<ConsoleNetplay::PackedInputFrameEntry> decoded;
+    ConsoleNetplay::PacketReader reader(writer.data().data(), writer.data().size());
+    REQUIRE(ConsoleNetplay::readPackedInputFrames(reader, kEpoch, entries.size(), decoded));
+    REQUIRE(reader.remaining() == 0u);
+    REQUIRE(decoded.size() == entries.size());
+    for(size_t index = 0; index < entries.size(); ++index) {
+        INFO(index);
+        REQUIRE(decoded[index].frame == entries[index].frame);
+        REQUIRE(decoded[index].sequence == entries[index].sequence);
+        REQUIRE(decoded[index].clockMicros == entries[index].clockMicros);
+        REQUIRE(decoded[index].netplayFrame == entries[index].netplayFrame);
+        REQUIRE(decoded[index].buttonMaskLo[1u] == entries[index].buttonMaskLo[1u]);
+        REQUIRE(decoded[index].buttonMaskHi[9u] == entries[index].buttonMaskHi[9u]);
+    }
+
+    ConsoleNetplay::PacketReader limitedReader(writer.data().data(), writer.data().size());
+    REQUIRE_FALSE(ConsoleNetplay::readPackedInputFrames(limitedReader, kEpoch, entries.size() - 1u, decoded));
+}
+
 TEST_CASE("Netplay input ack tracking honors sparse slot ids",
           "[netplay][ack][sparse][unit]")
 {
@@ -6105,7 +6570,6 @@ TEST_CASE("Netplay coordinator keeps stale-epoch packets gated during recovery l
     staleInput.buttonMaskLo = 0x1u;
     staleInput.buttonMaskHi = 0u;
     staleInput.sequence = 1u;
-    staleInput.payloadSize = 0u;
     InputFrame staleContribution{};
     staleContribution.frame = staleInput.frame;
     REQUIRE(GeraNESNetplay::injectInputFrameForTests(host, staleInput, staleContribution));
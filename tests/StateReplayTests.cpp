@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <optional>
 #include <thread>
@@ -11,6 +12,9 @@
 
 #include "GeraNESApp/PendingInputFrames.h"
 #include "GeraNESApp/ReplayFile.h"
+#include "GeraNESApp/RunAhead.h"
+#include "GeraNES/Rewind.h"
+#include "GeraNES/util/Crc32.h"
 #include "GeraNESApp/ThreadedEmulationHost.h"
 #include "StateReplayTest.h"
 #include "TestSupport.h"
@@ -140,6 +144,39 @@ namespace
         return emu.valid() && emu.frameCount() == frameBefore + 1u;
     }
 
+    // Console-sized state: a small, busy "RAM" region in front of a mostly static tail,
+    // which is the shape that makes XOR deltas against a keyframe small.
+    class SyntheticRewindTarget : public IRewindable
+    {
+    public:
+        std::vector<uint8_t> state = std::vector<uint8_t>(24 * 1024, 0);
+        std::vector<uint8_t> loaded;
+        uint32_t seed = 1;
+
+        void step()
+        {
+            for(int i = 0; i < 48; ++i) {
+                seed = seed * 1103515245u + 12345u;
+                state[(seed >> 8) % 2048u] = static_cast<uint8_t>(seed >> 24);
+            }
+        }
+
+        void serialization(SerializationBase& s) override
+        {
+            s.array(state.data(), 1, state.size());
+        }
+
+        void loadStateFromMemory(const std::vector<uint8_t>& data) override
+        {
+            loaded = data;
+        }
+
+        int getFPS() override
+        {
+            return 60;
+        }
+    };
+
     bool waitForHostFrame(ThreadedEmulationHost& host, uint32_t targetFrame, std::chrono::milliseconds timeout)
     {
         const auto deadline = std::chrono::steady_clock::now() + timeout;
@@ -283,6 +320,388 @@ TEST_CASE("State replay snapshots roundtrip byte-exact after dirty and clean-boo
     }
 }
 
+TEST_CASE("State saved into a caller buffer matches the vector save and loads in place", "[state-replay][state-buffer]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    for(uint32_t frame = 0; frame < 40u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+
+    const size_t stateSize = emu.stateSize();
+    std::vector<uint8_t> buffer(stateSize, 0xAA);
+    const size_t written = emu.saveStateToMemory(buffer.data(), buffer.size());
+    const std::vector<uint8_t> expected = emu.saveStateToMemory();
+    REQUIRE(written == expected.size());
+    REQUIRE(written <= stateSize);
+    REQUIRE(std::equal(expected.begin(), expected.end(), buffer.begin()));
+    REQUIRE(emu.saveStateToMemory(buffer.data(), written - 1) == 0);
+
+    for(uint32_t frame = 40u; frame < 80u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+    const std::vector<uint8_t> advanced = emu.saveStateToMemory();
+
+    emu.loadStateFromMemory(expected.data(), expected.size());
+    REQUIRE(emu.saveStateToMemory() == expected);
+    for(uint32_t frame = 40u; frame < 80u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+    REQUIRE(emu.saveStateToMemory() == advanced);
+    REQUIRE(emu.stateSize() == stateSize);
+}
+
+TEST_CASE("State size measured before the first frame holds later states", "[state-replay][state-buffer]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    const size_t stateSize = emu.stateSize();
+    std::vector<uint8_t> buffer(stateSize, 0xAA);
+
+    for(uint32_t frame = 0; frame < 3u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+
+    const size_t written = emu.saveStateToMemory(buffer.data(), buffer.size());
+    const std::vector<uint8_t> expected = emu.saveStateToMemory();
+    REQUIRE(written != 0);
+    REQUIRE(written == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), buffer.begin()));
+    REQUIRE(emu.stateSize() == stateSize);
+
+    // A played-back frame can carry more input data than this layout needs; the size
+    // reported before it was played still holds.
+    InputFrame paddedFrame = emu.createInputFrame(emu.frameCount());
+    paddedFrame.state.serializedInputData.resize(paddedFrame.state.serializedInputData.size() + 8u);
+    REQUIRE(emu.setPlaybackInputFrame(paddedFrame));
+    const uint32_t frameBefore = emu.frameCount();
+    (void)emu.updateUntilFrame(std::max<uint32_t>(1u, 1000u / std::max<uint32_t>(1u, emu.getRegionFPS())), false);
+    REQUIRE(emu.frameCount() == frameBefore + 1u);
+    REQUIRE(emu.stateSize() == stateSize);
+    REQUIRE(emu.saveStateToMemory(buffer.data(), buffer.size()) == emu.saveStateToMemory().size());
+
+    InputFrame oversizedFrame = emu.createInputFrame(emu.frameCount());
+    oversizedFrame.state.serializedInputData.resize(stateSize);
+    REQUIRE_FALSE(emu.setPlaybackInputFrame(oversizedFrame));
+}
+
+TEST_CASE("Incremental states restore on top of their base state", "[state-replay][state-incremental]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    for(uint32_t frame = 0; frame < 40u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+
+    const std::vector<uint8_t> base = emu.saveStateToMemory();
+    const uint32_t baseEpoch = emu.markSnapshotBase();
+
+    std::vector<std::vector<uint8_t>> deltas;
+    std::vector<std::vector<uint8_t>> expected;
+    for(uint32_t frame = 40u; frame < 100u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+        if(frame % 20u == 19u) {
+            deltas.push_back(emu.saveIncrementalState(baseEpoch));
+            expected.push_back(emu.saveStateToMemory());
+            REQUIRE(deltas.back().size() < expected.back().size());
+        }
+    }
+
+    // Any delta against the same base applies, in any order.
+    for(size_t i = deltas.size(); i-- > 0;) {
+        INFO("delta " << i);
+        emu.loadStateFromMemory(base);
+        emu.loadStateFromMemory(deltas[i]);
+        REQUIRE(emu.saveStateToMemory() == expected[i]);
+    }
+
+    // A load rewrites memory behind the tracker, so older bases get every page again.
+    const std::vector<uint8_t> afterLoad = emu.saveIncrementalState(baseEpoch);
+    emu.loadStateFromMemory(base);
+    emu.loadStateFromMemory(afterLoad);
+    REQUIRE(emu.saveStateToMemory() == expected.front());
+}
+
+TEST_CASE("Forked emulator matches the original frame by frame", "[state-replay][fork]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    for(uint32_t frame = 0; frame < 40u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+
+    std::unique_ptr<GeraNESEmu> fork = emu.fork();
+    REQUIRE(fork != nullptr);
+    REQUIRE(fork->saveStateToMemory() == emu.saveStateToMemory());
+
+    for(uint32_t frame = 40u; frame < 80u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+        REQUIRE(advanceExactlyOneFrame(*fork, deterministicReplayMask(frame)));
+        REQUIRE(fork->saveStateToMemory() == emu.saveStateToMemory());
+    }
+
+    // Let the fork run ahead on other input, then pull it back onto the original.
+    for(uint32_t frame = 80u; frame < 90u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(*fork, deterministicReplayMask(frame + 7u)));
+    }
+    REQUIRE(fork->copyStateFrom(emu));
+    REQUIRE(fork->saveStateToMemory() == emu.saveStateToMemory());
+
+    for(uint32_t frame = 80u; frame < 100u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+        REQUIRE(advanceExactlyOneFrame(*fork, deterministicReplayMask(frame)));
+        REQUIRE(fork->saveStateToMemory() == emu.saveStateToMemory());
+    }
+
+    GeraNESEmu other(DummyAudioOutput::instance());
+    REQUIRE_FALSE(other.copyStateFrom(emu));
+}
+
+TEST_CASE("Incremental state digest matches a full rehash frame by frame", "[state-replay][state-digest]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    const StateDigest initial = emu.stateDigest();
+    const size_t allPages = emu.stateDigestRehashedPages();
+    REQUIRE(allPages > 0);
+    REQUIRE(emu.stateDigest().root == initial.root);
+    REQUIRE(emu.stateDigestRehashedPages() == 0);
+
+    bool sawPartialRehash = false;
+    for(uint32_t frame = 0; frame < 120u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+
+        const StateDigest incremental = emu.stateDigest();
+        sawPartialRehash = sawPartialRehash || emu.stateDigestRehashedPages() < allPages;
+
+        // A fork starts with an empty page cache and hashes everything.
+        std::unique_ptr<GeraNESEmu> fresh = emu.fork();
+        REQUIRE(fresh != nullptr);
+        const StateDigest full = fresh->stateDigest();
+        REQUIRE(incremental.root == full.root);
+        REQUIRE(incremental.components == full.components);
+
+        // A state load replaces every page, so the next digest must not use the cache.
+        if(frame == 60u) {
+            const std::vector<uint8_t> state = emu.saveStateToMemory();
+            REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame + 3u)));
+            (void)emu.stateDigest();
+            emu.loadStateFromMemory(state);
+            REQUIRE(emu.stateDigest().root == full.root);
+        }
+    }
+    REQUIRE(sawPartialRehash);
+
+    // A single poked byte shows up in its own component only.
+    std::unique_ptr<GeraNESEmu> poked = emu.fork();
+    REQUIRE(poked != nullptr);
+    const StateDigest before = poked->stateDigest();
+    poked->debugWriteCpuMemory(0x0123, static_cast<uint8_t>(poked->debugPeekCpuMemory(0x0123) ^ 0xFF));
+    const StateDigest after = poked->stateDigest();
+    REQUIRE(after.root != before.root);
+    for(size_t i = 0; i < STATE_COMPONENT_COUNT; ++i) {
+        INFO("component " << stateComponentName(static_cast<StateComponent>(i)));
+        REQUIRE((after.components[i] != before.components[i]) == (i == static_cast<size_t>(StateComponent::RAM)));
+    }
+}
+
+TEST_CASE("State layout spans cover the save state by component", "[state-replay][state-layout]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+    for(uint32_t frame = 0; frame < 30u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+
+    const std::vector<uint8_t> before = emu.saveStateToMemory();
+    const std::vector<uint32_t> spans = emu.stateLayout();
+    REQUIRE(spans.size() >= 6u);
+    size_t total = 0;
+    for(const uint32_t span : spans) {
+        REQUIRE(span > 0u);
+        total += span;
+    }
+    REQUIRE(total == before.size());
+
+    // A poked RAM byte changes bytes of the 2 KB RAM span only.
+    emu.debugWriteCpuMemory(0x0456, static_cast<uint8_t>(emu.debugPeekCpuMemory(0x0456) ^ 0xFF));
+    const std::vector<uint8_t> after = emu.saveStateToMemory();
+    REQUIRE(after.size() == before.size());
+    size_t offset = 0;
+    size_t changedSpans = 0;
+    for(const uint32_t span : spans) {
+        if(!std::equal(before.begin() + offset, before.begin() + offset + span, after.begin() + offset)) {
+            ++changedSpans;
+            REQUIRE(span == 0x800u);
+        }
+        offset += span;
+    }
+    REQUIRE(changedSpans == 1u);
+
+    // An older state of the same shape takes the running layout; one it does not cover
+    // gets none.
+    for(uint32_t frame = 30u; frame < 40u; ++frame) {
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+    }
+    REQUIRE(emu.stateLayout(before) == spans);
+    REQUIRE(emu.stateLayout(emu.saveStateToMemory()) == emu.stateLayout());
+    REQUIRE(emu.stateLayout(std::vector<uint8_t>(before.begin(), before.end() - 1)).empty());
+}
+
+TEST_CASE("Run-ahead shows the frame reached later with the last input held", "[state-replay][run-ahead]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu emu(DummyAudioOutput::instance());
+    REQUIRE(emu.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(emu.valid());
+
+    GeraNESEmu reference(DummyAudioOutput::instance());
+    REQUIRE(reference.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(reference.valid());
+
+    RunAhead runAhead;
+    runAhead.setFrames(2u);
+    constexpr size_t framebufferBytes = PPU::SCREEN_WIDTH * PPU::SCREEN_HEIGHT * sizeof(uint32_t);
+
+    for(uint32_t frame = 0; frame < 60u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(emu, deterministicReplayMask(frame)));
+        const std::vector<uint8_t> state = emu.saveStateToMemory();
+
+        const uint32_t* ahead = runAhead.run(emu);
+        REQUIRE(ahead != nullptr);
+
+        // Running ahead leaves the emulator where it was.
+        REQUIRE(emu.saveStateToMemory() == state);
+
+        reference.loadStateFromMemory(state);
+        for(uint32_t i = 0; i < runAhead.frames(); ++i) {
+            REQUIRE(advanceExactlyOneFrame(reference, deterministicReplayMask(frame)));
+        }
+        REQUIRE(std::memcmp(ahead, reference.getFramebuffer(), framebufferBytes) == 0);
+    }
+
+    runAhead.setFrames(0u);
+    REQUIRE(runAhead.run(emu) == nullptr);
+}
+
+TEST_CASE("PPU catch-up scheduling matches lock-step emulation", "[state-replay][ppu-catch-up]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu catchUp(DummyAudioOutput::instance());
+    REQUIRE(catchUp.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(catchUp.valid());
+
+    // Any external bus handler turns on bus instrumentation, which keeps the PPU in lock-step.
+    GeraNESEmu lockStep(DummyAudioOutput::instance());
+    REQUIRE(lockStep.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(lockStep.valid());
+    lockStep.setExternalCpuIoHandlers({}, [](uint16_t) -> std::optional<uint8_t> { return std::nullopt; });
+
+    for(uint32_t frame = 0; frame < 120u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(catchUp, deterministicReplayMask(frame)));
+        REQUIRE(advanceExactlyOneFrame(lockStep, deterministicReplayMask(frame)));
+
+        const std::vector<uint8_t> expected = lockStep.saveStateToMemory();
+        const std::vector<uint8_t> actual = catchUp.saveStateToMemory();
+        if(const std::optional<ByteDiff> diff = firstByteDiff(expected, actual); diff.has_value()) {
+            INFO("first diff at offset " << diff->offset);
+            REQUIRE(stateCrc32(actual) == stateCrc32(expected));
+        }
+    }
+}
+
+TEST_CASE("Scanline fast path matches the dot renderer frame by frame", "[state-replay][ppu-fast-path]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu fastPath(DummyAudioOutput::instance());
+    REQUIRE(fastPath.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(fastPath.valid());
+    REQUIRE(fastPath.scanlineFastPathEnabled());
+
+    GeraNESEmu dotRenderer(DummyAudioOutput::instance());
+    REQUIRE(dotRenderer.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(dotRenderer.valid());
+    dotRenderer.setScanlineFastPathEnabled(false);
+
+    constexpr size_t framebufferBytes = 256u * 240u * sizeof(uint32_t);
+
+    for(uint32_t frame = 0; frame < 180u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(fastPath, deterministicReplayMask(frame)));
+        REQUIRE(advanceExactlyOneFrame(dotRenderer, deterministicReplayMask(frame)));
+
+        REQUIRE(std::memcmp(fastPath.getFramebuffer(), dotRenderer.getFramebuffer(), framebufferBytes) == 0);
+
+        const std::vector<uint8_t> expected = dotRenderer.saveStateToMemory();
+        const std::vector<uint8_t> actual = fastPath.saveStateToMemory();
+        if(const std::optional<ByteDiff> diff = firstByteDiff(expected, actual); diff.has_value()) {
+            INFO("first diff at offset " << diff->offset);
+            REQUIRE(stateCrc32(actual) == stateCrc32(expected));
+        }
+    }
+}
+
+TEST_CASE("Indexed framebuffer converts to the RGBA framebuffer frame by frame", "[state-replay][indexed-framebuffer]")
+{
+    GeraNESTestSupport::requireRomFixture();
+
+    GeraNESEmu indexed(DummyAudioOutput::instance());
+    indexed.setIndexedFramebufferEnabled(true);
+    REQUIRE(indexed.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(indexed.valid());
+
+    GeraNESEmu rgba(DummyAudioOutput::instance());
+    REQUIRE(rgba.openRom(GeraNESTestSupport::romPath().string()));
+    REQUIRE(rgba.valid());
+
+    constexpr size_t pixelCount = 256u * 240u;
+    IndexedColorLut lut;
+    std::vector<uint32_t> converted(pixelCount);
+
+    for(uint32_t frame = 0; frame < 120u; ++frame) {
+        INFO("frame " << frame);
+        REQUIRE(advanceExactlyOneFrame(indexed, deterministicReplayMask(frame)));
+        REQUIRE(advanceExactlyOneFrame(rgba, deterministicReplayMask(frame)));
+
+        indexed.buildIndexedColorLut(lut);
+        convertIndexedPixels(indexed.getIndexedFramebuffer(), converted.data(), pixelCount, lut.data());
+        REQUIRE(std::memcmp(converted.data(), rgba.getFramebuffer(), pixelCount * sizeof(uint32_t)) == 0);
+        REQUIRE(std::memcmp(indexed.getFramebuffer(), rgba.getFramebuffer(), pixelCount * sizeof(uint32_t)) == 0);
+        REQUIRE(stateCrc32(indexed.saveStateToMemory()) == stateCrc32(rgba.saveStateToMemory()));
+    }
+}
+
 TEST_CASE("Replay-style restore and advance stays byte-exact from restored snapshots", "[state-replay][seek-advance]")
 {
     SKIP("Immediate byte-exact post-restore replay is no longer guaranteed by the current save-state contract.");
@@ -555,3 +974,121 @@ TEST_CASE("Threaded replay seek and resume matches baseline replay CRCs", "[stat
         host.shutdown();
     }
 }
+
+TEST_CASE("Rewind restores every buffered frame byte-exact from the delta arena", "[state-replay][rewind]")
+{
+    constexpr size_t arenaMB = 1;
+    SyntheticRewindTarget target;
+    Rewind rewind(target);
+    rewind.setup(true, arenaMB, 1);
+
+    std::vector<std::vector<uint8_t>> history;
+    for(uint32_t frame = 0; frame < 3000u; ++frame) {
+        target.step();
+        if(frame == 1200u) {
+            target.state.resize(target.state.size() + 64u, 0x5A);
+        }
+        rewind.newFrame();
+        history.push_back(target.state);
+    }
+
+    // The arena wrapped and dropped the oldest groups.
+    const size_t buffered = rewind.bufferedFrames();
+    REQUIRE(buffered > 1u);
+    REQUIRE(buffered < history.size());
+    REQUIRE(rewind.usedBytes() <= arenaMB * 1024u * 1024u);
+
+    const auto rewindAll = [&](size_t frames) {
+        rewind.setRewind(true);
+        for(size_t i = 0; i < frames; ++i) {
+            INFO("rewind step " << i);
+            rewind.newFrame();
+            REQUIRE(target.loaded == history[history.size() - 1u - i]);
+        }
+        // At the limit the oldest frame keeps being restored.
+        rewind.newFrame();
+        REQUIRE(target.loaded == history[history.size() - frames]);
+        REQUIRE_FALSE(rewind.rewindLimit());
+    };
+
+    const size_t partial = buffered / 2u;
+    rewind.setRewind(true);
+    for(size_t i = 0; i < partial; ++i) {
+        rewind.newFrame();
+        REQUIRE(target.loaded == history[history.size() - 1u - i]);
+    }
+
+    // Capturing resumes from the restored frame; the frames rewound over are gone.
+    rewind.setRewind(false);
+    history.resize(history.size() - partial);
+    target.state = history.back();
+    for(uint32_t frame = 0; frame < 200u; ++frame) {
+        target.step();
+        rewind.newFrame();
+        history.push_back(target.state);
+    }
+
+    REQUIRE(rewind.bufferedFrames() == buffered - partial + 200u);
+    rewindAll(rewind.bufferedFrames());
+}
+
+namespace
+{
+    struct TestStateBlockV1
+    {
+        static constexpr uint32_t LAYOUT_VERSION = 1;
+        uint32_t counter = 0;
+        uint16_t address = 0;
+        uint8_t flags = 0;
+        uint8_t reserved = 0;
+    };
+
+    struct TestStateBlockV2
+    {
+        static constexpr uint32_t LAYOUT_VERSION = 2;
+        uint16_t address = 0;
+        uint8_t flags = 0;
+        uint8_t reserved = 0;
+        uint32_t counter = 0;
+    };
+}
+
+TEST_CASE("State blocks round-trip and reject a block saved with another layout", "[state-replay][state-block]")
+{
+    TestStateBlockV1 saved;
+    saved.counter = 0x12345678u;
+    saved.address = 0xBEEF;
+    saved.flags = 0x5A;
+    uint32_t trailer = 0xCAFEF00Du;
+
+    Serialize s;
+    s.block(saved);
+    SERIALIZEDATA(s, trailer);
+
+    {
+        TestStateBlockV1 loaded;
+        uint32_t loadedTrailer = 0;
+        Deserialize d;
+        d.setData(s.getData());
+        d.block(loaded);
+        SERIALIZEDATA(d, loadedTrailer);
+        REQUIRE_FALSE(d.error());
+        REQUIRE(std::memcmp(&loaded, &saved, sizeof(saved)) == 0);
+        REQUIRE(loadedTrailer == trailer);
+    }
+
+    // Same size, different layout: the load fails and nothing after it is read.
+    {
+        TestStateBlockV2 loaded;
+        loaded.counter = 7u;
+        uint32_t loadedTrailer = 0;
+        Deserialize d;
+        d.setData(s.getData());
+        d.block(loaded);
+        SERIALIZEDATA(d, loadedTrailer);
+        REQUIRE(d.error());
+        REQUIRE(loaded.counter == 7u);
+        REQUIRE(loaded.address == 0);
+        REQUIRE(loadedTrailer == 0u);
+    }
+}
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+#include "GeraNES/util/NesAssembler.h"
+
+namespace GeraNESTestSupport
+{
+    // Small iNES image assembled in memory. CPU addresses given to poke()/assembler() map to
+    // the last 32KB of PRG, which is what $8000-$FFFF shows on power-on for NROM and what
+    // the fixed banks show for MMC1 ($C000-$FFFF) and MMC3 ($E000-$FFFF). Code for banked
+    // mappers must stay in those fixed windows.
+    class SyntheticCartridge
+    {
+    private:
+        static constexpr size_t PRG_BANK_SIZE = 0x4000;
+        static constexpr size_t CHR_BANK_SIZE = 0x2000;
+
+        uint8_t m_mapperId;
+        bool m_verticalMirroring;
+        std::vector<uint8_t> m_prg;
+        std::vector<uint8_t> m_chr;
+
+        size_t prgOffset(uint16_t cpuAddr) const
+        {
+            return m_prg.size() - 0x8000 + static_cast<size_t>(cpuAddr - 0x8000);
+        }
+
+    public:
+        SyntheticCartridge(uint8_t mapperId, uint8_t prgBanks16k = 2, uint8_t chrBanks8k = 1, bool verticalMirroring = false)
+            : m_mapperId(mapperId)
+            , m_verticalMirroring(verticalMirroring)
+            , m_prg(static_cast<size_t>(prgBanks16k < 2 ? 2 : prgBanks16k) * PRG_BANK_SIZE, 0xEA)
+            , m_chr(static_cast<size_t>(chrBanks8k) * CHR_BANK_SIZE, 0x00)
+        {
+        }
+
+        std::vector<uint8_t>& prg() { return m_prg; }
+        std::vector<uint8_t>& chr() { return m_chr; }
+
+        void poke(uint16_t cpuAddr, uint8_t value)
+        {
+            m_prg[prgOffset(cpuAddr)] = value;
+        }
+
+        void pokeWord(uint16_t cpuAddr, uint16_t value)
+        {
+            poke(cpuAddr, static_cast<uint8_t>(value & 0xFF));
+            poke(static_cast<uint16_t>(cpuAddr + 1), static_cast<uint8_t>(value >> 8));
+        }
+
+        GeraNES::NesAssembler assembler(uint16_t cpuAddr)
+        {
+            return GeraNES::NesAssembler([this](uint16_t addr, uint8_t value) { poke(addr, value); }, cpuAddr);
+        }
+
+        void setVectors(uint16_t nmi, uint16_t reset, uint16_t irq)
+        {
+            pokeWord(0xFFFA, nmi);
+            pokeWord(0xFFFC, reset);
+            pokeWord(0xFFFE, irq);
+        }
+
+        std::vector<uint8_t> image() const
+        {
+            std::vector<uint8_t> rom = {
+                'N', 'E', 'S', 0x1A,
+                static_cast<uint8_t>(m_prg.size() / PRG_BANK_SIZE),
+                static_cast<uint8_t>(m_chr.size() / CHR_BANK_SIZE),
+                static_cast<uint8_t>(((m_mapperId & 0x0F) << 4) | (m_verticalMirroring ? 0x01 : 0x00)),
+                static_cast<uint8_t>(m_mapperId & 0xF0),
+                0, 0, 0, 0, 0, 0, 0, 0
+            };
+            rom.insert(rom.end(), m_prg.begin(), m_prg.end());
+            rom.insert(rom.end(), m_chr.begin(), m_chr.end());
+            return rom;
+        }
+
+        bool writeTo(const std::filesystem::path& path) const
+        {
+            const std::vector<uint8_t> rom = image();
+            std::ofstream file(path, std::ios::binary | std::ios::trunc);
+            file.write(reinterpret_cast<const char*>(rom.data()), static_cast<std::streamsize>(rom.size()));
+            return static_cast<bool>(file);
+        }
+    };
+}